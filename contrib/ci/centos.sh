@@ -10,6 +10,7 @@ meson .. \
 	-Dplugin_uefi=false \
 	-Dplugin_dell=false \
 	-Dplugin_modem_manager=false \
+	-Dplugin_flashrom=false \
 	-Dplugin_synaptics=true \
 	-Dintrospection=true \
 	-Dgtkdoc=true \
@@ -19,6 +19,7 @@ meson .. \
 	-Dplugin_uefi=false \
 	-Dplugin_dell=false \
 	-Dplugin_modem_manager=false \
+	-Dplugin_flashrom=false \
 	-Dplugin_redfish=false \
 	-Dintrospection=false \
 	-Dgtkdoc=false \
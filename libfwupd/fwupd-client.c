@@ -4,16 +4,22 @@
  * SPDX-License-Identifier: LGPL-2.1+
  */
 
+/* for memfd_create() and F_ADD_SEALS */
+#define _GNU_SOURCE
+
 #include "config.h"
 
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <gio/gunixfdlist.h>
 
+#include <errno.h>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "fwupd-client.h"
 #include "fwupd-common.h"
@@ -28,7 +34,8 @@
  * SECTION:fwupd-client
  * @short_description: a way of interfacing with the daemon
  *
- * An object that allows client code to call the daemon methods synchronously.
+ * An object that allows client code to call the daemon methods, either
+ * synchronously or asynchronously using a #GTask for each request.
  *
  * See also: #FwupdDevice
  */
@@ -42,6 +49,8 @@ typedef struct {
 	gchar				*daemon_version;
 	GDBusConnection			*conn;
 	GDBusProxy			*proxy;
+	gboolean			 connecting;
+	GPtrArray			*pending;	/* of GTask */
 } FwupdClientPrivate;
 
 enum {
@@ -68,40 +77,89 @@ G_DEFINE_TYPE_WITH_PRIVATE (FwupdClient, fwupd_client, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (fwupd_client_get_instance_private (o))
 
 typedef struct {
-	gboolean	 ret;
-	GError		*error;
+	GAsyncResult	*res;
+	GMainContext	*context;
 	GMainLoop	*loop;
-	GVariant	*val;
-	GDBusMessage	*message;
+	gboolean	 isolated;
 } FwupdClientHelper;
 
 static void
 fwupd_client_helper_free (FwupdClientHelper *helper)
 {
-	if (helper->message != NULL)
-		g_object_unref (helper->message);
-	if (helper->val != NULL)
-		g_variant_unref (helper->val);
-	if (helper->error != NULL)
-		g_error_free (helper->error);
+	if (helper->isolated)
+		g_main_context_pop_thread_default (helper->context);
+	if (helper->res != NULL)
+		g_object_unref (helper->res);
 	g_main_loop_unref (helper->loop);
+	g_main_context_unref (helper->context);
 	g_free (helper);
 }
 
+/* an isolated helper iterates a private context, like g_dbus_proxy_call_sync()
+ * does, so nothing else is dispatched while blocking; otherwise the
+ * thread-default context is used so that the ::status-changed and percentage
+ * notifications are delivered during long-running calls */
 static FwupdClientHelper *
-fwupd_client_helper_new (void)
+fwupd_client_helper_new (gboolean isolated)
 {
 	FwupdClientHelper *helper;
 	helper = g_new0 (FwupdClientHelper, 1);
-	helper->loop = g_main_loop_new (NULL, FALSE);
+	helper->isolated = isolated;
+	if (isolated) {
+		helper->context = g_main_context_new ();
+		g_main_context_push_thread_default (helper->context);
+	} else {
+		helper->context = g_main_context_ref_thread_default ();
+	}
+	helper->loop = g_main_loop_new (helper->context, FALSE);
 	return helper;
 }
 
+static void
+fwupd_client_helper_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->res = g_object_ref (res);
+	g_main_loop_quit (helper->loop);
+}
+
+static void
+fwupd_client_helper_run (FwupdClientHelper *helper)
+{
+	if (helper->res == NULL)
+		g_main_loop_run (helper->loop);
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-function"
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FwupdClientHelper, fwupd_client_helper_free)
 #pragma clang diagnostic pop
 
+/* a single method call into the daemon, or just a connection if @method is
+ * %NULL; this is the task data of the GTask used for each async request */
+typedef struct {
+	FwupdClient		*client;	/* no ref */
+	gchar			*method;
+	GVariant		*params;
+	GUnixFDList		*fd_list;
+	gint			 timeout_msec;
+	FwupdClientProgressFunc	 progress_cb;
+	gpointer		 progress_data;
+	gulong			 status_id;
+	gulong			 percentage_id;
+} FwupdClientCall;
+
+static void
+fwupd_client_call_free (FwupdClientCall *call)
+{
+	g_free (call->method);
+	if (call->params != NULL)
+		g_variant_unref (call->params);
+	if (call->fd_list != NULL)
+		g_object_unref (call->fd_list);
+	g_free (call);
+}
+
 static void
 fwupd_client_set_daemon_version (FwupdClient *client, const gchar *daemon_version)
 {
@@ -194,6 +252,28 @@ fwupd_client_signal_cb (GDBusProxy *proxy,
 	g_debug ("Unknown signal name '%s' from %s", signal_name, sender_name);
 }
 
+static void
+fwupd_client_set_proxy (FwupdClient *client, GDBusProxy *proxy)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariant) val2 = NULL;
+
+	priv->proxy = proxy;
+	if (priv->conn == NULL)
+		priv->conn = g_object_ref (g_dbus_proxy_get_connection (proxy));
+	g_signal_connect (priv->proxy, "g-properties-changed",
+			  G_CALLBACK (fwupd_client_properties_changed_cb), client);
+	g_signal_connect (priv->proxy, "g-signal",
+			  G_CALLBACK (fwupd_client_signal_cb), client);
+	val = g_dbus_proxy_get_cached_property (priv->proxy, "DaemonVersion");
+	if (val != NULL)
+		fwupd_client_set_daemon_version (client, g_variant_get_string (val, NULL));
+	val2 = g_dbus_proxy_get_cached_property (priv->proxy, "Tainted");
+	if (val2 != NULL)
+		priv->tainted = g_variant_get_boolean (val2);
+}
+
 /**
  * fwupd_client_connect:
  * @client: A #FwupdClient
@@ -212,8 +292,7 @@ gboolean
 fwupd_client_connect (FwupdClient *client, GCancellable *cancellable, GError **error)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
-	g_autoptr(GVariant) val2 = NULL;
+	GDBusProxy *proxy;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
@@ -224,31 +303,24 @@ fwupd_client_connect (FwupdClient *client, GCancellable *cancellable, GError **e
 		return TRUE;
 
 	/* connect to the daemon */
-	priv->conn = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, error);
 	if (priv->conn == NULL) {
-		g_prefix_error (error, "Failed to connect to system D-Bus: ");
-		return FALSE;
+		priv->conn = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, error);
+		if (priv->conn == NULL) {
+			g_prefix_error (error, "Failed to connect to system D-Bus: ");
+			return FALSE;
+		}
 	}
-	priv->proxy = g_dbus_proxy_new_sync (priv->conn,
-					     G_DBUS_PROXY_FLAGS_NONE,
-					     NULL,
-					     FWUPD_DBUS_SERVICE,
-					     FWUPD_DBUS_PATH,
-					     FWUPD_DBUS_INTERFACE,
-					     NULL,
-					     error);
-	if (priv->proxy == NULL)
+	proxy = g_dbus_proxy_new_sync (priv->conn,
+				       G_DBUS_PROXY_FLAGS_NONE,
+				       NULL,
+				       FWUPD_DBUS_SERVICE,
+				       FWUPD_DBUS_PATH,
+				       FWUPD_DBUS_INTERFACE,
+				       NULL,
+				       error);
+	if (proxy == NULL)
 		return FALSE;
-	g_signal_connect (priv->proxy, "g-properties-changed",
-			  G_CALLBACK (fwupd_client_properties_changed_cb), client);
-	g_signal_connect (priv->proxy, "g-signal",
-			  G_CALLBACK (fwupd_client_signal_cb), client);
-	val = g_dbus_proxy_get_cached_property (priv->proxy, "DaemonVersion");
-	if (val != NULL)
-		fwupd_client_set_daemon_version (client, g_variant_get_string (val, NULL));
-	val2 = g_dbus_proxy_get_cached_property (priv->proxy, "Tainted");
-	if (val2 != NULL)
-		priv->tainted = g_variant_get_boolean (val2);
+	fwupd_client_set_proxy (client, proxy);
 	return TRUE;
 }
 
@@ -367,65 +439,386 @@ fwupd_client_fixup_dbus_error (GError *error)
 	g_dbus_error_strip_remote_error (error);
 }
 
+static void
+fwupd_client_call_progress_cb (FwupdClient *client,
+			       GParamSpec *pspec,
+			       FwupdClientCall *call)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	call->progress_cb (client, priv->status, priv->percentage, call->progress_data);
+}
+
+static GTask *
+fwupd_client_call_new (FwupdClient *client,
+		       const gchar *method,
+		       GVariant *params,
+		       GUnixFDList *fd_list,
+		       gint timeout_msec,
+		       GCancellable *cancellable,
+		       GAsyncReadyCallback callback,
+		       gpointer callback_data,
+		       gpointer source_tag)
+{
+	FwupdClientCall *call = g_new0 (FwupdClientCall, 1);
+	GTask *task = g_task_new (client, cancellable, callback, callback_data);
+	g_task_set_source_tag (task, source_tag);
+	call->client = client;
+	call->method = g_strdup (method);
+	if (params != NULL)
+		call->params = g_variant_ref_sink (params);
+	if (fd_list != NULL)
+		call->fd_list = g_object_ref (fd_list);
+	call->timeout_msec = timeout_msec;
+	g_task_set_task_data (task, call, (GDestroyNotify) fwupd_client_call_free);
+	return task;
+}
+
+static void
+fwupd_client_call_set_progress (GTask *task,
+				FwupdClientProgressFunc progress_cb,
+				gpointer progress_data)
+{
+	FwupdClientCall *call = g_task_get_task_data (task);
+	if (progress_cb == NULL)
+		return;
+	call->progress_cb = progress_cb;
+	call->progress_data = progress_data;
+	call->status_id = g_signal_connect (call->client, "notify::status",
+					    G_CALLBACK (fwupd_client_call_progress_cb),
+					    call);
+	call->percentage_id = g_signal_connect (call->client, "notify::percentage",
+						G_CALLBACK (fwupd_client_call_progress_cb),
+						call);
+}
+
+/* takes ownership of @task, @val and @error */
+static void
+fwupd_client_call_complete (GTask *task, GVariant *val, GError *error)
+{
+	FwupdClientCall *call = g_task_get_task_data (task);
+	if (call->status_id != 0) {
+		g_signal_handler_disconnect (call->client, call->status_id);
+		call->status_id = 0;
+	}
+	if (call->percentage_id != 0) {
+		g_signal_handler_disconnect (call->client, call->percentage_id);
+		call->percentage_id = 0;
+	}
+	if (error != NULL)
+		g_task_return_error (task, error);
+	else if (call->method == NULL)
+		g_task_return_boolean (task, TRUE);
+	else
+		g_task_return_pointer (task, val, (GDestroyNotify) g_variant_unref);
+	g_object_unref (task);
+}
+
+static void
+fwupd_client_call_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GError *error = NULL;
+	GVariant *val;
+
+	val = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (source),
+							  NULL, res, &error);
+	if (val == NULL)
+		fwupd_client_fixup_dbus_error (error);
+	fwupd_client_call_complete (task, val, error);
+}
+
+/* takes ownership of @task */
+static void
+fwupd_client_call_dispatch (GTask *task)
+{
+	FwupdClientCall *call = g_task_get_task_data (task);
+	FwupdClientPrivate *priv = GET_PRIVATE (call->client);
+
+	/* just connecting */
+	if (call->method == NULL) {
+		fwupd_client_call_complete (task, NULL, NULL);
+		return;
+	}
+	g_dbus_proxy_call_with_unix_fd_list (priv->proxy,
+					     call->method,
+					     call->params,
+					     G_DBUS_CALL_FLAGS_NONE,
+					     call->timeout_msec,
+					     call->fd_list,
+					     g_task_get_cancellable (task),
+					     fwupd_client_call_cb,
+					     task);
+}
+
+/* takes ownership of @proxy and @error */
+static void
+fwupd_client_connect_done (FwupdClient *client, GDBusProxy *proxy, GError *error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GPtrArray) pending = priv->pending;
+
+	/* a sync connect may have finished first */
+	if (proxy != NULL) {
+		if (priv->proxy == NULL)
+			fwupd_client_set_proxy (client, proxy);
+		else
+			g_object_unref (proxy);
+	}
+
+	/* run everything that was waiting for the connection */
+	priv->pending = g_ptr_array_new ();
+	priv->connecting = FALSE;
+	for (guint i = 0; i < pending->len; i++) {
+		GTask *task = g_ptr_array_index (pending, i);
+		if (error != NULL) {
+			fwupd_client_call_complete (task, NULL, g_error_copy (error));
+			continue;
+		}
+		fwupd_client_call_dispatch (task);
+	}
+	if (error != NULL)
+		g_error_free (error);
+}
+
+static void
+fwupd_client_connect_proxy_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(FwupdClient) client = FWUPD_CLIENT (user_data);
+	GDBusProxy *proxy;
+	GError *error = NULL;
+
+	proxy = g_dbus_proxy_new_finish (res, &error);
+	fwupd_client_connect_done (client, proxy, error);
+}
+
+static void
+fwupd_client_connect_bus_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClient *client = FWUPD_CLIENT (user_data);
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	GDBusConnection *conn;
+	GError *error = NULL;
+
+	conn = g_bus_get_finish (res, &error);
+	if (conn == NULL) {
+		g_prefix_error (&error, "Failed to connect to system D-Bus: ");
+		fwupd_client_connect_done (client, NULL, error);
+		g_object_unref (client);
+		return;
+	}
+	if (priv->conn == NULL)
+		priv->conn = g_object_ref (conn);
+	g_dbus_proxy_new (conn,
+			  G_DBUS_PROXY_FLAGS_NONE,
+			  NULL,
+			  FWUPD_DBUS_SERVICE,
+			  FWUPD_DBUS_PATH,
+			  FWUPD_DBUS_INTERFACE,
+			  NULL,
+			  fwupd_client_connect_proxy_cb,
+			  client);
+	g_object_unref (conn);
+}
+
+/* takes ownership of @task, connecting to the daemon first if required */
+static void
+fwupd_client_call_run (FwupdClient *client, GTask *task)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+
+	/* already connected */
+	if (priv->proxy != NULL) {
+		fwupd_client_call_dispatch (task);
+		return;
+	}
+
+	/* only one connection attempt is made for all the pending calls */
+	g_ptr_array_add (priv->pending, task);
+	if (priv->connecting)
+		return;
+	priv->connecting = TRUE;
+	g_bus_get (G_BUS_TYPE_SYSTEM, NULL,
+		   fwupd_client_connect_bus_cb,
+		   g_object_ref (client));
+}
+
+/* copies @bytes into a memfd that is sealed so the daemon can map it */
+static gint
+fwupd_client_bytes_to_fd (GBytes *bytes, GError **error)
+{
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_MEMFD_SEALS)
+	gsize bufsz = 0;
+	gsize offset = 0;
+	gint fd;
+	const guint8 *buf = g_bytes_get_data (bytes, &bufsz);
+
+	fd = memfd_create ("fwupd-client", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to create memfd: %s",
+			     strerror (errno));
+		return -1;
+	}
+	while (offset < bufsz) {
+		gssize wrote = write (fd, buf + offset, bufsz - offset);
+		if (wrote < 0) {
+			if (errno == EINTR)
+				continue;
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "failed to write memfd: %s",
+				     strerror (errno));
+			close (fd);
+			return -1;
+		}
+		offset += wrote;
+	}
+	if (fcntl (fd, F_ADD_SEALS,
+		   F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to seal memfd: %s",
+			     strerror (errno));
+		close (fd);
+		return -1;
+	}
+	return fd;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "memfd_create() is not supported");
+	return -1;
+#endif
+}
+
 /**
- * fwupd_client_get_devices:
+ * fwupd_client_connect_async:
  * @client: A #FwupdClient
  * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Sets up the client ready for use without blocking. The other async methods
+ * connect automatically, and calls made before the connection is established
+ * are queued until it is.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_connect_async (FwupdClient *client,
+			    GCancellable *cancellable,
+			    GAsyncReadyCallback callback,
+			    gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, NULL, NULL, NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_connect_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_connect_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
  * @error: the #GError, or %NULL
  *
+ * Gets the result of fwupd_client_connect_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_connect_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_devices_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
  * Gets all the devices registered with the daemon.
  *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_devices_async (FwupdClient *client,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetDevices",
+				      NULL, NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_devices_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_devices_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_devices_async().
+ *
  * Returns: (element-type FwupdDevice) (transfer container): results
  *
- * Since: 0.9.2
+ * Since: 1.2.6
  **/
 GPtrArray *
-fwupd_client_get_devices (FwupdClient *client, GCancellable *cancellable, GError **error)
+fwupd_client_get_devices_finish (FwupdClient *client, GAsyncResult *res, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(GVariant) val = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return NULL;
-
-	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetDevices",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
 		return NULL;
-	}
 	return fwupd_client_parse_devices_from_variant (val);
 }
 
 /**
- * fwupd_client_get_history:
+ * fwupd_client_get_devices:
  * @client: A #FwupdClient
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Gets all the history.
+ * Gets all the devices registered with the daemon.
  *
  * Returns: (element-type FwupdDevice) (transfer container): results
  *
- * Since: 1.0.4
+ * Since: 0.9.2
  **/
 GPtrArray *
-fwupd_client_get_history (FwupdClient *client, GCancellable *cancellable, GError **error)
+fwupd_client_get_devices (FwupdClient *client, GCancellable *cancellable, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
@@ -436,87 +829,87 @@ fwupd_client_get_history (FwupdClient *client, GCancellable *cancellable, GError
 		return NULL;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetHistory",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
-	}
-	return fwupd_client_parse_devices_from_variant (val);
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_devices_async (client, cancellable,
+					fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_devices_finish (client, helper->res, error);
 }
 
 /**
- * fwupd_client_get_device_by_id:
+ * fwupd_client_get_history_async:
  * @client: A #FwupdClient
- * @device_id: the device ID, e.g. `usb:00:01:03:03`
  * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets all the history.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_history_async (FwupdClient *client,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetHistory",
+				      NULL, NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_history_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_history_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
  * @error: the #GError, or %NULL
  *
- * Gets a device by it's device ID.
+ * Gets the result of fwupd_client_get_history_async().
  *
- * Returns: (transfer full): a #FwupdDevice or %NULL
+ * Returns: (element-type FwupdDevice) (transfer container): results
  *
- * Since: 0.9.3
+ * Since: 1.2.6
  **/
-FwupdDevice *
-fwupd_client_get_device_by_id (FwupdClient *client,
-			       const gchar *device_id,
-			       GCancellable *cancellable,
-			       GError **error)
+GPtrArray *
+fwupd_client_get_history_finish (FwupdClient *client, GAsyncResult *res, GError **error)
 {
-	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GVariant) val = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (device_id != NULL, NULL);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	/* get all the devices */
-	devices = fwupd_client_get_devices (client, cancellable, error);
-	if (devices == NULL)
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
 		return NULL;
-
-	/* find the device by ID (client side) */
-	for (guint i = 0; i < devices->len; i++) {
-		FwupdDevice *dev = g_ptr_array_index (devices, i);
-		if (g_strcmp0 (fwupd_device_get_id (dev), device_id) == 0)
-			return g_object_ref (dev);
-	}
-	g_set_error (error,
-		     FWUPD_ERROR,
-		     FWUPD_ERROR_NOT_FOUND,
-		     "failed to find %s", device_id);
-	return NULL;
+	return fwupd_client_parse_devices_from_variant (val);
 }
 
 /**
- * fwupd_client_get_releases:
+ * fwupd_client_get_history:
  * @client: A #FwupdClient
- * @device_id: the device ID
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Gets all the releases for a specific device
+ * Gets all the history.
  *
- * Returns: (element-type FwupdRelease) (transfer container): results
+ * Returns: (element-type FwupdDevice) (transfer container): results
  *
- * Since: 0.9.3
+ * Since: 1.0.4
  **/
 GPtrArray *
-fwupd_client_get_releases (FwupdClient *client, const gchar *device_id,
-			   GCancellable *cancellable, GError **error)
+fwupd_client_get_history (FwupdClient *client, GCancellable *cancellable, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (device_id != NULL, NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
@@ -525,18 +918,290 @@ fwupd_client_get_releases (FwupdClient *client, const gchar *device_id,
 		return NULL;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetReleases",
-				      g_variant_new ("(s)", device_id),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_history_async (client, cancellable,
+					fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_history_finish (client, helper->res, error);
+}
+
+static void
+fwupd_client_get_device_by_id_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	const gchar *device_id = g_task_get_task_data (task);
+	GError *error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	devices = fwupd_client_get_devices_finish (FWUPD_CLIENT (source), res, &error);
+	if (devices == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+
+	/* find the device by ID (client side) */
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		if (g_strcmp0 (fwupd_device_get_id (dev), device_id) == 0) {
+			g_task_return_pointer (task, g_object_ref (dev),
+					       (GDestroyNotify) g_object_unref);
+			return;
+		}
+	}
+	g_task_return_new_error (task,
+				 FWUPD_ERROR,
+				 FWUPD_ERROR_NOT_FOUND,
+				 "failed to find %s", device_id);
+}
+
+/**
+ * fwupd_client_get_device_by_id_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID, e.g. `usb:00:01:03:03`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets a device by it's device ID.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_device_by_id_async (FwupdClient *client,
+				     const gchar *device_id,
+				     GCancellable *cancellable,
+				     GAsyncReadyCallback callback,
+				     gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (client, cancellable, callback, callback_data);
+	g_task_set_source_tag (task, fwupd_client_get_device_by_id_async);
+	g_task_set_task_data (task, g_strdup (device_id), g_free);
+	fwupd_client_get_devices_async (client, cancellable,
+					fwupd_client_get_device_by_id_cb, task);
+}
+
+/**
+ * fwupd_client_get_device_by_id_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_device_by_id_async().
+ *
+ * Returns: (transfer full): a #FwupdDevice or %NULL
+ *
+ * Since: 1.2.6
+ **/
+FwupdDevice *
+fwupd_client_get_device_by_id_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_device_by_id:
+ * @client: A #FwupdClient
+ * @device_id: the device ID, e.g. `usb:00:01:03:03`
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets a device by it's device ID.
+ *
+ * Returns: (transfer full): a #FwupdDevice or %NULL
+ *
+ * Since: 0.9.3
+ **/
+FwupdDevice *
+fwupd_client_get_device_by_id (FwupdClient *client,
+			       const gchar *device_id,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* get all the devices */
+	devices = fwupd_client_get_devices (client, cancellable, error);
+	if (devices == NULL)
+		return NULL;
+
+	/* find the device by ID (client side) */
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		if (g_strcmp0 (fwupd_device_get_id (dev), device_id) == 0)
+			return g_object_ref (dev);
 	}
+	g_set_error (error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_NOT_FOUND,
+		     "failed to find %s", device_id);
+	return NULL;
+}
+
+/**
+ * fwupd_client_get_releases_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets all the releases for a specific device
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_releases_async (FwupdClient *client,
+				 const gchar *device_id,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetReleases",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_releases_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_releases_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_releases_async().
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fwupd_client_get_releases_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	return fwupd_client_parse_releases_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_releases:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the releases for a specific device
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 0.9.3
+ **/
+GPtrArray *
+fwupd_client_get_releases (FwupdClient *client, const gchar *device_id,
+			   GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_releases_async (client, device_id, cancellable,
+					 fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_releases_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_get_downgrades_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets all the downgrades for a specific device.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_downgrades_async (FwupdClient *client,
+				   const gchar *device_id,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetDowngrades",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_downgrades_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_downgrades_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_downgrades_async().
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fwupd_client_get_downgrades_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
 	return fwupd_client_parse_releases_from_variant (val);
 }
 
@@ -557,8 +1222,7 @@ GPtrArray *
 fwupd_client_get_downgrades (FwupdClient *client, const gchar *device_id,
 			     GCancellable *cancellable, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (device_id != NULL, NULL);
@@ -570,18 +1234,69 @@ fwupd_client_get_downgrades (FwupdClient *client, const gchar *device_id,
 		return NULL;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetDowngrades",
-				      g_variant_new ("(s)", device_id),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_downgrades_async (client, device_id, cancellable,
+					   fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_downgrades_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_get_upgrades_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets all the upgrades for a specific device.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_upgrades_async (FwupdClient *client,
+				 const gchar *device_id,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetUpgrades",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_upgrades_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_upgrades_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_upgrades_async().
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fwupd_client_get_upgrades_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
 		return NULL;
-	}
 	return fwupd_client_parse_releases_from_variant (val);
 }
 
@@ -602,8 +1317,7 @@ GPtrArray *
 fwupd_client_get_upgrades (FwupdClient *client, const gchar *device_id,
 			   GCancellable *cancellable, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (device_id != NULL, NULL);
@@ -615,105 +1329,746 @@ fwupd_client_get_upgrades (FwupdClient *client, const gchar *device_id,
 		return NULL;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetUpgrades",
-				      g_variant_new ("(s)", device_id),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
-	}
-	return fwupd_client_parse_releases_from_variant (val);
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_upgrades_async (client, device_id, cancellable,
+					 fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_upgrades_finish (client, helper->res, error);
 }
 
-static void
-fwupd_client_proxy_call_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+/**
+ * fwupd_client_activate_async:
+ * @client: A #FwupdClient
+ * @device_id: a device
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Activates up a device, which normally means the device switches to a new
+ * firmware verson. This should only be called when data loss cannot occur.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_activate_async (FwupdClient *client,
+			     const gchar *device_id,
+			     GCancellable *cancellable,
+			     GAsyncReadyCallback callback,
+			     gpointer callback_data)
 {
-	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
-	helper->val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source),
-						res, &helper->error);
-	if (helper->val != NULL)
-		helper->ret = TRUE;
-	if (helper->error != NULL)
-		fwupd_client_fixup_dbus_error (helper->error);
-	g_main_loop_quit (helper->loop);
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "Activate",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_activate_async);
+	fwupd_client_call_run (client, task);
 }
 
 /**
- * fwupd_client_activate:
+ * fwupd_client_activate_finish:
  * @client: A #FwupdClient
- * @cancellable: the #GCancellable, or %NULL
- * @device_id: a device
+ * @res: the #GAsyncResult
  * @error: the #GError, or %NULL
  *
- * Activates up a device, which normally means the device switches to a new
- * firmware verson. This should only be called when data loss cannot occur.
+ * Gets the result of fwupd_client_activate_async().
  *
  * Returns: %TRUE for success
  *
  * Since: 1.2.6
  **/
 gboolean
-fwupd_client_activate (FwupdClient *client, GCancellable *cancellable,
-		       const gchar *device_id, GError **error)
+fwupd_client_activate_finish (FwupdClient *client, GAsyncResult *res, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(FwupdClientHelper) helper = NULL;
+	g_autoptr(GVariant) val = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
-	g_return_val_if_fail (device_id != NULL, FALSE);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return FALSE;
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
+}
+
+/**
+ * fwupd_client_activate:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @device_id: a device
+ * @error: the #GError, or %NULL
+ *
+ * Activates up a device, which normally means the device switches to a new
+ * firmware verson. This should only be called when data loss cannot occur.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_activate (FwupdClient *client, GCancellable *cancellable,
+		       const gchar *device_id, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return FALSE;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_activate_async (client, device_id, cancellable,
+				     fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_activate_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_verify_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Verify a specific device.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_verify_async (FwupdClient *client,
+			   const gchar *device_id,
+			   GCancellable *cancellable,
+			   GAsyncReadyCallback callback,
+			   gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "Verify",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_verify_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_verify_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_verify_async().
+ *
+ * Returns: %TRUE for verification success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_verify_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
+}
+
+/**
+ * fwupd_client_verify:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Verify a specific device.
+ *
+ * Returns: %TRUE for verification success
+ *
+ * Since: 0.7.0
+ **/
+gboolean
+fwupd_client_verify (FwupdClient *client, const gchar *device_id,
+		     GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return FALSE;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_verify_async (client, device_id, cancellable,
+				   fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_verify_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_verify_update_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Update the verification record for a specific device.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_verify_update_async (FwupdClient *client,
+				  const gchar *device_id,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "VerifyUpdate",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_verify_update_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_verify_update_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_verify_update_async().
+ *
+ * Returns: %TRUE for verification success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_verify_update_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
+}
+
+/**
+ * fwupd_client_verify_update:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Update the verification record for a specific device.
+ *
+ * Returns: %TRUE for verification success
+ *
+ * Since: 0.8.0
+ **/
+gboolean
+fwupd_client_verify_update (FwupdClient *client, const gchar *device_id,
+		     GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return FALSE;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_verify_update_async (client, device_id, cancellable,
+					  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_verify_update_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_unlock_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Unlocks a specific device so firmware can be read or wrote.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_unlock_async (FwupdClient *client,
+			   const gchar *device_id,
+			   GCancellable *cancellable,
+			   GAsyncReadyCallback callback,
+			   gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "Unlock",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_unlock_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_unlock_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_unlock_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_unlock_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
+}
+
+/**
+ * fwupd_client_unlock:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Unlocks a specific device so firmware can be read or wrote.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.7.0
+ **/
+gboolean
+fwupd_client_unlock (FwupdClient *client, const gchar *device_id,
+		     GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return FALSE;
 
 	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	g_dbus_proxy_call (priv->proxy,
-			   "Activate",
-			   g_variant_new ("(s)", device_id),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   cancellable,
-			   fwupd_client_proxy_call_cb,
-			   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_unlock_async (client, device_id, cancellable,
+				   fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_unlock_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_clear_results_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Clears the results for a specific device.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_clear_results_async (FwupdClient *client,
+				  const gchar *device_id,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "ClearResults",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_clear_results_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_clear_results_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_clear_results_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_clear_results_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
+}
+
+/**
+ * fwupd_client_clear_results:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Clears the results for a specific device.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.7.0
+ **/
+gboolean
+fwupd_client_clear_results (FwupdClient *client, const gchar *device_id,
+			    GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
 		return FALSE;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_clear_results_async (client, device_id, cancellable,
+					  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_clear_results_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_get_results_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets the results of a previous firmware update for a specific device.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_results_async (FwupdClient *client,
+				const gchar *device_id,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetResults",
+				      g_variant_new ("(s)", device_id), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_results_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_results_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_results_async().
+ *
+ * Returns: (transfer full): a #FwupdDevice, or %NULL for failure
+ *
+ * Since: 1.2.6
+ **/
+FwupdDevice *
+fwupd_client_get_results_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	return fwupd_device_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_results:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets the results of a previous firmware update for a specific device.
+ *
+ * Returns: (transfer full): a #FwupdDevice, or %NULL for failure
+ *
+ * Since: 0.7.0
+ **/
+FwupdDevice *
+fwupd_client_get_results (FwupdClient *client, const gchar *device_id,
+			  GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_get_results_async (client, device_id, cancellable,
+					fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_results_finish (client, helper->res, error);
+}
+
+/* takes ownership of @fd */
+static void
+fwupd_client_install_fd_async (FwupdClient *client,
+			       const gchar *device_id,
+			       gint fd,
+			       const gchar *filename,
+			       FwupdInstallFlags install_flags,
+			       FwupdClientProgressFunc progress_cb,
+			       gpointer progress_data,
+			       GCancellable *cancellable,
+			       GAsyncReadyCallback callback,
+			       gpointer callback_data,
+			       gpointer source_tag)
+{
+	GTask *task;
+	GVariantBuilder builder;
+	gint idx;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	/* set options */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
+	g_variant_builder_add (&builder, "{sv}",
+			       "reason", g_variant_new_string ("user-action"));
+	if (filename != NULL) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "filename", g_variant_new_string (filename));
 	}
-	return TRUE;
+	if (install_flags & FWUPD_INSTALL_FLAG_OFFLINE) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "offline", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_OLDER) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "allow-older", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_REINSTALL) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "allow-reinstall", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_FORCE) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "force", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_NO_HISTORY) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "no-history", g_variant_new_boolean (TRUE));
+	}
+
+	/* set out of band file descriptor */
+	fd_list = g_unix_fd_list_new ();
+	idx = g_unix_fd_list_append (fd_list, fd, NULL);
+	g_assert (idx != -1);
+
+	/* g_unix_fd_list_append did a dup() already */
+	close (fd);
+
+	/* call into daemon */
+	task = fwupd_client_call_new (client, "Install",
+				      g_variant_new ("(sha{sv})", device_id, idx, &builder),
+				      fd_list, G_MAXINT,
+				      cancellable, callback, callback_data,
+				      source_tag);
+	fwupd_client_call_set_progress (task, progress_cb, progress_data);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_install_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @filename: the filename to install
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
+ * @progress_cb: (scope async): a #FwupdClientProgressFunc, or %NULL
+ * @progress_data: the data to pass to @progress_cb
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Install a file onto a specific device without blocking. The daemon status
+ * and percentage are passed to @progress_cb until the install completes.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_install_async (FwupdClient *client,
+			    const gchar *device_id,
+			    const gchar *filename,
+			    FwupdInstallFlags install_flags,
+			    FwupdClientProgressFunc progress_cb,
+			    gpointer progress_data,
+			    GCancellable *cancellable,
+			    GAsyncReadyCallback callback,
+			    gpointer callback_data)
+{
+	gint fd;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (filename != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* open file */
+	fd = open (filename, O_RDONLY);
+	if (fd < 0) {
+		g_task_report_new_error (client, callback, callback_data,
+					 fwupd_client_install_async,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_INVALID_FILE,
+					 "failed to open %s",
+					 filename);
+		return;
+	}
+	fwupd_client_install_fd_async (client, device_id, fd, filename,
+				       install_flags, progress_cb, progress_data,
+				       cancellable, callback, callback_data,
+				       fwupd_client_install_async);
+}
+
+/**
+ * fwupd_client_install_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_install_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_install_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
 }
 
 /**
- * fwupd_client_verify:
+ * fwupd_client_install:
  * @client: A #FwupdClient
  * @device_id: the device ID
+ * @filename: the filename to install
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Verify a specific device.
+ * Install a file onto a specific device.
  *
- * Returns: %TRUE for verification success
+ * Returns: %TRUE for success
  *
  * Since: 0.7.0
  **/
 gboolean
-fwupd_client_verify (FwupdClient *client, const gchar *device_id,
-		     GCancellable *cancellable, GError **error)
+fwupd_client_install (FwupdClient *client,
+		      const gchar *device_id,
+		      const gchar *filename,
+		      FwupdInstallFlags install_flags,
+		      GCancellable *cancellable,
+		      GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
@@ -722,142 +2077,117 @@ fwupd_client_verify (FwupdClient *client, const gchar *device_id,
 		return FALSE;
 
 	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	g_dbus_proxy_call (priv->proxy,
-			   "Verify",
-			   g_variant_new ("(s)", device_id),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   cancellable,
-			   fwupd_client_proxy_call_cb,
-			   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return FALSE;
-	}
-	return TRUE;
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_install_async (client, device_id, filename, install_flags,
+				    NULL, NULL, cancellable,
+				    fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_install_finish (client, helper->res, error);
 }
 
 /**
- * fwupd_client_verify_update:
+ * fwupd_client_install_bytes_async:
  * @client: A #FwupdClient
  * @device_id: the device ID
+ * @bytes: cabinet archive
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
+ * @progress_cb: (scope async): a #FwupdClientProgressFunc, or %NULL
+ * @progress_data: the data to pass to @progress_cb
  * @cancellable: the #GCancellable, or %NULL
- * @error: the #GError, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
  *
- * Update the verification record for a specific device.
+ * Install firmware from memory onto a specific device without blocking.
  *
- * Returns: %TRUE for verification success
+ * The data is passed to the daemon in a sealed memfd, which means it can be
+ * used without copying and cannot be modified once it has been validated.
  *
- * Since: 0.8.0
+ * Since: 1.2.6
  **/
-gboolean
-fwupd_client_verify_update (FwupdClient *client, const gchar *device_id,
-		     GCancellable *cancellable, GError **error)
+void
+fwupd_client_install_bytes_async (FwupdClient *client,
+				  const gchar *device_id,
+				  GBytes *bytes,
+				  FwupdInstallFlags install_flags,
+				  FwupdClientProgressFunc progress_cb,
+				  gpointer progress_data,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(FwupdClientHelper) helper = NULL;
-
-	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
-	g_return_val_if_fail (device_id != NULL, FALSE);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	gint fd;
+	GError *error = NULL;
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return FALSE;
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (bytes != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
-	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	g_dbus_proxy_call (priv->proxy,
-			   "VerifyUpdate",
-			   g_variant_new ("(s)", device_id),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   cancellable,
-			   fwupd_client_proxy_call_cb,
-			   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return FALSE;
+	fd = fwupd_client_bytes_to_fd (bytes, &error);
+	if (fd < 0) {
+		g_task_report_error (client, callback, callback_data,
+				     fwupd_client_install_bytes_async, error);
+		return;
 	}
-	return TRUE;
+	fwupd_client_install_fd_async (client, device_id, fd, NULL,
+				       install_flags, progress_cb, progress_data,
+				       cancellable, callback, callback_data,
+				       fwupd_client_install_bytes_async);
 }
 
 /**
- * fwupd_client_unlock:
+ * fwupd_client_install_bytes_finish:
  * @client: A #FwupdClient
- * @device_id: the device ID
- * @cancellable: the #GCancellable, or %NULL
+ * @res: the #GAsyncResult
  * @error: the #GError, or %NULL
  *
- * Unlocks a specific device so firmware can be read or wrote.
+ * Gets the result of fwupd_client_install_bytes_async().
  *
  * Returns: %TRUE for success
  *
- * Since: 0.7.0
+ * Since: 1.2.6
  **/
 gboolean
-fwupd_client_unlock (FwupdClient *client, const gchar *device_id,
-		     GCancellable *cancellable, GError **error)
+fwupd_client_install_bytes_finish (FwupdClient *client, GAsyncResult *res, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(FwupdClientHelper) helper = NULL;
+	g_autoptr(GVariant) val = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
-	g_return_val_if_fail (device_id != NULL, FALSE);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return FALSE;
-
-	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	g_dbus_proxy_call (priv->proxy,
-			   "Unlock",
-			   g_variant_new ("(s)", device_id),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   cancellable,
-			   fwupd_client_proxy_call_cb,
-			   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return FALSE;
-	}
-	return TRUE;
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
 }
 
 /**
- * fwupd_client_clear_results:
+ * fwupd_client_install_bytes:
  * @client: A #FwupdClient
  * @device_id: the device ID
+ * @bytes: cabinet archive
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Clears the results for a specific device.
+ * Install firmware from memory onto a specific device.
  *
  * Returns: %TRUE for success
  *
- * Since: 0.7.0
+ * Since: 1.2.6
  **/
 gboolean
-fwupd_client_clear_results (FwupdClient *client, const gchar *device_id,
-			    GCancellable *cancellable, GError **error)
+fwupd_client_install_bytes (FwupdClient *client,
+			    const gchar *device_id,
+			    GBytes *bytes,
+			    FwupdInstallFlags install_flags,
+			    GCancellable *cancellable,
+			    GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (bytes != NULL, FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
@@ -866,46 +2196,133 @@ fwupd_client_clear_results (FwupdClient *client, const gchar *device_id,
 		return FALSE;
 
 	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	g_dbus_proxy_call (priv->proxy,
-			   "ClearResults",
-			   g_variant_new ("(s)", device_id),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   cancellable,
-			   fwupd_client_proxy_call_cb,
-			   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return FALSE;
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_install_bytes_async (client, device_id, bytes, install_flags,
+					  NULL, NULL, cancellable,
+					  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_install_bytes_finish (client, helper->res, error);
+}
+
+/* takes ownership of @fd */
+static void
+fwupd_client_get_details_fd_async (FwupdClient *client,
+				   gint fd,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data,
+				   gpointer source_tag)
+{
+	GTask *task;
+	gint idx;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	/* set out of band file descriptor */
+	fd_list = g_unix_fd_list_new ();
+	idx = g_unix_fd_list_append (fd_list, fd, NULL);
+	g_assert (idx != -1);
+
+	/* g_unix_fd_list_append did a dup() already */
+	close (fd);
+
+	/* call into daemon */
+	task = fwupd_client_call_new (client, "GetDetails",
+				      g_variant_new ("(h)", idx),
+				      fd_list, -1,
+				      cancellable, callback, callback_data,
+				      source_tag);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_details_async:
+ * @client: A #FwupdClient
+ * @filename: the firmware filename, e.g. `firmware.cab`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets details about a specific firmware file.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_details_async (FwupdClient *client,
+				const gchar *filename,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer callback_data)
+{
+	gint fd;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (filename != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* open file */
+	fd = open (filename, O_RDONLY);
+	if (fd < 0) {
+		g_task_report_new_error (client, callback, callback_data,
+					 fwupd_client_get_details_async,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_INVALID_FILE,
+					 "failed to open %s",
+					 filename);
+		return;
 	}
-	return TRUE;
+	fwupd_client_get_details_fd_async (client, fd, cancellable,
+					   callback, callback_data,
+					   fwupd_client_get_details_async);
 }
 
 /**
- * fwupd_client_get_results:
+ * fwupd_client_get_details_finish:
  * @client: A #FwupdClient
- * @device_id: the device ID
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_details_async().
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): an array of results
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fwupd_client_get_details_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	return fwupd_client_parse_devices_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_details:
+ * @client: A #FwupdClient
+ * @filename: the firmware filename, e.g. `firmware.cab`
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Gets the results of a previous firmware update for a specific device.
+ * Gets details about a specific firmware file.
  *
- * Returns: (transfer full): a #FwupdDevice, or %NULL for failure
+ * Returns: (transfer container) (element-type FwupdDevice): an array of results
  *
- * Since: 0.7.0
+ * Since: 1.0.0
  **/
-FwupdDevice *
-fwupd_client_get_results (FwupdClient *client, const gchar *device_id,
+GPtrArray *
+fwupd_client_get_details (FwupdClient *client, const gchar *filename,
 			  GCancellable *cancellable, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (filename != NULL, NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
@@ -914,184 +2331,99 @@ fwupd_client_get_results (FwupdClient *client, const gchar *device_id,
 		return NULL;
 
 	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	g_dbus_proxy_call (priv->proxy,
-			   "GetResults",
-			   g_variant_new ("(s)", device_id),
-			   G_DBUS_CALL_FLAGS_NONE,
-			   -1,
-			   cancellable,
-			   fwupd_client_proxy_call_cb,
-			   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return NULL;
-	}
-	return fwupd_device_from_variant (helper->val);
-}
-
-static void
-fwupd_client_send_message_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
-{
-	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
-	GDBusConnection *con = G_DBUS_CONNECTION (source_object);
-	helper->message = g_dbus_connection_send_message_with_reply_finish (con, res,
-									    &helper->error);
-	if (helper->message &&
-	    !g_dbus_message_to_gerror (helper->message, &helper->error)) {
-		helper->ret = TRUE;
-		helper->val = g_dbus_message_get_body (helper->message);
-		if (helper->val != NULL)
-			g_variant_ref (helper->val);
-	}
-	if (helper->error != NULL)
-		fwupd_client_fixup_dbus_error (helper->error);
-	g_main_loop_quit (helper->loop);
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_get_details_async (client, filename, cancellable,
+					fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_details_finish (client, helper->res, error);
 }
 
 /**
- * fwupd_client_install:
+ * fwupd_client_get_details_bytes_async:
  * @client: A #FwupdClient
- * @device_id: the device ID
- * @filename: the filename to install
- * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
+ * @bytes: cabinet archive
  * @cancellable: the #GCancellable, or %NULL
- * @error: the #GError, or %NULL
- *
- * Install a file onto a specific device.
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
  *
- * Returns: %TRUE for success
+ * Gets details about firmware held in memory. The data is passed to the
+ * daemon in a sealed memfd so that it can be used without copying.
  *
- * Since: 0.7.0
+ * Since: 1.2.6
  **/
-gboolean
-fwupd_client_install (FwupdClient *client,
-		      const gchar *device_id,
-		      const gchar *filename,
-		      FwupdInstallFlags install_flags,
-		      GCancellable *cancellable,
-		      GError **error)
+void
+fwupd_client_get_details_bytes_async (FwupdClient *client,
+				      GBytes *bytes,
+				      GCancellable *cancellable,
+				      GAsyncReadyCallback callback,
+				      gpointer callback_data)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariant *body;
-	GVariantBuilder builder;
-	gint retval;
 	gint fd;
-	g_autoptr(FwupdClientHelper) helper = NULL;
-	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
-
-	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
-	g_return_val_if_fail (device_id != NULL, FALSE);
-	g_return_val_if_fail (filename != NULL, FALSE);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return FALSE;
+	GError *error = NULL;
 
-	/* set options */
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-	g_variant_builder_add (&builder, "{sv}",
-			       "reason", g_variant_new_string ("user-action"));
-	g_variant_builder_add (&builder, "{sv}",
-			       "filename", g_variant_new_string (filename));
-	if (install_flags & FWUPD_INSTALL_FLAG_OFFLINE) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "offline", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_OLDER) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "allow-older", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_REINSTALL) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "allow-reinstall", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_FORCE) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "force", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_NO_HISTORY) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "no-history", g_variant_new_boolean (TRUE));
-	}
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (bytes != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
-	/* open file */
-	fd = open (filename, O_RDONLY);
+	fd = fwupd_client_bytes_to_fd (bytes, &error);
 	if (fd < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     filename);
-		return FALSE;
+		g_task_report_error (client, callback, callback_data,
+				     fwupd_client_get_details_bytes_async, error);
+		return;
 	}
+	fwupd_client_get_details_fd_async (client, fd, cancellable,
+					   callback, callback_data,
+					   fwupd_client_get_details_bytes_async);
+}
 
-	/* set out of band file descriptor */
-	fd_list = g_unix_fd_list_new ();
-	retval = g_unix_fd_list_append (fd_list, fd, NULL);
-	g_assert (retval != -1);
-	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
-						  FWUPD_DBUS_PATH,
-						  FWUPD_DBUS_INTERFACE,
-						  "Install");
-	g_dbus_message_set_unix_fd_list (request, fd_list);
+/**
+ * fwupd_client_get_details_bytes_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_details_bytes_async().
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): an array of results
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fwupd_client_get_details_bytes_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
 
-	/* g_unix_fd_list_append did a dup() already */
-	close (fd);
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	body = g_variant_new ("(sha{sv})", device_id, fd, &builder);
-	g_dbus_message_set_body (request, body);
-	g_dbus_connection_send_message_with_reply (priv->conn,
-						   request,
-						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   G_MAXINT,
-						   NULL,
-						   cancellable,
-						   fwupd_client_send_message_cb,
-						   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return FALSE;
-	}
-	return TRUE;
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	return fwupd_client_parse_devices_from_variant (val);
 }
 
 /**
- * fwupd_client_get_details:
+ * fwupd_client_get_details_bytes:
  * @client: A #FwupdClient
- * @filename: the firmware filename, e.g. `firmware.cab`
+ * @bytes: cabinet archive
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Gets details about a specific firmware file.
+ * Gets details about firmware held in memory.
  *
  * Returns: (transfer container) (element-type FwupdDevice): an array of results
  *
- * Since: 1.0.0
+ * Since: 1.2.6
  **/
 GPtrArray *
-fwupd_client_get_details (FwupdClient *client, const gchar *filename,
-			  GCancellable *cancellable, GError **error)
+fwupd_client_get_details_bytes (FwupdClient *client, GBytes *bytes,
+				GCancellable *cancellable, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariant *body;
-	gint fd;
-	gint retval;
 	g_autoptr(FwupdClientHelper) helper = NULL;
-	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (filename != NULL, NULL);
+	g_return_val_if_fail (bytes != NULL, NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
@@ -1099,52 +2431,12 @@ fwupd_client_get_details (FwupdClient *client, const gchar *filename,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return NULL;
 
-	/* open file */
-	fd = open (filename, O_RDONLY);
-	if (fd < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     filename);
-		return NULL;
-	}
-
-	/* set out of band file descriptor */
-	fd_list = g_unix_fd_list_new ();
-	retval = g_unix_fd_list_append (fd_list, fd, NULL);
-	g_assert (retval != -1);
-	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
-						  FWUPD_DBUS_PATH,
-						  FWUPD_DBUS_INTERFACE,
-						  "GetDetails");
-	g_dbus_message_set_unix_fd_list (request, fd_list);
-
-	/* g_unix_fd_list_append did a dup() already */
-	close (fd);
-
 	/* call into daemon */
-	helper = fwupd_client_helper_new ();
-	body = g_variant_new ("(h)", fd);
-	g_dbus_message_set_body (request, body);
-
-	g_dbus_connection_send_message_with_reply (priv->conn,
-						   request,
-						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   -1,
-						   NULL,
-						   cancellable,
-						   fwupd_client_send_message_cb,
-						   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return NULL;
-	}
-
-	/* return results */
-	return fwupd_client_parse_devices_from_variant (helper->val);
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_get_details_bytes_async (client, bytes, cancellable,
+					      fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_details_bytes_finish (client, helper->res, error);
 }
 
 /**
@@ -1219,6 +2511,109 @@ fwupd_client_get_tainted (FwupdClient *client)
 	return priv->tainted;
 }
 
+/**
+ * fwupd_client_update_metadata_async:
+ * @client: A #FwupdClient
+ * @remote_id: the remote ID, e.g. `lvfs-testing`
+ * @metadata_fn: the XML metadata filename
+ * @signature_fn: the GPG signature file
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Updates the metadata without blocking. See fwupd_client_update_metadata()
+ * for more details.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_update_metadata_async (FwupdClient *client,
+				    const gchar *remote_id,
+				    const gchar *metadata_fn,
+				    const gchar *signature_fn,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer callback_data)
+{
+	GTask *task;
+	gint fd;
+	gint fd_sig;
+	gint idx;
+	gint idx_sig;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (metadata_fn != NULL);
+	g_return_if_fail (signature_fn != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* open file */
+	fd = open (metadata_fn, O_RDONLY);
+	if (fd < 0) {
+		g_task_report_new_error (client, callback, callback_data,
+					 fwupd_client_update_metadata_async,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_INVALID_FILE,
+					 "failed to open %s",
+					 metadata_fn);
+		return;
+	}
+	fd_sig = open (signature_fn, O_RDONLY);
+	if (fd_sig < 0) {
+		close (fd);
+		g_task_report_new_error (client, callback, callback_data,
+					 fwupd_client_update_metadata_async,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_INVALID_FILE,
+					 "failed to open %s",
+					 signature_fn);
+		return;
+	}
+
+	/* set out of band file descriptor */
+	fd_list = g_unix_fd_list_new ();
+	idx = g_unix_fd_list_append (fd_list, fd, NULL);
+	idx_sig = g_unix_fd_list_append (fd_list, fd_sig, NULL);
+
+	/* g_unix_fd_list_append did a dup() already */
+	close (fd);
+	close (fd_sig);
+
+	/* call into daemon */
+	task = fwupd_client_call_new (client, "UpdateMetadata",
+				      g_variant_new ("(shh)", remote_id, idx, idx_sig),
+				      fd_list, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_update_metadata_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_update_metadata_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_update_metadata_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_update_metadata_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
+}
+
 /**
  * fwupd_client_update_metadata:
  * @client: A #FwupdClient
@@ -1247,13 +2642,7 @@ fwupd_client_update_metadata (FwupdClient *client,
 			      GCancellable *cancellable,
 			      GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariant *body;
-	gint fd;
-	gint fd_sig;
 	g_autoptr(FwupdClientHelper) helper = NULL;
-	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (remote_id != NULL, FALSE);
@@ -1266,60 +2655,70 @@ fwupd_client_update_metadata (FwupdClient *client,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return FALSE;
 
-	/* open file */
-	fd = open (metadata_fn, O_RDONLY);
-	if (fd < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     metadata_fn);
-		return FALSE;
-	}
-	fd_sig = open (signature_fn, O_RDONLY);
-	if (fd_sig < 0) {
-		close (fd);
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     signature_fn);
-		return FALSE;
-	}
+	/* call into daemon */
+	helper = fwupd_client_helper_new (FALSE);
+	fwupd_client_update_metadata_async (client, remote_id,
+					    metadata_fn, signature_fn,
+					    cancellable,
+					    fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_update_metadata_finish (client, helper->res, error);
+}
 
-	/* set out of band file descriptor */
-	fd_list = g_unix_fd_list_new ();
-	g_unix_fd_list_append (fd_list, fd, NULL);
-	g_unix_fd_list_append (fd_list, fd_sig, NULL);
-	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
-						  FWUPD_DBUS_PATH,
-						  FWUPD_DBUS_INTERFACE,
-						  "UpdateMetadata");
-	g_dbus_message_set_unix_fd_list (request, fd_list);
+/**
+ * fwupd_client_get_remotes_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets the list of remotes that have been configured for the system.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_remotes_async (FwupdClient *client,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer callback_data)
+{
+	GTask *task;
 
-	/* g_unix_fd_list_append did a dup() already */
-	close (fd);
-	close (fd_sig);
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
-	/* call into daemon */
-	body = g_variant_new ("(shh)", remote_id, fd, fd_sig);
-	g_dbus_message_set_body (request, body);
-	helper = fwupd_client_helper_new ();
-	g_dbus_connection_send_message_with_reply (priv->conn,
-						   request,
-						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
-						   -1,
-						   NULL,
-						   cancellable,
-						   fwupd_client_send_message_cb,
-						   helper);
-	g_main_loop_run (helper->loop);
-	if (!helper->ret) {
-		g_propagate_error (error, helper->error);
-		helper->error = NULL;
-		return FALSE;
-	}
-	return TRUE;
+	task = fwupd_client_call_new (client, "GetRemotes",
+				      NULL, NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_remotes_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_remotes_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_remotes_async().
+ *
+ * Returns: (element-type FwupdRemote) (transfer container): list of remotes, or %NULL
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fwupd_client_get_remotes_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	return fwupd_client_parse_remotes_from_data (val);
 }
 
 /**
@@ -1328,17 +2727,204 @@ fwupd_client_update_metadata (FwupdClient *client,
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Gets the list of remotes that have been configured for the system.
+ * Gets the list of remotes that have been configured for the system.
+ *
+ * Returns: (element-type FwupdRemote) (transfer container): list of remotes, or %NULL
+ *
+ * Since: 0.9.3
+ **/
+GPtrArray *
+fwupd_client_get_remotes (FwupdClient *client, GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_remotes_async (client, cancellable,
+					fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_remotes_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_get_approved_firmware_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets the list of approved firmware.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_approved_firmware_async (FwupdClient *client,
+					  GCancellable *cancellable,
+					  GAsyncReadyCallback callback,
+					  gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetApprovedFirmware",
+				      NULL, NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_approved_firmware_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_approved_firmware_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_approved_firmware_async().
+ *
+ * Returns: (transfer full): list of remotes, or %NULL
+ *
+ * Since: 1.2.6
+ **/
+gchar **
+fwupd_client_get_approved_firmware_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+	gchar **retval = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	g_variant_get (val, "(^as)", &retval);
+	return retval;
+}
+
+/**
+ * fwupd_client_get_approved_firmware:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets the list of approved firmware.
+ *
+ * Returns: (transfer full): list of remotes, or %NULL
+ *
+ * Since: 1.2.6
+ **/
+gchar **
+fwupd_client_get_approved_firmware (FwupdClient *client,
+				    GCancellable *cancellable,
+				    GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_approved_firmware_async (client, cancellable,
+						  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_approved_firmware_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_get_stats_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets the performance counters kept by the daemon.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_stats_async (FwupdClient *client,
+			      GCancellable *cancellable,
+			      GAsyncReadyCallback callback,
+			      gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "GetStats",
+				      NULL, NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_get_stats_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_get_stats_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_stats_async().
+ *
+ * Returns: (transfer full): a #GVariant of type `a{sa{sv}}`, or %NULL
+ *
+ * Since: 1.2.6
+ **/
+GVariant *
+fwupd_client_get_stats_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+	GVariant *retval = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	g_variant_get (val, "(@a{sa{sv}})", &retval);
+	return retval;
+}
+
+/**
+ * fwupd_client_get_stats:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets the performance counters kept by the daemon since it was started.
+ * Each ID maps to a dictionary with the keys `Count`, `Total`, `Min` and
+ * `Max`, and for durations in microseconds also `Histogram`.
  *
- * Returns: (element-type FwupdRemote) (transfer container): list of remotes, or %NULL
+ * Returns: (transfer full): a #GVariant of type `a{sa{sv}}`, or %NULL
  *
- * Since: 0.9.3
+ * Since: 1.2.6
  **/
-GPtrArray *
-fwupd_client_get_remotes (FwupdClient *client, GCancellable *cancellable, GError **error)
+GVariant *
+fwupd_client_get_stats (FwupdClient *client,
+			GCancellable *cancellable,
+			GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
@@ -1349,65 +2935,67 @@ fwupd_client_get_remotes (FwupdClient *client, GCancellable *cancellable, GError
 		return NULL;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetRemotes",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
-	}
-	return fwupd_client_parse_remotes_from_data (val);
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_get_stats_async (client, cancellable,
+				      fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_get_stats_finish (client, helper->res, error);
 }
 
 /**
- * fwupd_client_get_approved_firmware:
+ * fwupd_client_set_approved_firmware_async:
  * @client: A #FwupdClient
+ * @checksums: Array of checksums
  * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Sets the list of approved firmware.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_set_approved_firmware_async (FwupdClient *client,
+					  gchar **checksums,
+					  GCancellable *cancellable,
+					  GAsyncReadyCallback callback,
+					  gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "SetApprovedFirmware",
+				      g_variant_new ("(^as)", checksums), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_set_approved_firmware_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_set_approved_firmware_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
  * @error: the #GError, or %NULL
  *
- * Gets the list of approved firmware.
+ * Gets the result of fwupd_client_set_approved_firmware_async().
  *
- * Returns: (transfer full): list of remotes, or %NULL
+ * Returns: %TRUE for success
  *
  * Since: 1.2.6
  **/
-gchar **
-fwupd_client_get_approved_firmware (FwupdClient *client,
-				    GCancellable *cancellable,
-				    GError **error)
+gboolean
+fwupd_client_set_approved_firmware_finish (FwupdClient *client, GAsyncResult *res, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(GVariant) val = NULL;
-	gchar **retval = NULL;
-
-	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return NULL;
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetApprovedFirmware",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
-	}
-	g_variant_get (val, "(^as)", &retval);
-	return retval;
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
 }
 
 /**
@@ -1429,8 +3017,7 @@ fwupd_client_set_approved_firmware (FwupdClient *client,
 				    GCancellable *cancellable,
 				    GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
@@ -1441,19 +3028,88 @@ fwupd_client_set_approved_firmware (FwupdClient *client,
 		return FALSE;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "SetApprovedFirmware",
-				      g_variant_new ("(^as)", checksums),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return FALSE;
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_set_approved_firmware_async (client, checksums, cancellable,
+						  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_set_approved_firmware_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_self_sign_async:
+ * @client: A #FwupdClient
+ * @value: A string to sign, typically a JSON blob
+ * @flags: #FwupdSelfSignFlags, e.g. %FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Signs the data using the client self-signed certificate.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_self_sign_async (FwupdClient *client,
+			      const gchar *value,
+			      FwupdSelfSignFlags flags,
+			      GCancellable *cancellable,
+			      GAsyncReadyCallback callback,
+			      gpointer callback_data)
+{
+	GTask *task;
+	GVariantBuilder builder;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* set options */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
+	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "add-timestamp", g_variant_new_boolean (TRUE));
 	}
-	return TRUE;
+	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_CERT) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "add-cert", g_variant_new_boolean (TRUE));
+	}
+
+	/* call into daemon */
+	task = fwupd_client_call_new (client, "SelfSign",
+				      g_variant_new ("(sa{sv})", value, &builder),
+				      NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_self_sign_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_self_sign_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_self_sign_async().
+ *
+ * Returns: a signature, or %NULL for failure
+ *
+ * Since: 1.2.6
+ **/
+gchar *
+fwupd_client_self_sign_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+	gchar *retval = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	if (val == NULL)
+		return NULL;
+	g_variant_get (val, "(s)", &retval);
+	return retval;
 }
 
 /**
@@ -1477,12 +3133,10 @@ fwupd_client_self_sign (FwupdClient *client,
 			GCancellable *cancellable,
 			GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariantBuilder builder;
-	g_autoptr(GVariant) val = NULL;
-	gchar *retval = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (value != NULL, NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
@@ -1490,32 +3144,77 @@ fwupd_client_self_sign (FwupdClient *client,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return NULL;
 
-	/* set options */
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "add-timestamp", g_variant_new_boolean (TRUE));
-	}
-	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_CERT) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "add-cert", g_variant_new_boolean (TRUE));
-	}
-
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "SelfSign",
-				      g_variant_new ("(sa{sv})", value, &builder),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
-	}
-	g_variant_get (val, "(s)", &retval);
-	return retval;
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_self_sign_async (client, value, flags, cancellable,
+				      fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_self_sign_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_modify_remote_async:
+ * @client: A #FwupdClient
+ * @remote_id: the remote ID, e.g. `lvfs-testing`
+ * @key: the key, e.g. `Enabled`
+ * @value: the key, e.g. `true`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Modifies a system remote in a specific way.
+ *
+ * NOTE: User authentication may be required to complete this action.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_modify_remote_async (FwupdClient *client,
+				  const gchar *remote_id,
+				  const gchar *key,
+				  const gchar *value,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "ModifyRemote",
+				      g_variant_new ("(sss)", remote_id, key, value), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_modify_remote_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_modify_remote_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_modify_remote_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_modify_remote_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
 }
 
 /**
@@ -1543,8 +3242,7 @@ fwupd_client_modify_remote (FwupdClient *client,
 			    GCancellable *cancellable,
 			    GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (remote_id != NULL, FALSE);
@@ -1558,19 +3256,77 @@ fwupd_client_modify_remote (FwupdClient *client,
 		return FALSE;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "ModifyRemote",
-				      g_variant_new ("(sss)", remote_id, key, value),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return FALSE;
-	}
-	return TRUE;
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_modify_remote_async (client, remote_id, key, value, cancellable,
+					  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_modify_remote_finish (client, helper->res, error);
+}
+
+/**
+ * fwupd_client_modify_device_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @key: the key, e.g. `Flags`
+ * @value: the key, e.g. `reported`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Modifies a device in a specific way. Not all properties on the #FwupdDevice
+ * are settable by the client, and some may have other restrictions on @value.
+ *
+ * NOTE: User authentication may be required to complete this action.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_modify_device_async (FwupdClient *client,
+				  const gchar *device_id,
+				  const gchar *key,
+				  const gchar *value,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = fwupd_client_call_new (client, "ModifyDevice",
+				      g_variant_new ("(sss)", device_id, key, value), NULL, -1,
+				      cancellable, callback, callback_data,
+				      fwupd_client_modify_device_async);
+	fwupd_client_call_run (client, task);
+}
+
+/**
+ * fwupd_client_modify_device_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_modify_device_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fwupd_client_modify_device_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	val = g_task_propagate_pointer (G_TASK (res), error);
+	return val != NULL;
 }
 
 /**
@@ -1593,17 +3349,16 @@ fwupd_client_modify_remote (FwupdClient *client,
  **/
 gboolean
 fwupd_client_modify_device (FwupdClient *client,
-			    const gchar *remote_id,
+			    const gchar *device_id,
 			    const gchar *key,
 			    const gchar *value,
 			    GCancellable *cancellable,
 			    GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	g_autoptr(FwupdClientHelper) helper = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
-	g_return_val_if_fail (remote_id != NULL, FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
 	g_return_val_if_fail (key != NULL, FALSE);
 	g_return_val_if_fail (value != NULL, FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
@@ -1614,19 +3369,11 @@ fwupd_client_modify_device (FwupdClient *client,
 		return FALSE;
 
 	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "ModifyDevice",
-				      g_variant_new ("(sss)", remote_id, key, value),
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return FALSE;
-	}
-	return TRUE;
+	helper = fwupd_client_helper_new (TRUE);
+	fwupd_client_modify_device_async (client, device_id, key, value, cancellable,
+					  fwupd_client_helper_cb, helper);
+	fwupd_client_helper_run (helper);
+	return fwupd_client_modify_device_finish (client, helper->res, error);
 }
 
 static FwupdRemote *
@@ -1640,6 +3387,87 @@ fwupd_client_get_remote_by_id_noref (GPtrArray *remotes, const gchar *remote_id)
 	return NULL;
 }
 
+static void
+fwupd_client_get_remote_by_id_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	const gchar *remote_id = g_task_get_task_data (task);
+	FwupdRemote *remote;
+	GError *error = NULL;
+	g_autoptr(GPtrArray) remotes = NULL;
+
+	/* find remote in list */
+	remotes = fwupd_client_get_remotes_finish (FWUPD_CLIENT (source), res, &error);
+	if (remotes == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+	remote = fwupd_client_get_remote_by_id_noref (remotes, remote_id);
+	if (remote == NULL) {
+		g_task_return_new_error (task,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_NOT_FOUND,
+					 "No remote '%s' found in search paths",
+					 remote_id);
+		return;
+	}
+	g_task_return_pointer (task, g_object_ref (remote),
+			       (GDestroyNotify) g_object_unref);
+}
+
+/**
+ * fwupd_client_get_remote_by_id_async:
+ * @client: A #FwupdClient
+ * @remote_id: the remote ID, e.g. `lvfs-testing`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets a specific remote that has been configured for the system.
+ *
+ * Since: 1.2.6
+ **/
+void
+fwupd_client_get_remote_by_id_async (FwupdClient *client,
+				     const gchar *remote_id,
+				     GCancellable *cancellable,
+				     GAsyncReadyCallback callback,
+				     gpointer callback_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (client, cancellable, callback, callback_data);
+	g_task_set_source_tag (task, fwupd_client_get_remote_by_id_async);
+	g_task_set_task_data (task, g_strdup (remote_id), g_free);
+	fwupd_client_get_remotes_async (client, cancellable,
+					fwupd_client_get_remote_by_id_cb, task);
+}
+
+/**
+ * fwupd_client_get_remote_by_id_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_remote_by_id_async().
+ *
+ * Returns: (transfer full): a #FwupdRemote, or %NULL if not found
+ *
+ * Since: 1.2.6
+ **/
+FwupdRemote *
+fwupd_client_get_remote_by_id_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_remote_by_id:
  * @client: A #FwupdClient
@@ -1874,6 +3702,8 @@ fwupd_client_class_init (FwupdClientClass *klass)
 static void
 fwupd_client_init (FwupdClient *client)
 {
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	priv->pending = g_ptr_array_new ();
 }
 
 static void
@@ -1883,6 +3713,7 @@ fwupd_client_finalize (GObject *object)
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
 
 	g_free (priv->daemon_version);
+	g_ptr_array_unref (priv->pending);
 	if (priv->conn != NULL)
 		g_object_unref (priv->conn);
 	if (priv->proxy != NULL)
@@ -40,6 +40,20 @@ struct _FwupdClientClass
 	void (*_fwupd_reserved7)	(void);
 };
 
+/**
+ * FwupdClientProgressFunc:
+ * @client: A #FwupdClient
+ * @status: the daemon #FwupdStatus
+ * @percentage: the daemon percentage, or 0 for unknown
+ * @user_data: the data passed when the request was made
+ *
+ * The progress of a long-running asynchronous request.
+ **/
+typedef void	(*FwupdClientProgressFunc)		(FwupdClient	*client,
+							 FwupdStatus	 status,
+							 guint		 percentage,
+							 gpointer	 user_data);
+
 FwupdClient	*fwupd_client_new			(void);
 gboolean	 fwupd_client_connect			(FwupdClient	*client,
 							 GCancellable	*cancellable,
@@ -100,6 +114,16 @@ gboolean	 fwupd_client_install			(FwupdClient	*client,
 							 FwupdInstallFlags install_flags,
 							 GCancellable	*cancellable,
 							 GError		**error);
+gboolean	 fwupd_client_install_bytes		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GBytes		*bytes,
+							 FwupdInstallFlags install_flags,
+							 GCancellable	*cancellable,
+							 GError		**error);
+GPtrArray	*fwupd_client_get_details_bytes		(FwupdClient	*client,
+							 GBytes		*bytes,
+							 GCancellable	*cancellable,
+							 GError		**error);
 gboolean	 fwupd_client_update_metadata		(FwupdClient	*client,
 							 const gchar	*remote_id,
 							 const gchar	*metadata_fn,
@@ -138,10 +162,231 @@ gboolean	 fwupd_client_set_approved_firmware	(FwupdClient	*client,
 							 gchar		**checksums,
 							 GCancellable	*cancellable,
 							 GError		**error);
+GVariant	*fwupd_client_get_stats			(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
 gchar		*fwupd_client_self_sign			(FwupdClient	*client,
 							 const gchar	*value,
 							 FwupdSelfSignFlags flags,
 							 GCancellable	*cancellable,
 							 GError		**error);
 
+void		 fwupd_client_connect_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_connect_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_devices_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_devices_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_history_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_history_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_releases_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_releases_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_downgrades_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_downgrades_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_upgrades_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_upgrades_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_details_async		(FwupdClient	*client,
+							 const gchar	*filename,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_details_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_verify_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_verify_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_verify_update_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_verify_update_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_unlock_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_unlock_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_activate_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_activate_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_clear_results_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_clear_results_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_results_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+FwupdDevice	*fwupd_client_get_results_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_device_by_id_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+FwupdDevice	*fwupd_client_get_device_by_id_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_install_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 const gchar	*filename,
+							 FwupdInstallFlags install_flags,
+							 FwupdClientProgressFunc progress_cb,
+							 gpointer	 progress_data,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_install_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_install_bytes_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GBytes		*bytes,
+							 FwupdInstallFlags install_flags,
+							 FwupdClientProgressFunc progress_cb,
+							 gpointer	 progress_data,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_install_bytes_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_details_bytes_async	(FwupdClient	*client,
+							 GBytes		*bytes,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_details_bytes_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_update_metadata_async	(FwupdClient	*client,
+							 const gchar	*remote_id,
+							 const gchar	*metadata_fn,
+							 const gchar	*signature_fn,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_update_metadata_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_modify_remote_async	(FwupdClient	*client,
+							 const gchar	*remote_id,
+							 const gchar	*key,
+							 const gchar	*value,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_modify_remote_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_modify_device_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 const gchar	*key,
+							 const gchar	*value,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_modify_device_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_remotes_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_remotes_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_remote_by_id_async	(FwupdClient	*client,
+							 const gchar	*remote_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+FwupdRemote	*fwupd_client_get_remote_by_id_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_approved_firmware_async	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gchar		**fwupd_client_get_approved_firmware_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_set_approved_firmware_async	(FwupdClient	*client,
+							 gchar		**checksums,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_set_approved_firmware_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_get_stats_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GVariant	*fwupd_client_get_stats_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fwupd_client_self_sign_async		(FwupdClient	*client,
+							 const gchar	*value,
+							 FwupdSelfSignFlags flags,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gchar		*fwupd_client_self_sign_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+
 G_END_DECLS
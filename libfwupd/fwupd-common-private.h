@@ -13,5 +13,12 @@
 G_BEGIN_DECLS
 
 gchar		*fwupd_checksum_format_for_display	(const gchar	*checksum);
+void		 fwupd_guid_hash_data_raw		(const guint8	*data,
+							 gsize		 datasz,
+							 FwupdGuidFlags	 flags,
+							 fwupd_guid_t	*guid);
+guint		 fwupd_guid_raw_hash			(gconstpointer	 guid);
+gboolean	 fwupd_guid_raw_equal			(gconstpointer	 guid1,
+							 gconstpointer	 guid2);
 
 G_END_DECLS
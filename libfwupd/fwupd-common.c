@@ -16,10 +16,6 @@
 #include <sys/utsname.h>
 #include <json-glib/json-glib.h>
 
-#if !GLIB_CHECK_VERSION(2,54,0)
-#include <errno.h>
-#endif
-
 /**
  * fwupd_checksum_guess_kind:
  * @checksum: A checksum
@@ -520,8 +516,13 @@ fwupd_build_history_report_json (GPtrArray *devices, GError **error)
 	return data;
 }
 
-#define FWUPD_GUID_NAMESPACE_DEFAULT	"6ba7b810-9dad-11d1-80b4-00c04fd430c8"
-#define FWUPD_GUID_NAMESPACE_MICROSOFT	"70ffd812-4c7f-4c7d-0000-000000000000"
+/* these are stored as big endian */
+static const fwupd_guid_t fwupd_guid_namespace_default = {
+	0x6b, 0xa7, 0xb8, 0x10, 0x9d, 0xad, 0x11, 0xd1,
+	0x80, 0xb4, 0x00, 0xc0, 0x4f, 0xd4, 0x30, 0xc8 };
+static const fwupd_guid_t fwupd_guid_namespace_microsoft = {
+	0x70, 0xff, 0xd8, 0x12, 0x4c, 0x7f, 0x4c, 0x7d,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 
 typedef struct __attribute__((packed)) {
 	guint32		a;
@@ -573,71 +574,19 @@ fwupd_guid_to_string (const fwupd_guid_t *guid, FwupdGuidFlags flags)
 				gnat.e[4], gnat.e[5]);
 }
 
-#if !GLIB_CHECK_VERSION(2,54,0)
-static gboolean
-str_has_sign (const gchar *str)
-{
-	return str[0] == '-' || str[0] == '+';
-}
-
-static gboolean
-str_has_hex_prefix (const gchar *str)
+/* parses exactly @len hex digits, returning -1 on error */
+static gint64
+fwupd_guid_parse_hex (const gchar *str, guint len)
 {
-	return str[0] == '0' && g_ascii_tolower (str[1]) == 'x';
-}
-
-static gboolean
-g_ascii_string_to_unsigned (const gchar *str,
-			    guint base,
-			    guint64 min,
-			    guint64 max,
-			    guint64 *out_num,
-			    GError **error)
-{
-	const gchar *end_ptr = NULL;
-	gint saved_errno = 0;
-	guint64 number;
-
-	g_return_val_if_fail (str != NULL, FALSE);
-	g_return_val_if_fail (base >= 2 && base <= 36, FALSE);
-	g_return_val_if_fail (min <= max, FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-	if (str[0] == '\0') {
-		g_set_error_literal (error,
-				     G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
-				     "Empty string is not a number");
-		return FALSE;
-	}
-
-	errno = 0;
-	number = g_ascii_strtoull (str, (gchar **)&end_ptr, base);
-	saved_errno = errno;
-
-	if (g_ascii_isspace (str[0]) || str_has_sign (str) ||
-	    (base == 16 && str_has_hex_prefix (str)) ||
-	    (saved_errno != 0 && saved_errno != ERANGE) ||
-	    end_ptr == NULL ||
-	    *end_ptr != '\0') {
-		g_set_error (error,
-			     G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
-			     "“%s” is not an unsigned number", str);
-		return FALSE;
+	guint64 val = 0;
+	for (guint i = 0; i < len; i++) {
+		gint tmp = g_ascii_xdigit_value (str[i]);
+		if (tmp < 0)
+			return -1;
+		val = (val << 4) | (guint) tmp;
 	}
-	if (saved_errno == ERANGE || number < min || number > max) {
-		g_autofree gchar *min_str = g_strdup_printf ("%" G_GUINT64_FORMAT, min);
-		g_autofree gchar *max_str = g_strdup_printf ("%" G_GUINT64_FORMAT, max);
-		g_set_error (error,
-			     G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
-			     "Number “%s” is out of bounds [%s, %s]",
-			     str, min_str, max_str);
-		return FALSE;
-	}
-	if (out_num != NULL)
-		*out_num = number;
-	return TRUE;
+	return (gint64) val;
 }
-#endif /* GLIB_CHECK_VERSION(2,54,0) */
 
 /**
  * fwupd_guid_from_string:
@@ -661,12 +610,11 @@ fwupd_guid_from_string (const gchar *guidstr,
 {
 	fwupd_guid_native_t gu = { 0x0 };
 	gboolean mixed_endian = flags & FWUPD_GUID_FLAG_MIXED_ENDIAN;
-	guint64 tmp;
-	g_auto(GStrv) split = NULL;
+	gint64 tmp[4];
 
 	g_return_val_if_fail (guidstr != NULL, FALSE);
 
-	/* split into sections */
+	/* check sections, without allocating as this is called a lot */
 	if (strlen (guidstr) != 36) {
 		g_set_error_literal (error,
 				     G_IO_ERROR,
@@ -674,43 +622,41 @@ fwupd_guid_from_string (const gchar *guidstr,
 				     "is not valid format");
 		return FALSE;
 	}
-	split = g_strsplit (guidstr, "-", 5);
-	if (g_strv_length (split) != 5) {
+	if (guidstr[8] != '-' || guidstr[13] != '-' ||
+	    guidstr[18] != '-' || guidstr[23] != '-') {
 		g_set_error_literal (error,
 				     G_IO_ERROR,
 				     G_IO_ERROR_INVALID_DATA,
 				     "is not valid format, no dashes");
 		return FALSE;
 	}
-	if (strlen (split[0]) != 8 && strlen (split[1]) != 4 &&
-	    strlen (split[2]) != 4 && strlen (split[3]) != 4 &&
-	    strlen (split[4]) != 12) {
+
+	/* parse */
+	tmp[0] = fwupd_guid_parse_hex (guidstr, 8);
+	tmp[1] = fwupd_guid_parse_hex (guidstr + 9, 4);
+	tmp[2] = fwupd_guid_parse_hex (guidstr + 14, 4);
+	tmp[3] = fwupd_guid_parse_hex (guidstr + 19, 4);
+	if (tmp[0] < 0 || tmp[1] < 0 || tmp[2] < 0 || tmp[3] < 0) {
 		g_set_error_literal (error,
 				     G_IO_ERROR,
 				     G_IO_ERROR_INVALID_DATA,
 				     "is not valid format, not GUID");
 		return FALSE;
 	}
-
-	/* parse */
-	if (!g_ascii_string_to_unsigned (split[0], 16, 0, 0xffffffff, &tmp, error))
-		return FALSE;
-	gu.a = mixed_endian ? GUINT32_TO_LE(tmp) : GUINT32_TO_BE(tmp);
-	if (!g_ascii_string_to_unsigned (split[1], 16, 0, 0xffff, &tmp, error))
-		return FALSE;
-	gu.b = mixed_endian ? GUINT16_TO_LE(tmp) : GUINT16_TO_BE(tmp);
-	if (!g_ascii_string_to_unsigned (split[2], 16, 0, 0xffff, &tmp, error))
-		return FALSE;
-	gu.c = mixed_endian ? GUINT16_TO_LE(tmp) : GUINT16_TO_BE(tmp);
-	if (!g_ascii_string_to_unsigned (split[3], 16, 0, 0xffff, &tmp, error))
-		return FALSE;
-	gu.d = GUINT16_TO_BE(tmp);
+	gu.a = mixed_endian ? GUINT32_TO_LE((guint32) tmp[0]) : GUINT32_TO_BE((guint32) tmp[0]);
+	gu.b = mixed_endian ? GUINT16_TO_LE((guint16) tmp[1]) : GUINT16_TO_BE((guint16) tmp[1]);
+	gu.c = mixed_endian ? GUINT16_TO_LE((guint16) tmp[2]) : GUINT16_TO_BE((guint16) tmp[2]);
+	gu.d = GUINT16_TO_BE((guint16) tmp[3]);
 	for (guint i = 0; i < 6; i++) {
-		gchar buffer[3] = { 0x0 };
-		memcpy (buffer, split[4] + (i * 2), 2);
-		if (!g_ascii_string_to_unsigned (buffer, 16, 0, 0xff, &tmp, error))
+		gint64 val = fwupd_guid_parse_hex (guidstr + 24 + (i * 2), 2);
+		if (val < 0) {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_INVALID_DATA,
+					     "is not valid format, not GUID");
 			return FALSE;
-		gu.e[i] = tmp;
+		}
+		gu.e[i] = (guint8) val;
 	}
 	if (guid != NULL)
 		memcpy (guid, &gu, sizeof(gu));
@@ -719,6 +665,76 @@ fwupd_guid_from_string (const gchar *guidstr,
 	return TRUE;
 }
 
+/**
+ * fwupd_guid_hash_data_raw:
+ * @data: data to hash
+ * @datasz: length of @data
+ * @flags: some %FwupdGuidFlags, e.g. %FWUPD_GUID_FLAG_NAMESPACE_MICROSOFT
+ * @guid: a #fwupd_guid_t to write
+ *
+ * Generates a binary GUID for some data, as in fwupd_guid_hash_data().
+ **/
+void
+fwupd_guid_hash_data_raw (const guint8 *data, gsize datasz,
+			  FwupdGuidFlags flags, fwupd_guid_t *guid)
+{
+	const fwupd_guid_t *uu_namespace = &fwupd_guid_namespace_default;
+	gsize digestlen = 20;
+	guint8 hash[20];
+	guint8 *uu_new = (guint8 *) guid;
+	g_autoptr(GChecksum) csum = NULL;
+
+	/* old MS GUID */
+	if (flags & FWUPD_GUID_FLAG_NAMESPACE_MICROSOFT)
+		uu_namespace = &fwupd_guid_namespace_microsoft;
+
+	/* hash the namespace and then the string */
+	csum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (csum, (const guchar *) uu_namespace, sizeof(*uu_namespace));
+	g_checksum_update (csum, (const guchar *) data, (gssize) datasz);
+	g_checksum_get_digest (csum, hash, &digestlen);
+
+	/* copy most parts of the hash 1:1 */
+	memcpy (uu_new, hash, sizeof(fwupd_guid_t));
+
+	/* set specific bits according to Section 4.1.3 */
+	uu_new[6] = (guint8) ((uu_new[6] & 0x0f) | (5 << 4));
+	uu_new[8] = (guint8) ((uu_new[8] & 0x3f) | 0x80);
+}
+
+/**
+ * fwupd_guid_raw_hash:
+ * @guid: a #fwupd_guid_t
+ *
+ * Hashes a binary GUID for use in a #GHashTable.
+ *
+ * Returns: a hash value
+ **/
+guint
+fwupd_guid_raw_hash (gconstpointer guid)
+{
+	guint32 tmp;
+
+	/* the bytes are already well distributed */
+	memcpy (&tmp, (const guint8 *) guid + 12, sizeof(tmp));
+	return tmp;
+}
+
+/**
+ * fwupd_guid_raw_equal:
+ * @guid1: a #fwupd_guid_t
+ * @guid2: a #fwupd_guid_t
+ *
+ * Compares two binary GUIDs for use in a #GHashTable.
+ *
+ * Returns: %TRUE if the GUIDs are the same
+ **/
+gboolean
+fwupd_guid_raw_equal (gconstpointer guid1, gconstpointer guid2)
+{
+	return memcmp (guid1, guid2, sizeof(fwupd_guid_t)) == 0;
+}
+
 /**
  * fwupd_guid_hash_data:
  * @data: data to hash
@@ -738,37 +754,12 @@ fwupd_guid_from_string (const gchar *guidstr,
 gchar *
 fwupd_guid_hash_data (const guint8 *data, gsize datasz, FwupdGuidFlags flags)
 {
-	const gchar *namespace_id = FWUPD_GUID_NAMESPACE_DEFAULT;
-	gsize digestlen = 20;
-	guint8 hash[20];
-	fwupd_guid_t uu_namespace;
 	fwupd_guid_t uu_new;
-	g_autoptr(GChecksum) csum = NULL;
 
-	g_return_val_if_fail (namespace_id != NULL, NULL);
 	g_return_val_if_fail (data != NULL, NULL);
 	g_return_val_if_fail (datasz != 0, NULL);
 
-	/* old MS GUID */
-	if (flags & FWUPD_GUID_FLAG_NAMESPACE_MICROSOFT)
-		namespace_id = FWUPD_GUID_NAMESPACE_MICROSOFT;
-
-	/* convert the namespace to binary: hardcoded BE, not @flags */
-	if (!fwupd_guid_from_string (namespace_id, &uu_namespace, FWUPD_GUID_FLAG_NONE, NULL))
-		return NULL;
-
-	/* hash the namespace and then the string */
-	csum = g_checksum_new (G_CHECKSUM_SHA1);
-	g_checksum_update (csum, (guchar *) &uu_namespace, sizeof(uu_namespace));
-	g_checksum_update (csum, (guchar *) data, (gssize) datasz);
-	g_checksum_get_digest (csum, hash, &digestlen);
-
-	/* copy most parts of the hash 1:1 */
-	memcpy (uu_new, hash, sizeof(uu_new));
-
-	/* set specific bits according to Section 4.1.3 */
-	uu_new[6] = (guint8) ((uu_new[6] & 0x0f) | (5 << 4));
-	uu_new[8] = (guint8) ((uu_new[8] & 0x3f) | 0x80);
+	fwupd_guid_hash_data_raw (data, datasz, flags, &uu_new);
 	return fwupd_guid_to_string ((const fwupd_guid_t *) &uu_new, flags);
 }
 
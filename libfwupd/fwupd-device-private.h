@@ -21,6 +21,8 @@ void		 fwupd_device_incorporate		(FwupdDevice	*self,
 							 FwupdDevice	*donor);
 void		 fwupd_device_to_json			(FwupdDevice *device,
 							 JsonBuilder *builder);
+gboolean	 fwupd_device_has_guid_raw		(FwupdDevice	*device,
+							 const fwupd_guid_t *guid);
 
 G_END_DECLS
 
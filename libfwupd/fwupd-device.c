@@ -34,6 +34,7 @@ typedef struct {
 	guint64				 modified;
 	guint64				 flags;
 	GPtrArray			*guids;
+	GHashTable			*guids_raw;	/* fwupd_guid_t */
 	GPtrArray			*instance_ids;
 	GPtrArray			*icons;
 	gchar				*name;
@@ -314,8 +315,16 @@ fwupd_device_has_guid (FwupdDevice *device, const gchar *guid)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 
+	fwupd_guid_t guid_raw;
+
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 
+	/* use the set where possible */
+	if (guid != NULL &&
+	    fwupd_guid_from_string (guid, &guid_raw, FWUPD_GUID_FLAG_NONE, NULL))
+		return g_hash_table_contains (priv->guids_raw, &guid_raw);
+
+	/* not a GUID, so fall back to comparing strings */
 	for (guint i = 0; i < priv->guids->len; i++) {
 		const gchar *guid_tmp = g_ptr_array_index (priv->guids, i);
 		if (g_strcmp0 (guid, guid_tmp) == 0)
@@ -324,6 +333,24 @@ fwupd_device_has_guid (FwupdDevice *device, const gchar *guid)
 	return FALSE;
 }
 
+/**
+ * fwupd_device_has_guid_raw:
+ * @device: A #FwupdDevice
+ * @guid: a #fwupd_guid_t
+ *
+ * Finds out if the device has this specific GUID without any parsing.
+ *
+ * Returns: %TRUE if the GUID is found
+ **/
+gboolean
+fwupd_device_has_guid_raw (FwupdDevice *device, const fwupd_guid_t *guid)
+{
+	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
+	g_return_val_if_fail (guid != NULL, FALSE);
+	return g_hash_table_contains (priv->guids_raw, guid);
+}
+
 /**
  * fwupd_device_add_guid:
  * @device: A #FwupdDevice
@@ -337,9 +364,18 @@ void
 fwupd_device_add_guid (FwupdDevice *device, const gchar *guid)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	fwupd_guid_t guid_raw;
+
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
-	if (fwupd_device_has_guid (device, guid))
+
+	if (guid != NULL &&
+	    fwupd_guid_from_string (guid, &guid_raw, FWUPD_GUID_FLAG_NONE, NULL)) {
+		if (g_hash_table_contains (priv->guids_raw, &guid_raw))
+			return;
+		g_hash_table_add (priv->guids_raw, g_memdup (&guid_raw, sizeof(guid_raw)));
+	} else if (fwupd_device_has_guid (device, guid)) {
 		return;
+	}
 	g_ptr_array_add (priv->guids, g_strdup (guid));
 }
 
@@ -1818,6 +1854,9 @@ fwupd_device_init (FwupdDevice *device)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	priv->guids = g_ptr_array_new_with_free_func (g_free);
+	priv->guids_raw = g_hash_table_new_full (fwupd_guid_raw_hash,
+						 fwupd_guid_raw_equal,
+						 g_free, NULL);
 	priv->instance_ids = g_ptr_array_new_with_free_func (g_free);
 	priv->icons = g_ptr_array_new_with_free_func (g_free);
 	priv->checksums = g_ptr_array_new_with_free_func (g_free);
@@ -1847,6 +1886,7 @@ fwupd_device_finalize (GObject *object)
 	g_free (priv->version_lowest);
 	g_free (priv->version_bootloader);
 	g_ptr_array_unref (priv->guids);
+	g_hash_table_unref (priv->guids_raw);
 	g_ptr_array_unref (priv->instance_ids);
 	g_ptr_array_unref (priv->icons);
 	g_ptr_array_unref (priv->checksums);
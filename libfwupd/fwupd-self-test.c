@@ -10,7 +10,7 @@
 #include <fnmatch.h>
 
 #include "fwupd-client.h"
-#include "fwupd-common.h"
+#include "fwupd-common-private.h"
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
 #include "fwupd-device-private.h"
@@ -429,6 +429,86 @@ fwupd_client_devices_func (void)
 	g_assert_cmpstr (fwupd_device_get_id (dev), !=, NULL);
 }
 
+typedef struct {
+	GMainLoop	*loop;
+	GAsyncResult	*res_devices;
+	GAsyncResult	*res_remotes;
+} FwupdClientTestHelper;
+
+static void
+fwupd_client_async_devices_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientTestHelper *helper = (FwupdClientTestHelper *) user_data;
+	helper->res_devices = g_object_ref (res);
+	if (helper->res_remotes != NULL)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fwupd_client_async_remotes_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientTestHelper *helper = (FwupdClientTestHelper *) user_data;
+	helper->res_remotes = g_object_ref (res);
+	if (helper->res_devices != NULL)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fwupd_client_async_func (void)
+{
+	gboolean ret;
+	FwupdClientTestHelper helper = { NULL };
+	g_autoptr(FwupdClient) client = NULL;
+	g_autoptr(FwupdClient) client_async = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) remotes = NULL;
+
+	client = fwupd_client_new ();
+
+	/* only run if running fwupd is new enough */
+	ret = fwupd_client_connect (client, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	if (fwupd_client_get_daemon_version (client) == NULL) {
+		g_test_skip ("no enabled fwupd daemon");
+		return;
+	}
+	if (!g_str_has_prefix (fwupd_client_get_daemon_version (client), "1.")) {
+		g_test_skip ("running fwupd is too old");
+		return;
+	}
+
+	/* both calls are queued until the new client has connected */
+	client_async = fwupd_client_new ();
+	helper.loop = loop;
+	fwupd_client_get_devices_async (client_async, NULL,
+					fwupd_client_async_devices_cb, &helper);
+	fwupd_client_get_remotes_async (client_async, NULL,
+					fwupd_client_async_remotes_cb, &helper);
+	g_main_loop_run (loop);
+	g_assert_nonnull (fwupd_client_get_daemon_version (client_async));
+
+	/* remotes are always available */
+	remotes = fwupd_client_get_remotes_finish (client_async, helper.res_remotes, &error);
+	g_object_unref (helper.res_remotes);
+	g_assert_no_error (error);
+	g_assert_nonnull (remotes);
+	g_assert_cmpint (remotes->len, >, 0);
+
+	devices = fwupd_client_get_devices_finish (client_async, helper.res_devices, &error);
+	g_object_unref (helper.res_devices);
+	if (devices == NULL &&
+	    g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO)) {
+		g_test_skip ("no available fwupd devices");
+		return;
+	}
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, >, 0);
+}
+
 static void
 fwupd_client_remotes_func (void)
 {
@@ -546,6 +626,12 @@ fwupd_common_guid_func (void)
 	guid2 = fwupd_guid_hash_string ("8086:0406");
 	g_assert_cmpstr (guid2, ==, "1fbd1f2c-80f4-5d7c-a6ad-35c7b9bd5486");
 
+	/* binary form */
+	fwupd_guid_hash_data_raw ((const guint8 *) "python.org", 10,
+				  FWUPD_GUID_FLAG_NONE, &buf);
+	g_assert (memcmp (buf, "\x88\x63\x13\xe1\x3b\x8a\x53\x72\x9b\x90\x0c\x9a\xee\x19\x9e\x5d", sizeof(buf)) == 0);
+	g_assert_true (fwupd_guid_raw_equal (&buf, &buf));
+
 	/* round-trip BE */
 	ret = fwupd_guid_from_string ("00112233-4455-6677-8899-aabbccddeeff", &buf,
 				      FWUPD_GUID_FLAG_NONE, &error);
@@ -591,6 +677,7 @@ main (int argc, char **argv)
 	if (fwupd_has_system_bus ()) {
 		g_test_add_func ("/fwupd/client{remotes}", fwupd_client_remotes_func);
 		g_test_add_func ("/fwupd/client{devices}", fwupd_client_devices_func);
+		g_test_add_func ("/fwupd/client{async}", fwupd_client_async_func);
 	}
 	return g_test_run ();
 }
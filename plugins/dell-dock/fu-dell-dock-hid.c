@@ -27,6 +27,8 @@
 #define HIDI2C_MAX_REGISTER		4
 #define HID_MAX_RETRIES			5
 #define TBT_MAX_RETRIES			2
+#define TBT_AUTHENTICATE_DELAY		2000	/* ms */
+#define TBT_AUTHENTICATE_TIMEOUT	3000	/* ms */
 #define HIDI2C_TRANSACTION_TIMEOUT	2000
 
 #define HUB_CMD_READ_DATA		0xC0
@@ -485,6 +487,33 @@ fu_dell_dock_hid_tbt_write (FuDevice *self,
 	return TRUE;
 }
 
+typedef struct {
+	FuTbtCmdBuffer		*cmd_buffer;
+	guint8			 result;
+} FuDellDockHidTbtHelper;
+
+static gboolean
+fu_dell_dock_hid_tbt_authenticate_cb (FuDevice *self, gpointer user_data, GError **error)
+{
+	FuDellDockHidTbtHelper *helper = (FuDellDockHidTbtHelper *) user_data;
+
+	if (!fu_dell_dock_hid_set_report (self, (guint8 *) helper->cmd_buffer, error)) {
+		g_prefix_error (error, "failed to set check authentication: ");
+		return FALSE;
+	}
+	if (!fu_dell_dock_hid_get_report (self, helper->cmd_buffer->data, error)) {
+		g_prefix_error (error, "failed to get check authentication: ");
+		return FALSE;
+	}
+	helper->result = helper->cmd_buffer->data[1] & 0xf;
+	if (helper->result != 0) {
+		g_debug ("Thunderbolt authenticate not complete: %x",
+			 helper->result);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 gboolean
 fu_dell_dock_hid_tbt_authenticate (FuDevice *self,
 				   const FuHIDI2CParameters *parameters,
@@ -499,36 +528,33 @@ fu_dell_dock_hid_tbt_authenticate (FuDevice *self,
 	    .bufferlen = 0,
 	    .extended_cmdarea[0 ... 53] = 0,
 	};
-	guint8 result;
+	FuDellDockHidTbtHelper helper = {
+	    .cmd_buffer = &cmd_buffer,
+	    .result = 0,
+	};
+	g_autoptr(GError) error_local = NULL;
 
 	if (!fu_dell_dock_hid_set_report (self, (guint8 *) &cmd_buffer, error)) {
 		g_prefix_error (error, "failed to send authentication: ");
 		return FALSE;
 	}
 
-	cmd_buffer.tbt_command = GUINT32_TO_LE (TBT_COMMAND_AUTHENTICATE_STATUS);
 	/* needs at least 2 seconds */
-	g_usleep (2000000);
-	for (gint i = 1; i <= TBT_MAX_RETRIES; i++) {
-		if (!fu_dell_dock_hid_set_report (self, (guint8 *) &cmd_buffer, error)) {
-			g_prefix_error (error, "failed to set check authentication: ");
-			return FALSE;
-		}
-		if (!fu_dell_dock_hid_get_report (self, cmd_buffer.data, error)) {
-			g_prefix_error (error, "failed to get check authentication: ");
+	cmd_buffer.tbt_command = GUINT32_TO_LE (TBT_COMMAND_AUTHENTICATE_STATUS);
+	if (!fu_device_wait_for (self,
+				 fu_dell_dock_hid_tbt_authenticate_cb, &helper,
+				 TBT_AUTHENTICATE_DELAY,
+				 TBT_AUTHENTICATE_TIMEOUT,
+				 &error_local)) {
+		if (!g_error_matches (error_local,
+				      G_IO_ERROR,
+				      G_IO_ERROR_TIMED_OUT)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
 			return FALSE;
 		}
-		result = cmd_buffer.data[1] & 0xf;
-		if (result == 0)
-			break;
-		g_debug ("attempt %d/%d: Thunderbolt authenticate failed: %x",
-			  i, TBT_MAX_RETRIES, result);
-		g_usleep (500000);
-	}
-	if (result != 0) {
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			     "Thunderbolt authentication failed: %s",
-			     fu_dell_dock_hid_tbt_map_error (result));
+			     fu_dell_dock_hid_tbt_map_error (helper.result));
 		return FALSE;
 	}
 
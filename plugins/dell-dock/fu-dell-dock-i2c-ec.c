@@ -47,6 +47,9 @@
 #define PASSIVE_REBOOT_MASK		0x02
 #define PASSIVE_TBT_MASK		0x04
 
+#define EC_UPDATE_TIMEOUT		300000	/* ms */
+#define EC_QUERY_TIMEOUT		2000	/* ms */
+
 typedef enum {
 	FW_UPDATE_IN_PROGRESS,
 	FW_UPDATE_COMPLETE,
@@ -792,12 +795,47 @@ fu_dell_dock_ec_commit_package (FuDevice *device, GBytes *blob_fw,
 }
 
 static gboolean
-fu_dell_dock_ec_write_fw (FuDevice *device, GBytes *blob_fw,
-			  GError **error)
+fu_dell_dock_ec_update_complete_cb (FuDevice *device, gpointer user_data, GError **error)
 {
 	FuDellDockEc *self = FU_DELL_DOCK_EC (device);
 	FuDellDockECFWUpdateStatus status = FW_UPDATE_IN_PROGRESS;
 	guint8 progress1 = 0, progress0 = 0;
+	g_autoptr(GError) error_local = NULL;
+
+	if (!fu_dell_dock_hid_get_ec_status (self->symbiote, &progress1,
+					     &progress0, error)) {
+		g_prefix_error (error, "Failed to read scratch: ");
+		return FALSE;
+	}
+	g_debug ("Read %u and %u from scratch", progress1, progress0);
+	if (progress0 > 100)
+		progress0 = 100;
+	fu_device_set_progress_full (device, progress0, 100);
+
+	/* This is expected to fail until update is done
+	 * TODO: After can guarantee EC version that reports status byte
+	 *       don't call this until progress0 is 100
+	 */
+	if (!fu_dell_dock_get_ec_status (device, &status, &error_local)) {
+		g_debug ("Flash EC Received result: %s (status %u)",
+			 error_local->message, status);
+		return TRUE;
+	}
+	if (status == FW_UPDATE_AUTHENTICATION_FAILED) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "invalid EC firmware image");
+		return FALSE;
+	}
+	return status == FW_UPDATE_COMPLETE;
+}
+
+static gboolean
+fu_dell_dock_ec_write_fw (FuDevice *device, GBytes *blob_fw,
+			  GError **error)
+{
+	FuDellDockEc *self = FU_DELL_DOCK_EC (device);
 	gsize fw_size = 0;
 	const guint8 *data = g_bytes_get_data (blob_fw, &fw_size);
 	gsize write_size =
@@ -875,39 +913,9 @@ fu_dell_dock_ec_write_fw (FuDevice *device, GBytes *blob_fw,
 
 	/* poll for completion status */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_BUSY);
-	while (status != FW_UPDATE_COMPLETE) {
-		g_autoptr(GError) error_local = NULL;
-
-		if (!fu_dell_dock_hid_get_ec_status (self->symbiote, &progress1,
-						     &progress0, error)) {
-			g_prefix_error (error, "Failed to read scratch: ");
-			return FALSE;
-		}
-		g_debug ("Read %u and %u from scratch", progress1, progress0);
-		if (progress0 > 100)
-			progress0 = 100;
-		fu_device_set_progress_full (device, progress0, 100);
-
-		/* This is expected to fail until update is done
-		 * TODO: After can guarantee EC version that reports status byte
-		 *       don't call this until progress0 is 100
-		 */
-		if (!fu_dell_dock_get_ec_status (device, &status,
-						 &error_local)) {
-			g_debug ("Flash EC Received result: %s (status %u)",
-				 error_local->message, status);
-			return TRUE;
-		}
-		if (status == FW_UPDATE_AUTHENTICATION_FAILED) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_NOT_SUPPORTED,
-					     "invalid EC firmware image");
-			return FALSE;
-		}
-	}
-
-	return TRUE;
+	return fu_device_wait_for (device,
+				   fu_dell_dock_ec_update_complete_cb, NULL,
+				   0, EC_UPDATE_TIMEOUT, error);
 }
 
 static gboolean
@@ -981,6 +989,25 @@ fu_dell_dock_ec_query (FuDevice *device, GError **error)
 	return fu_dell_dock_ec_get_dock_info (device, error);
 }
 
+static gboolean
+fu_dell_dock_ec_query_cb (FuDevice *device, gpointer user_data, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	/* bad signatures are expected until the EC has settled */
+	if (!fu_dell_dock_ec_query (device, &error_local)) {
+		if (g_error_matches (error_local,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_SIGNATURE_INVALID)) {
+			g_debug ("%s", error_local->message);
+			return FALSE;
+		}
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_dell_dock_ec_setup (FuDevice *device, GError **error)
 {
@@ -992,10 +1019,20 @@ fu_dell_dock_ec_setup (FuDevice *device, GError **error)
 		if (g_error_matches (error_local,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_SIGNATURE_INVALID)) {
+			g_autoptr(GError) error_wait = NULL;
 			g_warning ("%s", error_local->message);
-			g_usleep (2 * G_USEC_PER_SEC);
-			if (!fu_dell_dock_ec_query (device, error))
-				return FALSE;
+			if (!fu_device_wait_for (device, fu_dell_dock_ec_query_cb, NULL,
+						 0, EC_QUERY_TIMEOUT, &error_wait)) {
+				if (!g_error_matches (error_wait,
+						      G_IO_ERROR,
+						      G_IO_ERROR_TIMED_OUT)) {
+					g_propagate_error (error, g_steal_pointer (&error_wait));
+					return FALSE;
+				}
+				/* get the real error */
+				if (!fu_dell_dock_ec_query (device, error))
+					return FALSE;
+			}
 		} else {
 			g_propagate_error (error, g_steal_pointer (&error_local));
 			return FALSE;
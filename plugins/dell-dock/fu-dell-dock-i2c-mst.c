@@ -35,6 +35,9 @@
 #define MST_REG_QUAD_DISABLE		0x200fc0
 #define MST_REG_HDCP22_DISABLE		0x200f90
 
+#define MST_RC_TIMEOUT			5000	/* ms */
+#define MST_ERASE_SETTLE_DELAY		5000	/* ms */
+
 /* MST remote control commands */
 #define MST_CMD_ENABLE_REMOTE_CONTROL	0x1
 #define MST_CMD_DISABLE_REMOTE_CONTROL	0x2
@@ -255,10 +258,34 @@ fu_dell_dock_mst_enable_remote_control (FuDevice *symbiote, GError **error)
 }
 
 static gboolean
-fu_dell_dock_trigger_rc_command (FuDevice *symbiote, GError **error)
+fu_dell_dock_trigger_rc_command_cb (FuDevice *symbiote, gpointer user_data, GError **error)
 {
+	guint32 *tmp = (guint32 *) user_data;
 	const guint8 *result = NULL;
+	g_autoptr(GBytes) bytes = NULL;
+
+	if (!fu_dell_dock_mst_read_register (symbiote,
+					     MST_RC_COMMAND_ADDR,
+					     sizeof(guint32), &bytes,
+					     error)) {
+		g_prefix_error (error,
+				"Failed to poll MST_RC_COMMAND_ADDR");
+		return FALSE;
+	}
+	result = g_bytes_get_data (bytes, NULL);
+	/* complete */
+	if ((result[2] & 0x80) == 0) {
+		*tmp = result[3];
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+fu_dell_dock_trigger_rc_command (FuDevice *symbiote, GError **error)
+{
 	guint32 tmp;
+	g_autoptr(GError) error_local = NULL;
 
 	/* Trigger the write */
 	tmp = MST_TRIGGER_WRITE;
@@ -271,23 +298,15 @@ fu_dell_dock_trigger_rc_command (FuDevice *symbiote, GError **error)
 	}
 	/* poll for completion */
 	tmp = 0xffff;
-	for (guint i = 0; i < 1000; i++) {
-		g_autoptr(GBytes) bytes = NULL;
-		if (!fu_dell_dock_mst_read_register (symbiote,
-						     MST_RC_COMMAND_ADDR,
-						     sizeof(guint32), &bytes,
-						     error)) {
-			g_prefix_error (error,
-					"Failed to poll MST_RC_COMMAND_ADDR");
+	if (!fu_device_wait_for (symbiote,
+				 fu_dell_dock_trigger_rc_command_cb, &tmp,
+				 0, MST_RC_TIMEOUT, &error_local)) {
+		if (!g_error_matches (error_local,
+				      G_IO_ERROR,
+				      G_IO_ERROR_TIMED_OUT)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
 			return FALSE;
 		}
-		result = g_bytes_get_data (bytes, NULL);
-		/* complete */
-		if ((result[2] & 0x80) == 0) {
-			tmp = result[3];
-			break;
-		}
-		g_usleep (2000);
 	}
 	switch (tmp) {
 	/* need to enable remote control */
@@ -507,9 +526,8 @@ fu_dell_dock_mst_erase_bank (FuDevice *symbiote, MSTBank bank, GError **error)
 		}
 	}
 	g_debug ("MST: Waiting for flash clear to settle");
-	g_usleep (5000000);
-
-	return TRUE;
+	return fu_device_wait_for (symbiote, NULL, NULL,
+				   MST_ERASE_SETTLE_DELAY, 0, error);
 }
 
 static gboolean
@@ -27,6 +27,9 @@
 
 #define I2C_TBT_ADDRESS 0xa2
 
+/* time for the controller to wake up */
+#define TBT_WAKE_DELAY		2000	/* ms */
+
 const FuHIDI2CParameters tbt_base_settings = {
 	.i2cslaveaddr = I2C_TBT_ADDRESS,
 	.regaddrlen = 1,
@@ -96,7 +99,8 @@ fu_dell_dock_tbt_write_fw (FuDevice *device,
 	g_debug ("waking Thunderbolt controller");
 	if (!fu_dell_dock_hid_tbt_wake (self->symbiote, &tbt_base_settings, error))
 		return FALSE;
-	g_usleep (2000000);
+	if (!fu_device_wait_for (device, NULL, NULL, TBT_WAKE_DELAY, 0, error))
+		return FALSE;
 
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 0; i < image_size; i+= HIDI2C_MAX_WRITE, buffer += HIDI2C_MAX_WRITE) {
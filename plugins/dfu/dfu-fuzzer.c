@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "dfu-firmware.h"
+#include "fu-fuzzer.h"
+
+/* ihex, srec, DFU and DfuSe, using the same detection as dfu-tool */
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autoptr(DfuFirmware) firmware = dfu_firmware_new ();
+	g_autoptr(GBytes) blob = g_bytes_new_static (data, size);
+	if (dfu_firmware_parse_data (firmware, blob, DFU_FIRMWARE_PARSE_FLAG_NONE, NULL)) {
+		g_autofree gchar *str = dfu_firmware_to_string (firmware);
+	}
+	return 0;
+}
@@ -12,6 +12,7 @@
 #include "fu-archive.h"
 #include "fu-chunk.h"
 #include "fu-fastboot-device.h"
+#include "fu-fastboot-sparse.h"
 
 #define FASTBOOT_REMOVE_DELAY_RE_ENUMERATE	60000 /* ms */
 #define FASTBOOT_TRANSACTION_TIMEOUT		1000 /* ms */
@@ -19,11 +20,13 @@
 #define FASTBOOT_EP_IN				0x81
 #define FASTBOOT_EP_OUT				0x01
 #define FASTBOOT_CMD_BUFSZ			64 /* bytes */
+#define FASTBOOT_PACKETS_PER_TRANSFER		32
 
 struct _FuFastbootDevice {
 	FuUsbDevice			 parent_instance;
 	gboolean			 secure;
 	guint				 blocksz;
+	guint64				 max_download_size;
 	guint8				 intf_nr;
 };
 
@@ -37,6 +40,10 @@ fu_fastboot_device_to_string (FuDevice *device, GString *str)
 	g_string_append_printf (str, "    intf:\t0x%02x\n", (guint) self->intf_nr);
 	g_string_append_printf (str, "    secure:\t%i\n", self->secure);
 	g_string_append_printf (str, "    blocksz:\t%u\n", self->blocksz);
+	if (self->max_download_size > 0) {
+		g_string_append_printf (str, "    max-download-size:\t0x%" G_GINT64_MODIFIER "x\n",
+					self->max_download_size);
+	}
 }
 
 static gboolean
@@ -141,7 +148,6 @@ fu_fastboot_device_read (FuDevice *device,
 			 FuFastbootDeviceReadFlags flags,
 			 GError **error)
 {
-	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
 	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (device));
 	guint retries = 1;
 
@@ -185,7 +191,7 @@ fu_fastboot_device_read (FuDevice *device,
 		}
 
 		/* info */
-		tmp = g_strndup ((const gchar *) buf + 4, self->blocksz - 4);
+		tmp = g_strndup ((const gchar *) buf + 4, actual_len - 4);
 		if (memcmp (buf, "INFO", 4) == 0) {
 			if (g_strcmp0 (tmp, "erasing flash") == 0)
 				fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
@@ -280,11 +286,15 @@ fu_fastboot_device_download (FuDevice *device, GBytes *fw, GError **error)
 						0x00,	/* start addr */
 						0x00,	/* page_sz */
 						self->blocksz);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_fastboot_device_write (device, chk->data, chk->data_sz, error))
-			return FALSE;
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len * 2);
+	if (!fu_usb_device_write_chunks (FU_USB_DEVICE (device),
+					 FASTBOOT_EP_OUT,
+					 chunks,
+					 FU_USB_DEVICE_TRANSFER_QUEUE_DEPTH,
+					 FASTBOOT_TRANSACTION_TIMEOUT,
+					 FU_USB_DEVICE_TRANSFER_FLAG_NONE,
+					 error)) {
+		g_prefix_error (error, "failed to do bulk transfer: ");
+		return FALSE;
 	}
 	if (!fu_fastboot_device_read (device, NULL,
 				      FU_FASTBOOT_DEVICE_READ_FLAG_STATUS_POLL, error))
@@ -292,6 +302,77 @@ fu_fastboot_device_download (FuDevice *device, GBytes *fw, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_fastboot_device_flash_image (FuDevice *device,
+				const gchar *partition,
+				GBytes *fw,
+				GError **error)
+{
+	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
+	g_autoptr(GPtrArray) images = NULL;
+
+	/* the device does not tell us how much it can buffer */
+	if (self->max_download_size == 0) {
+		if (!fu_fastboot_device_download (device, fw, error))
+			return FALSE;
+		return fu_fastboot_device_flash (device, partition, error);
+	}
+
+	/* large images are sent as several sparse images */
+	images = fu_fastboot_sparse_split (fw,
+					   MIN (self->max_download_size, G_MAXSIZE),
+					   error);
+	if (images == NULL) {
+		g_prefix_error (error, "failed to split %s: ", partition);
+		return FALSE;
+	}
+	for (guint i = 0; i < images->len; i++) {
+		GBytes *img = g_ptr_array_index (images, i);
+		if (images->len > 1) {
+			g_debug ("flashing %s sparse image %u/%u",
+				 partition, i + 1, images->len);
+		}
+		if (!fu_fastboot_device_download (device, img, error))
+			return FALSE;
+		if (!fu_fastboot_device_flash (device, partition, error))
+			return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static guint
+fu_fastboot_device_get_max_packet_size (FuFastbootDevice *self)
+{
+#if G_USB_CHECK_VERSION(0,3,3)
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) intfs = NULL;
+
+	intfs = g_usb_device_get_interfaces (usb_device, &error_local);
+	if (intfs == NULL) {
+		g_debug ("failed to get interfaces: %s", error_local->message);
+		return 0;
+	}
+	for (guint i = 0; i < intfs->len; i++) {
+		GUsbInterface *intf = g_ptr_array_index (intfs, i);
+		g_autoptr(GPtrArray) endpoints = NULL;
+		if (g_usb_interface_get_number (intf) != self->intf_nr)
+			continue;
+		endpoints = g_usb_interface_get_endpoints (intf);
+		if (endpoints == NULL)
+			continue;
+		for (guint j = 0; j < endpoints->len; j++) {
+			GUsbEndpoint *ep = g_ptr_array_index (endpoints, j);
+			if (g_usb_endpoint_get_address (ep) == FASTBOOT_EP_OUT)
+				return g_usb_endpoint_get_maximum_packet_size (ep);
+		}
+	}
+#endif
+	return 0;
+}
+
 static gboolean
 fu_fastboot_device_setup (FuDevice *device, GError **error)
 {
@@ -301,6 +382,17 @@ fu_fastboot_device_setup (FuDevice *device, GError **error)
 	g_autofree gchar *version = NULL;
 	g_autofree gchar *secure = NULL;
 	g_autofree gchar *version_bootloader = NULL;
+	g_autofree gchar *max_download_size = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* send whole packets unless the quirk overrides the transfer size */
+	if (self->blocksz == 0) {
+		guint max_packet_size = fu_fastboot_device_get_max_packet_size (self);
+		if (max_packet_size > 0)
+			self->blocksz = max_packet_size * FASTBOOT_PACKETS_PER_TRANSFER;
+		else
+			self->blocksz = 512;
+	}
 
 	/* product */
 	if (!fu_fastboot_device_getvar (device, "product", &product, error))
@@ -334,6 +426,14 @@ fu_fastboot_device_setup (FuDevice *device, GError **error)
 	if (secure != NULL && secure[0] != '\0')
 		self->secure = TRUE;
 
+	/* largest image the device can buffer, which is optional */
+	if (!fu_fastboot_device_getvar (device, "max-download-size",
+					&max_download_size, &error_local)) {
+		g_debug ("no max-download-size: %s", error_local->message);
+	} else if (max_download_size != NULL && max_download_size[0] != '\0') {
+		self->max_download_size = fu_common_strtoull (max_download_size);
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -366,9 +466,7 @@ fu_fastboot_device_write_qfil_part (FuDevice *device,
 		partition += 2;
 
 	/* flash the partition */
-	if (!fu_fastboot_device_download (device, data, error))
-		return FALSE;
-	return fu_fastboot_device_flash (device, partition, error);
+	return fu_fastboot_device_flash_image (device, partition, data, error);
 }
 
 static gboolean
@@ -491,9 +589,7 @@ fu_fastboot_device_write_motorola_part (FuDevice *device,
 		}
 
 		/* flash the partition */
-		if (!fu_fastboot_device_download (device, data, error))
-			return FALSE;
-		return fu_fastboot_device_flash (device, partition, error);
+		return fu_fastboot_device_flash_image (device, partition, data, error);
 	}
 
 	/* dumb operation that doesn't expect a response */
@@ -681,8 +777,6 @@ fu_fastboot_device_attach (FuDevice *device, GError **error)
 static void
 fu_fastboot_device_init (FuFastbootDevice *self)
 {
-	/* this is a safe default, even using USBv1 */
-	self->blocksz = 512;
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_UPDATABLE);
 	fu_device_set_remove_delay (FU_DEVICE (self), FASTBOOT_REMOVE_DELAY_RE_ENUMERATE);
 }
@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-common.h"
+#include "fu-fastboot-sparse.h"
+
+typedef struct {
+	guint16			 chunk_type;
+	guint32			 blocks;
+	const guint8		*data;		/* RAW or FILL payload */
+	gsize			 data_len;	/* may be less than blocks * blksz */
+} FuFastbootSparseChunk;
+
+/**
+ * fu_fastboot_sparse_is_sparse:
+ * @blob: A #GBytes
+ *
+ * Checks if the image is in the Android sparse format.
+ *
+ * Returns: %TRUE if the sparse header magic was found
+ **/
+gboolean
+fu_fastboot_sparse_is_sparse (GBytes *blob)
+{
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (blob, &bufsz);
+	if (bufsz < FU_FASTBOOT_SPARSE_HEADER_SZ)
+		return FALSE;
+	return fu_common_read_uint32 (buf, G_LITTLE_ENDIAN) == FU_FASTBOOT_SPARSE_HEADER_MAGIC;
+}
+
+static gboolean
+fu_fastboot_sparse_parse (GBytes *blob,
+			  guint32 *blksz,
+			  guint32 *total_blks,
+			  GArray *chunks,
+			  GError **error)
+{
+	gsize bufsz = 0;
+	gsize offset;
+	guint16 chunk_hdr_sz;
+	guint16 file_hdr_sz;
+	guint16 major;
+	guint32 total_chunks;
+	guint64 blocks_seen = 0;
+	const guint8 *buf = g_bytes_get_data (blob, &bufsz);
+
+	/* file header */
+	major = fu_common_read_uint16 (buf + 0x04, G_LITTLE_ENDIAN);
+	if (major != 1) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "sparse major version %u not supported",
+			     major);
+		return FALSE;
+	}
+	file_hdr_sz = fu_common_read_uint16 (buf + 0x08, G_LITTLE_ENDIAN);
+	chunk_hdr_sz = fu_common_read_uint16 (buf + 0x0a, G_LITTLE_ENDIAN);
+	if (file_hdr_sz < FU_FASTBOOT_SPARSE_HEADER_SZ ||
+	    file_hdr_sz > bufsz ||
+	    chunk_hdr_sz < FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "sparse header size invalid");
+		return FALSE;
+	}
+	*blksz = fu_common_read_uint32 (buf + 0x0c, G_LITTLE_ENDIAN);
+	if (*blksz == 0 || *blksz % 4 != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "sparse block size 0x%x invalid",
+			     *blksz);
+		return FALSE;
+	}
+	*total_blks = fu_common_read_uint32 (buf + 0x10, G_LITTLE_ENDIAN);
+	total_chunks = fu_common_read_uint32 (buf + 0x14, G_LITTLE_ENDIAN);
+
+	/* chunks */
+	offset = file_hdr_sz;
+	for (guint32 i = 0; i < total_chunks; i++) {
+		FuFastbootSparseChunk chk = { 0x0 };
+		gboolean valid = FALSE;
+		guint32 total_sz;
+		guint64 data_sz;
+
+		if (bufsz - offset < chunk_hdr_sz) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "sparse chunk %u truncated", i);
+			return FALSE;
+		}
+		chk.chunk_type = fu_common_read_uint16 (buf + offset, G_LITTLE_ENDIAN);
+		chk.blocks = fu_common_read_uint32 (buf + offset + 0x04, G_LITTLE_ENDIAN);
+		total_sz = fu_common_read_uint32 (buf + offset + 0x08, G_LITTLE_ENDIAN);
+		if (total_sz < chunk_hdr_sz || total_sz > bufsz - offset) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "sparse chunk %u truncated", i);
+			return FALSE;
+		}
+
+		/* check the payload matches the chunk type */
+		data_sz = total_sz - chunk_hdr_sz;
+		switch (chk.chunk_type) {
+		case FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW:
+			valid = data_sz == (guint64) chk.blocks * *blksz;
+			break;
+		case FU_FASTBOOT_SPARSE_CHUNK_TYPE_FILL:
+			valid = data_sz == 4;
+			break;
+		case FU_FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE:
+			valid = data_sz == 0;
+			break;
+		case FU_FASTBOOT_SPARSE_CHUNK_TYPE_CRC32:
+			valid = data_sz == 4 && chk.blocks == 0;
+			break;
+		default:
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "sparse chunk %u has unknown type 0x%04x",
+				     i, chk.chunk_type);
+			return FALSE;
+		}
+		if (!valid) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "sparse chunk %u size invalid", i);
+			return FALSE;
+		}
+		blocks_seen += chk.blocks;
+		if (blocks_seen > *total_blks) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "sparse chunks exceed %u blocks",
+				     *total_blks);
+			return FALSE;
+		}
+
+		/* the image checksum is not valid once split */
+		if (chk.chunk_type != FU_FASTBOOT_SPARSE_CHUNK_TYPE_CRC32) {
+			if (data_sz > 0) {
+				chk.data = buf + offset + chunk_hdr_sz;
+				chk.data_len = data_sz;
+			}
+			g_array_append_val (chunks, chk);
+		}
+		offset += total_sz;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_fastboot_sparse_parse_raw (GBytes *blob,
+			      guint32 *blksz,
+			      guint32 *total_blks,
+			      GArray *chunks,
+			      GError **error)
+{
+	FuFastbootSparseChunk chk = { 0x0 };
+	gsize bufsz = 0;
+	guint64 blocks;
+
+	/* the last block is padded with zeros, just like fastboot does */
+	chk.data = g_bytes_get_data (blob, &bufsz);
+	blocks = (bufsz + FU_FASTBOOT_SPARSE_BLOCK_SZ - 1) / FU_FASTBOOT_SPARSE_BLOCK_SZ;
+	if (blocks > G_MAXUINT32) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "image too large");
+		return FALSE;
+	}
+	chk.chunk_type = FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW;
+	chk.blocks = blocks;
+	chk.data_len = bufsz;
+	g_array_append_val (chunks, chk);
+	*blksz = FU_FASTBOOT_SPARSE_BLOCK_SZ;
+	*total_blks = blocks;
+	return TRUE;
+}
+
+static void
+fu_fastboot_sparse_append_chunk (GByteArray *buf,
+				 guint32 *n_chunks,
+				 guint16 chunk_type,
+				 guint32 blocks,
+				 const guint8 *data,
+				 gsize data_len,
+				 gsize payload_sz)
+{
+	guint8 hdr[FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ] = { 0x0 };
+
+	fu_common_write_uint16 (hdr + 0x00, chunk_type, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x04, blocks, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x08, sizeof(hdr) + payload_sz, G_LITTLE_ENDIAN);
+	g_byte_array_append (buf, hdr, sizeof(hdr));
+	if (data_len > 0)
+		g_byte_array_append (buf, data, data_len);
+	if (payload_sz > data_len) {
+		guint len_old = buf->len;
+		g_byte_array_set_size (buf, len_old + payload_sz - data_len);
+		memset (buf->data + len_old, 0x0, payload_sz - data_len);
+	}
+	(*n_chunks)++;
+}
+
+static GByteArray *
+fu_fastboot_sparse_piece_new (guint32 blksz,
+			      guint32 total_blks,
+			      guint32 start_blk,
+			      guint32 *n_chunks)
+{
+	GByteArray *buf = g_byte_array_new ();
+	guint8 hdr[FU_FASTBOOT_SPARSE_HEADER_SZ] = { 0x0 };
+
+	/* total_chunks is written when the piece is finished */
+	fu_common_write_uint32 (hdr + 0x00, FU_FASTBOOT_SPARSE_HEADER_MAGIC, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x04, 1, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x06, 0, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x08, FU_FASTBOOT_SPARSE_HEADER_SZ, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x0a, FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x0c, blksz, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x10, total_blks, G_LITTLE_ENDIAN);
+	g_byte_array_append (buf, hdr, sizeof(hdr));
+
+	/* skip over the blocks sent in earlier pieces */
+	*n_chunks = 0;
+	if (start_blk > 0) {
+		fu_fastboot_sparse_append_chunk (buf, n_chunks,
+						 FU_FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE,
+						 start_blk, NULL, 0, 0);
+	}
+	return buf;
+}
+
+static GBytes *
+fu_fastboot_sparse_piece_finish (GByteArray *buf,
+				 guint32 *n_chunks,
+				 guint32 total_blks,
+				 guint32 end_blk)
+{
+	/* skip over the blocks sent in later pieces */
+	if (end_blk < total_blks) {
+		fu_fastboot_sparse_append_chunk (buf, n_chunks,
+						 FU_FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE,
+						 total_blks - end_blk, NULL, 0, 0);
+	}
+	fu_common_write_uint32 (buf->data + 0x14, *n_chunks, G_LITTLE_ENDIAN);
+	return g_byte_array_free_to_bytes (buf);
+}
+
+/**
+ * fu_fastboot_sparse_split:
+ * @blob: A #GBytes
+ * @max_size: The largest image the device can download, in bytes
+ *
+ * Splits an image into pieces that are each no larger than @max_size.
+ * Each piece is a valid sparse image covering every block of the original,
+ * with the blocks found in the other pieces marked as "don't care".
+ *
+ * Raw images that are too large are converted to sparse images, and images
+ * that already fit are returned as-is.
+ *
+ * Returns: (transfer container) (element-type GBytes): images, or %NULL for error
+ **/
+GPtrArray *
+fu_fastboot_sparse_split (GBytes *blob, gsize max_size, GError **error)
+{
+	guint32 blksz = 0;
+	guint32 cur_blk = 0;
+	guint32 n_chunks = 0;
+	guint32 total_blks = 0;
+	g_autoptr(GArray) chunks = NULL;
+	g_autoptr(GByteArray) piece = NULL;
+	g_autoptr(GPtrArray) pieces = NULL;
+
+	/* nothing to do */
+	pieces = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	if (g_bytes_get_size (blob) <= max_size) {
+		g_ptr_array_add (pieces, g_bytes_ref (blob));
+		return g_steal_pointer (&pieces);
+	}
+
+	/* get the list of chunks */
+	chunks = g_array_new (FALSE, FALSE, sizeof(FuFastbootSparseChunk));
+	if (fu_fastboot_sparse_is_sparse (blob)) {
+		if (!fu_fastboot_sparse_parse (blob, &blksz, &total_blks, chunks, error))
+			return NULL;
+	} else {
+		if (!fu_fastboot_sparse_parse_raw (blob, &blksz, &total_blks, chunks, error))
+			return NULL;
+	}
+
+	/* room for the header, both padding chunks and one block of data */
+	if (max_size < FU_FASTBOOT_SPARSE_HEADER_SZ +
+		       3 * FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ + blksz) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "max-download-size 0x%x too small for block size 0x%x",
+			     (guint) max_size, blksz);
+		return NULL;
+	}
+
+	for (guint i = 0; i < chunks->len; i++) {
+		FuFastbootSparseChunk *chk = &g_array_index (chunks, FuFastbootSparseChunk, i);
+		guint32 done = 0;
+		while (done < chk->blocks) {
+			gsize avail;
+			gsize used;
+			guint32 fit = 0;
+
+			/* start a new piece */
+			if (piece == NULL) {
+				piece = fu_fastboot_sparse_piece_new (blksz,
+								      total_blks,
+								      cur_blk,
+								      &n_chunks);
+			}
+
+			/* leave room for this chunk and the trailing padding */
+			used = piece->len + 2 * FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ;
+			avail = used < max_size ? max_size - used : 0;
+			if (chk->chunk_type == FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW) {
+				fit = MIN (chk->blocks - done, avail / blksz);
+			} else if (chk->chunk_type == FU_FASTBOOT_SPARSE_CHUNK_TYPE_FILL) {
+				if (avail >= chk->data_len)
+					fit = chk->blocks - done;
+			} else if (used <= max_size) {
+				fit = chk->blocks - done;
+			}
+
+			/* piece is full */
+			if (fit == 0) {
+				g_ptr_array_add (pieces,
+						 fu_fastboot_sparse_piece_finish (g_steal_pointer (&piece),
+										  &n_chunks,
+										  total_blks,
+										  cur_blk));
+				continue;
+			}
+
+			/* raw chunks can be split on any block boundary */
+			if (chk->chunk_type == FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW) {
+				gsize offset = (gsize) done * blksz;
+				gsize payload_sz = (gsize) fit * blksz;
+				gsize data_len = 0;
+				if (offset < chk->data_len)
+					data_len = MIN (payload_sz, chk->data_len - offset);
+				fu_fastboot_sparse_append_chunk (piece, &n_chunks,
+								 chk->chunk_type, fit,
+								 chk->data + offset,
+								 data_len, payload_sz);
+			} else {
+				fu_fastboot_sparse_append_chunk (piece, &n_chunks,
+								 chk->chunk_type, fit,
+								 chk->data,
+								 chk->data_len,
+								 chk->data_len);
+			}
+			done += fit;
+			cur_blk += fit;
+		}
+	}
+	if (piece != NULL) {
+		g_ptr_array_add (pieces,
+				 fu_fastboot_sparse_piece_finish (g_steal_pointer (&piece),
+								  &n_chunks,
+								  total_blks,
+								  cur_blk));
+	}
+
+	/* success */
+	return g_steal_pointer (&pieces);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FU_FASTBOOT_SPARSE_HEADER_MAGIC		0xed26ff3a
+#define FU_FASTBOOT_SPARSE_HEADER_SZ		28	/* bytes */
+#define FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ	12	/* bytes */
+#define FU_FASTBOOT_SPARSE_BLOCK_SZ		4096	/* bytes, for raw images */
+
+#define FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW	0xcac1
+#define FU_FASTBOOT_SPARSE_CHUNK_TYPE_FILL	0xcac2
+#define FU_FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE	0xcac3
+#define FU_FASTBOOT_SPARSE_CHUNK_TYPE_CRC32	0xcac4
+
+gboolean	 fu_fastboot_sparse_is_sparse		(GBytes		*blob);
+GPtrArray	*fu_fastboot_sparse_split		(GBytes		*blob,
+							 gsize		 max_size,
+							 GError		**error);
+
+G_END_DECLS
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-common.h"
+#include "fu-fastboot-sparse.h"
+
+#define FU_TEST_SPARSE_BLKSZ	0x1000
+
+/* write the blocks described by a sparse image into a raw buffer */
+static void
+fu_test_sparse_apply (GBytes *blob, guint8 *img, gsize imgsz)
+{
+	gsize bufsz = 0;
+	gsize offset = FU_FASTBOOT_SPARSE_HEADER_SZ;
+	guint32 blk = 0;
+	guint32 blksz;
+	guint32 total_blks;
+	guint32 total_chunks;
+	const guint8 *buf = g_bytes_get_data (blob, &bufsz);
+
+	g_assert_true (fu_fastboot_sparse_is_sparse (blob));
+	blksz = fu_common_read_uint32 (buf + 0x0c, G_LITTLE_ENDIAN);
+	total_blks = fu_common_read_uint32 (buf + 0x10, G_LITTLE_ENDIAN);
+	total_chunks = fu_common_read_uint32 (buf + 0x14, G_LITTLE_ENDIAN);
+	g_assert_cmpint ((gsize) total_blks * blksz, ==, imgsz);
+	for (guint32 i = 0; i < total_chunks; i++) {
+		guint16 chunk_type = fu_common_read_uint16 (buf + offset, G_LITTLE_ENDIAN);
+		guint32 blocks = fu_common_read_uint32 (buf + offset + 0x04, G_LITTLE_ENDIAN);
+		guint32 total_sz = fu_common_read_uint32 (buf + offset + 0x08, G_LITTLE_ENDIAN);
+		const guint8 *data = buf + offset + FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ;
+		g_assert_cmpint (offset + total_sz, <=, bufsz);
+		if (chunk_type == FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW) {
+			memcpy (img + (gsize) blk * blksz, data, (gsize) blocks * blksz);
+		} else if (chunk_type == FU_FASTBOOT_SPARSE_CHUNK_TYPE_FILL) {
+			for (gsize j = 0; j < (gsize) blocks * blksz; j += 4)
+				memcpy (img + (gsize) blk * blksz + j, data, 4);
+		} else {
+			g_assert_cmpint (chunk_type, ==, FU_FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE);
+		}
+		blk += blocks;
+		offset += total_sz;
+	}
+	g_assert_cmpint (offset, ==, bufsz);
+	g_assert_cmpint (blk, ==, total_blks);
+}
+
+static void
+fu_test_sparse_append_chunk (GByteArray *buf, guint16 chunk_type, guint32 blocks,
+			     const guint8 *data, gsize data_len)
+{
+	guint8 hdr[FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ] = { 0x0 };
+	fu_common_write_uint16 (hdr + 0x00, chunk_type, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x04, blocks, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x08, sizeof(hdr) + data_len, G_LITTLE_ENDIAN);
+	g_byte_array_append (buf, hdr, sizeof(hdr));
+	g_byte_array_append (buf, data, data_len);
+}
+
+static void
+fu_fastboot_sparse_split_func (void)
+{
+	const guint8 fill[] = { 0xde, 0xad, 0xbe, 0xef };
+	guint8 hdr[FU_FASTBOOT_SPARSE_HEADER_SZ] = { 0x0 };
+	g_autofree guint8 *raw = g_malloc (5 * FU_TEST_SPARSE_BLKSZ);
+	g_autofree guint8 *img1 = g_malloc0 (12 * FU_TEST_SPARSE_BLKSZ);
+	g_autofree guint8 *img2 = g_malloc0 (12 * FU_TEST_SPARSE_BLKSZ);
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) images = NULL;
+
+	/* RAW:3, FILL:2, DONT_CARE:1, RAW:2, CRC32, with 4 trailing blocks */
+	for (guint i = 0; i < 5 * FU_TEST_SPARSE_BLKSZ; i++)
+		raw[i] = g_random_int_range (0x00, 0xff);
+	fu_common_write_uint32 (hdr + 0x00, FU_FASTBOOT_SPARSE_HEADER_MAGIC, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x04, 1, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x08, FU_FASTBOOT_SPARSE_HEADER_SZ, G_LITTLE_ENDIAN);
+	fu_common_write_uint16 (hdr + 0x0a, FU_FASTBOOT_SPARSE_CHUNK_HEADER_SZ, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x0c, FU_TEST_SPARSE_BLKSZ, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x10, 12, G_LITTLE_ENDIAN);
+	fu_common_write_uint32 (hdr + 0x14, 5, G_LITTLE_ENDIAN);
+	g_byte_array_append (buf, hdr, sizeof(hdr));
+	fu_test_sparse_append_chunk (buf, FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW, 3,
+				     raw, 3 * FU_TEST_SPARSE_BLKSZ);
+	fu_test_sparse_append_chunk (buf, FU_FASTBOOT_SPARSE_CHUNK_TYPE_FILL, 2,
+				     fill, sizeof(fill));
+	fu_test_sparse_append_chunk (buf, FU_FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE, 1,
+				     NULL, 0);
+	fu_test_sparse_append_chunk (buf, FU_FASTBOOT_SPARSE_CHUNK_TYPE_RAW, 2,
+				     raw + 3 * FU_TEST_SPARSE_BLKSZ, 2 * FU_TEST_SPARSE_BLKSZ);
+	fu_test_sparse_append_chunk (buf, FU_FASTBOOT_SPARSE_CHUNK_TYPE_CRC32, 0,
+				     fill, sizeof(fill));
+	blob = g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+	g_assert_true (fu_fastboot_sparse_is_sparse (blob));
+	fu_test_sparse_apply (blob, img1, 12 * FU_TEST_SPARSE_BLKSZ);
+
+	/* fits already */
+	images = fu_fastboot_sparse_split (blob, g_bytes_get_size (blob), &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (images);
+	g_assert_cmpint (images->len, ==, 1);
+	g_assert_true (g_ptr_array_index (images, 0) == blob);
+	g_clear_pointer (&images, g_ptr_array_unref);
+
+	/* too small for even one block */
+	images = fu_fastboot_sparse_split (blob, FU_TEST_SPARSE_BLKSZ, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+	g_assert_null (images);
+	g_clear_error (&error);
+
+	/* each piece holds two blocks of data */
+	images = fu_fastboot_sparse_split (blob, 2 * FU_TEST_SPARSE_BLKSZ + 0x80, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (images);
+	g_assert_cmpint (images->len, ==, 3);
+	for (guint i = 0; i < images->len; i++) {
+		GBytes *img = g_ptr_array_index (images, i);
+		g_assert_cmpint (g_bytes_get_size (img), <=, 2 * FU_TEST_SPARSE_BLKSZ + 0x80);
+		fu_test_sparse_apply (img, img2, 12 * FU_TEST_SPARSE_BLKSZ);
+	}
+	g_assert_cmpint (memcmp (img1, img2, 12 * FU_TEST_SPARSE_BLKSZ), ==, 0);
+}
+
+static void
+fu_fastboot_sparse_split_raw_func (void)
+{
+	gsize rawsz = 3 * FU_TEST_SPARSE_BLKSZ + 0x123;
+	g_autofree guint8 *raw = g_malloc (rawsz);
+	g_autofree guint8 *img = g_malloc0 (4 * FU_TEST_SPARSE_BLKSZ);
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) images = NULL;
+
+	for (guint i = 0; i < rawsz; i++)
+		raw[i] = g_random_int_range (0x00, 0xff);
+	blob = g_bytes_new (raw, rawsz);
+	g_assert_false (fu_fastboot_sparse_is_sparse (blob));
+
+	/* converted to sparse, with the last block padded */
+	images = fu_fastboot_sparse_split (blob, 2 * FU_TEST_SPARSE_BLKSZ + 0x80, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (images);
+	g_assert_cmpint (images->len, ==, 2);
+	for (guint i = 0; i < images->len; i++)
+		fu_test_sparse_apply (g_ptr_array_index (images, i), img, 4 * FU_TEST_SPARSE_BLKSZ);
+	g_assert_cmpint (memcmp (img, raw, rawsz), ==, 0);
+	for (gsize i = rawsz; i < 4 * FU_TEST_SPARSE_BLKSZ; i++)
+		g_assert_cmpint (img[i], ==, 0x0);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	/* only critical and error are fatal */
+	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	/* log everything */
+	g_setenv ("G_MESSAGES_DEBUG", "all", FALSE);
+
+	/* tests go here */
+	g_test_add_func ("/fastboot/sparse{split}", fu_fastboot_sparse_split_func);
+	g_test_add_func ("/fastboot/sparse{split-raw}", fu_fastboot_sparse_split_raw_func);
+	return g_test_run ();
+}
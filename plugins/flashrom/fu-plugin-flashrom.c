@@ -21,14 +21,30 @@
 
 #include "config.h"
 
+#include <libflashrom.h>
 #include <string.h>
 
 #include "fu-plugin-vfuncs.h"
+#include "fu-plugin-flashrom.h"
+
+#define FLASHROM_PROGRAMMER_DEFAULT	"internal:laptop=force_I_want_a_brick"
+#define FLASHROM_REGIONS_DEFAULT	"bios"
 
 struct FuPluginData {
-	gchar			*flashrom_fn;
+	struct flashrom_programmer	*flashprog;
+	struct flashrom_flashctx	*flashctx;
+	gsize				 flash_size;
+	gboolean			 initialized;
 };
 
+/* libflashrom callbacks have no user data, so the device being updated is
+ * tracked here while the flash is open */
+static FuDevice *fu_plugin_flashrom_device = NULL;
+static gsize fu_plugin_flashrom_size = 0;
+#ifdef HAVE_FLASHROM_SET_PROGRESS_CALLBACK
+static struct flashrom_progress fu_plugin_flashrom_progress;
+#endif
+
 void
 fu_plugin_init (FuPlugin *plugin)
 {
@@ -41,7 +57,166 @@ void
 fu_plugin_destroy (FuPlugin *plugin)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
-	g_free (data->flashrom_fn);
+	if (data->initialized)
+		flashrom_shutdown ();
+}
+
+/**
+ * fu_plugin_flashrom_parse_address:
+ * @line: a line of libflashrom output, e.g. `0x000000-0x000fff:S, 0x001000-0x001fff:W`
+ *
+ * Finds the end of the highest block in a libflashrom progress line.
+ *
+ * Returns: the address after the highest block, or 0 for no blocks
+ **/
+guint64
+fu_plugin_flashrom_parse_address (const gchar *line)
+{
+	guint64 addr_best = 0x0;
+	g_auto(GStrv) blocks = NULL;
+
+	blocks = g_strsplit_set (line, ", \n\r", -1);
+	for (guint i = 0; blocks[i] != NULL; i++) {
+		const gchar *tmp = strchr (blocks[i], '-');
+		gchar *endptr = NULL;
+		guint64 addr_tmp;
+
+		/* the end address, with an optional status suffix */
+		if (tmp == NULL || !g_str_has_prefix (tmp + 1, "0x"))
+			continue;
+		addr_tmp = g_ascii_strtoull (tmp + 3, &endptr, 16);
+		if (endptr == tmp + 3 || (*endptr != '\0' && *endptr != ':'))
+			continue;
+		if (addr_tmp + 1 > addr_best)
+			addr_best = addr_tmp + 1;
+	}
+	return addr_best;
+}
+
+static int
+fu_plugin_flashrom_debug_cb (enum flashrom_log_level lvl, const char *fmt, va_list args)
+{
+	g_autofree gchar *tmp = g_strdup_vprintf (fmt, args);
+	g_strchomp (tmp);
+	if (tmp[0] == '\0')
+		return 0;
+	switch (lvl) {
+	case FLASHROM_MSG_ERROR:
+	case FLASHROM_MSG_WARN:
+		g_warning ("%s", tmp);
+		break;
+	case FLASHROM_MSG_INFO:
+	case FLASHROM_MSG_DEBUG:
+		g_debug ("%s", tmp);
+		break;
+	default:
+		break;
+	}
+
+#ifndef HAVE_FLASHROM_SET_PROGRESS_CALLBACK
+	/* older versions only report the block addresses in the log */
+	if (fu_plugin_flashrom_device != NULL && g_str_has_prefix (tmp, "0x")) {
+		fu_device_set_progress_full (fu_plugin_flashrom_device,
+					     fu_plugin_flashrom_parse_address (tmp),
+					     fu_plugin_flashrom_size);
+	}
+#endif
+	return 0;
+}
+
+#ifdef HAVE_FLASHROM_SET_PROGRESS_CALLBACK
+static void
+fu_plugin_flashrom_progress_cb (struct flashrom_flashctx *flashctx)
+{
+	struct flashrom_progress *progress = &fu_plugin_flashrom_progress;
+	if (fu_plugin_flashrom_device == NULL || progress->total == 0)
+		return;
+	switch (progress->stage) {
+	case FLASHROM_PROGRESS_READ:
+		fu_device_set_status (fu_plugin_flashrom_device, FWUPD_STATUS_DEVICE_READ);
+		break;
+	case FLASHROM_PROGRESS_ERASE:
+		fu_device_set_status (fu_plugin_flashrom_device, FWUPD_STATUS_DEVICE_ERASE);
+		break;
+	case FLASHROM_PROGRESS_WRITE:
+		fu_device_set_status (fu_plugin_flashrom_device, FWUPD_STATUS_DEVICE_WRITE);
+		break;
+	default:
+		break;
+	}
+	fu_device_set_progress_full (fu_plugin_flashrom_device,
+				     progress->current,
+				     progress->total);
+}
+#endif
+
+static gboolean
+fu_plugin_flashrom_open (FuPlugin *plugin, FuDevice *device, GError **error)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	const gchar *programmer = fu_device_get_metadata (device, "FlashromProgrammer");
+	g_auto(GStrv) split = NULL;
+
+	/* e.g. `internal:laptop=force_I_want_a_brick` */
+	if (programmer == NULL)
+		programmer = FLASHROM_PROGRAMMER_DEFAULT;
+	split = g_strsplit (programmer, ":", 2);
+	if (flashrom_programmer_init (&data->flashprog, split[0], split[1])) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "programmer %s initialization failed",
+			     split[0]);
+		return FALSE;
+	}
+	if (flashrom_flash_probe (&data->flashctx, data->flashprog, NULL)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_FOUND,
+				     "flash probe failed");
+		flashrom_programmer_shutdown (data->flashprog);
+		data->flashprog = NULL;
+		return FALSE;
+	}
+	data->flash_size = flashrom_flash_getsize (data->flashctx);
+	if (data->flash_size == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "flash size zero");
+		flashrom_flash_release (data->flashctx);
+		flashrom_programmer_shutdown (data->flashprog);
+		data->flashctx = NULL;
+		data->flashprog = NULL;
+		return FALSE;
+	}
+	fu_device_set_firmware_size_max (device, data->flash_size);
+
+	/* track progress */
+	fu_plugin_flashrom_device = device;
+	fu_plugin_flashrom_size = data->flash_size;
+#ifdef HAVE_FLASHROM_SET_PROGRESS_CALLBACK
+	memset (&fu_plugin_flashrom_progress, 0, sizeof(fu_plugin_flashrom_progress));
+	flashrom_set_progress_callback (data->flashctx,
+					fu_plugin_flashrom_progress_cb,
+					&fu_plugin_flashrom_progress);
+#endif
+	return TRUE;
+}
+
+static void
+fu_plugin_flashrom_close (FuPlugin *plugin)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	fu_plugin_flashrom_device = NULL;
+	if (data->flashctx != NULL) {
+		flashrom_flash_release (data->flashctx);
+		data->flashctx = NULL;
+	}
+	if (data->flashprog != NULL) {
+		flashrom_programmer_shutdown (data->flashprog);
+		data->flashprog = NULL;
+	}
 }
 
 gboolean
@@ -49,10 +224,17 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
 	GPtrArray *hwids;
-	g_autoptr(GError) error_local = NULL;
 
-	/* we need flashrom from the host system */
-	data->flashrom_fn = fu_common_find_program_in_path ("flashrom", &error_local);
+	/* libflashrom has no context, so this is process-wide */
+	if (flashrom_init (1)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "flashrom initialization error");
+		return FALSE;
+	}
+	data->initialized = TRUE;
+	flashrom_set_log_callback (fu_plugin_flashrom_debug_cb);
 
 	/* search for devices */
 	hwids = fu_plugin_get_hwids (plugin);
@@ -65,20 +247,28 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 							  quirk_key_prefixed,
 							  "DeviceId");
 		if (quirk_str != NULL) {
+			const gchar *programmer;
+			const gchar *regions;
 			g_autofree gchar *device_id = g_strdup_printf ("flashrom-%s", quirk_str);
 			g_autoptr(FuDevice) dev = fu_device_new ();
 			fu_device_set_id (dev, device_id);
 			fu_device_set_quirks (dev, fu_plugin_get_quirks (plugin));
 			fu_device_add_flag (dev, FWUPD_DEVICE_FLAG_INTERNAL);
-			if (data->flashrom_fn != NULL) {
-				fu_device_add_flag (dev, FWUPD_DEVICE_FLAG_UPDATABLE);
-			} else {
-				fu_device_set_update_error (dev, error_local->message);
-			}
+			fu_device_add_flag (dev, FWUPD_DEVICE_FLAG_UPDATABLE);
 			fu_device_add_guid (dev, guid);
 			fu_device_set_name (dev, fu_plugin_get_dmi_value (plugin, FU_HWIDS_KEY_PRODUCT_NAME));
 			fu_device_set_vendor (dev, fu_plugin_get_dmi_value (plugin, FU_HWIDS_KEY_MANUFACTURER));
 			fu_device_set_version (dev, fu_plugin_get_dmi_value (plugin, FU_HWIDS_KEY_BIOS_VERSION));
+			regions = fu_plugin_lookup_quirk_by_id (plugin,
+								quirk_key_prefixed,
+								"FlashromRegions");
+			fu_device_set_metadata (dev, "FlashromRegions",
+						regions != NULL ? regions : FLASHROM_REGIONS_DEFAULT);
+			programmer = fu_plugin_lookup_quirk_by_id (plugin,
+								   quirk_key_prefixed,
+								   "FlashromProgrammer");
+			if (programmer != NULL)
+				fu_device_set_metadata (dev, "FlashromProgrammer", programmer);
 			fu_plugin_device_add (plugin, dev);
 			fu_plugin_cache_add (plugin, device_id, dev);
 			break;
@@ -87,44 +277,6 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 	return TRUE;
 }
 
-static guint
-fu_plugin_flashrom_parse_percentage (const gchar *lines_verbose)
-{
-	const guint64 addr_highest = 0x800000;
-	guint64 addr_best = 0x0;
-	g_auto(GStrv) chunks = NULL;
-
-	/* parse 0x000000-0x000fff:S, 0x001000-0x001fff:S */
-	chunks = g_strsplit_set (lines_verbose, "x-:S, \n\r", -1);
-	for (guint i = 0; chunks[i] != NULL; i++) {
-		guint64 addr_tmp;
-		if (strlen (chunks[i]) != 6)
-			continue;
-		addr_tmp = g_ascii_strtoull (chunks[i], NULL, 16);
-		if (addr_tmp > addr_best)
-			addr_best = addr_tmp;
-	}
-	return (addr_best * 100) / addr_highest;
-}
-
-static void
-fu_plugin_flashrom_read_cb (const gchar *line, gpointer user_data)
-{
-	FuDevice *device = FU_DEVICE (user_data);
-	if (g_strcmp0 (line, "Reading flash...") == 0)
-		fu_device_set_status (device, FWUPD_STATUS_DEVICE_VERIFY);
-	fu_device_set_progress (device, fu_plugin_flashrom_parse_percentage (line));
-}
-
-static void
-fu_plugin_flashrom_write_cb (const gchar *line, gpointer user_data)
-{
-	FuDevice *device = FU_DEVICE (user_data);
-	if (g_strcmp0 (line, "Writing flash...") == 0)
-		fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	fu_device_set_progress (device, fu_plugin_flashrom_parse_percentage (line));
-}
-
 gboolean
 fu_plugin_update_prepare (FuPlugin *plugin,
 			  FwupdInstallFlags flags,
@@ -134,6 +286,8 @@ fu_plugin_update_prepare (FuPlugin *plugin,
 	FuPluginData *data = fu_plugin_get_data (plugin);
 	g_autofree gchar *firmware_orig = NULL;
 	g_autofree gchar *basename = NULL;
+	g_autofree guint8 *buf = NULL;
+	g_autoptr(GBytes) blob = NULL;
 
 	/* not us */
 	if (fu_plugin_cache_lookup (plugin, fu_device_get_id (device)) == NULL)
@@ -143,22 +297,62 @@ fu_plugin_update_prepare (FuPlugin *plugin,
 	basename = g_strdup_printf ("flashrom-%s.bin", fu_device_get_id (device));
 	firmware_orig = g_build_filename (LOCALSTATEDIR, "lib", "fwupd",
 					  "builder", basename, NULL);
+	if (g_file_test (firmware_orig, G_FILE_TEST_EXISTS))
+		return TRUE;
 	if (!fu_common_mkdir_parent (firmware_orig, error))
 		return FALSE;
-	if (!g_file_test (firmware_orig, G_FILE_TEST_EXISTS)) {
-		const gchar *argv[] = {
-			data->flashrom_fn,
-			"--programmer", "internal:laptop=force_I_want_a_brick",
-			"--read", firmware_orig,
-			"--verbose", NULL };
-		if (!fu_common_spawn_sync ((const gchar * const *) argv,
-					   fu_plugin_flashrom_read_cb, device,
-					   0, NULL, error)) {
-			g_prefix_error (error, "failed to get original firmware: ");
+	if (!fu_plugin_flashrom_open (plugin, device, error))
+		return FALSE;
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_READ);
+	buf = g_malloc0 (data->flash_size);
+	if (flashrom_image_read (data->flashctx, buf, data->flash_size)) {
+		fu_plugin_flashrom_close (plugin);
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_READ,
+				     "failed to get original firmware");
+		return FALSE;
+	}
+	blob = g_bytes_new_take (g_steal_pointer (&buf), data->flash_size);
+	fu_plugin_flashrom_close (plugin);
+	return fu_common_set_contents_bytes (firmware_orig, blob, error);
+}
+
+static gboolean
+fu_plugin_flashrom_get_layout (FuPlugin *plugin,
+			       FuDevice *device,
+			       const guint8 *buf,
+			       gsize bufsz,
+			       struct flashrom_layout **layout_out,
+			       GError **error)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	const gchar *regions_str = fu_device_get_metadata (device, "FlashromRegions");
+	struct flashrom_layout *layout = NULL;
+	g_auto(GStrv) regions = NULL;
+
+	/* the Intel flash descriptor, or else a coreboot FMAP */
+	if (flashrom_layout_read_from_ifd (&layout, data->flashctx, buf, bufsz) != 0 &&
+	    flashrom_layout_read_fmap_from_buffer (&layout, data->flashctx, buf, bufsz) != 0) {
+		g_debug ("no IFD or FMAP layout in image, writing whole chip");
+		*layout_out = NULL;
+		return TRUE;
+	}
+
+	/* only write the regions that are meant to be updated */
+	regions = g_strsplit (regions_str, ",", -1);
+	for (guint i = 0; regions[i] != NULL; i++) {
+		g_debug ("including layout region %s", regions[i]);
+		if (flashrom_layout_include_region (layout, regions[i])) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "no %s region in layout", regions[i]);
+			flashrom_layout_release (layout);
 			return FALSE;
 		}
 	}
-
+	*layout_out = layout;
 	return TRUE;
 }
 
@@ -170,34 +364,49 @@ fu_plugin_update (FuPlugin *plugin,
 		  GError **error)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
-	g_autofree gchar *firmware_fn = NULL;
-	g_autofree gchar *tmpdir = NULL;
-	const gchar *argv[] = {
-		data->flashrom_fn,
-		"--programmer", "internal:laptop=force_I_want_a_brick",
-		"--write", "xxx",
-		"--verbose", NULL };
-
-	/* write blob to temp location */
-	tmpdir = g_dir_make_tmp ("fwupd-XXXXXX", error);
-	if (tmpdir == NULL)
-		return FALSE;
-	firmware_fn = g_build_filename (tmpdir, "flashrom-firmware.bin", NULL);
-	if (!fu_common_set_contents_bytes (firmware_fn, blob_fw, error))
+	gsize sz = 0;
+	struct flashrom_layout *layout = NULL;
+	g_autofree guint8 *buf = NULL;
+
+	if (!fu_plugin_flashrom_open (plugin, device, error))
 		return FALSE;
 
-	/* use flashrom to write image */
-	argv[4] = firmware_fn;
-	if (!fu_common_spawn_sync ((const gchar * const *) argv,
-				   fu_plugin_flashrom_write_cb, device,
-				   0, NULL, error)) {
-		g_prefix_error (error, "failed to write firmware: ");
+	/* libflashrom may modify the buffer */
+	buf = g_memdup (g_bytes_get_data (blob_fw, &sz), sz);
+	if (sz != data->flash_size) {
+		fu_plugin_flashrom_close (plugin);
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "invalid image size 0x%x, expected 0x%x",
+			     (guint) sz, (guint) data->flash_size);
 		return FALSE;
 	}
 
-	/* delete temp location */
-	if (!fu_common_rmtree (tmpdir, error))
+	/* write only the target regions; blocks that already match are skipped */
+	if (!fu_plugin_flashrom_get_layout (plugin, device, buf, sz, &layout, error)) {
+		fu_plugin_flashrom_close (plugin);
 		return FALSE;
+	}
+	if (layout != NULL)
+		flashrom_layout_set (data->flashctx, layout);
+	flashrom_flag_set (data->flashctx, FLASHROM_FLAG_VERIFY_AFTER_WRITE, TRUE);
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	if (flashrom_image_write (data->flashctx, buf, sz, NULL)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_WRITE,
+				     "image write failed");
+		flashrom_layout_set (data->flashctx, NULL);
+		if (layout != NULL)
+			flashrom_layout_release (layout);
+		fu_plugin_flashrom_close (plugin);
+		return FALSE;
+	}
+	flashrom_layout_set (data->flashctx, NULL);
+	if (layout != NULL)
+		flashrom_layout_release (layout);
+	fu_plugin_flashrom_close (plugin);
 
 	/* success */
 	return TRUE;
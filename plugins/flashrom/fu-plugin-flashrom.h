@@ -0,0 +1,11 @@
+/*
+ * Copyright (C) 2017 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "fu-plugin.h"
+
+guint64	 fu_plugin_flashrom_parse_address	(const gchar	*line);
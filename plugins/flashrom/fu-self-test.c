@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include <fwupd.h>
+
+#include "fu-hwids.h"
+#include "fu-plugin-private.h"
+#include "fu-plugin-vfuncs.h"
+#include "fu-plugin-flashrom.h"
+
+static void
+fu_plugin_flashrom_parse_address_func (void)
+{
+	struct {
+		const gchar	*line;
+		guint64		 addr;
+	} map[] = {
+		{ "0x000000-0x000fff:S, 0x001000-0x001fff:S",	0x2000 },
+		{ "0xb00000-0xbfffff:W",			0xc00000 },
+		{ "0x1ff000-0x1fffff:EW\n",			0x200000 },
+		{ "0x000000-0x000fff",				0x1000 },
+		{ "Erasing and writing flash chip... ",		0x0 },
+		{ "0x000000-0xfoo",				0x0 },
+	};
+	for (guint i = 0; i < G_N_ELEMENTS (map); i++) {
+		g_assert_cmpint (fu_plugin_flashrom_parse_address (map[i].line), ==,
+				 map[i].addr);
+	}
+}
+
+static void
+fu_plugin_flashrom_update_func (void)
+{
+	gboolean ret;
+	gsize sz = 0x400000;
+	guint8 *buf = g_malloc (sz);
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuHwids) hwids = fu_hwids_new ();
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_small = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* no hardware matches, but libflashrom is initialized */
+	fu_plugin_init (plugin);
+	fu_plugin_set_hwids (plugin, hwids);
+	ret = fu_plugin_startup (plugin, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* an image for the emulated 4MiB SPI chip */
+	for (gsize i = 0; i < sz; i++)
+		buf[i] = (guint8) (i * 7);
+	blob = g_bytes_new_take (buf, sz);
+	fu_device_set_id (device, "flashrom-test");
+	fu_device_set_metadata (device, "FlashromProgrammer",
+				"dummy:bus=spi,emulate=SST25VF032B");
+	fu_device_set_metadata (device, "FlashromRegions", "bios");
+
+	/* wrong size */
+	blob_small = g_bytes_new_from_bytes (blob, 0x0, 0x1000);
+	ret = fu_plugin_update (plugin, device, blob_small,
+				FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_false (ret);
+	g_clear_error (&error);
+
+	/* no layout, so the whole chip is written and verified */
+	ret = fu_plugin_update (plugin, device, blob,
+				FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	fu_plugin_destroy (plugin);
+}
+
+static void
+fu_plugin_flashrom_destroy_func (void)
+{
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+
+	/* libflashrom is not shut down if it was never initialized */
+	fu_plugin_init (plugin);
+	fu_plugin_destroy (plugin);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	/* only critical and error are fatal */
+	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	/* tests go here */
+	g_test_add_func ("/flashrom/parse-address", fu_plugin_flashrom_parse_address_func);
+	g_test_add_func ("/flashrom/update{dummy}", fu_plugin_flashrom_update_func);
+	g_test_add_func ("/flashrom/destroy", fu_plugin_flashrom_destroy_func);
+	return g_test_run ();
+}
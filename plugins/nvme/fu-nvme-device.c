@@ -7,6 +7,7 @@
 #include "config.h"
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/errno.h>
 #include <sys/ioctl.h>
@@ -17,17 +18,21 @@
 
 #include <linux/nvme_ioctl.h>
 
-#include "fu-chunk.h"
 #include "fu-nvme-common.h"
 #include "fu-nvme-device.h"
 
-#define FU_NVME_ID_CTRL_SIZE	0x1000
+#define FU_NVME_ID_CTRL_SIZE		0x1000
+#define FU_NVME_PAGE_SIZE		0x1000		/* assume CAP.MPSMIN is 4K */
+#define FU_NVME_TRANSFER_SIZE_MAX	0x20000		/* when MDTS has no limit */
 
 struct _FuNvmeDevice {
 	FuUdevDevice		 parent_instance;
 	guint			 pci_depth;
 	gint			 fd;
-	guint64			 write_block_size;
+	guint64			 write_block_size;	/* from quirk */
+	guint64			 fwug;			/* bytes, or 0 for unknown */
+	guint64			 mdts;			/* bytes, or 0 for no limit */
+	gdouble			 write_throughput;	/* bytes/s */
 };
 
 G_DEFINE_TYPE (FuNvmeDevice, fu_nvme_device, FU_TYPE_UDEV_DEVICE)
@@ -46,6 +51,20 @@ fu_nvme_device_to_string (FuDevice *device, GString *str)
 	g_string_append (str, "  FuNvmeDevice:\n");
 	g_string_append_printf (str, "    fd:\t\t\t%i\n", self->fd);
 	g_string_append_printf (str, "    pci-depth:\t\t%u\n", self->pci_depth);
+	if (self->fwug > 0) {
+		g_string_append_printf (str, "    fwug:\t\t0x%" G_GINT64_MODIFIER "x\n",
+					self->fwug);
+	}
+	if (self->mdts > 0) {
+		g_string_append_printf (str, "    mdts:\t\t0x%" G_GINT64_MODIFIER "x\n",
+					self->mdts);
+	}
+	g_string_append_printf (str, "    transfer-size:\t0x%" G_GINT64_MODIFIER "x\n",
+				fu_nvme_device_get_transfer_size (self));
+	if (self->write_throughput > 0.f) {
+		g_string_append_printf (str, "    write-throughput:\t%.1f KiB/s\n",
+					self->write_throughput / 1024.f);
+	}
 }
 
 /* @addr_start and @addr_end are *inclusive* to match the NMVe specification */
@@ -170,6 +189,49 @@ fu_nvme_device_fw_download (FuNvmeDevice *self,
 	return fu_nvme_device_submit_admin_passthru (self, &cmd, error);
 }
 
+/**
+ * fu_nvme_device_get_transfer_size:
+ * @self: A #FuNvmeDevice
+ *
+ * Gets the largest FW_DOWNLOAD transfer that is legal for the controller,
+ * i.e. the largest multiple of FWUG that does not exceed MDTS. If FWUG is
+ * larger than MDTS then the transfer is clamped to MDTS.
+ *
+ * Returns: size in bytes
+ **/
+guint64
+fu_nvme_device_get_transfer_size (FuNvmeDevice *self)
+{
+	guint64 limit;
+
+	/* set from a quirk */
+	if (self->write_block_size > 0)
+		return self->write_block_size;
+
+	/* no granularity information, so use the smallest safe size */
+	if (self->fwug == 0)
+		return FU_NVME_PAGE_SIZE;
+
+	/* no transfer can be both a multiple of FWUG and within MDTS, so
+	 * never exceed what the controller can actually transfer */
+	limit = self->mdts > 0 ? self->mdts : FU_NVME_TRANSFER_SIZE_MAX;
+	if (self->fwug > limit)
+		return limit;
+	return limit - (limit % self->fwug);
+}
+
+/* the smallest transfer the controller accepts, which is also the alignment
+ * of every offset written */
+static guint64
+fu_nvme_device_get_transfer_size_min (FuNvmeDevice *self)
+{
+	if (self->write_block_size > 0)
+		return self->write_block_size;
+	if (self->fwug > 0)
+		return MIN (self->fwug, fu_nvme_device_get_transfer_size (self));
+	return FU_NVME_PAGE_SIZE;
+}
+
 static void
 fu_nvme_device_parse_cns_maybe_dell (FuNvmeDevice *self, const guint8 *buf)
 {
@@ -242,6 +304,7 @@ fu_nvme_device_parse_cns (FuNvmeDevice *self, const guint8 *buf, gsize sz, GErro
 {
 	guint8 fawr;
 	guint8 fwug;
+	guint8 mdts;
 	guint8 nfws;
 	guint8 s1ro;
 	g_autofree gchar *gu = NULL;
@@ -273,10 +336,17 @@ fu_nvme_device_parse_cns (FuNvmeDevice *self, const guint8 *buf, gsize sz, GErro
 			return FALSE;
 	}
 
-	/* firmware update granularity (FWUG) */
+	/* maximum data transfer size (MDTS) in units of the minimum page size */
+	mdts = buf[77];
+	if (mdts > 0 && mdts < 32)
+		self->mdts = ((guint64) FU_NVME_PAGE_SIZE) << mdts;
+
+	/* firmware update granularity (FWUG), where 0xff is no restriction */
 	fwug = buf[319];
-	if (fwug != 0x00 && fwug != 0xff)
-		self->write_block_size = ((guint64) fwug) * 0x1000;
+	if (fwug == 0xff)
+		self->fwug = FU_NVME_PAGE_SIZE;
+	else if (fwug != 0x00)
+		self->fwug = ((guint64) fwug) * 0x1000;
 
 	/* firmware slot information */
 	fawr = (buf[260] & 0x10) >> 4;
@@ -394,39 +464,76 @@ static gboolean
 fu_nvme_device_write_firmware (FuDevice *device, GBytes *fw, GError **error)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
+	const guint8 *data;
+	gsize data_sz = 0;
+	gpointer buf = NULL;
+	guint64 block_size = fu_nvme_device_get_transfer_size (self);
+	guint64 block_size_min = fu_nvme_device_get_transfer_size_min (self);
 	g_autoptr(GBytes) fw2 = NULL;
-	g_autoptr(GPtrArray) chunks = NULL;
-	guint64 block_size = self->write_block_size > 0 ?
-			     self->write_block_size : 0x1000;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* the controller limits are contradictory */
+	if (self->write_block_size == 0 && self->fwug > block_size) {
+		g_warning ("firmware update granularity 0x%x is larger "
+			   "than the maximum transfer size, using 0x%x",
+			   (guint) self->fwug, (guint) block_size);
+	}
 
 	/* some vendors provide firmware files whose sizes are not multiples
 	 * of blksz *and* the device won't accept blocks of different sizes */
 	if (fu_device_has_custom_flag (device, "force-align")) {
-		fw2 = fu_common_bytes_align (fw, block_size, 0xff);
+		fw2 = fu_common_bytes_align (fw, block_size_min, 0xff);
 	} else {
 		fw2 = g_bytes_ref (fw);
 	}
+	data = g_bytes_get_data (fw2, &data_sz);
 
-	/* build packets */
-	chunks = fu_chunk_array_new_from_bytes (fw2,
-						0x00,		/* start_addr */
-						0x00,		/* page_sz */
-						block_size);	/* block size */
+	/* the same page-aligned buffer is reused for every command so the
+	 * kernel can map it directly rather than using a bounce buffer */
+	if (posix_memalign (&buf, FU_NVME_PAGE_SIZE, block_size) != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to allocate 0x%x bytes",
+			     (guint) block_size);
+		return FALSE;
+	}
 
 	/* write each block */
+	g_debug ("using transfer size of 0x%x", (guint) block_size);
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_nvme_device_fw_download (self,
-						 chk->address,
-						 chk->data,
-						 chk->data_sz,
-						 error)) {
-			g_prefix_error (error, "failed to write chunk %u: ", i);
+	for (gsize addr = 0; addr < data_sz; ) {
+		guint32 chunk_sz = MIN (data_sz - addr, block_size);
+		g_autoptr(GError) error_local = NULL;
+		memcpy (buf, data + addr, chunk_sz);
+		if (!fu_nvme_device_fw_download (self, addr, buf, chunk_sz,
+						 &error_local)) {
+			/* try again with a smaller transfer size */
+			if (block_size / 2 >= block_size_min &&
+			    (block_size / 2) % block_size_min == 0) {
+				g_debug ("failed to write 0x%x bytes at 0x%x, "
+					 "retrying with smaller transfer: %s",
+					 chunk_sz, (guint) addr,
+					 error_local->message);
+				block_size /= 2;
+				continue;
+			}
+			g_propagate_prefixed_error (error,
+						    g_steal_pointer (&error_local),
+						    "failed to write chunk at 0x%x: ",
+						    (guint) addr);
+			free (buf);
 			return FALSE;
 		}
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len + 1);
+		addr += chunk_sz;
+		fu_device_set_progress_full (device, addr, data_sz);
 	}
+	free (buf);
+
+	/* this is useful when tuning the quirk */
+	self->write_throughput = (gdouble) data_sz / g_timer_elapsed (timer, NULL);
+	g_debug ("wrote 0x%x bytes at %.1f KiB/s",
+		 (guint) data_sz, self->write_throughput / 1024.f);
 
 	/* commit */
 	if (!fu_nvme_device_fw_commit (self,
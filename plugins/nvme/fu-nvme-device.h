@@ -17,5 +17,6 @@ FuNvmeDevice	*fu_nvme_device_new			(FuUdevDevice	*device);
 FuNvmeDevice	*fu_nvme_device_new_from_blob		(const guint8	*buf,
 							 gsize		 sz,
 							 GError		**error);
+guint64		 fu_nvme_device_get_transfer_size	(FuNvmeDevice	*self);
 
 G_END_DECLS
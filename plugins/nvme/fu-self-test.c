@@ -35,6 +35,45 @@ fu_nvme_cns_func (void)
 	g_assert_cmpstr (fu_device_get_version (FU_DEVICE (dev)), ==, "410557LA");
 	g_assert_cmpstr (fu_device_get_serial (FU_DEVICE (dev)), ==, "37RSDEADBEEF");
 	g_assert_cmpstr (fu_device_get_guid_default (FU_DEVICE (dev)), ==, "e1409b09-50cf-5aef-8ad8-760b9022f88d");
+
+	/* no FWUG, so use the smallest transfer size */
+	g_assert_cmpint (fu_nvme_device_get_transfer_size (dev), ==, 0x1000);
+}
+
+static void
+fu_nvme_cns_transfer_size_func (void)
+{
+	gboolean ret;
+	gsize sz;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *path = NULL;
+	g_autoptr(GError) error = NULL;
+	struct {
+		guint8	 mdts;
+		guint8	 fwug;
+		guint64	 transfer_size;
+	} map[] = {
+		{ 0x00,	0x00,	0x1000 },	/* no information */
+		{ 0x05,	0x02,	0x20000 },	/* 128KiB max, 8KiB granularity */
+		{ 0x05,	0x03,	0x1e000 },	/* largest multiple of 12KiB */
+		{ 0x00,	0xff,	0x20000 },	/* no limit, no restriction */
+		{ 0x01,	0x04,	0x2000 },	/* granularity larger than MDTS */
+	};
+
+	path = fu_test_get_filename (TESTDATADIR, "TOSHIBA_THNSN5512GPU7.bin");
+	g_assert_nonnull (path);
+	ret = g_file_get_contents (path, &data, &sz, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	for (guint i = 0; i < G_N_ELEMENTS (map); i++) {
+		g_autoptr(FuNvmeDevice) dev = NULL;
+		data[77] = map[i].mdts;
+		data[319] = map[i].fwug;
+		dev = fu_nvme_device_new_from_blob ((guint8 *)data, sz, &error);
+		g_assert_no_error (error);
+		g_assert_nonnull (dev);
+		g_assert_cmpint (fu_nvme_device_get_transfer_size (dev), ==, map[i].transfer_size);
+	}
 }
 
 static void
@@ -84,6 +123,7 @@ main (int argc, char **argv)
 
 	/* tests go here */
 	g_test_add_func ("/fwupd/cns", fu_nvme_cns_func);
+	g_test_add_func ("/fwupd/cns{transfer-size}", fu_nvme_cns_transfer_size_func);
 	g_test_add_func ("/fwupd/cns{all}", fu_nvme_cns_all_func);
 	return g_test_run ();
 }
@@ -51,6 +51,9 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 	GBytes *smbios_data = fu_plugin_get_smbios_data (plugin, REDFISH_SMBIOS_TABLE_TYPE);
 	g_autofree gchar *redfish_uri = NULL;
 	g_autofree gchar *ca_check = NULL;
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *cache_filename = NULL;
+	g_autofree gchar *max_connections = NULL;
 
 	/* read the conf file */
 	redfish_uri = fu_plugin_get_config_value (plugin, "Uri");
@@ -109,6 +112,25 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 	else
 		fu_redfish_client_set_cacheck (data->client, TRUE);
 
+	max_connections = fu_plugin_get_config_value (plugin, "MaxConnections");
+	if (max_connections != NULL) {
+		guint64 tmp = fu_common_strtoull (max_connections);
+		if (tmp == 0 || tmp > G_MAXUINT) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "invalid MaxConnections: %s",
+				     max_connections);
+			return FALSE;
+		}
+		fu_redfish_client_set_max_connections (data->client, (guint) tmp);
+	}
+
+	/* reuse unchanged inventory from the last daemon start */
+	cachedir = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	cache_filename = g_build_filename (cachedir, "redfish", "inventory.ini", NULL);
+	fu_redfish_client_set_cache_filename (data->client, cache_filename);
+
 	return fu_redfish_client_setup (data->client, smbios_data, error);
 }
 
@@ -13,6 +13,7 @@
 #include "fwupd-error.h"
 #include "fwupd-enums.h"
 
+#include "fu-common.h"
 #include "fu-device.h"
 
 #include "fu-redfish-client.h"
@@ -31,9 +32,39 @@ struct _FuRedfishClient
 	gboolean		 auth_created;
 	gboolean		 use_https;
 	gboolean		 cacheck;
+	guint			 max_connections;
+	guint			 task_poll_interval;	/* ms */
+	gchar			*expand_query;
+	gchar			*cache_filename;
+	GKeyFile		*etag_cache;
+	GHashTable		*etag_seen;	/* cache key:NULL */
+	JsonParser		*parser;
 	GPtrArray		*devices;
 };
 
+typedef struct {
+	FuRedfishClient		*self;
+	GMainLoop		*loop;
+	GPtrArray		*uris;		/* (element-type utf8) */
+	GPtrArray		*members;	/* (element-type JsonObject) */
+	guint			 idx_next;
+	guint			 in_flight;
+	GError			*error;
+} FuRedfishClientCrawlHelper;
+
+typedef struct {
+	FuRedfishClient		*self;
+	FuDevice		*device;
+	GMainLoop		*loop;
+	gsize			 bytes_total;
+	gsize			 bytes_written;
+	SoupURI			*task_uri;
+	gchar			*task_uri_str;
+	guint			 task_poll_interval;	/* ms */
+	gint64			 task_deadline;		/* us */
+	GError			*error;
+} FuRedfishClientUploadHelper;
+
 G_DEFINE_TYPE (FuRedfishClient, fu_redfish_client, G_TYPE_OBJECT)
 
 static void
@@ -58,42 +89,196 @@ fu_redfish_client_set_auth (FuRedfishClient *self, SoupURI *uri,
 	}
 }
 
-static GBytes *
-fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GError **error)
+static SoupMessage *
+fu_redfish_client_build_message_for_uri (FuRedfishClient *self,
+					 SoupURI *uri,
+					 GError **error)
+{
+	SoupMessage *msg;
+	g_autofree gchar *etag = NULL;
+	g_autofree gchar *cache_key = NULL;
+
+	msg = soup_message_new_from_uri (SOUP_METHOD_GET, uri);
+	if (msg == NULL) {
+		g_autofree gchar *tmp = soup_uri_to_string (uri, FALSE);
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "failed to create message for URI %s", tmp);
+		return NULL;
+	}
+	fu_redfish_client_set_auth (self, uri, msg);
+
+	/* only ask for the body if it changed since the last crawl */
+	cache_key = soup_uri_to_string (uri, TRUE);
+	etag = g_key_file_get_string (self->etag_cache, cache_key, "ETag", NULL);
+	if (etag != NULL) {
+		soup_message_headers_replace (msg->request_headers,
+					      "If-None-Match", etag);
+	}
+	return msg;
+}
+
+static SoupMessage *
+fu_redfish_client_build_message (FuRedfishClient *self,
+				 const gchar *uri_path,
+				 const gchar *query,
+				 GError **error)
 {
-	guint status_code;
-	g_autoptr(SoupMessage) msg = NULL;
 	g_autoptr(SoupURI) uri = NULL;
 
 	/* create URI */
 	uri = soup_uri_new (NULL);
 	soup_uri_set_scheme (uri, self->use_https ? "https" : "http");
 	soup_uri_set_path (uri, uri_path);
+	soup_uri_set_query (uri, query);
 	soup_uri_set_host (uri, self->hostname);
 	soup_uri_set_port (uri, self->port);
-	msg = soup_message_new_from_uri (SOUP_METHOD_GET, uri);
-	if (msg == NULL) {
-		g_autofree gchar *tmp = soup_uri_to_string (uri, FALSE);
+	return fu_redfish_client_build_message_for_uri (self, uri, error);
+}
+
+static gsize
+fu_redfish_client_get_etag_cache_size (FuRedfishClient *self)
+{
+	gsize len = 0;
+	g_auto(GStrv) groups = g_key_file_get_groups (self->etag_cache, &len);
+	return len;
+}
+
+static GBytes *
+fu_redfish_client_process_response (FuRedfishClient *self,
+				    SoupMessage *msg,
+				    GError **error)
+{
+	const gchar *etag;
+	SoupURI *uri = soup_message_get_uri (msg);
+	g_autofree gchar *cache_key = soup_uri_to_string (uri, TRUE);
+
+	/* keep the entry when the cache is next saved */
+	g_hash_table_add (self->etag_seen, g_strdup (cache_key));
+
+	/* use the body we saw last time */
+	if (msg->status_code == SOUP_STATUS_NOT_MODIFIED) {
+		g_autofree gchar *data = NULL;
+		data = g_key_file_get_string (self->etag_cache, cache_key, "Data", NULL);
+		if (data != NULL) {
+			gsize datasz = strlen (data);
+			return g_bytes_new_take (g_steal_pointer (&data), datasz);
+		}
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to create message for URI %s", tmp);
+			     "%s not modified but no cached data", cache_key);
 		return NULL;
 	}
-	fu_redfish_client_set_auth (self, uri, msg);
-	status_code = soup_session_send_message (self->session, msg);
-	if (status_code != SOUP_STATUS_OK) {
+	if (msg->status_code != SOUP_STATUS_OK) {
 		g_autofree gchar *tmp = soup_uri_to_string (uri, FALSE);
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
 			     "failed to download %s: %s",
-			     tmp, soup_status_get_phrase (status_code));
+			     tmp, soup_status_get_phrase (msg->status_code));
 		return NULL;
 	}
+
+	/* save for next time, unless the body is too large to be worth it */
+	etag = soup_message_headers_get_one (msg->response_headers, "ETag");
+	if (etag != NULL &&
+	    msg->response_body->length <= FU_REDFISH_CLIENT_ETAG_DATA_MAX &&
+	    (g_key_file_has_group (self->etag_cache, cache_key) ||
+	     fu_redfish_client_get_etag_cache_size (self) < FU_REDFISH_CLIENT_ETAG_CACHE_MAX)) {
+		g_autofree gchar *data = NULL;
+		data = g_strndup (msg->response_body->data, msg->response_body->length);
+		g_key_file_set_string (self->etag_cache, cache_key, "ETag", etag);
+		g_key_file_set_string (self->etag_cache, cache_key, "Data", data);
+	} else {
+		g_key_file_remove_group (self->etag_cache, cache_key, NULL);
+	}
 	return g_bytes_new (msg->response_body->data, msg->response_body->length);
 }
 
+static GBytes *
+fu_redfish_client_fetch_data_with_query (FuRedfishClient *self,
+					 const gchar *uri_path,
+					 const gchar *query,
+					 GError **error)
+{
+	g_autoptr(SoupMessage) msg = NULL;
+
+	msg = fu_redfish_client_build_message (self, uri_path, query, error);
+	if (msg == NULL)
+		return NULL;
+	soup_session_send_message (self->session, msg);
+	return fu_redfish_client_process_response (self, msg, error);
+}
+
+static GBytes *
+fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GError **error)
+{
+	return fu_redfish_client_fetch_data_with_query (self, uri_path, NULL, error);
+}
+
+/* the parser is reused, so the caller owns a ref on the returned object */
+static JsonObject *
+fu_redfish_client_parse_object (FuRedfishClient *self, GBytes *blob, GError **error)
+{
+	JsonNode *node_root;
+	JsonObject *obj;
+
+	if (!json_parser_load_from_data (self->parser,
+					 g_bytes_get_data (blob, NULL),
+					 (gssize) g_bytes_get_size (blob),
+					 error)) {
+		g_prefix_error (error, "failed to parse node: ");
+		return NULL;
+	}
+	node_root = json_parser_get_root (self->parser);
+	if (node_root == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "no root node");
+		return NULL;
+	}
+	obj = json_node_get_object (node_root);
+	if (obj == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "no member object");
+		return NULL;
+	}
+	return json_object_ref (obj);
+}
+
+static void
+fu_redfish_client_save_etag_cache (FuRedfishClient *self)
+{
+	g_auto(GStrv) groups = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* drop URIs the BMC no longer links to */
+	groups = g_key_file_get_groups (self->etag_cache, NULL);
+	for (guint i = 0; groups[i] != NULL; i++) {
+		if (!g_hash_table_contains (self->etag_seen, groups[i]))
+			g_key_file_remove_group (self->etag_cache, groups[i], NULL);
+	}
+	g_hash_table_remove_all (self->etag_seen);
+
+	if (self->cache_filename == NULL)
+		return;
+	if (!fu_common_mkdir_parent (self->cache_filename, &error_local)) {
+		g_debug ("failed to create cache dir: %s", error_local->message);
+		return;
+	}
+	if (!g_key_file_save_to_file (self->etag_cache,
+				      self->cache_filename,
+				      &error_local)) {
+		g_debug ("failed to save ETag cache: %s", error_local->message);
+		return;
+	}
+}
+
 static gboolean
 fu_redfish_client_coldplug_member (FuRedfishClient *self,
 				   JsonObject *member,
@@ -145,19 +330,87 @@ fu_redfish_client_coldplug_member (FuRedfishClient *self,
 	return TRUE;
 }
 
+static void fu_redfish_client_crawl_queue_next (FuRedfishClientCrawlHelper *helper);
+
+static void
+fu_redfish_client_crawl_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	FuRedfishClientCrawlHelper *helper = (FuRedfishClientCrawlHelper *) user_data;
+	guint idx = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (msg), "idx"));
+
+	helper->in_flight--;
+	if (helper->error == NULL) {
+		g_autoptr(GBytes) blob = NULL;
+		blob = fu_redfish_client_process_response (helper->self, msg,
+							   &helper->error);
+		if (blob != NULL) {
+			JsonObject *obj;
+			obj = fu_redfish_client_parse_object (helper->self, blob,
+							      &helper->error);
+			if (obj != NULL)
+				g_ptr_array_index (helper->members, idx) = obj;
+		}
+	}
+	fu_redfish_client_crawl_queue_next (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_redfish_client_crawl_queue_next (FuRedfishClientCrawlHelper *helper)
+{
+	FuRedfishClient *self = helper->self;
+
+	/* stop queueing on the first failure */
+	if (helper->error != NULL)
+		return;
+
+	/* keep up to max_connections requests in flight */
+	while (helper->in_flight < self->max_connections &&
+	       helper->idx_next < helper->uris->len) {
+		guint idx = helper->idx_next++;
+		const gchar *uri_path = g_ptr_array_index (helper->uris, idx);
+		SoupMessage *msg;
+
+		/* already expanded */
+		if (uri_path == NULL)
+			continue;
+		msg = fu_redfish_client_build_message (self, uri_path, NULL,
+						       &helper->error);
+		if (msg == NULL)
+			return;
+		g_object_set_data (G_OBJECT (msg), "idx", GUINT_TO_POINTER (idx));
+		soup_session_queue_message (self->session, msg,
+					    fu_redfish_client_crawl_cb, helper);
+		helper->in_flight++;
+	}
+}
+
+static void
+fu_redfish_client_json_object_unref (JsonObject *obj)
+{
+	if (obj != NULL)
+		json_object_unref (obj);
+}
+
 static gboolean
 fu_redfish_client_coldplug_collection (FuRedfishClient *self,
 				       JsonObject *collection,
 				       GError **error)
 {
+	FuRedfishClientCrawlHelper helper = { 0 };
 	JsonArray *members;
-	JsonNode *node_root;
-	JsonObject *member;
+	guint members_len;
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+	g_autoptr(GPtrArray) uris = g_ptr_array_new ();
+	g_autoptr(GPtrArray) objs = NULL;
 
 	members = json_object_get_array_member (collection, "Members");
-	for (guint i = 0; i < json_array_get_length (members); i++) {
-		g_autoptr(JsonParser) parser = json_parser_new ();
-		g_autoptr(GBytes) blob = NULL;
+	members_len = json_array_get_length (members);
+	objs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_redfish_client_json_object_unref);
+	g_ptr_array_set_size (objs, members_len);
+	for (guint i = 0; i < members_len; i++) {
 		JsonObject *member_id;
 		const gchar *member_uri;
 
@@ -171,37 +424,33 @@ fu_redfish_client_coldplug_collection (FuRedfishClient *self,
 			return FALSE;
 		}
 
-		/* try to connect */
-		blob = fu_redfish_client_fetch_data (self, member_uri, error);
-		if (blob == NULL)
-			return FALSE;
-
-		/* get the member object */
-		if (!json_parser_load_from_data (parser,
-						 g_bytes_get_data (blob, NULL),
-						 (gssize) g_bytes_get_size (blob),
-						 error)) {
-			g_prefix_error (error, "failed to parse node: ");
-			return FALSE;
-		}
-		node_root = json_parser_get_root (parser);
-		if (node_root == NULL) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INVALID_FILE,
-					     "no root node");
-			return FALSE;
-		}
-		member = json_node_get_object (node_root);
-		if (member == NULL) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INVALID_FILE,
-					     "no member object");
-			return FALSE;
+		/* already returned inline using $expand */
+		if (json_object_has_member (member_id, "Id")) {
+			g_ptr_array_index (objs, i) = json_object_ref (member_id);
+			g_ptr_array_add (uris, NULL);
+			continue;
 		}
+		g_ptr_array_add (uris, (gpointer) member_uri);
+	}
 
-		/* Create the device for the member */
+	/* fetch the remaining members concurrently */
+	helper.self = self;
+	helper.loop = loop;
+	helper.uris = uris;
+	helper.members = objs;
+	g_main_context_push_thread_default (context);
+	fu_redfish_client_crawl_queue_next (&helper);
+	if (helper.in_flight > 0)
+		g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+
+	/* create the devices in the order the service listed them */
+	for (guint i = 0; i < objs->len; i++) {
+		JsonObject *member = g_ptr_array_index (objs, i);
 		if (!fu_redfish_client_coldplug_member (self, member, error))
 			return FALSE;
 	}
@@ -213,10 +462,8 @@ fu_redfish_client_coldplug_inventory (FuRedfishClient *self,
 				      JsonObject *inventory,
 				      GError **error)
 {
-	g_autoptr(JsonParser) parser = json_parser_new ();
 	g_autoptr(GBytes) blob = NULL;
-	JsonNode *node_root;
-	JsonObject *collection;
+	g_autoptr(JsonObject) collection = NULL;
 	const gchar *collection_uri;
 
 	if (inventory == NULL) {
@@ -236,35 +483,30 @@ fu_redfish_client_coldplug_inventory (FuRedfishClient *self,
 		return FALSE;
 	}
 
+	/* ask for the members inline if the service supports it */
+	if (self->expand_query != NULL) {
+		g_autoptr(GError) error_local = NULL;
+		blob = fu_redfish_client_fetch_data_with_query (self,
+								collection_uri,
+								self->expand_query,
+								&error_local);
+		if (blob == NULL) {
+			g_debug ("ignoring %s: %s",
+				 self->expand_query, error_local->message);
+		}
+	}
+
 	/* try to connect */
-	blob = fu_redfish_client_fetch_data (self, collection_uri, error);
-	if (blob == NULL)
-		return FALSE;
+	if (blob == NULL) {
+		blob = fu_redfish_client_fetch_data (self, collection_uri, error);
+		if (blob == NULL)
+			return FALSE;
+	}
 
 	/* get the inventory object */
-	if (!json_parser_load_from_data (parser,
-					 g_bytes_get_data (blob, NULL),
-					 (gssize) g_bytes_get_size (blob),
-					 error)) {
-		g_prefix_error (error, "failed to parse node: ");
-		return FALSE;
-	}
-	node_root = json_parser_get_root (parser);
-	if (node_root == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "no root node");
+	collection = fu_redfish_client_parse_object (self, blob, error);
+	if (collection == NULL)
 		return FALSE;
-	}
-	collection = json_node_get_object (node_root);
-	if (collection == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "no collection object");
-		return FALSE;
-	}
 
 	return fu_redfish_client_coldplug_collection (self, collection, error);
 }
@@ -339,12 +581,16 @@ fu_redfish_client_coldplug (FuRedfishClient *self, GError **error)
 	}
 	if (json_object_has_member (obj_root, "FirmwareInventory")) {
 		JsonObject *tmp = json_object_get_object_member (obj_root, "FirmwareInventory");
-		return fu_redfish_client_coldplug_inventory (self, tmp, error);
-	}
-	if (json_object_has_member (obj_root, "SoftwareInventory")) {
+		if (!fu_redfish_client_coldplug_inventory (self, tmp, error))
+			return FALSE;
+	} else if (json_object_has_member (obj_root, "SoftwareInventory")) {
 		JsonObject *tmp = json_object_get_object_member (obj_root, "SoftwareInventory");
-		return fu_redfish_client_coldplug_inventory (self, tmp, error);
+		if (!fu_redfish_client_coldplug_inventory (self, tmp, error))
+			return FALSE;
 	}
+
+	/* only the bodies we just used are worth keeping */
+	fu_redfish_client_save_etag_cache (self);
 	return TRUE;
 }
 
@@ -565,19 +811,196 @@ fu_redfish_client_set_smbios_interfaces (FuRedfishClient *self,
 	return TRUE;
 }
 
+static void
+fu_redfish_client_upload_wrote_body_data_cb (SoupMessage *msg,
+					      SoupBuffer *chunk,
+					      gpointer user_data)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) user_data;
+	helper->bytes_written += chunk->length;
+	fu_device_set_progress_full (helper->device,
+				     MIN (helper->bytes_written, helper->bytes_total),
+				     helper->bytes_total);
+}
+
+static void
+fu_redfish_client_upload_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) user_data;
+	g_main_loop_quit (helper->loop);
+}
+
+static void fu_redfish_client_task_queue (FuRedfishClientUploadHelper *helper);
+
+/* returns TRUE when the task has finished, successfully or not */
+static gboolean
+fu_redfish_client_task_parse (FuRedfishClientUploadHelper *helper, SoupMessage *msg)
+{
+	FuRedfishClient *self = helper->self;
+	const gchar *state;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(JsonObject) obj = NULL;
+
+	/* the task monitor returns the final response when done */
+	if (msg->status_code == SOUP_STATUS_NO_CONTENT)
+		return TRUE;
+	if (msg->status_code != SOUP_STATUS_OK &&
+	    msg->status_code != SOUP_STATUS_ACCEPTED) {
+		g_set_error (&helper->error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_WRITE,
+			     "failed to get task %s: %s",
+			     helper->task_uri_str,
+			     soup_status_get_phrase (msg->status_code));
+		return TRUE;
+	}
+	if (msg->response_body->length == 0)
+		return msg->status_code == SOUP_STATUS_OK;
+
+	/* not a Task resource */
+	blob = g_bytes_new (msg->response_body->data, msg->response_body->length);
+	obj = fu_redfish_client_parse_object (self, blob, NULL);
+	if (obj == NULL || !json_object_has_member (obj, "TaskState"))
+		return msg->status_code == SOUP_STATUS_OK;
+
+	if (json_object_has_member (obj, "PercentComplete")) {
+		gint64 pc = json_object_get_int_member (obj, "PercentComplete");
+		if (pc >= 0 && pc <= 100)
+			fu_device_set_progress (helper->device, (guint) pc);
+	}
+	state = json_object_get_string_member (obj, "TaskState");
+	if (g_strcmp0 (state, "New") == 0 ||
+	    g_strcmp0 (state, "Starting") == 0 ||
+	    g_strcmp0 (state, "Running") == 0 ||
+	    g_strcmp0 (state, "Pending") == 0 ||
+	    g_strcmp0 (state, "Service") == 0 ||
+	    g_strcmp0 (state, "Stopping") == 0 ||
+	    g_strcmp0 (state, "Suspended") == 0)
+		return FALSE;
+	if (g_strcmp0 (state, "Completed") == 0)
+		return TRUE;
+
+	/* Exception, Killed, Cancelled or Interrupted */
+	g_set_error (&helper->error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_WRITE,
+		     "task %s failed with state %s",
+		     helper->task_uri_str, state);
+	if (json_object_has_member (obj, "Messages")) {
+		JsonArray *msgs = json_object_get_array_member (obj, "Messages");
+		if (msgs != NULL && json_array_get_length (msgs) > 0) {
+			JsonObject *tmp = json_array_get_object_element (msgs, 0);
+			if (tmp != NULL && json_object_has_member (tmp, "Message")) {
+				g_prefix_error (&helper->error, "%s: ",
+						json_object_get_string_member (tmp, "Message"));
+			}
+		}
+	}
+	return TRUE;
+}
+
+static void
+fu_redfish_client_task_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) user_data;
+
+	if (fu_redfish_client_task_parse (helper, msg)) {
+		g_main_loop_quit (helper->loop);
+		return;
+	}
+	if (g_get_monotonic_time () > helper->task_deadline) {
+		g_set_error (&helper->error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_WRITE,
+			     "timed out waiting for task %s",
+			     helper->task_uri_str);
+		g_main_loop_quit (helper->loop);
+		return;
+	}
+	fu_redfish_client_task_queue (helper);
+}
+
+static gboolean
+fu_redfish_client_task_timeout_cb (gpointer user_data)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) user_data;
+	FuRedfishClient *self = helper->self;
+	SoupMessage *msg;
+
+	msg = fu_redfish_client_build_message_for_uri (self, helper->task_uri,
+						       &helper->error);
+	if (msg == NULL) {
+		g_main_loop_quit (helper->loop);
+		return G_SOURCE_REMOVE;
+	}
+
+	/* the task state is never worth caching */
+	soup_message_headers_remove (msg->request_headers, "If-None-Match");
+	soup_session_queue_message (self->session, msg,
+				    fu_redfish_client_task_cb, helper);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_redfish_client_task_queue (FuRedfishClientUploadHelper *helper)
+{
+	g_autoptr(GSource) source = g_timeout_source_new (helper->task_poll_interval);
+	g_source_set_callback (source, fu_redfish_client_task_timeout_cb, helper, NULL);
+	g_source_attach (source, g_main_loop_get_context (helper->loop));
+}
+
+/* the push response either has a task monitor URI or a Task resource,
+ * either of which may be relative to the push URI */
+static SoupURI *
+fu_redfish_client_get_task_uri (FuRedfishClient *self, SoupMessage *msg)
+{
+	SoupURI *base = soup_message_get_uri (msg);
+	SoupURI *uri = NULL;
+	const gchar *location;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(JsonObject) obj = NULL;
+
+	location = soup_message_headers_get_one (msg->response_headers, "Location");
+	if (location != NULL) {
+		uri = soup_uri_new_with_base (base, location);
+	} else if (msg->response_body->length > 0) {
+		blob = g_bytes_new (msg->response_body->data, msg->response_body->length);
+		obj = fu_redfish_client_parse_object (self, blob, NULL);
+		if (obj != NULL &&
+		    json_object_has_member (obj, "TaskState") &&
+		    json_object_has_member (obj, "@odata.id")) {
+			uri = soup_uri_new_with_base (base,
+						      json_object_get_string_member (obj, "@odata.id"));
+		}
+	}
+	if (uri == NULL)
+		return NULL;
+
+	/* the BMC credentials are sent with every poll */
+	if (!SOUP_URI_VALID_FOR_HTTP (uri) || !soup_uri_host_equal (uri, base)) {
+		g_autofree gchar *tmp = soup_uri_to_string (uri, FALSE);
+		g_warning ("not polling task on another host: %s", tmp);
+		soup_uri_free (uri);
+		return NULL;
+	}
+	return uri;
+}
+
 gboolean
 fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_fw,
 			  GError **error)
 {
 	FwupdRelease *release;
+	FuRedfishClientUploadHelper helper = { 0 };
 	g_autofree gchar *filename = NULL;
-
-	guint status_code;
 	g_autoptr(SoupMessage) msg = NULL;
 	g_autoptr(SoupURI) uri = NULL;
+	g_autoptr(SoupURI) task_uri = NULL;
 	g_autoptr(SoupMultipart) multipart = NULL;
 	g_autoptr(SoupBuffer) buffer = NULL;
 	g_autofree gchar *uri_str = NULL;
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
 
 	/* Get the update version */
 	release = fwupd_device_get_release_default (FWUPD_DEVICE (device));
@@ -598,11 +1021,13 @@ fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_
 	soup_uri_set_port (uri, self->port);
 	uri_str = soup_uri_to_string (uri, FALSE);
 
-	/* Create the multipart request */
+	/* Create the multipart request, the buffer keeps a ref on the
+	 * firmware rather than copying it */
 	multipart = soup_multipart_new (SOUP_FORM_MIME_TYPE_MULTIPART);
-	buffer = soup_buffer_new (SOUP_MEMORY_COPY,
-				  g_bytes_get_data (blob_fw, NULL),
-				  g_bytes_get_size (blob_fw));
+	buffer = soup_buffer_new_with_owner (g_bytes_get_data (blob_fw, NULL),
+					     g_bytes_get_size (blob_fw),
+					     g_bytes_ref (blob_fw),
+					     (GDestroyNotify) g_bytes_unref);
 	soup_multipart_append_form_file (multipart, filename, filename,
 					 "application/octet-stream",
 					 buffer);
@@ -615,20 +1040,92 @@ fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_
 		return FALSE;
 	}
 	fu_redfish_client_set_auth (self, uri, msg);
-	status_code = soup_session_send_message (self->session, msg);
-	if (status_code != SOUP_STATUS_OK) {
+
+	/* report progress as each chunk is written to the socket */
+	helper.self = self;
+	helper.device = device;
+	helper.loop = loop;
+	helper.bytes_total = msg->request_body->length;
+	helper.task_poll_interval = self->task_poll_interval;
+	g_signal_connect (msg, "wrote-body-data",
+			  G_CALLBACK (fu_redfish_client_upload_wrote_body_data_cb),
+			  &helper);
+
+	/* upload */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	g_main_context_push_thread_default (context);
+	soup_session_queue_message (self->session, g_object_ref (msg),
+				    fu_redfish_client_upload_cb, &helper);
+	g_main_loop_run (loop);
+	g_signal_handlers_disconnect_by_data (msg, &helper);
+	if (msg->status_code != SOUP_STATUS_OK &&
+	    msg->status_code != SOUP_STATUS_ACCEPTED &&
+	    msg->status_code != SOUP_STATUS_NO_CONTENT) {
+		g_main_context_pop_thread_default (context);
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
 			     "failed to upload %s to %s: %s",
 			     filename, uri_str,
-			     soup_status_get_phrase (status_code));
+			     soup_status_get_phrase (msg->status_code));
+		return FALSE;
+	}
+
+	/* wait for the BMC to apply the image */
+	task_uri = fu_redfish_client_get_task_uri (self, msg);
+	if (task_uri != NULL) {
+		helper.task_uri = task_uri;
+		helper.task_uri_str = soup_uri_to_string (task_uri, FALSE);
+		g_debug ("waiting for task %s", helper.task_uri_str);
+		fu_device_set_status (device, FWUPD_STATUS_DEVICE_BUSY);
+		fu_device_set_progress (device, 0);
+		helper.task_deadline = g_get_monotonic_time () +
+				       FU_REDFISH_CLIENT_TASK_TIMEOUT * G_USEC_PER_SEC;
+		fu_redfish_client_task_queue (&helper);
+		g_main_loop_run (loop);
+		g_free (helper.task_uri_str);
+	}
+	g_main_context_pop_thread_default (context);
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
 		return FALSE;
 	}
 
 	return TRUE;
 }
 
+static void
+fu_redfish_client_parse_features (FuRedfishClient *self, JsonObject *obj_features)
+{
+	JsonObject *obj_expand;
+	const gchar *expand = NULL;
+
+	if (!json_object_has_member (obj_features, "ExpandQuery"))
+		return;
+	obj_expand = json_object_get_object_member (obj_features, "ExpandQuery");
+	if (obj_expand == NULL)
+		return;
+
+	/* Members are subordinate resources, so prefer not to expand Links */
+	if (json_object_has_member (obj_expand, "NoLinks") &&
+	    json_object_get_boolean_member (obj_expand, "NoLinks")) {
+		expand = ".";
+	} else if (json_object_has_member (obj_expand, "ExpandAll") &&
+		   json_object_get_boolean_member (obj_expand, "ExpandAll")) {
+		expand = "*";
+	}
+	if (expand == NULL)
+		return;
+	g_free (self->expand_query);
+	if (json_object_has_member (obj_expand, "Levels") &&
+	    json_object_get_boolean_member (obj_expand, "Levels")) {
+		self->expand_query = g_strdup_printf ("$expand=%s($levels=1)", expand);
+	} else {
+		self->expand_query = g_strdup_printf ("$expand=%s", expand);
+	}
+	g_debug ("Expand:   %s", self->expand_query);
+}
+
 gboolean
 fu_redfish_client_setup (FuRedfishClient *self, GBytes *smbios_table, GError **error)
 {
@@ -662,6 +1159,9 @@ fu_redfish_client_setup (FuRedfishClient *self, GBytes *smbios_table, GError **e
 	user_agent = g_strdup_printf ("%s/%s", PACKAGE_NAME, PACKAGE_VERSION);
 	self->session = soup_session_new_with_options (SOUP_SESSION_USER_AGENT, user_agent,
 						       SOUP_SESSION_TIMEOUT, 60,
+						       SOUP_SESSION_MAX_CONNS, self->max_connections,
+						       SOUP_SESSION_MAX_CONNS_PER_HOST, self->max_connections,
+						       SOUP_SESSION_USE_THREAD_CONTEXT, TRUE,
 						       NULL);
 	if (self->session == NULL) {
 		g_set_error_literal (error,
@@ -701,6 +1201,18 @@ fu_redfish_client_setup (FuRedfishClient *self, GBytes *smbios_table, GError **e
 	if (self->password != NULL)
 		g_debug ("Password: %s", self->password);
 
+	/* load the ETags from the last crawl */
+	if (self->cache_filename != NULL &&
+	    g_file_test (self->cache_filename, G_FILE_TEST_EXISTS)) {
+		g_autoptr(GError) error_local = NULL;
+		if (!g_key_file_load_from_file (self->etag_cache,
+						self->cache_filename,
+						G_KEY_FILE_NONE,
+						&error_local)) {
+			g_debug ("ignoring ETag cache: %s", error_local->message);
+		}
+	}
+
 	/* try to connect */
 	blob = fu_redfish_client_fetch_data (self, "/redfish/v1/", error);
 	if (blob == NULL)
@@ -741,6 +1253,13 @@ fu_redfish_client_setup (FuRedfishClient *self, GBytes *smbios_table, GError **e
 	g_debug ("UUID:     %s",
 		 json_object_get_string_member (obj_root, "UUID"));
 
+	/* can we get collection members inline */
+	if (json_object_has_member (obj_root, "ProtocolFeaturesSupported")) {
+		JsonObject *obj_features = json_object_get_object_member (obj_root, "ProtocolFeaturesSupported");
+		if (obj_features != NULL)
+			fu_redfish_client_parse_features (self, obj_features);
+	}
+
 	if (json_object_has_member (obj_root, "UpdateService"))
 		obj_update_service = json_object_get_object_member (obj_root, "UpdateService");
 	if (obj_update_service == NULL) {
@@ -793,6 +1312,25 @@ fu_redfish_client_set_cacheck (FuRedfishClient *self, gboolean cacheck)
 	self->cacheck = cacheck;
 }
 
+void
+fu_redfish_client_set_max_connections (FuRedfishClient *self, guint max_connections)
+{
+	self->max_connections = MAX (max_connections, 1);
+}
+
+void
+fu_redfish_client_set_task_poll_interval (FuRedfishClient *self, guint task_poll_interval)
+{
+	self->task_poll_interval = task_poll_interval;
+}
+
+void
+fu_redfish_client_set_cache_filename (FuRedfishClient *self, const gchar *cache_filename)
+{
+	g_free (self->cache_filename);
+	self->cache_filename = g_strdup (cache_filename);
+}
+
 void
 fu_redfish_client_set_username (FuRedfishClient *self, const gchar *username)
 {
@@ -818,6 +1356,11 @@ fu_redfish_client_finalize (GObject *object)
 	g_free (self->hostname);
 	g_free (self->username);
 	g_free (self->password);
+	g_free (self->expand_query);
+	g_free (self->cache_filename);
+	g_key_file_unref (self->etag_cache);
+	g_hash_table_unref (self->etag_seen);
+	g_object_unref (self->parser);
 	g_ptr_array_unref (self->devices);
 	G_OBJECT_CLASS (fu_redfish_client_parent_class)->finalize (object);
 }
@@ -832,6 +1375,11 @@ fu_redfish_client_class_init (FuRedfishClientClass *klass)
 static void
 fu_redfish_client_init (FuRedfishClient *self)
 {
+	self->max_connections = FU_REDFISH_CLIENT_MAX_CONNECTIONS_DEFAULT;
+	self->task_poll_interval = FU_REDFISH_CLIENT_TASK_POLL_INTERVAL;
+	self->etag_cache = g_key_file_new ();
+	self->etag_seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	self->parser = json_parser_new ();
 	self->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 }
 
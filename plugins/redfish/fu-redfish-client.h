@@ -14,6 +14,12 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (FuRedfishClient, fu_redfish_client, FU, REDFISH_CLIENT, GObject)
 
+#define FU_REDFISH_CLIENT_MAX_CONNECTIONS_DEFAULT	4
+#define FU_REDFISH_CLIENT_TASK_POLL_INTERVAL		1000	/* ms */
+#define FU_REDFISH_CLIENT_TASK_TIMEOUT			1800	/* s */
+#define FU_REDFISH_CLIENT_ETAG_DATA_MAX			0x10000	/* bytes */
+#define FU_REDFISH_CLIENT_ETAG_CACHE_MAX		1024	/* URIs */
+
 FuRedfishClient	*fu_redfish_client_new		(void);
 void		 fu_redfish_client_set_hostname	(FuRedfishClient	*self,
 						 const gchar		*hostname);
@@ -27,6 +33,12 @@ void		 fu_redfish_client_set_https	(FuRedfishClient	*self,
 						 gboolean		 use_https);
 void		 fu_redfish_client_set_cacheck	(FuRedfishClient	*self,
 						 gboolean		 cacheck);
+void		 fu_redfish_client_set_max_connections	(FuRedfishClient	*self,
+							 guint			 max_connections);
+void		 fu_redfish_client_set_task_poll_interval	(FuRedfishClient	*self,
+							 guint			 task_poll_interval);
+void		 fu_redfish_client_set_cache_filename	(FuRedfishClient	*self,
+							 const gchar		*cache_filename);
 gboolean	 fu_redfish_client_update       (FuRedfishClient	*self,
 						 FuDevice		*device,
 						 GBytes			*blob_fw,
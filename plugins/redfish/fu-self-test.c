@@ -7,12 +7,212 @@
 #include "config.h"
 
 #include <fwupd.h>
+#include <glib/gstdio.h>
+#include <libsoup/soup.h>
+#include <string.h>
 
 #include "fu-plugin-private.h"
 #include "fu-test.h"
 
+#include "fu-redfish-client.h"
 #include "fu-redfish-common.h"
 
+#define FU_TEST_REDFISH_CACHE_FILENAME	"/tmp/fwupd-self-test/redfish/inventory.ini"
+
+typedef struct {
+	SoupServer		*server;
+	GMainContext		*context;
+	GMainLoop		*loop;
+	GThread			*thread;
+	GHashTable		*docs;		/* path:JSON */
+	GHashTable		*docs_expanded;	/* path:JSON */
+	guint			 port;
+	gint			 cnt_requests;
+	gint			 cnt_not_modified;
+	gint			 cnt_task_polls;
+	gsize			 upload_size;
+} FuTestRedfishServer;
+
+static void
+fu_test_redfish_server_task_cb (FuTestRedfishServer *self, SoupMessage *msg)
+{
+	const gchar *json;
+
+	/* still running for the first few polls */
+	if (g_atomic_int_add (&self->cnt_task_polls, 1) < 3) {
+		json = "{\"@odata.id\":\"/redfish/v1/TaskService/Tasks/1\","
+		       "\"TaskState\":\"Running\",\"PercentComplete\":50}";
+		soup_message_set_status (msg, SOUP_STATUS_ACCEPTED);
+	} else {
+		json = "{\"@odata.id\":\"/redfish/v1/TaskService/Tasks/1\","
+		       "\"TaskState\":\"Completed\",\"PercentComplete\":100}";
+		soup_message_set_status (msg, SOUP_STATUS_OK);
+	}
+	soup_message_set_response (msg, "application/json",
+				   SOUP_MEMORY_STATIC, json, strlen (json));
+}
+
+static void
+fu_test_redfish_server_cb (SoupServer *server,
+			   SoupMessage *msg,
+			   const char *path,
+			   GHashTable *query,
+			   SoupClientContext *client,
+			   gpointer user_data)
+{
+	FuTestRedfishServer *self = (FuTestRedfishServer *) user_data;
+	const gchar *json;
+	const gchar *if_none_match;
+	g_autofree gchar *etag = NULL;
+
+	g_atomic_int_inc (&self->cnt_requests);
+	if (msg->method == SOUP_METHOD_POST && g_strcmp0 (path, "/FWUpdate") == 0) {
+		self->upload_size = msg->request_body->length;
+		soup_message_headers_replace (msg->response_headers, "Location",
+					      "/redfish/v1/TaskService/Tasks/1/Monitor?token=abc");
+		soup_message_set_status (msg, SOUP_STATUS_ACCEPTED);
+		return;
+	}
+	if (g_strcmp0 (path, "/redfish/v1/TaskService/Tasks/1/Monitor") == 0) {
+		/* the query from the Location header has to be sent back */
+		if (query == NULL ||
+		    g_strcmp0 (g_hash_table_lookup (query, "token"), "abc") != 0) {
+			soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+			return;
+		}
+		fu_test_redfish_server_task_cb (self, msg);
+		return;
+	}
+	if (query != NULL && g_hash_table_lookup (query, "$expand") != NULL) {
+		json = g_hash_table_lookup (self->docs_expanded, path);
+		if (json == NULL) {
+			soup_message_set_status (msg, SOUP_STATUS_BAD_REQUEST);
+			return;
+		}
+	} else {
+		json = g_hash_table_lookup (self->docs, path);
+	}
+	if (json == NULL) {
+		soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+		return;
+	}
+
+	/* only send the body if the client does not already have it */
+	etag = g_strdup_printf ("\"%08x\"", g_str_hash (json));
+	if_none_match = soup_message_headers_get_one (msg->request_headers,
+						      "If-None-Match");
+	if (g_strcmp0 (if_none_match, etag) == 0) {
+		g_atomic_int_inc (&self->cnt_not_modified);
+		soup_message_set_status (msg, SOUP_STATUS_NOT_MODIFIED);
+		return;
+	}
+	soup_message_headers_replace (msg->response_headers, "ETag", etag);
+	soup_message_set_response (msg, "application/json",
+				   SOUP_MEMORY_COPY, json, strlen (json));
+	soup_message_set_status (msg, SOUP_STATUS_OK);
+}
+
+static gpointer
+fu_test_redfish_server_thread_cb (gpointer user_data)
+{
+	FuTestRedfishServer *self = (FuTestRedfishServer *) user_data;
+	g_main_context_push_thread_default (self->context);
+	g_main_loop_run (self->loop);
+	g_main_context_pop_thread_default (self->context);
+	return NULL;
+}
+
+static gboolean
+fu_test_redfish_server_quit_cb (gpointer user_data)
+{
+	FuTestRedfishServer *self = (FuTestRedfishServer *) user_data;
+	g_main_loop_quit (self->loop);
+	return G_SOURCE_REMOVE;
+}
+
+static FuTestRedfishServer *
+fu_test_redfish_server_new (void)
+{
+	FuTestRedfishServer *self = g_new0 (FuTestRedfishServer, 1);
+	gboolean ret;
+	GSList *uris;
+	g_autoptr(GError) error = NULL;
+
+	self->docs = g_hash_table_new (g_str_hash, g_str_equal);
+	self->docs_expanded = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (self->docs, "/redfish/v1/",
+			     "{\"RedfishVersion\":\"1.6.0\","
+			     "\"UUID\":\"92384634-2938-2342-8820-489239905423\","
+			     "\"UpdateService\":{\"@odata.id\":\"/redfish/v1/UpdateService\"}}");
+	g_hash_table_insert (self->docs, "/redfish/v1/UpdateService",
+			     "{\"ServiceEnabled\":true,"
+			     "\"HttpPushUri\":\"/FWUpdate\","
+			     "\"FirmwareInventory\":{\"@odata.id\":\"/redfish/v1/UpdateService/FirmwareInventory\"}}");
+	g_hash_table_insert (self->docs, "/redfish/v1/UpdateService/FirmwareInventory",
+			     "{\"Members\":["
+			     "{\"@odata.id\":\"/redfish/v1/UpdateService/FirmwareInventory/BMC\"},"
+			     "{\"@odata.id\":\"/redfish/v1/UpdateService/FirmwareInventory/BIOS\"},"
+			     "{\"@odata.id\":\"/redfish/v1/UpdateService/FirmwareInventory/NIC\"}]}");
+	g_hash_table_insert (self->docs, "/redfish/v1/UpdateService/FirmwareInventory/BMC",
+			     "{\"Id\":\"BMC\",\"Name\":\"BMC\",\"Version\":\"1.2.3\","
+			     "\"SoftwareId\":\"2cf4da1e-f4d9-5f8a-9a5a-3d1d5f0b1c8e\"}");
+	g_hash_table_insert (self->docs, "/redfish/v1/UpdateService/FirmwareInventory/BIOS",
+			     "{\"Id\":\"BIOS\",\"Name\":\"BIOS\",\"Version\":\"2.0.1\","
+			     "\"SoftwareId\":\"fe462d4a-e48f-5069-9172-47330fc5e838\"}");
+	g_hash_table_insert (self->docs, "/redfish/v1/UpdateService/FirmwareInventory/NIC",
+			     "{\"Id\":\"NIC\",\"Name\":\"NIC\",\"Version\":\"4.5\"}");
+
+	/* listen on a random port from a thread-private context */
+	self->context = g_main_context_new ();
+	g_main_context_push_thread_default (self->context);
+	self->server = soup_server_new (SOUP_SERVER_SERVER_HEADER, "fwupd-self-test", NULL);
+	soup_server_add_handler (self->server, NULL,
+				 fu_test_redfish_server_cb, self, NULL);
+	ret = soup_server_listen_local (self->server, 0,
+					SOUP_SERVER_LISTEN_IPV4_ONLY,
+					&error);
+	g_main_context_pop_thread_default (self->context);
+	g_assert_no_error (error);
+	g_assert (ret);
+	uris = soup_server_get_uris (self->server);
+	g_assert (uris != NULL);
+	self->port = soup_uri_get_port (uris->data);
+	g_slist_free_full (uris, (GDestroyNotify) soup_uri_free);
+
+	/* serve requests while the client blocks the test thread */
+	self->loop = g_main_loop_new (self->context, FALSE);
+	self->thread = g_thread_new ("redfish-server",
+				     fu_test_redfish_server_thread_cb,
+				     self);
+	return self;
+}
+
+static void
+fu_test_redfish_server_free (FuTestRedfishServer *self)
+{
+	g_main_context_invoke (self->context, fu_test_redfish_server_quit_cb, self);
+	g_thread_join (self->thread);
+	g_object_unref (self->server);
+	g_main_loop_unref (self->loop);
+	g_main_context_unref (self->context);
+	g_hash_table_unref (self->docs);
+	g_hash_table_unref (self->docs_expanded);
+	g_free (self);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuTestRedfishServer, fu_test_redfish_server_free)
+
+static FuRedfishClient *
+fu_test_redfish_client_new (FuTestRedfishServer *server)
+{
+	FuRedfishClient *client = fu_redfish_client_new ();
+	fu_redfish_client_set_hostname (client, "127.0.0.1");
+	fu_redfish_client_set_port (client, server->port);
+	fu_redfish_client_set_https (client, FALSE);
+	fu_redfish_client_set_cache_filename (client, FU_TEST_REDFISH_CACHE_FILENAME);
+	return client;
+}
+
 static void
 fu_test_redfish_common_func (void)
 {
@@ -27,11 +227,161 @@ fu_test_redfish_common_func (void)
 	g_assert_cmpstr (ipv6, ==, "00010203:04050607:08090a0b:0c0d0e0f");
 }
 
+static void
+fu_test_redfish_client_coldplug_func (void)
+{
+	FuDevice *device;
+	GPtrArray *devices;
+	gboolean ret;
+	g_autoptr(FuRedfishClient) client1 = NULL;
+	g_autoptr(FuRedfishClient) client2 = NULL;
+	g_autoptr(FuTestRedfishServer) server = fu_test_redfish_server_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	g_unlink (FU_TEST_REDFISH_CACHE_FILENAME);
+
+	/* crawl the inventory, NIC has no SoftwareId */
+	client1 = fu_test_redfish_client_new (server);
+	fu_redfish_client_set_max_connections (client1, 2);
+	ret = fu_redfish_client_setup (client1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_redfish_client_coldplug (client1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	devices = fu_redfish_client_get_devices (client1);
+	g_assert_cmpint (devices->len, ==, 2);
+	device = g_ptr_array_index (devices, 0);
+	g_assert_cmpstr (fu_device_get_name (device), ==, "BMC");
+	g_assert_cmpstr (fu_device_get_version (device), ==, "1.2.3");
+	device = g_ptr_array_index (devices, 1);
+	g_assert_cmpstr (fu_device_get_name (device), ==, "BIOS");
+	g_assert_cmpint (server->cnt_requests, ==, 6);
+	g_assert_cmpint (server->cnt_not_modified, ==, 0);
+	g_assert (g_file_test (FU_TEST_REDFISH_CACHE_FILENAME, G_FILE_TEST_EXISTS));
+
+	/* a resource that the BMC no longer links to */
+	ret = g_key_file_load_from_file (kf, FU_TEST_REDFISH_CACHE_FILENAME,
+					 G_KEY_FILE_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_key_file_set_string (kf, "/redfish/v1/Stale", "ETag", "\"deadbeef\"");
+	g_key_file_set_string (kf, "/redfish/v1/Stale", "Data", "{}");
+	ret = g_key_file_save_to_file (kf, FU_TEST_REDFISH_CACHE_FILENAME, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* nothing changed, so every body comes from the ETag cache */
+	client2 = fu_test_redfish_client_new (server);
+	ret = fu_redfish_client_setup (client2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_redfish_client_coldplug (client2, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	devices = fu_redfish_client_get_devices (client2);
+	g_assert_cmpint (devices->len, ==, 2);
+	device = g_ptr_array_index (devices, 1);
+	g_assert_cmpstr (fu_device_get_version (device), ==, "2.0.1");
+	g_assert_cmpint (server->cnt_requests, ==, 12);
+	g_assert_cmpint (server->cnt_not_modified, ==, 6);
+
+	/* the stale resource was dropped from the cache */
+	ret = g_key_file_load_from_file (kf, FU_TEST_REDFISH_CACHE_FILENAME,
+					 G_KEY_FILE_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_false (g_key_file_has_group (kf, "/redfish/v1/Stale"));
+	g_assert_true (g_key_file_has_group (kf, "/redfish/v1/"));
+}
+
+static void
+fu_test_redfish_client_expand_func (void)
+{
+	GPtrArray *devices;
+	gboolean ret;
+	g_autoptr(FuRedfishClient) client = NULL;
+	g_autoptr(FuTestRedfishServer) server = fu_test_redfish_server_new ();
+	g_autoptr(GError) error = NULL;
+
+	g_unlink (FU_TEST_REDFISH_CACHE_FILENAME);
+	g_hash_table_insert (server->docs, "/redfish/v1/",
+			     "{\"RedfishVersion\":\"1.6.0\","
+			     "\"ProtocolFeaturesSupported\":{\"ExpandQuery\":"
+			     "{\"ExpandAll\":true,\"Levels\":true,\"NoLinks\":true}},"
+			     "\"UpdateService\":{\"@odata.id\":\"/redfish/v1/UpdateService\"}}");
+	g_hash_table_insert (server->docs_expanded, "/redfish/v1/UpdateService/FirmwareInventory",
+			     "{\"Members\":["
+			     "{\"@odata.id\":\"/redfish/v1/UpdateService/FirmwareInventory/BMC\","
+			     "\"Id\":\"BMC\",\"Name\":\"BMC\",\"Version\":\"1.2.3\","
+			     "\"SoftwareId\":\"2cf4da1e-f4d9-5f8a-9a5a-3d1d5f0b1c8e\"}]}");
+
+	/* the members are returned inline so are never fetched */
+	client = fu_test_redfish_client_new (server);
+	ret = fu_redfish_client_setup (client, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_redfish_client_coldplug (client, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	devices = fu_redfish_client_get_devices (client);
+	g_assert_cmpint (devices->len, ==, 1);
+	g_assert_cmpint (server->cnt_requests, ==, 3);
+}
+
+static void
+fu_test_redfish_device_progress_cb (FuDevice *device, GParamSpec *pspec, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+	(*cnt)++;
+}
+
+static void
+fu_test_redfish_client_update_func (void)
+{
+	gboolean ret;
+	guint cnt_progress = 0;
+	g_autofree guint8 *buf = g_malloc0 (0x100000);
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuRedfishClient) client = NULL;
+	g_autoptr(FuTestRedfishServer) server = fu_test_redfish_server_new ();
+	g_autoptr(GBytes) blob_fw = NULL;
+	g_autoptr(GError) error = NULL;
+
+	g_unlink (FU_TEST_REDFISH_CACHE_FILENAME);
+	client = fu_test_redfish_client_new (server);
+	fu_redfish_client_set_task_poll_interval (client, 10);
+	ret = fu_redfish_client_setup (client, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_redfish_client_coldplug (client, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* upload 1MB then wait for the task to complete */
+	fu_device_set_name (device, "BMC");
+	g_signal_connect (device, "notify::progress",
+			  G_CALLBACK (fu_test_redfish_device_progress_cb),
+			  &cnt_progress);
+	blob_fw = g_bytes_new_take (g_steal_pointer (&buf), 0x100000);
+	ret = fu_redfish_client_update (client, device, blob_fw, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (server->upload_size, >, 0x100000);
+	g_assert_cmpint (server->cnt_task_polls, ==, 4);
+	g_assert_cmpint (fu_device_get_progress (device), ==, 100);
+	g_assert_cmpint (cnt_progress, >, 2);
+}
+
 int
 main (int argc, char **argv)
 {
 	g_test_init (&argc, &argv, NULL);
 	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
 	g_test_add_func ("/redfish/common", fu_test_redfish_common_func);
+	g_test_add_func ("/redfish/client{coldplug}", fu_test_redfish_client_coldplug_func);
+	g_test_add_func ("/redfish/client{expand}", fu_test_redfish_client_expand_func);
+	g_test_add_func ("/redfish/client{update}", fu_test_redfish_client_update_func);
 	return g_test_run ();
 }
@@ -15,7 +15,9 @@
 #include "fu-superio-common.h"
 #include "fu-superio-device.h"
 
-#define FU_PLUGIN_SUPERIO_TIMEOUT	0.25 /* s */
+#define FU_PLUGIN_SUPERIO_TIMEOUT	250000	/* us */
+#define FU_PLUGIN_SUPERIO_SPIN		50	/* us */
+#define FU_PLUGIN_SUPERIO_SLEEP_MAX	1000	/* us */
 
 /* EC Status Register (see ec/google/chromeec/ec_commands.h) */
 #define SIO_STATUS_EC_OBF		(1 << 0)	/* o/p buffer full */
@@ -84,21 +86,35 @@ fu_superio_device_check_id (FuSuperioDevice *self, GError **error)
 	return TRUE;
 }
 
+/* the EC normally responds within a few microseconds, so spin for a short
+ * time before backing off to increasing sleeps rather than burning a core */
+static gboolean
+fu_superio_device_backoff (gint64 start, gulong *delay)
+{
+	gint64 elapsed = g_get_monotonic_time () - start;
+	if (elapsed > FU_PLUGIN_SUPERIO_TIMEOUT)
+		return FALSE;
+	if (elapsed > FU_PLUGIN_SUPERIO_SPIN) {
+		g_usleep (*delay);
+		*delay = MIN (*delay * 2, FU_PLUGIN_SUPERIO_SLEEP_MAX);
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_superio_device_wait_for (FuSuperioDevice *self, guint8 mask, gboolean set, GError **error)
 {
-	g_autoptr(GTimer) timer = g_timer_new ();
+	gint64 start = g_get_monotonic_time ();
+	gulong delay = 1;
 	do {
 		guint8 status = 0x00;
 		if (!fu_superio_inb (self->fd, self->pm1_iobad1, &status, error))
 			return FALSE;
-		if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT)
-			break;
 		if (set && (status & mask) != 0)
 			return TRUE;
 		if (!set && (status & mask) == 0)
 			return TRUE;
-	} while (TRUE);
+	} while (fu_superio_device_backoff (start, &delay));
 	g_set_error (error,
 		     G_IO_ERROR,
 		     G_IO_ERROR_TIMED_OUT,
@@ -131,25 +147,23 @@ fu_superio_device_ec_write (FuSuperioDevice *self,
 static gboolean
 fu_superio_device_ec_flush (FuSuperioDevice *self, GError **error)
 {
-	guint8 status = 0x00;
-	g_autoptr(GTimer) timer = g_timer_new ();
+	gint64 start = g_get_monotonic_time ();
+	gulong delay = 1;
 	do {
+		guint8 status = 0x00;
 		guint8 unused = 0;
 		if (!fu_superio_inb (self->fd, self->pm1_iobad1, &status, error))
 			return FALSE;
 		if ((status & SIO_STATUS_EC_OBF) == 0)
-			break;
+			return TRUE;
 		if (!fu_superio_inb (self->fd, self->pm1_iobad0, &unused, error))
 			return FALSE;
-		if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT) {
-			g_set_error_literal (error,
-					     G_IO_ERROR,
-					     G_IO_ERROR_TIMED_OUT,
-					     "timed out whilst waiting for flush");
-			return FALSE;
-		}
-	} while (TRUE);
-	return TRUE;
+	} while (fu_superio_device_backoff (start, &delay));
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_TIMED_OUT,
+			     "timed out whilst waiting for flush");
+	return FALSE;
 }
 
 static gboolean
@@ -176,6 +190,41 @@ fu_superio_device_ec_set_param (FuSuperioDevice *self, guint8 param, guint8 data
 }
 #endif
 
+/**
+ * fu_superio_device_ec_read_params:
+ * @self: A #FuSuperioDevice
+ * @param: the first EC parameter
+ * @buf: (out): a buffer for the values
+ * @bufsz: the number of consecutive parameters to read
+ * @error: A #GError, or %NULL
+ *
+ * Reads a range of EC parameters, flushing the output buffer only once.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_superio_device_ec_read_params (FuSuperioDevice *self,
+				  guint8 param,
+				  guint8 *buf,
+				  gsize bufsz,
+				  GError **error)
+{
+	g_return_val_if_fail (FU_IS_SUPERIO_DEVICE (self), FALSE);
+	g_return_val_if_fail (bufsz <= 0x100 - param, FALSE);
+	if (!fu_superio_device_ec_flush (self, error)) {
+		g_prefix_error (error, "failed to flush: ");
+		return FALSE;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		if (!fu_superio_device_ec_get_param (self, param + i, &buf[i], error)) {
+			g_prefix_error (error, "failed to get param 0x%02x: ",
+					(guint) (param + i));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 static gchar *
 fu_superio_device_ec_get_str (FuSuperioDevice *self, guint8 idx, GError **error)
 {
@@ -235,11 +284,7 @@ fu_superio_device_setup_it85xx (FuSuperioDevice *self, GError **error)
 	g_autofree gchar *version = NULL;
 
 	/* get EC size */
-	if (!fu_superio_device_ec_flush (self, error)) {
-		g_prefix_error (error, "failed to flush: ");
-		return FALSE;
-	}
-	if (!fu_superio_device_ec_get_param (self, 0xe5, &size_tmp, error)) {
+	if (!fu_superio_device_ec_read_params (self, 0xe5, &size_tmp, 1, error)) {
 		g_prefix_error (error, "failed to get EC size: ");
 		return FALSE;
 	}
@@ -262,21 +307,24 @@ fu_superio_device_setup_it85xx (FuSuperioDevice *self, GError **error)
 }
 
 static gboolean
-fu_superio_device_it89xx_read_ec_register (FuSuperioDevice *self,
-					   guint16 addr,
-					   guint8 *outval,
-					   GError **error)
+fu_superio_device_it89xx_set_ec_address (FuSuperioDevice *self,
+					 guint16 addr,
+					 gboolean set_high,
+					 GError **error)
 {
-	if (!fu_superio_regwrite (self->fd, self->port,
-				  SIO_LDNxx_IDX_D2ADR,
-				  SIO_DEPTH2_I2EC_ADDRH,
-				  error))
-		return FALSE;
-	if (!fu_superio_regwrite (self->fd, self->port,
-				  SIO_LDNxx_IDX_D2DAT,
-				  addr >> 8,
-				  error))
-		return FALSE;
+	/* the high byte only changes every 256 registers */
+	if (set_high) {
+		if (!fu_superio_regwrite (self->fd, self->port,
+					  SIO_LDNxx_IDX_D2ADR,
+					  SIO_DEPTH2_I2EC_ADDRH,
+					  error))
+			return FALSE;
+		if (!fu_superio_regwrite (self->fd, self->port,
+					  SIO_LDNxx_IDX_D2DAT,
+					  addr >> 8,
+					  error))
+			return FALSE;
+	}
 	if (!fu_superio_regwrite (self->fd, self->port,
 				  SIO_LDNxx_IDX_D2ADR,
 				  SIO_DEPTH2_I2EC_ADDRL,
@@ -286,41 +334,72 @@ fu_superio_device_it89xx_read_ec_register (FuSuperioDevice *self,
 				  SIO_LDNxx_IDX_D2DAT,
 				  addr & 0xff, error))
 		return FALSE;
-	if (!fu_superio_regwrite (self->fd, self->port,
-				  SIO_LDNxx_IDX_D2ADR,
-				  SIO_DEPTH2_I2EC_DATA,
-				  error))
-		return FALSE;
-	return fu_superio_regval (self->fd, self->port,
-				  SIO_LDNxx_IDX_D2DAT,
-				  outval,
-				  error);
+	return fu_superio_regwrite (self->fd, self->port,
+				    SIO_LDNxx_IDX_D2ADR,
+				    SIO_DEPTH2_I2EC_DATA,
+				    error);
+}
+
+/**
+ * fu_superio_device_it89xx_read_ec_registers:
+ * @self: A #FuSuperioDevice
+ * @addr: the first EC register address
+ * @buf: (out): a buffer for the values
+ * @bufsz: the number of consecutive registers to read
+ * @error: A #GError, or %NULL
+ *
+ * Reads a range of EC-only registers using the I2EC interface, only setting
+ * the high address byte when it changes.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_superio_device_it89xx_read_ec_registers (FuSuperioDevice *self,
+					    guint16 addr,
+					    guint8 *buf,
+					    gsize bufsz,
+					    GError **error)
+{
+	g_return_val_if_fail (FU_IS_SUPERIO_DEVICE (self), FALSE);
+	g_return_val_if_fail (bufsz <= 0x10000 - addr, FALSE);
+	for (gsize i = 0; i < bufsz; i++) {
+		guint16 addr_tmp = addr + i;
+		gboolean set_high = i == 0 || (addr_tmp & 0xff) == 0;
+		if (!fu_superio_device_it89xx_set_ec_address (self, addr_tmp,
+							      set_high, error))
+			return FALSE;
+		if (!fu_superio_regval (self->fd, self->port,
+					SIO_LDNxx_IDX_D2DAT,
+					&buf[i],
+					error))
+			return FALSE;
+	}
+	return TRUE;
 }
 
 static gboolean
 fu_superio_device_it89xx_ec_size (FuSuperioDevice *self, GError **error)
 {
-	guint8 tmp = 0;
+	guint8 buf[3] = { 0x00 };
+	guint8 tmp;
+
+	/* ECHIPID1, ECHIPID2 and ECHIPVER are consecutive */
+	if (!fu_superio_device_it89xx_read_ec_registers (self,
+							 GCTRL_ECHIPID1,
+							 buf, sizeof(buf),
+							 error))
+		return FALSE;
 
 	/* not sure why we can't just use SIO_LDNxx_IDX_CHIPID1,
 	 * but lets do the same as the vendor flash tool... */
-	if (!fu_superio_device_it89xx_read_ec_register (self,
-							GCTRL_ECHIPID1,
-							&tmp,
-							error))
-		return FALSE;
-	if (tmp == 0x85) {
+	if (buf[0] == 0x85) {
 		g_warning ("possibly IT85xx class device");
 		self->size = 0x20000;
 		return TRUE;
 	}
 
 	/* can't we just use SIO_LDNxx_IDX_CHIPVER... */
-	if (!fu_superio_device_it89xx_read_ec_register (self,
-							GCTRL_ECHIPVER,
-							&tmp,
-							error))
-		return FALSE;
+	tmp = buf[GCTRL_ECHIPVER - GCTRL_ECHIPID1];
 	if (tmp >> 4 == 0x00) {
 		self->size = 0x20000;
 		return TRUE;
@@ -345,16 +424,9 @@ fu_superio_device_setup_it89xx (FuSuperioDevice *self, GError **error)
 	g_autofree gchar *version = NULL;
 
 	/* get version */
-	if (!fu_superio_device_ec_flush (self, error)) {
-		g_prefix_error (error, "failed to flush: ");
-		return FALSE;
-	}
-	if (!fu_superio_device_ec_get_param (self, 0x00, &version_tmp[0], error)) {
-		g_prefix_error (error, "failed to get version major: ");
-		return FALSE;
-	}
-	if (!fu_superio_device_ec_get_param (self, 0x01, &version_tmp[1], error)) {
-		g_prefix_error (error, "failed to get version minor: ");
+	if (!fu_superio_device_ec_read_params (self, 0x00, version_tmp,
+					       sizeof(version_tmp), error)) {
+		g_prefix_error (error, "failed to get version: ");
 		return FALSE;
 	}
 	version = g_strdup_printf ("%02u.%02u", version_tmp[0], version_tmp[1]);
@@ -382,8 +454,9 @@ fu_superio_device_setup (FuDevice *device, GError **error)
 	/* dump LDNs */
 	if (g_getenv ("FWUPD_SUPERIO_VERBOSE") != NULL) {
 		for (guint j = 0; j < SIO_LDN_LAST; j++) {
-			if (!fu_superio_regdump (self->fd, self->port, j, error))
-				return FALSE;
+			g_autoptr(GError) error_local = NULL;
+			if (!fu_superio_regdump (self->fd, self->port, j, &error_local))
+				g_debug ("LDN: 0x%02x = %s", j, error_local->message);
 		}
 	}
 
@@ -405,15 +478,18 @@ fu_superio_device_setup (FuDevice *device, GError **error)
 
 	/* dump PMC register map */
 	if (g_getenv ("FWUPD_SUPERIO_VERBOSE") != NULL) {
-		guint8 buf[0xff] = { 0x00 };
-		for (guint i = 0x00; i < 0xff; i++) {
+		guint8 buf[0x100] = { 0x00 };
+		g_autoptr(GError) error_flush = NULL;
+		if (!fu_superio_device_ec_flush (self, &error_flush))
+			g_debug ("failed to flush: %s", error_flush->message);
+		for (guint i = 0x00; i < sizeof(buf); i++) {
 			g_autoptr(GError) error_local = NULL;
 			if (!fu_superio_device_ec_get_param (self, i, &buf[i], &error_local)) {
 				g_debug ("param: 0x%02x = %s", i, error_local->message);
 				continue;
 			}
 		}
-		fu_common_dump_raw (G_LOG_DOMAIN, "EC Registers", buf, 0x100);
+		fu_common_dump_raw (G_LOG_DOMAIN, "EC Registers", buf, sizeof(buf));
 	}
 
 	/* IT85xx */
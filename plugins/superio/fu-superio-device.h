@@ -16,5 +16,15 @@ G_DECLARE_FINAL_TYPE (FuSuperioDevice, fu_superio_device, FU, SUPERIO_DEVICE, Fu
 FuSuperioDevice	*fu_superio_device_new		(const gchar		*chipset,
 						 guint16		 id,
 						 guint16		 port);
+gboolean	 fu_superio_device_ec_read_params	(FuSuperioDevice	*self,
+							 guint8			 param,
+							 guint8			*buf,
+							 gsize			 bufsz,
+							 GError			**error);
+gboolean	 fu_superio_device_it89xx_read_ec_registers	(FuSuperioDevice	*self,
+								 guint16		 addr,
+								 guint8			*buf,
+								 gsize			 bufsz,
+								 GError			**error);
 
 G_END_DECLS
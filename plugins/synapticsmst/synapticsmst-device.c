@@ -554,108 +554,216 @@ synapticsmst_device_set_flash_sector_erase (SynapticsMSTDevice *device,
 	return TRUE;
 }
 
+typedef struct {
+	guint16			 erase_cmd;
+	guint16			 erase_offset;
+	guint32			 offset;	/* EEPROM address */
+	const guint8		*data;
+	guint32			 data_sz;
+	guint32			 check_sz;	/* bytes covered by the checksum */
+	guint32			 checksum;	/* expected UPDC_CAL_EEPROM_CHECKSUM */
+	gboolean		 dirty;
+} SynapticsMSTDeviceSector;
+
+static void
+synapticsmst_device_sector_init (SynapticsMSTDeviceSector *sector,
+				 guint16 erase_cmd,
+				 guint16 erase_offset,
+				 guint32 offset,
+				 const guint8 *data,
+				 guint32 data_sz,
+				 guint32 check_sz)
+{
+	sector->erase_cmd = erase_cmd;
+	sector->erase_offset = erase_offset;
+	sector->offset = offset;
+	sector->data = data;
+	sector->data_sz = data_sz;
+	sector->check_sz = check_sz;
+	sector->dirty = FALSE;
+
+	/* anything not written is left erased */
+	sector->checksum = 0;
+	for (guint32 i = 0; i < data_sz; i++)
+		sector->checksum += data[i];
+	sector->checksum += 0xff * (check_sz - data_sz);
+}
+
 static gboolean
-synapticsmst_device_update_esm (SynapticsMSTDevice *device,
-				const guint8 *payload_data,
-				GFileProgressCallback progress_cb,
-				gpointer progress_data,
-				GError **error)
+synapticsmst_device_sector_verify (SynapticsMSTDevice *device,
+				   SynapticsMSTDeviceSector *sector,
+				   GError **error)
 {
-	SynapticsMSTDevicePrivate *priv = GET_PRIVATE (device);
-	guint32 checksum = 0;
-	guint32 esm_sz = ESM_CODE_SIZE;
 	guint32 flash_checksum = 0;
-	guint32 unit_sz = BLOCK_UNIT;
-	guint32 write_loops = 0;
-	g_autoptr(SynapticsMSTConnection) connection = NULL;
-
-	connection = synapticsmst_common_new (priv->fd, priv->layer, priv->rad);
-
-	for (guint32 i = 0; i < esm_sz; i++)
-		checksum += *(payload_data + EEPROM_ESM_OFFSET +i);
 	if (!synapticsmst_device_get_flash_checksum (device,
-						    esm_sz,
-						    EEPROM_ESM_OFFSET,
-						    &flash_checksum, error)) {
+						     sector->check_sz,
+						     sector->offset,
+						     &flash_checksum,
+						     error))
 		return FALSE;
+	sector->dirty = flash_checksum != sector->checksum;
+	if (sector->dirty) {
+		g_debug ("sector 0x%05x checksum %x doesn't match expected %x",
+			 sector->offset, flash_checksum, sector->checksum);
 	}
+	return TRUE;
+}
 
-	/* ESM checksum same */
-	if (checksum == flash_checksum) {
-		g_debug ("ESM checksum already matches");
-		return TRUE;
+static gboolean
+synapticsmst_device_sector_write (SynapticsMSTDevice *device,
+				  SynapticsMSTConnection *connection,
+				  SynapticsMSTDeviceSector *sector,
+				  guint32 *done,
+				  guint32 total,
+				  GFileProgressCallback progress_cb,
+				  gpointer progress_data,
+				  GError **error)
+{
+	for (guint32 idx = 0; idx < sector->data_sz; idx += BLOCK_UNIT) {
+		guint32 offset = sector->offset + idx;
+		guint32 length = MIN (sector->data_sz - idx, BLOCK_UNIT);
+		g_autoptr(GError) error_local = NULL;
+		if (!synapticsmst_common_rc_set_command (connection,
+							 UPDC_WRITE_TO_EEPROM,
+							 length, offset,
+							 sector->data + idx,
+							 &error_local)) {
+			g_warning ("Failed to write flash offset 0x%04x: %s, retrying",
+				   offset, error_local->message);
+			/* repeat once */
+			if (!synapticsmst_common_rc_set_command (connection,
+								 UPDC_WRITE_TO_EEPROM,
+								 length, offset,
+								 sector->data + idx,
+								 error)) {
+				g_prefix_error (error, "can't write flash offset 0x%04x: ",
+						offset);
+				return FALSE;
+			}
+		}
+		*done += length;
+		if (progress_cb != NULL)
+			progress_cb ((goffset) *done, (goffset) total, progress_data);
 	}
-	g_debug ("ESM checksum %x doesn't match expected %x", flash_checksum, checksum);
+	return TRUE;
+}
 
-	/* update ESM firmware */
-	write_loops = esm_sz / unit_sz;
-	for (guint retries_cnt = 0; ; retries_cnt++) {
-		guint32 write_idx = 0;
-		guint32 write_offset = EEPROM_ESM_OFFSET;
-		const guint8 *esm_code_ptr = &payload_data[EEPROM_ESM_OFFSET];
+/* only the sectors where the EEPROM checksum differs are erased and written,
+ * unless @force is set, and each is verified on its own so a retry only
+ * repeats that sector */
+static gboolean
+synapticsmst_device_update_sectors (SynapticsMSTDevice *device,
+				    SynapticsMSTDeviceSector *sectors,
+				    guint sectors_len,
+				    gboolean force,
+				    GFileProgressCallback progress_cb,
+				    gpointer progress_data,
+				    GError **error)
+{
+	SynapticsMSTDevicePrivate *priv = GET_PRIVATE (device);
+	guint dirty_cnt = 0;
+	guint32 done = 0;
+	guint32 total = 0;
+	g_autoptr(SynapticsMSTConnection) connection = NULL;
 
-		/* erase ESM firmware; erase failure is fatal */
-		for (guint32 j = 0; j < 4; j++)	{
-			if (!synapticsmst_device_set_flash_sector_erase (device,
-									 FLASH_SECTOR_ERASE_64K,
-									 j + 4,
-									 error)) {
-				g_prefix_error (error, "failed to erase sector %u: ", j);
-				return FALSE;
-			}
+	/* find the sectors that need writing */
+	for (guint i = 0; i < sectors_len; i++) {
+		if (force) {
+			sectors[i].dirty = TRUE;
+		} else if (!synapticsmst_device_sector_verify (device, &sectors[i], error)) {
+			return FALSE;
 		}
+		if (!sectors[i].dirty)
+			continue;
+		total += sectors[i].data_sz;
+		dirty_cnt++;
+	}
+	if (dirty_cnt == 0) {
+		g_debug ("all sector checksums already match");
+		return TRUE;
+	}
+	g_debug ("updating %u of %u sectors", dirty_cnt, sectors_len);
 
-		g_debug ("Waiting for flash clear to settle");
-		g_usleep (FLASH_SETTLE_TIME);
+	/* erase everything first so we only have to wait once */
+	for (guint i = 0; i < sectors_len; i++) {
+		if (!sectors[i].dirty)
+			continue;
+		if (!synapticsmst_device_set_flash_sector_erase (device,
+								 sectors[i].erase_cmd,
+								 sectors[i].erase_offset,
+								 error))
+			return FALSE;
+	}
+	g_debug ("Waiting for flash clear to settle");
+	g_usleep (FLASH_SETTLE_TIME);
 
-		/* write firmware */
-		for (guint32 i = 0; i < write_loops; i++) {
-			g_autoptr(GError) error_local = NULL;
-			if (!synapticsmst_common_rc_set_command (connection,
-								 UPDC_WRITE_TO_EEPROM,
-								 unit_sz,
-								 write_offset,
-								 esm_code_ptr + write_idx,
-								 &error_local)) {
-				g_warning ("failed to write ESM: %s", error_local->message);
+	connection = synapticsmst_common_new (priv->fd, priv->layer, priv->rad);
+	for (guint i = 0; i < sectors_len; i++) {
+		SynapticsMSTDeviceSector *sector = &sectors[i];
+		guint32 done_sector = done;
+		if (!sector->dirty)
+			continue;
+		for (guint32 retries_cnt = 0; ; retries_cnt++) {
+			done = done_sector;
+			if (!synapticsmst_device_sector_write (device, connection,
+								sector, &done, total,
+								progress_cb, progress_data,
+								error))
+				return FALSE;
+			if (!synapticsmst_device_sector_verify (device, sector, error))
+				return FALSE;
+			if (!sector->dirty)
 				break;
-			}
-			write_offset += unit_sz;
-			write_idx += unit_sz;
-			if (progress_cb != NULL) {
-				progress_cb ((goffset) i * 100,
-					(goffset) (write_loops -1) * 100,
-					progress_data);
+			g_debug ("attempt %u: sector 0x%05x failed to verify",
+				 retries_cnt, sector->offset);
+			if (retries_cnt > MAX_RETRY_COUNTS) {
+				g_set_error (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_INVALID_DATA,
+					     "checksum of sector 0x%05x did not match after %u tries",
+					     sector->offset, retries_cnt);
+				return FALSE;
 			}
 
+			/* start this sector again */
+			if (!synapticsmst_device_set_flash_sector_erase (device,
+									 sector->erase_cmd,
+									 sector->erase_offset,
+									 error))
+				return FALSE;
+			g_debug ("Waiting for flash clear to settle");
+			g_usleep (FLASH_SETTLE_TIME);
 		}
+	}
 
-		/* check ESM checksum */
-		checksum = 0;
-		flash_checksum = 0;
-		for (guint32 i = 0; i < esm_sz; i++)
-			checksum += *(payload_data + EEPROM_ESM_OFFSET +i);
-		if (!synapticsmst_device_get_flash_checksum (device,
-							     esm_sz,
-							     EEPROM_ESM_OFFSET,
-							     &flash_checksum,
-							     error))
-			return FALSE;
-
-		/* ESM update done */
-		if (checksum == flash_checksum)
-			break;
-		g_debug ("attempt %u: ESM checksum %x didn't match %x", retries_cnt, flash_checksum, checksum);
+	return TRUE;
+}
 
-		/* abort */
-		if (retries_cnt > MAX_RETRY_COUNTS) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_INVALID_DATA,
-				     "checksum did not match after %u tries", retries_cnt);
-			return FALSE;
-		}
+static gboolean
+synapticsmst_device_update_esm (SynapticsMSTDevice *device,
+				const guint8 *payload_data,
+				GFileProgressCallback progress_cb,
+				gpointer progress_data,
+				GError **error)
+{
+	SynapticsMSTDeviceSector sectors[ESM_CODE_SIZE / PAYLOAD_SIZE_64K];
+
+	for (guint32 i = 0; i < G_N_ELEMENTS (sectors); i++) {
+		guint32 offset = EEPROM_ESM_OFFSET + (i * PAYLOAD_SIZE_64K);
+		synapticsmst_device_sector_init (&sectors[i],
+						 FLASH_SECTOR_ERASE_64K,
+						 offset / PAYLOAD_SIZE_64K,
+						 offset,
+						 payload_data + offset,
+						 PAYLOAD_SIZE_64K,
+						 PAYLOAD_SIZE_64K);
 	}
+	if (!synapticsmst_device_update_sectors (device, sectors,
+						 G_N_ELEMENTS (sectors),
+						 FALSE,
+						 progress_cb, progress_data,
+						 error))
+		return FALSE;
 	g_debug ("ESM successfully written");
 
 	return TRUE;
@@ -669,87 +777,15 @@ synapticsmst_device_update_tesla_leaf_firmware (SynapticsMSTDevice *device,
 						gpointer progress_data,
 						GError **error)
 {
-	SynapticsMSTDevicePrivate *priv = GET_PRIVATE (device);
-	g_autoptr(SynapticsMSTConnection) connection = NULL;
-	guint32 data_to_write = 0;
-	guint32 offset = 0;
-	guint32 write_loops = 0;
-
-	write_loops = (payload_len / BLOCK_UNIT);
-	data_to_write = payload_len;
-
-	if (payload_len % BLOCK_UNIT)
-		write_loops++;
-
-	connection = synapticsmst_common_new (priv->fd, priv->layer, priv->rad);
-	for (guint32 retries_cnt = 0; ; retries_cnt++) {
-		guint32 checksum = 0;
-		guint32 flash_checksum = 0;
-
-		if (!synapticsmst_device_set_flash_sector_erase (device, 0xffff, 0, error))
-			return FALSE;
-		g_debug ("Waiting for flash clear to settle");
-		g_usleep (FLASH_SETTLE_TIME);
-
-		for (guint32 i = 0; i < write_loops; i++) {
-			g_autoptr(GError) error_local = NULL;
-			guint8 length = BLOCK_UNIT;
-
-			if (data_to_write < BLOCK_UNIT)
-				length = data_to_write;
-			if (!synapticsmst_common_rc_set_command (connection,
-								 UPDC_WRITE_TO_EEPROM,
-								 length, offset,
-								 payload_data + offset,
-								 &error_local)) {
-				g_warning ("Failed to write flash offset 0x%04x: %s, retrying",
-					   offset, error_local->message);
-				/* repeat once */
-				if (!synapticsmst_common_rc_set_command (connection,
-									 UPDC_WRITE_TO_EEPROM,
-									 length, offset,
-									 payload_data + offset,
-									 error)) {
-					g_prefix_error (error, "can't write flash offset 0x%04x: ",
-							offset);
-					return FALSE;
-				}
-			}
-			offset += length;
-			data_to_write -= length;
-			if (progress_cb != NULL) {
-				progress_cb ((goffset) i * 100,
-					     (goffset) (write_loops -1) * 100,
-					     progress_data);
-			}
-		}
-
-		/* check data just written */
-		for (guint32 i = 0; i < payload_len; i++)
-			checksum += *(payload_data + i);
-
-		if (!synapticsmst_device_get_flash_checksum (device,
-								payload_len,
-								0,
-								&flash_checksum,
-								error))
-			return FALSE;
-		if (checksum == flash_checksum)
-			break;
-		g_debug ("attempt %u: checksum %x didn't match %x", retries_cnt, flash_checksum, checksum);
-
-		if (retries_cnt > MAX_RETRY_COUNTS) {
-			g_set_error (error,
-					G_IO_ERROR,
-					G_IO_ERROR_INVALID_DATA,
-					"checksum %x mismatched %x",
-					flash_checksum,
-					checksum);
-			return FALSE;
-		}
-	}
-
-	return TRUE;
+	SynapticsMSTDeviceSector sector;
+
+	/* the payload fits in one 64K sector, which is cleared with a full
+	 * erase as on Tesla the 64K sector erase is not used */
+	synapticsmst_device_sector_init (&sector, 0xffff, 0, 0,
+					 payload_data, payload_len, payload_len);
+	return synapticsmst_device_update_sectors (device, &sector, 1, FALSE,
+						   progress_cb, progress_data,
+						   error);
 }
 
 static gboolean
@@ -762,9 +798,13 @@ synapticsmst_device_update_panamera_firmware (SynapticsMSTDevice *device,
 {
 
 	guint16 crc_tmp = 0;
+	guint32 checksum = 0;
+	guint32 flash_checksum = 0;
 	guint32 fw_size;
 	guint32 unit_sz = BLOCK_UNIT;
 	guint32 write_loops = 0;
+	guint32 write_sz;
+	SynapticsMSTDeviceSector sectors[EEPROM_BANK_OFFSET / PAYLOAD_SIZE_64K];
 	guint8 bank_in_use;
 	guint8 bank_to_update = BANKTAG_1;
 	guint8 readBuf[256];
@@ -796,61 +836,35 @@ synapticsmst_device_update_panamera_firmware (SynapticsMSTDevice *device,
 	write_loops = fw_size / unit_sz;
 	if (fw_size % unit_sz)
 		write_loops++;
-
+	write_sz = write_loops * unit_sz;
+
+	/* the whole bank is compared so the tag is known to be erased */
+	for (guint32 i = 0; i < G_N_ELEMENTS (sectors); i++) {
+		guint32 sector_offset = i * PAYLOAD_SIZE_64K;
+		guint32 data_sz = 0;
+		if (write_sz > sector_offset)
+			data_sz = MIN (write_sz - sector_offset, PAYLOAD_SIZE_64K);
+		synapticsmst_device_sector_init (&sectors[i],
+						 FLASH_SECTOR_ERASE_64K,
+						 (bank_to_update * 2) + i,
+						 (EEPROM_BANK_OFFSET * bank_to_update) + sector_offset,
+						 payload_data + sector_offset,
+						 data_sz,
+						 PAYLOAD_SIZE_64K);
+	}
+	connection = synapticsmst_common_new (priv->fd, priv->layer, priv->rad);
+	checksum = synapticsmst_device_get_crc ( 0, 16, fw_size, payload_data );
 	for (guint32 retries_cnt = 0; ; retries_cnt++) {
-		guint32 checksum = 0;
-		guint32 erase_offset;
-		guint32 flash_checksum = 0;
-		guint32 write_idx;
-		guint32 write_offset;
-
-		/* erase storage */
-		erase_offset = bank_to_update * 2;
-		if (!synapticsmst_device_set_flash_sector_erase (device,
-								 FLASH_SECTOR_ERASE_64K, erase_offset++, error))
+		/* the per-sector sums can match even when the CRC does not, so
+		 * after a CRC failure the whole bank is erased and rewritten */
+		if (!synapticsmst_device_update_sectors (device, sectors,
+							 G_N_ELEMENTS (sectors),
+							 retries_cnt > 0,
+							 progress_cb, progress_data,
+							 error))
 			return FALSE;
-		if (!synapticsmst_device_set_flash_sector_erase (device,
-								 FLASH_SECTOR_ERASE_64K, erase_offset, error))
-			return FALSE;
-		g_debug ("Waiting for flash clear to settle");
-		g_usleep (FLASH_SETTLE_TIME);
-
-		/* write */
-		write_idx = 0;
-		write_offset = EEPROM_BANK_OFFSET * bank_to_update;
-		connection = synapticsmst_common_new (priv->fd, priv->layer, priv->rad);
-		for (guint32 i = 0; i < write_loops ; i++ ) {
-			g_autoptr(GError) error_local = NULL;
-			if (!synapticsmst_common_rc_set_command (connection,
-								UPDC_WRITE_TO_EEPROM,
-								unit_sz,
-								write_offset,
-								payload_data + write_idx,
-								&error_local)) {
-				g_warning ("Write failed: %s, retrying", error_local->message);
-				/* repeat once */
-				if (!synapticsmst_common_rc_set_command (connection,
-									 UPDC_WRITE_TO_EEPROM,
-									 unit_sz,
-									 write_offset,
-									 payload_data + write_idx,
-									 error)) {
-					g_prefix_error (error, "firmware write failed: ");
-					return FALSE;
-				}
-			}
-
-			write_offset += unit_sz;
-			write_idx += unit_sz;
-			if (progress_cb != NULL) {
-				progress_cb ((goffset) i * 100,
-					     (goffset) (write_loops -1) * 100,
-					     progress_data);
-			}
-		}
 
 		/* verify CRC */
-		checksum = synapticsmst_device_get_crc ( 0, 16, fw_size, payload_data );
 		for (guint32 i = 0; i < 4; i++) {
 			g_usleep (1000);	/* wait crc calculation */
 			if (!synapticsmst_common_rc_special_get_command (connection,
@@ -864,11 +878,14 @@ synapticsmst_device_update_panamera_firmware (SynapticsMSTDevice *device,
 		}
 		if (checksum == flash_checksum)
 			break;
+		g_debug ("attempt %u: CRC %x didn't match %x",
+			 retries_cnt, flash_checksum, checksum);
 		if (retries_cnt > MAX_RETRY_COUNTS) {
-			g_set_error_literal (error,
-					     G_IO_ERROR,
-					     G_IO_ERROR_INVALID_DATA,
-					     "firmware update fail");
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "firmware update fail, CRC %x did not match %x",
+				     flash_checksum, checksum);
 			return FALSE;
 		}
 		g_usleep (2000);
@@ -31,10 +31,63 @@ fu_plugin_destroy (FuPlugin *plugin)
 	g_debug ("destroy");
 }
 
+static guint
+fu_plugin_test_get_env_uint (const gchar *name, guint value_default)
+{
+	const gchar *tmp = g_getenv (name);
+	if (tmp == NULL)
+		return value_default;
+	return (guint) g_ascii_strtoull (tmp, NULL, 10);
+}
+
+/* lots of devices that need no hardware, used by `fwupdtool benchmark` */
+static gboolean
+fu_plugin_test_coldplug_benchmark (FuPlugin *plugin, GError **error)
+{
+	guint devices = fu_plugin_test_get_env_uint ("FWUPD_PLUGIN_TEST_DEVICES", 10);
+	guint guids = fu_plugin_test_get_env_uint ("FWUPD_PLUGIN_TEST_GUIDS", 1);
+	guint children = fu_plugin_test_get_env_uint ("FWUPD_PLUGIN_TEST_CHILDREN", 0);
+
+	for (guint i = 0; i < devices; i++) {
+		g_autofree gchar *id = g_strdup_printf ("Benchmark%04u", i);
+		g_autoptr(FuDevice) device = fu_device_new ();
+		fu_device_set_id (device, id);
+		for (guint j = 0; j < guids; j++) {
+			g_autofree gchar *instance_id = NULL;
+			instance_id = g_strdup_printf ("BENCHMARK\\DEV_%04u&GUID_%04u", i, j);
+			fu_device_add_instance_id (device, instance_id);
+		}
+		fu_device_set_name (device, "Benchmark");
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_set_vendor (device, "ACME Corp.");
+		fu_device_set_vendor_id (device, "USB:0x046D");
+		fu_device_set_version (device, "1.2.2");
+		for (guint j = 0; j < children; j++) {
+			g_autofree gchar *child_id = NULL;
+			g_autofree gchar *instance_id = NULL;
+			g_autoptr(FuDevice) child = fu_device_new ();
+			child_id = g_strdup_printf ("Benchmark%04u-%04u", i, j);
+			fu_device_set_id (child, child_id);
+			instance_id = g_strdup_printf ("BENCHMARK\\DEV_%04u&CHILD_%04u", i, j);
+			fu_device_add_instance_id (child, instance_id);
+			fu_device_set_name (child, "Module");
+			fu_device_add_flag (child, FWUPD_DEVICE_FLAG_UPDATABLE);
+			fu_device_set_version (child, "1.2.2");
+			fu_device_add_child (device, child);
+		}
+		fu_plugin_device_add (plugin, device);
+	}
+	return TRUE;
+}
+
 gboolean
 fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 {
 	g_autoptr(FuDevice) device = NULL;
+
+	if (g_strcmp0 (g_getenv ("FWUPD_PLUGIN_TEST"), "benchmark") == 0)
+		return fu_plugin_test_coldplug_benchmark (plugin, error);
+
 	device = fu_device_new ();
 	fu_device_set_id (device, "FakeDevice");
 	fu_device_add_guid (device, "b585990a-003e-5270-89d5-3705a17f9a43");
@@ -133,6 +186,11 @@ fu_plugin_update (FuPlugin *plugin,
 				     "device was not in supported mode");
 		return FALSE;
 	}
+
+	/* only the engine overhead is interesting */
+	if (g_strcmp0 (test, "benchmark") == 0)
+		return TRUE;
+
 	fu_device_set_status (device, FWUPD_STATUS_DECOMPRESSING);
 	for (guint i = 1; i <= 100; i++) {
 		g_usleep (1000);
@@ -0,0 +1,21 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-fuzzer.h"
+#include "fu-thunderbolt-image.h"
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autoptr(GBytes) blob = g_bytes_new_static (data, size);
+
+	/* the same untrusted data is used for both images */
+	fu_thunderbolt_image_validate (blob, blob, NULL);
+	fu_thunderbolt_image_controller_is_native (blob, NULL, NULL);
+	return 0;
+}
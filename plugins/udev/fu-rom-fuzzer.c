@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-fuzzer.h"
+#include "fu-rom.h"
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autofree guint8 *buf = g_memdup (data, size);
+	g_autoptr(FuRom) rom = fu_rom_new ();
+	fu_rom_load_data (rom, buf, size, FU_ROM_LOAD_FLAG_NONE, NULL, NULL);
+	return 0;
+}
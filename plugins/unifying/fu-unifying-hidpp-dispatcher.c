@@ -0,0 +1,674 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-unifying-common.h"
+#include "fu-unifying-hidpp.h"
+#include "fu-unifying-hidpp-dispatcher.h"
+
+/*
+ * The dispatcher allows more than one HID++ request to be written before the
+ * first reply has been read. Replies are matched to requests using the device
+ * index, the feature index or SubID and the function ID, which for HID++2.0
+ * includes the SwID. Requests for the same function on the same device are
+ * given different SwIDs so that they can also be in flight at the same time.
+ *
+ * Any report that does not match a pending request is either an unsolicited
+ * notification, which is passed to the subscribers, or a reply to some other
+ * software, e.g. Solaar, which is ignored.
+ */
+
+typedef struct {
+	FuUnifyingHidppMsg	*msg;		/* not owned */
+	gboolean		 sent;
+	gboolean		 done;
+	gint64			 deadline;	/* monotonic, in us */
+	GError			*error;
+} FuUnifyingHidppRequest;
+
+typedef struct {
+	guint			 id;
+	guint8			 device_id;
+	FuUnifyingHidppNotifyFunc func;
+	gpointer		 user_data;
+} FuUnifyingHidppSubscriber;
+
+struct _FuUnifyingHidppDispatcher {
+	GObject			 parent_instance;
+	FuIOChannel		*io_channel;
+	GPtrArray		*requests;	/* of FuUnifyingHidppRequest */
+	GPtrArray		*subscribers;	/* of FuUnifyingHidppSubscriber */
+	guint			 subscriber_id;
+	guint			 max_in_flight;
+	guint8			 hidpp_version;
+};
+
+G_DEFINE_TYPE (FuUnifyingHidppDispatcher, fu_unifying_hidpp_dispatcher, G_TYPE_OBJECT)
+
+static void
+fu_unifying_hidpp_request_free (FuUnifyingHidppRequest *req)
+{
+	if (req->error != NULL)
+		g_error_free (req->error);
+	g_free (req);
+}
+
+static gboolean
+fu_unifying_hidpp_request_is_in_flight (FuUnifyingHidppRequest *req)
+{
+	return req->sent && !req->done;
+}
+
+static void
+fu_unifying_hidpp_request_complete (FuUnifyingHidppRequest *req, GError *error)
+{
+	req->done = TRUE;
+	if (error != NULL && req->error == NULL)
+		req->error = error;
+	else if (error != NULL)
+		g_error_free (error);
+}
+
+guint
+fu_unifying_hidpp_dispatcher_get_in_flight (FuUnifyingHidppDispatcher *self)
+{
+	guint cnt = 0;
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), 0);
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		if (fu_unifying_hidpp_request_is_in_flight (req))
+			cnt++;
+	}
+	return cnt;
+}
+
+static gboolean
+fu_unifying_hidpp_dispatcher_device_match (guint8 device_id1, guint8 device_id2)
+{
+	if (device_id1 == HIDPP_DEVICE_ID_UNSET || device_id2 == HIDPP_DEVICE_ID_UNSET)
+		return TRUE;
+	return device_id1 == device_id2;
+}
+
+/* would a reply to @msg be confused with a reply to any in-flight request */
+static gboolean
+fu_unifying_hidpp_dispatcher_is_conflict (FuUnifyingHidppDispatcher *self,
+					  FuUnifyingHidppMsg *msg,
+					  guint8 function_id)
+{
+	const guint32 ignore_mask = FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SUB_ID |
+				    FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_FNCT_ID;
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		if (!fu_unifying_hidpp_request_is_in_flight (req))
+			continue;
+		if (!fu_unifying_hidpp_dispatcher_device_match (req->msg->device_id,
+								msg->device_id))
+			continue;
+		if ((req->msg->flags & ignore_mask) > 0 || (msg->flags & ignore_mask) > 0)
+			return TRUE;
+		if (req->msg->sub_id == msg->sub_id &&
+		    req->msg->function_id == function_id)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* choose a SwID that no in-flight request to the same function is using */
+static gboolean
+fu_unifying_hidpp_dispatcher_allocate_swid (FuUnifyingHidppDispatcher *self,
+					    FuUnifyingHidppMsg *msg)
+{
+	/* only for HID++2.0, and only if not already specified */
+	if (msg->hidpp_version < 2.f ||
+	    (msg->function_id & 0x0f) != 0x00 ||
+	    msg->flags & FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SWID) {
+		return !fu_unifying_hidpp_dispatcher_is_conflict (self, msg,
+								  msg->function_id);
+	}
+	for (guint8 swid = FU_UNIFYING_HIDPP_MSG_SW_ID; swid <= 0x0f; swid++) {
+		guint8 function_id = (msg->function_id & 0xf0) | swid;
+		if (!fu_unifying_hidpp_dispatcher_is_conflict (self, msg, function_id)) {
+			msg->function_id = function_id;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* write as many queued requests as the window and SwID space allow */
+static void
+fu_unifying_hidpp_dispatcher_send_queued (FuUnifyingHidppDispatcher *self)
+{
+	gboolean blocked[256] = { FALSE };
+	guint in_flight = fu_unifying_hidpp_dispatcher_get_in_flight (self);
+
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		FuIOChannelFlags flags = FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO;
+		guint timeout = FU_UNIFYING_DEVICE_TIMEOUT_MS;
+		GError *error_local = NULL;
+
+		if (req->sent || req->done)
+			continue;
+		if (in_flight >= self->max_in_flight)
+			break;
+
+		/* requests to the same device are never reordered */
+		if (blocked[req->msg->device_id])
+			continue;
+		if (!fu_unifying_hidpp_dispatcher_allocate_swid (self, req->msg)) {
+			blocked[req->msg->device_id] = TRUE;
+			continue;
+		}
+
+		/* increase timeout for some operations */
+		if (req->msg->flags & FU_UNIFYING_HIDPP_MSG_FLAG_LONGER_TIMEOUT)
+			timeout *= 10;
+
+		/* only throw away stale reports if nothing can be lost */
+		if (in_flight == 0)
+			flags |= FU_IO_CHANNEL_FLAG_FLUSH_INPUT;
+		if (!fu_unifying_hidpp_send_full (self->io_channel, req->msg,
+						  timeout, flags, &error_local)) {
+			fu_unifying_hidpp_request_complete (req, error_local);
+			continue;
+		}
+		req->sent = TRUE;
+		req->deadline = g_get_monotonic_time () + ((gint64) timeout * 1000);
+		in_flight++;
+	}
+}
+
+static FuUnifyingHidppRequest *
+fu_unifying_hidpp_dispatcher_find_for_error (FuUnifyingHidppDispatcher *self,
+					     FuUnifyingHidppMsg *msg)
+{
+	FuUnifyingHidppRequest *req_last = NULL;
+	guint in_flight = 0;
+
+	/* the error report contains the SubID and function ID of the request */
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		if (!fu_unifying_hidpp_request_is_in_flight (req))
+			continue;
+		in_flight++;
+		req_last = req;
+		if (!fu_unifying_hidpp_dispatcher_device_match (req->msg->device_id,
+								msg->device_id))
+			continue;
+		if (msg->function_id == req->msg->sub_id &&
+		    msg->data[0] == req->msg->function_id)
+			return req;
+	}
+
+	/* not everything fills in the error report correctly */
+	if (in_flight == 1)
+		return req_last;
+	return NULL;
+}
+
+static FuUnifyingHidppRequest *
+fu_unifying_hidpp_dispatcher_find_for_reply (FuUnifyingHidppDispatcher *self,
+					     FuUnifyingHidppMsg *msg)
+{
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		if (!fu_unifying_hidpp_request_is_in_flight (req))
+			continue;
+		if (fu_unifying_hidpp_msg_is_reply (req->msg, msg))
+			return req;
+	}
+	return NULL;
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_dispatch:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @msg: a received #FuUnifyingHidppMsg
+ *
+ * Routes a received report to the pending request it replies to, or to the
+ * notification subscribers if it was unsolicited.
+ *
+ * Returns: %TRUE if the report was used
+ **/
+gboolean
+fu_unifying_hidpp_dispatcher_dispatch (FuUnifyingHidppDispatcher *self,
+				       FuUnifyingHidppMsg *msg)
+{
+	FuUnifyingHidppRequest *req;
+	gboolean handled = FALSE;
+
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), FALSE);
+	g_return_val_if_fail (msg != NULL, FALSE);
+
+	/* we don't know how to handle this report packet */
+	if (fu_unifying_hidpp_msg_get_payload_length (msg) == 0x0) {
+		g_debug ("HID++1.0 report 0x%02x has unknown length, ignoring",
+			 msg->report_id);
+		return FALSE;
+	}
+
+	/* an error for one of our requests */
+	if (msg->sub_id == HIDPP_SUBID_ERROR_MSG ||
+	    msg->sub_id == HIDPP_SUBID_ERROR_MSG_20) {
+		GError *error_local = NULL;
+		req = fu_unifying_hidpp_dispatcher_find_for_error (self, msg);
+		if (req == NULL) {
+			g_debug ("ignoring error for SubID 0x%02x FnctID 0x%02x",
+				 msg->function_id, msg->data[0]);
+			return FALSE;
+		}
+		fu_unifying_hidpp_msg_is_error (msg, &error_local);
+		fu_unifying_hidpp_request_complete (req, error_local);
+		return TRUE;
+	}
+
+	/* a reply to one of our requests */
+	req = fu_unifying_hidpp_dispatcher_find_for_reply (self, msg);
+	if (req != NULL) {
+		fu_unifying_hidpp_msg_copy (req->msg, msg);
+		fu_unifying_hidpp_request_complete (req, NULL);
+		return TRUE;
+	}
+
+	/* probably a reply to some other software */
+	if (!fu_unifying_hidpp_msg_is_notification (msg)) {
+		if (msg->hidpp_version >= 2.f) {
+			g_debug ("ignoring reply with SwId 0x%02x",
+				 (guint) msg->function_id & 0x0f);
+		} else {
+			g_debug ("ignoring reply for SubID 0x%02x",
+				 msg->sub_id);
+		}
+		return FALSE;
+	}
+
+	/* unsolicited */
+	for (guint i = 0; i < self->subscribers->len; i++) {
+		FuUnifyingHidppSubscriber *sub = g_ptr_array_index (self->subscribers, i);
+		if (sub->device_id != HIDPP_DEVICE_ID_UNSET &&
+		    sub->device_id != msg->device_id)
+			continue;
+		sub->func (msg, sub->user_data);
+		handled = TRUE;
+	}
+	if (!handled)
+		g_debug ("no subscriber for notification 0x%02x", msg->sub_id);
+	return handled;
+}
+
+/* read one report, or expire the requests that have waited too long */
+static void
+fu_unifying_hidpp_dispatcher_pump (FuUnifyingHidppDispatcher *self)
+{
+	gint64 deadline = G_MAXINT64;
+	gint64 now = g_get_monotonic_time ();
+	guint timeout_ms;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
+
+	/* wait until the earliest deadline */
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		if (fu_unifying_hidpp_request_is_in_flight (req))
+			deadline = MIN (deadline, req->deadline);
+	}
+	if (deadline == G_MAXINT64)
+		return;
+	timeout_ms = deadline > now ? (guint) ((deadline - now + 999) / 1000) : 1;
+
+	msg->hidpp_version = self->hidpp_version;
+	if (fu_unifying_hidpp_receive (self->io_channel, msg, timeout_ms, &error_local)) {
+		fu_unifying_hidpp_dispatcher_dispatch (self, msg);
+
+		/* a stream of unrelated reports must not extend the timeout */
+		now = g_get_monotonic_time ();
+		for (guint i = 0; i < self->requests->len; i++) {
+			FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+			if (!fu_unifying_hidpp_request_is_in_flight (req))
+				continue;
+			if (req->deadline > now)
+				continue;
+			fu_unifying_hidpp_request_complete (req,
+				g_error_new_literal (G_IO_ERROR,
+						     G_IO_ERROR_TIMED_OUT,
+						     "failed to receive: timeout"));
+		}
+		return;
+	}
+
+	/* a timeout only fails the requests that have expired, but any other
+	 * error means the device has gone away */
+	now = g_get_monotonic_time ();
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, i);
+		if (!fu_unifying_hidpp_request_is_in_flight (req))
+			continue;
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_TIMED_OUT) &&
+		    req->deadline > MAX (deadline, now))
+			continue;
+		fu_unifying_hidpp_request_complete (req, g_error_copy (error_local));
+	}
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_submit:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @msg: a #FuUnifyingHidppMsg, which must remain valid until waited for
+ * @error: a #GError, or %NULL
+ *
+ * Queues a request and writes it to the device as soon as it can be told
+ * apart from the other in-flight requests. The reply is copied into @msg
+ * when fu_unifying_hidpp_dispatcher_wait() or
+ * fu_unifying_hidpp_dispatcher_flush() is used.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_unifying_hidpp_dispatcher_submit (FuUnifyingHidppDispatcher *self,
+				     FuUnifyingHidppMsg *msg,
+				     GError **error)
+{
+	FuUnifyingHidppRequest *req;
+
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), FALSE);
+	g_return_val_if_fail (msg != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* already queued */
+	for (guint i = 0; i < self->requests->len; i++) {
+		req = g_ptr_array_index (self->requests, i);
+		if (req->msg == msg) {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_PENDING,
+					     "request already submitted");
+			return FALSE;
+		}
+	}
+
+	req = g_new0 (FuUnifyingHidppRequest, 1);
+	req->msg = msg;
+	g_ptr_array_add (self->requests, req);
+	self->hidpp_version = msg->hidpp_version;
+	fu_unifying_hidpp_dispatcher_send_queued (self);
+	return TRUE;
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_expect:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @msg: a #FuUnifyingHidppMsg, which must remain valid until waited for
+ * @timeout_ms: timeout in ms
+ *
+ * Waits for a report matching @msg without writing anything to the device,
+ * for instance an event that completes an earlier command.
+ **/
+void
+fu_unifying_hidpp_dispatcher_expect (FuUnifyingHidppDispatcher *self,
+				     FuUnifyingHidppMsg *msg,
+				     guint timeout_ms)
+{
+	FuUnifyingHidppRequest *req;
+
+	g_return_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self));
+	g_return_if_fail (msg != NULL);
+
+	req = g_new0 (FuUnifyingHidppRequest, 1);
+	req->msg = msg;
+	req->sent = TRUE;
+	req->deadline = g_get_monotonic_time () + ((gint64) timeout_ms * 1000);
+	g_ptr_array_add (self->requests, req);
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_wait:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @msg: a submitted #FuUnifyingHidppMsg
+ * @error: a #GError, or %NULL
+ *
+ * Reads reports until the reply for @msg has been received, dispatching any
+ * other replies and notifications as they arrive.
+ *
+ * Returns: %TRUE if the device replied without error
+ **/
+gboolean
+fu_unifying_hidpp_dispatcher_wait (FuUnifyingHidppDispatcher *self,
+				   FuUnifyingHidppMsg *msg,
+				   GError **error)
+{
+	FuUnifyingHidppRequest *req = NULL;
+
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), FALSE);
+	g_return_val_if_fail (msg != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	for (guint i = 0; i < self->requests->len; i++) {
+		FuUnifyingHidppRequest *req_tmp = g_ptr_array_index (self->requests, i);
+		if (req_tmp->msg == msg) {
+			req = req_tmp;
+			break;
+		}
+	}
+	if (req == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "request was not submitted");
+		return FALSE;
+	}
+
+	/* keep the pipeline full while waiting */
+	while (!req->done) {
+		fu_unifying_hidpp_dispatcher_send_queued (self);
+		if (req->done)
+			break;
+		if (fu_unifying_hidpp_dispatcher_get_in_flight (self) == 0) {
+			g_set_error_literal (&req->error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_FAILED,
+					     "request could not be sent");
+			break;
+		}
+		fu_unifying_hidpp_dispatcher_pump (self);
+	}
+
+	if (req->error != NULL) {
+		g_propagate_error (error, g_steal_pointer (&req->error));
+		g_ptr_array_remove (self->requests, req);
+		return FALSE;
+	}
+	g_ptr_array_remove (self->requests, req);
+	return TRUE;
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_flush:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @error: a #GError, or %NULL
+ *
+ * Waits for every submitted request to complete.
+ *
+ * Returns: %TRUE if all requests succeeded, otherwise the first error
+ **/
+gboolean
+fu_unifying_hidpp_dispatcher_flush (FuUnifyingHidppDispatcher *self, GError **error)
+{
+	g_autoptr(GError) error_first = NULL;
+
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	while (self->requests->len > 0) {
+		FuUnifyingHidppRequest *req = g_ptr_array_index (self->requests, 0);
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_unifying_hidpp_dispatcher_wait (self, req->msg, &error_local)) {
+			if (error_first == NULL)
+				error_first = g_steal_pointer (&error_local);
+		}
+	}
+	if (error_first != NULL) {
+		g_propagate_error (error, g_steal_pointer (&error_first));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_transfer:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @msg: a #FuUnifyingHidppMsg
+ * @error: a #GError, or %NULL
+ *
+ * Sends a request and waits for the reply, which is copied into @msg.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_unifying_hidpp_dispatcher_transfer (FuUnifyingHidppDispatcher *self,
+				       FuUnifyingHidppMsg *msg,
+				       GError **error)
+{
+	if (!fu_unifying_hidpp_dispatcher_submit (self, msg, error))
+		return FALSE;
+	return fu_unifying_hidpp_dispatcher_wait (self, msg, error);
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_poll:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @timeout_ms: timeout in ms
+ * @error: a #GError, or %NULL
+ *
+ * Reads any pending reports and passes notifications to the subscribers.
+ *
+ * Returns: %TRUE for success, which includes no reports being available
+ **/
+gboolean
+fu_unifying_hidpp_dispatcher_poll (FuUnifyingHidppDispatcher *self,
+				   guint timeout_ms,
+				   GError **error)
+{
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* do not starve the caller if the device is very chatty */
+	for (guint i = 0; i < 32; i++) {
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
+		msg->hidpp_version = self->hidpp_version;
+		if (!fu_unifying_hidpp_receive (self->io_channel, msg,
+						timeout_ms, &error_local)) {
+			if (g_error_matches (error_local,
+					     G_IO_ERROR,
+					     G_IO_ERROR_TIMED_OUT))
+				break;
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+		fu_unifying_hidpp_dispatcher_dispatch (self, msg);
+	}
+	return TRUE;
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_subscribe:
+ * @self: a #FuUnifyingHidppDispatcher
+ * @device_id: a HID++ device index, or %HIDPP_DEVICE_ID_UNSET for all
+ * @func: a #FuUnifyingHidppNotifyFunc
+ * @user_data: user data for @func
+ *
+ * Registers a callback for unsolicited reports. The callback must not submit
+ * new requests.
+ *
+ * Returns: a subscription ID
+ **/
+guint
+fu_unifying_hidpp_dispatcher_subscribe (FuUnifyingHidppDispatcher *self,
+					guint8 device_id,
+					FuUnifyingHidppNotifyFunc func,
+					gpointer user_data)
+{
+	FuUnifyingHidppSubscriber *sub;
+
+	g_return_val_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self), 0);
+	g_return_val_if_fail (func != NULL, 0);
+
+	sub = g_new0 (FuUnifyingHidppSubscriber, 1);
+	sub->id = ++self->subscriber_id;
+	sub->device_id = device_id;
+	sub->func = func;
+	sub->user_data = user_data;
+	g_ptr_array_add (self->subscribers, sub);
+	return sub->id;
+}
+
+void
+fu_unifying_hidpp_dispatcher_unsubscribe (FuUnifyingHidppDispatcher *self,
+					  guint subscription_id)
+{
+	g_return_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self));
+	for (guint i = 0; i < self->subscribers->len; i++) {
+		FuUnifyingHidppSubscriber *sub = g_ptr_array_index (self->subscribers, i);
+		if (sub->id == subscription_id) {
+			g_ptr_array_remove_index (self->subscribers, i);
+			return;
+		}
+	}
+}
+
+void
+fu_unifying_hidpp_dispatcher_set_max_in_flight (FuUnifyingHidppDispatcher *self,
+						guint max_in_flight)
+{
+	g_return_if_fail (FU_IS_UNIFYING_HIDPP_DISPATCHER (self));
+	self->max_in_flight = MAX (max_in_flight, 1);
+}
+
+static void
+fu_unifying_hidpp_dispatcher_finalize (GObject *object)
+{
+	FuUnifyingHidppDispatcher *self = FU_UNIFYING_HIDPP_DISPATCHER (object);
+	g_ptr_array_unref (self->requests);
+	g_ptr_array_unref (self->subscribers);
+	g_object_unref (self->io_channel);
+	G_OBJECT_CLASS (fu_unifying_hidpp_dispatcher_parent_class)->finalize (object);
+}
+
+static void
+fu_unifying_hidpp_dispatcher_class_init (FuUnifyingHidppDispatcherClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_unifying_hidpp_dispatcher_finalize;
+}
+
+static void
+fu_unifying_hidpp_dispatcher_init (FuUnifyingHidppDispatcher *self)
+{
+	self->max_in_flight = FU_UNIFYING_HIDPP_DISPATCHER_MAX_IN_FLIGHT;
+	self->requests = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_unifying_hidpp_request_free);
+	self->subscribers = g_ptr_array_new_with_free_func (g_free);
+}
+
+/**
+ * fu_unifying_hidpp_dispatcher_new:
+ * @io_channel: a #FuIOChannel
+ *
+ * Creates a new HID++ dispatcher for a hidraw device.
+ *
+ * Returns: a #FuUnifyingHidppDispatcher
+ **/
+FuUnifyingHidppDispatcher *
+fu_unifying_hidpp_dispatcher_new (FuIOChannel *io_channel)
+{
+	FuUnifyingHidppDispatcher *self;
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (io_channel), NULL);
+	self = g_object_new (FU_TYPE_UNIFYING_HIDPP_DISPATCHER, NULL);
+	self->io_channel = g_object_ref (io_channel);
+	return self;
+}
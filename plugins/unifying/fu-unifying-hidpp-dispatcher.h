@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "fu-io-channel.h"
+#include "fu-unifying-hidpp-msg.h"
+
+G_BEGIN_DECLS
+
+#define FU_TYPE_UNIFYING_HIDPP_DISPATCHER (fu_unifying_hidpp_dispatcher_get_type ())
+G_DECLARE_FINAL_TYPE (FuUnifyingHidppDispatcher, fu_unifying_hidpp_dispatcher, FU, UNIFYING_HIDPP_DISPATCHER, GObject)
+
+/* maximum number of requests written before a reply has been received */
+#define FU_UNIFYING_HIDPP_DISPATCHER_MAX_IN_FLIGHT	8
+
+typedef void	(*FuUnifyingHidppNotifyFunc)	(FuUnifyingHidppMsg	*msg,
+						 gpointer		 user_data);
+
+FuUnifyingHidppDispatcher *fu_unifying_hidpp_dispatcher_new	(FuIOChannel		*io_channel);
+void		 fu_unifying_hidpp_dispatcher_set_max_in_flight	(FuUnifyingHidppDispatcher *self,
+								 guint			 max_in_flight);
+guint		 fu_unifying_hidpp_dispatcher_get_in_flight	(FuUnifyingHidppDispatcher *self);
+guint		 fu_unifying_hidpp_dispatcher_subscribe		(FuUnifyingHidppDispatcher *self,
+								 guint8			 device_id,
+								 FuUnifyingHidppNotifyFunc func,
+								 gpointer		 user_data);
+void		 fu_unifying_hidpp_dispatcher_unsubscribe	(FuUnifyingHidppDispatcher *self,
+								 guint			 subscription_id);
+gboolean	 fu_unifying_hidpp_dispatcher_submit		(FuUnifyingHidppDispatcher *self,
+								 FuUnifyingHidppMsg	*msg,
+								 GError			**error);
+void		 fu_unifying_hidpp_dispatcher_expect		(FuUnifyingHidppDispatcher *self,
+								 FuUnifyingHidppMsg	*msg,
+								 guint			 timeout_ms);
+gboolean	 fu_unifying_hidpp_dispatcher_wait		(FuUnifyingHidppDispatcher *self,
+								 FuUnifyingHidppMsg	*msg,
+								 GError			**error);
+gboolean	 fu_unifying_hidpp_dispatcher_flush		(FuUnifyingHidppDispatcher *self,
+								 GError			**error);
+gboolean	 fu_unifying_hidpp_dispatcher_transfer		(FuUnifyingHidppDispatcher *self,
+								 FuUnifyingHidppMsg	*msg,
+								 GError			**error);
+gboolean	 fu_unifying_hidpp_dispatcher_poll		(FuUnifyingHidppDispatcher *self,
+								 guint			 timeout_ms,
+								 GError			**error);
+gboolean	 fu_unifying_hidpp_dispatcher_dispatch		(FuUnifyingHidppDispatcher *self,
+								 FuUnifyingHidppMsg	*msg);
+
+G_END_DECLS
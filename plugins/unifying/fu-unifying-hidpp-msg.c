@@ -396,3 +396,32 @@ fu_unifying_hidpp_msg_verify_swid (FuUnifyingHidppMsg *msg)
 		return FALSE;
 	return TRUE;
 }
+
+/* unsolicited reports from the receiver or the peripheral */
+gboolean
+fu_unifying_hidpp_msg_is_notification (FuUnifyingHidppMsg *msg)
+{
+	g_return_val_if_fail (msg != NULL, FALSE);
+
+	/* register access replies and errors */
+	if (msg->sub_id >= HIDPP_SUBID_SET_REGISTER)
+		return FALSE;
+
+	/* all HID++1.0 events, even when sent to a HID++2.0 device */
+	if (msg->hidpp_version < 2.f ||
+	    fu_unifying_hidpp_msg_is_hidpp10_compat (msg))
+		return TRUE;
+
+	/* HID++2.0 events always use a SwID of zero */
+	return (msg->function_id & 0x0f) == 0x00;
+}
+
+/* the DeviceConnection notification has the protocol type in r0 and the link
+ * status in bit 6 of r1, which is set when the link is not established */
+gboolean
+fu_unifying_hidpp_msg_is_link_established (FuUnifyingHidppMsg *msg)
+{
+	g_return_val_if_fail (msg != NULL, FALSE);
+	g_return_val_if_fail (msg->sub_id == HIDPP_SUBID_DEVICE_CONNECTION, FALSE);
+	return (msg->data[0] & 0x40) == 0;
+}
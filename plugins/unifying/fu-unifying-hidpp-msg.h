@@ -49,6 +49,8 @@ gboolean	 fu_unifying_hidpp_msg_is_hidpp10_compat	(FuUnifyingHidppMsg	*msg);
 gboolean	 fu_unifying_hidpp_msg_is_error			(FuUnifyingHidppMsg	*msg,
 								 GError			**error);
 gboolean	 fu_unifying_hidpp_msg_verify_swid		(FuUnifyingHidppMsg	*msg);
+gboolean	 fu_unifying_hidpp_msg_is_notification		(FuUnifyingHidppMsg	*msg);
+gboolean	 fu_unifying_hidpp_msg_is_link_established	(FuUnifyingHidppMsg	*msg);
 
 const gchar	*fu_unifying_hidpp_msg_dev_id_to_string		(FuUnifyingHidppMsg	*msg);
 const gchar	*fu_unifying_hidpp_msg_rpt_id_to_string		(FuUnifyingHidppMsg	*msg);
@@ -57,15 +57,16 @@ fu_unifying_hidpp_msg_to_string (FuUnifyingHidppMsg *msg)
 }
 
 gboolean
-fu_unifying_hidpp_send (FuIOChannel *io_channel,
-			FuUnifyingHidppMsg *msg,
-			guint timeout,
-			GError **error)
+fu_unifying_hidpp_send_full (FuIOChannel *io_channel,
+			     FuUnifyingHidppMsg *msg,
+			     guint timeout,
+			     FuIOChannelFlags flags,
+			     GError **error)
 {
 	gsize len = fu_unifying_hidpp_msg_get_payload_length (msg);
 
-	/* only for HID++2.0 */
-	if (msg->hidpp_version >= 2.f)
+	/* only for HID++2.0, and only if not already chosen */
+	if (msg->hidpp_version >= 2.f && (msg->function_id & 0x0f) == 0x00)
 		msg->function_id |= FU_UNIFYING_HIDPP_MSG_SW_ID;
 
 	/* detailed debugging */
@@ -77,8 +78,7 @@ fu_unifying_hidpp_send (FuIOChannel *io_channel,
 
 	/* HID */
 	if (!fu_io_channel_write_raw (io_channel, (guint8 *) msg, len, 1500,
-				      FU_IO_CHANNEL_FLAG_FLUSH_INPUT |
-				      FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO, error)) {
+				      flags, error)) {
 		g_prefix_error (error, "failed to send: ");
 		return FALSE;
 	}
@@ -87,6 +87,18 @@ fu_unifying_hidpp_send (FuIOChannel *io_channel,
 	return TRUE;
 }
 
+gboolean
+fu_unifying_hidpp_send (FuIOChannel *io_channel,
+			FuUnifyingHidppMsg *msg,
+			guint timeout,
+			GError **error)
+{
+	return fu_unifying_hidpp_send_full (io_channel, msg, timeout,
+					    FU_IO_CHANNEL_FLAG_FLUSH_INPUT |
+					    FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO,
+					    error);
+}
+
 gboolean
 fu_unifying_hidpp_receive (FuIOChannel *io_channel,
 			   FuUnifyingHidppMsg *msg,
@@ -128,80 +140,3 @@ fu_unifying_hidpp_receive (FuIOChannel *io_channel,
 	/* success */
 	return TRUE;
 }
-
-gboolean
-fu_unifying_hidpp_transfer (FuIOChannel *io_channel, FuUnifyingHidppMsg *msg, GError **error)
-{
-	guint timeout = FU_UNIFYING_DEVICE_TIMEOUT_MS;
-	guint ignore_cnt = 0;
-	g_autoptr(FuUnifyingHidppMsg) msg_tmp = fu_unifying_hidpp_msg_new ();
-
-	/* increase timeout for some operations */
-	if (msg->flags & FU_UNIFYING_HIDPP_MSG_FLAG_LONGER_TIMEOUT)
-		timeout *= 10;
-
-	/* send request */
-	if (!fu_unifying_hidpp_send (io_channel, msg, timeout, error))
-		return FALSE;
-
-	/* keep trying to receive until we get a valid reply */
-	while (1) {
-		msg_tmp->hidpp_version = msg->hidpp_version;
-		if (!fu_unifying_hidpp_receive (io_channel, msg_tmp, timeout, error)) {
-			g_prefix_error (error, "failed to receive: ");
-			return FALSE;
-		}
-
-		/* we don't know how to handle this report packet */
-		if (fu_unifying_hidpp_msg_get_payload_length (msg_tmp) == 0x0) {
-			g_debug ("HID++1.0 report 0x%02x has unknown length, ignoring",
-				 msg_tmp->report_id);
-			continue;
-		}
-
-		/* maybe something is also writing to the device? --
-		 * we can't use the SwID as this is a HID++2.0 feature */
-		if (!fu_unifying_hidpp_msg_is_error (msg_tmp, error))
-			return FALSE;
-
-		/* is valid reply */
-		if (fu_unifying_hidpp_msg_is_reply (msg, msg_tmp))
-			break;
-
-		/* to ensure compatibility when an HID++ 2.0 device is
-		 * connected to an HID++ 1.0 receiver, any feature index
-		 * corresponding to an HID++ 1.0 sub-identifier which could be
-		 * sent by the receiver, must be assigned to a dummy feature */
-		if (msg->hidpp_version >= 2.f) {
-			if (fu_unifying_hidpp_msg_is_hidpp10_compat (msg_tmp)) {
-				g_debug ("ignoring HID++1.0 reply");
-				continue;
-			}
-
-			/* not us */
-			if ((msg->flags & FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SWID) == 0) {
-				if (!fu_unifying_hidpp_msg_verify_swid (msg_tmp)) {
-					g_debug ("ignoring reply with SwId 0x%02i, expected 0x%02i",
-						 msg_tmp->function_id & 0x0f,
-						 FU_UNIFYING_HIDPP_MSG_SW_ID);
-					continue;
-				}
-			}
-		}
-
-		/* hardware not responding */
-		if (ignore_cnt++ > 10) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_FAILED,
-				     "too many messages to ignore");
-			return FALSE;
-		}
-
-		g_debug ("ignoring message %u", ignore_cnt);
-	};
-
-	/* copy over data */
-	fu_unifying_hidpp_msg_copy (msg, msg_tmp);
-	return TRUE;
-}
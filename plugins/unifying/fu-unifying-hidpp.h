@@ -141,12 +141,14 @@ gboolean	 fu_unifying_hidpp_send		(FuIOChannel		*self,
 						 FuUnifyingHidppMsg	*msg,
 						 guint			 timeout,
 						 GError			**error);
-gboolean	 fu_unifying_hidpp_receive	(FuIOChannel		*self,
+gboolean	 fu_unifying_hidpp_send_full	(FuIOChannel		*self,
 						 FuUnifyingHidppMsg	*msg,
 						 guint			 timeout,
+						 FuIOChannelFlags	 flags,
 						 GError			**error);
-gboolean	 fu_unifying_hidpp_transfer	(FuIOChannel		*self,
+gboolean	 fu_unifying_hidpp_receive	(FuIOChannel		*self,
 						 FuUnifyingHidppMsg	*msg,
+						 guint			 timeout,
 						 GError			**error);
 
 G_END_DECLS
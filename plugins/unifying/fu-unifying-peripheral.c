@@ -11,6 +11,7 @@
 #include "fu-unifying-common.h"
 #include "fu-unifying-peripheral.h"
 #include "fu-unifying-hidpp.h"
+#include "fu-unifying-hidpp-dispatcher.h"
 
 struct _FuUnifyingPeripheral
 {
@@ -22,6 +23,7 @@ struct _FuUnifyingPeripheral
 	gboolean		 is_updatable;
 	gboolean		 is_active;
 	FuIOChannel		*io_channel;
+	FuUnifyingHidppDispatcher *dispatcher;
 	GPtrArray		*feature_index;	/* of FuUnifyingHidppMap */
 };
 
@@ -135,7 +137,7 @@ fu_unifying_peripheral_ping (FuUnifyingPeripheral *self, GError **error)
 	msg->data[1] = 0x00;
 	msg->data[2] = 0xaa; /* user-selected value */
 	msg->hidpp_version = self->hidpp_version;
-	if (!fu_unifying_hidpp_transfer (self->io_channel, msg, &error_local)) {
+	if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, &error_local)) {
 		if (g_error_matches (error_local,
 				     G_IO_ERROR,
 				     G_IO_ERROR_NOT_SUPPORTED)) {
@@ -180,6 +182,7 @@ static gboolean
 fu_unifying_peripheral_close (FuDevice *device, GError **error)
 {
 	FuUnifyingPeripheral *self = FU_UNIFYING_PERIPHERAL (device);
+	g_clear_object (&self->dispatcher);
 	if (!fu_io_channel_shutdown (self->io_channel, error))
 		return FALSE;
 	g_clear_object (&self->io_channel);
@@ -192,7 +195,6 @@ fu_unifying_peripheral_poll (FuDevice *device, GError **error)
 	FuUnifyingPeripheral *self = FU_UNIFYING_PERIPHERAL (device);
 	const guint timeout = 1; /* ms */
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
 	g_autoptr(FuDeviceLocker) locker = NULL;
 
 	/* open */
@@ -200,18 +202,10 @@ fu_unifying_peripheral_poll (FuDevice *device, GError **error)
 	if (locker == NULL)
 		return FALSE;
 
-	/* flush pending data */
-	msg->device_id = self->hidpp_id;
-	msg->hidpp_version = self->hidpp_version;
-	if (!fu_unifying_hidpp_receive (self->io_channel, msg, timeout, &error_local)) {
-		if (!g_error_matches (error_local,
-				      G_IO_ERROR,
-				      G_IO_ERROR_TIMED_OUT)) {
-			g_warning ("failed to get pending read: %s", error_local->message);
-			return TRUE;
-		}
-		/* no data to recieve */
-		g_clear_error (&error_local);
+	/* deliver pending notifications */
+	if (!fu_unifying_hidpp_dispatcher_poll (self->dispatcher, timeout, &error_local)) {
+		g_warning ("failed to get pending read: %s", error_local->message);
+		return TRUE;
 	}
 
 	/* just ping */
@@ -231,6 +225,21 @@ fu_unifying_peripheral_poll (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static void
+fu_unifying_peripheral_notify_cb (FuUnifyingHidppMsg *msg, gpointer user_data)
+{
+	FuUnifyingPeripheral *self = FU_UNIFYING_PERIPHERAL (user_data);
+
+	/* the receiver tells us when the wireless link comes and goes */
+	if (msg->sub_id == HIDPP_SUBID_DEVICE_CONNECTION) {
+		self->is_active = fu_unifying_hidpp_msg_is_link_established (msg);
+		g_debug ("link is %s", self->is_active ? "established" : "lost");
+		fu_unifying_peripheral_refresh_updatable (self);
+		return;
+	}
+	g_debug ("ignoring notification with SubID 0x%02x", msg->sub_id);
+}
+
 static gboolean
 fu_unifying_peripheral_open (FuDevice *device, GError **error)
 {
@@ -243,6 +252,12 @@ fu_unifying_peripheral_open (FuDevice *device, GError **error)
 	if (self->io_channel == NULL)
 		return FALSE;
 
+	/* allow more than one request in flight */
+	self->dispatcher = fu_unifying_hidpp_dispatcher_new (self->io_channel);
+	fu_unifying_hidpp_dispatcher_subscribe (self->dispatcher,
+						HIDPP_DEVICE_ID_UNSET,
+						fu_unifying_peripheral_notify_cb,
+						self);
 	return TRUE;
 }
 
@@ -284,6 +299,7 @@ fu_unifying_peripheral_fetch_firmware_info (FuUnifyingPeripheral *self, GError *
 	guint8 idx;
 	guint8 entity_count;
 	g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
+	g_autoptr(GPtrArray) msgs = g_ptr_array_new_with_free_func (g_free);
 
 	/* get the feature index */
 	idx = fu_unifying_peripheral_feature_get_idx (self, HIDPP_FEATURE_I_FIRMWARE_INFO);
@@ -296,54 +312,64 @@ fu_unifying_peripheral_fetch_firmware_info (FuUnifyingPeripheral *self, GError *
 	msg->sub_id = idx;
 	msg->function_id = 0x00 << 4; /* getCount */
 	msg->hidpp_version = self->hidpp_version;
-	if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+	if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 		g_prefix_error (error, "failed to get firmware count: ");
 		return FALSE;
 	}
 	entity_count = msg->data[0];
 	g_debug ("firmware entity count is %u", entity_count);
 
-	/* get firmware, bootloader, hardware versions */
+	/* get firmware, bootloader, hardware versions all at once */
+	for (guint8 i = 0; i < entity_count; i++) {
+		FuUnifyingHidppMsg *msg_info = fu_unifying_hidpp_msg_new ();
+		msg_info->report_id = HIDPP_REPORT_ID_SHORT;
+		msg_info->device_id = self->hidpp_id;
+		msg_info->sub_id = idx;
+		msg_info->function_id = 0x01 << 4; /* getInfo */
+		msg_info->data[0] = i;
+		msg_info->hidpp_version = self->hidpp_version;
+		g_ptr_array_add (msgs, msg_info);
+		if (!fu_unifying_hidpp_dispatcher_submit (self->dispatcher, msg_info, error)) {
+			fu_unifying_hidpp_dispatcher_flush (self->dispatcher, NULL);
+			return FALSE;
+		}
+	}
+	if (!fu_unifying_hidpp_dispatcher_flush (self->dispatcher, error)) {
+		g_prefix_error (error, "failed to get firmware info: ");
+		return FALSE;
+	}
 	for (guint8 i = 0; i < entity_count; i++) {
+		FuUnifyingHidppMsg *msg_info = g_ptr_array_index (msgs, i);
 		guint16 build;
 		g_autofree gchar *version = NULL;
 		g_autofree gchar *name = NULL;
 
-		msg->report_id = HIDPP_REPORT_ID_SHORT;
-		msg->device_id = self->hidpp_id;
-		msg->sub_id = idx;
-		msg->function_id = 0x01 << 4; /* getInfo */
-		msg->data[0] = i;
-		if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
-			g_prefix_error (error, "failed to get firmware info: ");
-			return FALSE;
-		}
-		if (msg->data[1] == 0x00 &&
-		    msg->data[2] == 0x00 &&
-		    msg->data[3] == 0x00 &&
-		    msg->data[4] == 0x00 &&
-		    msg->data[5] == 0x00 &&
-		    msg->data[6] == 0x00 &&
-		    msg->data[7] == 0x00) {
+		if (msg_info->data[1] == 0x00 &&
+		    msg_info->data[2] == 0x00 &&
+		    msg_info->data[3] == 0x00 &&
+		    msg_info->data[4] == 0x00 &&
+		    msg_info->data[5] == 0x00 &&
+		    msg_info->data[6] == 0x00 &&
+		    msg_info->data[7] == 0x00) {
 			g_debug ("no version set for entity %u", i);
 			continue;
 		}
 		name = g_strdup_printf ("%c%c%c",
-					msg->data[1],
-					msg->data[2],
-					msg->data[3]);
-		build = ((guint16) msg->data[6]) << 8 | msg->data[7];
+					msg_info->data[1],
+					msg_info->data[2],
+					msg_info->data[3]);
+		build = ((guint16) msg_info->data[6]) << 8 | msg_info->data[7];
 		version = fu_unifying_format_version (name,
-					     msg->data[4],
-					     msg->data[5],
+					     msg_info->data[4],
+					     msg_info->data[5],
 					     build);
 		g_debug ("firmware entity 0x%02x version is %s", i, version);
-		if (msg->data[0] == 0) {
+		if (msg_info->data[0] == 0) {
 			fu_device_set_version (FU_DEVICE (self), version);
 			self->cached_fw_entity = i;
-		} else if (msg->data[0] == 1) {
+		} else if (msg_info->data[0] == 1) {
 			fu_device_set_version_bootloader (FU_DEVICE (self), version);
-		} else if (msg->data[0] == 2) {
+		} else if (msg_info->data[0] == 2) {
 			fu_device_set_metadata (FU_DEVICE (self), "version-hw", version);
 		}
 	}
@@ -366,7 +392,7 @@ fu_unifying_peripheral_fetch_battery_level (FuUnifyingPeripheral *self, GError *
 			msg->sub_id = idx;
 			msg->function_id = 0x00; /* GetBatteryLevelStatus */
 			msg->hidpp_version = self->hidpp_version;
-			if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+			if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 				g_prefix_error (error, "failed to get battery info: ");
 				return FALSE;
 			}
@@ -384,7 +410,7 @@ fu_unifying_peripheral_fetch_battery_level (FuUnifyingPeripheral *self, GError *
 		msg->sub_id = HIDPP_SUBID_GET_REGISTER;
 		msg->function_id = HIDPP_REGISTER_BATTERY_MILEAGE;
 		msg->hidpp_version = self->hidpp_version;
-		if (fu_unifying_hidpp_transfer (self->io_channel, msg, NULL)) {
+		if (fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, NULL)) {
 			if (msg->data[0] != 0x00)
 				self->battery_level = msg->data[0];
 			return TRUE;
@@ -392,7 +418,7 @@ fu_unifying_peripheral_fetch_battery_level (FuUnifyingPeripheral *self, GError *
 
 		/* try HID++1.0 battery status instead */
 		msg->function_id = HIDPP_REGISTER_BATTERY_STATUS;
-		if (fu_unifying_hidpp_transfer (self->io_channel, msg, NULL)) {
+		if (fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, NULL)) {
 			switch (msg->data[0]) {
 			case 1: /* 0 - 10 */
 				self->battery_level = 5;
@@ -419,12 +445,10 @@ fu_unifying_peripheral_fetch_battery_level (FuUnifyingPeripheral *self, GError *
 	return TRUE;
 }
 
-static gboolean
-fu_unifying_hidpp_feature_search (FuDevice *device, guint16 feature, GError **error)
+static FuUnifyingHidppMsg *
+fu_unifying_hidpp_feature_search_msg (FuUnifyingPeripheral *self, guint16 feature)
 {
-	FuUnifyingPeripheral *self = FU_UNIFYING_PERIPHERAL (device);
-	FuUnifyingHidppMap *map;
-	g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
+	FuUnifyingHidppMsg *msg = fu_unifying_hidpp_msg_new ();
 
 	/* find the idx for the feature */
 	msg->report_id = HIDPP_REPORT_ID_SHORT;
@@ -435,7 +459,18 @@ fu_unifying_hidpp_feature_search (FuDevice *device, guint16 feature, GError **er
 	msg->data[1] = feature;
 	msg->data[2] = 0x00;
 	msg->hidpp_version = self->hidpp_version;
-	if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+	return msg;
+}
+
+static gboolean
+fu_unifying_hidpp_feature_search_finish (FuUnifyingPeripheral *self,
+					 guint16 feature,
+					 FuUnifyingHidppMsg *msg,
+					 GError **error)
+{
+	FuUnifyingHidppMap *map;
+
+	if (!fu_unifying_hidpp_dispatcher_wait (self->dispatcher, msg, error)) {
 		g_prefix_error (error,
 				"failed to get idx for feature %s [0x%04x]: ",
 				fu_unifying_hidpp_feature_to_string (feature), feature);
@@ -495,6 +530,7 @@ fu_unifying_peripheral_setup (FuDevice *device, GError **error)
 		HIDPP_FEATURE_DFU_CONTROL_SIGNED,
 		HIDPP_FEATURE_DFU,
 		HIDPP_FEATURE_ROOT };
+	g_autoptr(GPtrArray) msgs = g_ptr_array_new_with_free_func (g_free);
 
 	/* ping device to get HID++ version */
 	if (!fu_unifying_peripheral_ping (self, error))
@@ -509,12 +545,23 @@ fu_unifying_peripheral_setup (FuDevice *device, GError **error)
 		g_ptr_array_add (self->feature_index, map);
 	}
 
-	/* map some *optional* HID++2.0 features we might use */
+	/* map some *optional* HID++2.0 features we might use, asking for all
+	 * of them before waiting for the first reply */
 	for (guint i = 0; map_features[i] != HIDPP_FEATURE_ROOT; i++) {
+		FuUnifyingHidppMsg *msg = fu_unifying_hidpp_feature_search_msg (self, map_features[i]);
+		g_ptr_array_add (msgs, msg);
+		if (!fu_unifying_hidpp_dispatcher_submit (self->dispatcher, msg, error)) {
+			fu_unifying_hidpp_dispatcher_flush (self->dispatcher, NULL);
+			return FALSE;
+		}
+	}
+	for (guint i = 0; i < msgs->len; i++) {
+		FuUnifyingHidppMsg *msg = g_ptr_array_index (msgs, i);
 		g_autoptr(GError) error_local = NULL;
-		if (!fu_unifying_hidpp_feature_search (device,
-						       map_features[i],
-						       &error_local)) {
+		if (!fu_unifying_hidpp_feature_search_finish (self,
+							      map_features[i],
+							      msg,
+							      &error_local)) {
 			g_debug ("%s", error_local->message);
 			if (g_error_matches (error_local,
 					     G_IO_ERROR,
@@ -528,6 +575,9 @@ fu_unifying_peripheral_setup (FuDevice *device, GError **error)
 		}
 	}
 
+	/* do not leave requests pointing at freed messages */
+	fu_unifying_hidpp_dispatcher_flush (self->dispatcher, NULL);
+
 	/* get the firmware information */
 	if (!fu_unifying_peripheral_fetch_firmware_info (self, error))
 		return FALSE;
@@ -546,7 +596,7 @@ fu_unifying_peripheral_setup (FuDevice *device, GError **error)
 		msg->sub_id = idx;
 		msg->function_id = 0x02 << 4; /* getDeviceType */
 		msg->hidpp_version = self->hidpp_version;
-		if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+		if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 			g_prefix_error (error, "failed to get device type: ");
 			return FALSE;
 		}
@@ -573,7 +623,7 @@ fu_unifying_peripheral_setup (FuDevice *device, GError **error)
 		msg->sub_id = idx;
 		msg->function_id = 0x00 << 4; /* getDfuStatus */
 		msg->hidpp_version = self->hidpp_version;
-		if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+		if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 			g_prefix_error (error, "failed to get DFU status: ");
 			return FALSE;
 		}
@@ -626,7 +676,7 @@ fu_unifying_peripheral_detach (FuDevice *device, GError **error)
 		msg->hidpp_version = self->hidpp_version;
 		msg->flags = FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SUB_ID |
 			     FU_UNIFYING_HIDPP_MSG_FLAG_LONGER_TIMEOUT;
-		if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+		if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 			g_prefix_error (error, "failed to put device into DFU mode: ");
 			return FALSE;
 		}
@@ -649,7 +699,7 @@ fu_unifying_peripheral_detach (FuDevice *device, GError **error)
 		msg->data[5] = 'F';
 		msg->data[6] = 'U';
 		msg->flags = FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SUB_ID;
-		if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+		if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 			g_prefix_error (error, "failed to put device into DFU mode: ");
 			return FALSE;
 		}
@@ -810,16 +860,14 @@ fu_unifying_peripheral_check_status (guint8 status, GError **error)
 	return FALSE;
 }
 
-static gboolean
+static FuUnifyingHidppMsg *
 fu_unifying_peripheral_write_firmware_pkt (FuUnifyingPeripheral *self,
 					   guint8 idx,
 					   guint8 cmd,
 					   const guint8 *data,
 					   GError **error)
 {
-	guint32 packet_cnt;
 	g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
-	g_autoptr(GError) error_local = NULL;
 
 	/* send firmware data */
 	msg->report_id = HIDPP_REPORT_ID_LONG;
@@ -828,7 +876,22 @@ fu_unifying_peripheral_write_firmware_pkt (FuUnifyingPeripheral *self,
 	msg->function_id = cmd << 4; /* dfuStart or dfuCmdDataX */
 	msg->hidpp_version = self->hidpp_version;
 	memcpy (msg->data, data, 16);
-	if (!fu_unifying_hidpp_transfer (self->io_channel, msg, &error_local)) {
+	if (!fu_unifying_hidpp_dispatcher_submit (self->dispatcher, msg, error)) {
+		g_prefix_error (error, "failed to supply program data: ");
+		return NULL;
+	}
+	return g_steal_pointer (&msg);
+}
+
+static gboolean
+fu_unifying_peripheral_write_firmware_pkt_finish (FuUnifyingPeripheral *self,
+						  FuUnifyingHidppMsg *msg,
+						  GError **error)
+{
+	guint32 packet_cnt;
+	g_autoptr(GError) error_local = NULL;
+
+	if (!fu_unifying_hidpp_dispatcher_wait (self->dispatcher, msg, error)) {
 		g_prefix_error (error, "failed to supply program data: ");
 		return FALSE;
 	}
@@ -854,19 +917,19 @@ fu_unifying_peripheral_write_firmware_pkt (FuUnifyingPeripheral *self,
 	g_debug ("ignoring: %s", error_local->message);
 	for (guint retry = 0; retry < 10; retry++) {
 		g_autoptr(FuUnifyingHidppMsg) msg2 = fu_unifying_hidpp_msg_new ();
+		g_autoptr(GError) error2 = NULL;
+		msg2->device_id = msg->device_id;
+		msg2->sub_id = msg->sub_id;
+		msg2->hidpp_version = msg->hidpp_version;
 		msg2->flags = FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_FNCT_ID;
-		if (!fu_unifying_hidpp_receive (self->io_channel, msg2, 15000, error))
+		fu_unifying_hidpp_dispatcher_expect (self->dispatcher, msg2, 15000);
+		if (!fu_unifying_hidpp_dispatcher_wait (self->dispatcher, msg2, error))
 			return FALSE;
-		if (fu_unifying_hidpp_msg_is_reply (msg, msg2)) {
-			g_autoptr(GError) error2 = NULL;
-			if (!fu_unifying_peripheral_check_status (msg2->data[4], &error2)) {
-				g_debug ("got %s, waiting a bit longer", error2->message);
-				continue;
-			}
-			return TRUE;
-		} else {
-			g_debug ("got wrong packet, continue to wait...");
+		if (!fu_unifying_peripheral_check_status (msg2->data[4], &error2)) {
+			g_debug ("got %s, waiting a bit longer", error2->message);
+			continue;
 		}
+		return TRUE;
 	}
 
 	/* nothing in the queue */
@@ -900,17 +963,21 @@ fu_unifying_peripheral_write_firmware (FuDevice *device, GBytes *fw, GError **er
 	data = g_bytes_get_data (fw, &sz);
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (gsize i = 0; i < sz / 16; i++) {
+		g_autoptr(FuUnifyingHidppMsg) msg = NULL;
 
 		/* send packet and wait for reply */
 		g_debug ("send data at addr=0x%04x", (guint) i * 16);
-		if (!fu_unifying_peripheral_write_firmware_pkt (self,
-								idx,
-								cmd,
-								data + (i * 16),
-								error)) {
+		msg = fu_unifying_peripheral_write_firmware_pkt (self,
+								 idx,
+								 cmd,
+								 data + (i * 16),
+								 error);
+		if (msg == NULL ||
+		    !fu_unifying_peripheral_write_firmware_pkt_finish (self, msg, error)) {
 			g_prefix_error (error,
 					"failed to write @0x%04x: ",
 					(guint) i * 16);
+			fu_unifying_hidpp_dispatcher_flush (self->dispatcher, NULL);
 			return FALSE;
 		}
 
@@ -918,7 +985,7 @@ fu_unifying_peripheral_write_firmware (FuDevice *device, GBytes *fw, GError **er
 		cmd = (cmd + 1) % 4;
 
 		/* update progress-bar */
-		fu_device_set_progress_full (device, i * 16, sz);
+		fu_device_set_progress_full (device, (i + 1) * 16, sz);
 	}
 
 	return TRUE;
@@ -951,7 +1018,7 @@ fu_unifying_peripheral_attach (FuDevice *device, GError **error)
 	msg->flags = FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SUB_ID |
 		     FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SWID | // inferred?
 		     FU_UNIFYING_HIDPP_MSG_FLAG_LONGER_TIMEOUT;
-	if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+	if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 		g_prefix_error (error, "failed to restart device: ");
 		return FALSE;
 	}
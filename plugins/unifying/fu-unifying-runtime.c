@@ -11,6 +11,7 @@
 #include "fu-unifying-common.h"
 #include "fu-unifying-runtime.h"
 #include "fu-unifying-hidpp.h"
+#include "fu-unifying-hidpp-dispatcher.h"
 
 struct _FuUnifyingRuntime
 {
@@ -18,6 +19,7 @@ struct _FuUnifyingRuntime
 	guint8			 version_bl_major;
 	gboolean		 signed_firmware;
 	FuIOChannel		*io_channel;
+	FuUnifyingHidppDispatcher *dispatcher;
 };
 
 G_DEFINE_TYPE (FuUnifyingRuntime, fu_unifying_runtime, FU_TYPE_UDEV_DEVICE)
@@ -45,26 +47,47 @@ fu_unifying_runtime_enable_notifications (FuUnifyingRuntime *self, GError **erro
 	msg->data[1] = 0x05; /* Wireless + SoftwarePresent */
 	msg->data[2] = 0x00;
 	msg->hidpp_version = 1;
-	return fu_unifying_hidpp_transfer (self->io_channel, msg, error);
+	return fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error);
 }
 
 static gboolean
 fu_unifying_runtime_close (FuDevice *device, GError **error)
 {
 	FuUnifyingRuntime *self = FU_UNIFYING_RUNTIME (device);
+	g_clear_object (&self->dispatcher);
 	if (!fu_io_channel_shutdown (self->io_channel, error))
 		return FALSE;
 	g_clear_object (&self->io_channel);
 	return TRUE;
 }
 
+static void
+fu_unifying_runtime_notify_cb (FuUnifyingHidppMsg *msg, gpointer user_data)
+{
+	/* unifying receiver notification */
+	if (msg->report_id != HIDPP_REPORT_ID_SHORT)
+		return;
+	switch (msg->sub_id) {
+	case HIDPP_SUBID_DEVICE_CONNECTION:
+	case HIDPP_SUBID_DEVICE_DISCONNECTION:
+	case HIDPP_SUBID_DEVICE_LOCKING_CHANGED:
+		g_debug ("device connection event, do something");
+		break;
+	case HIDPP_SUBID_LINK_QUALITY:
+		g_debug ("ignoring link quality message");
+		break;
+	default:
+		g_debug ("unknown SubID %02x", msg->sub_id);
+		break;
+	}
+}
+
 static gboolean
 fu_unifying_runtime_poll (FuDevice *device, GError **error)
 {
 	FuUnifyingRuntime *self = FU_UNIFYING_RUNTIME (device);
 	const guint timeout = 1; /* ms */
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(FuUnifyingHidppMsg) msg = fu_unifying_hidpp_msg_new ();
 	g_autoptr(FuDeviceLocker) locker = NULL;
 
 	/* open */
@@ -72,43 +95,9 @@ fu_unifying_runtime_poll (FuDevice *device, GError **error)
 	if (locker == NULL)
 		return FALSE;
 
-	/* is there any pending data to read */
-	msg->hidpp_version = 1;
-	if (!fu_unifying_hidpp_receive (self->io_channel, msg, timeout, &error_local)) {
-		if (g_error_matches (error_local,
-				     G_IO_ERROR,
-				     G_IO_ERROR_TIMED_OUT)) {
-			return TRUE;
-		}
-		g_warning ("failed to get pending read: %s", error_local->message);
-		return TRUE;
-	}
-
-	/* HID++1.0 error */
-	if (!fu_unifying_hidpp_msg_is_error (msg, &error_local)) {
+	/* deliver any pending notifications */
+	if (!fu_unifying_hidpp_dispatcher_poll (self->dispatcher, timeout, &error_local))
 		g_warning ("failed to get pending read: %s", error_local->message);
-		return TRUE;
-	}
-
-	/* unifying receiver notification */
-	if (msg->report_id == HIDPP_REPORT_ID_SHORT) {
-		switch (msg->sub_id) {
-		case HIDPP_SUBID_DEVICE_CONNECTION:
-		case HIDPP_SUBID_DEVICE_DISCONNECTION:
-		case HIDPP_SUBID_DEVICE_LOCKING_CHANGED:
-			g_debug ("device connection event, do something");
-			break;
-		case HIDPP_SUBID_LINK_QUALITY:
-			g_debug ("ignoring link quality message");
-			break;
-		case HIDPP_SUBID_ERROR_MSG:
-			g_debug ("ignoring link quality message");
-			break;
-		default:
-			g_debug ("unknown SubID %02x", msg->sub_id);
-			break;
-		}
-	}
 	return TRUE;
 }
 
@@ -123,6 +112,11 @@ fu_unifying_runtime_open (FuDevice *device, GError **error)
 	self->io_channel = fu_io_channel_new_file (devpath, error);
 	if (self->io_channel == NULL)
 		return FALSE;
+	self->dispatcher = fu_unifying_hidpp_dispatcher_new (self->io_channel);
+	fu_unifying_hidpp_dispatcher_subscribe (self->dispatcher,
+						HIDPP_DEVICE_ID_UNSET,
+						fu_unifying_runtime_notify_cb,
+						self);
 
 	/* poll for notifications */
 	fu_device_set_poll_interval (device, 5000);
@@ -202,7 +196,7 @@ fu_unifying_runtime_setup_internal (FuDevice *device, GError **error)
 		msg->function_id = HIDPP_REGISTER_DEVICE_FIRMWARE_INFORMATION;
 		msg->data[0] = i;
 		msg->hidpp_version = 1;
-		if (!fu_unifying_hidpp_transfer (self->io_channel, msg, error)) {
+		if (!fu_unifying_hidpp_dispatcher_transfer (self->dispatcher, msg, error)) {
 			g_prefix_error (error, "failed to read device config: ");
 			return FALSE;
 		}
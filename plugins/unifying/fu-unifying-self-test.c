@@ -8,8 +8,11 @@
 
 #include <fwupd.h>
 #include <glib-object.h>
+#include <sys/socket.h>
 
 #include "fu-unifying-common.h"
+#include "fu-unifying-hidpp.h"
+#include "fu-unifying-hidpp-dispatcher.h"
 
 static void
 fu_unifying_common (void)
@@ -27,6 +30,147 @@ fu_unifying_common (void)
 	g_assert_cmpstr (ver1, ==, "A87.65_B4321");
 }
 
+static void
+fu_unifying_hidpp_dispatcher_notify_cb (FuUnifyingHidppMsg *msg, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+	g_assert_cmpint (msg->sub_id, ==, HIDPP_SUBID_DEVICE_CONNECTION);
+	(*cnt)++;
+}
+
+static void
+fu_unifying_hidpp_dispatcher_func (void)
+{
+	gboolean ret;
+	gint sv[2];
+	guint notify_cnt = 0;
+	const guint8 replies[][7] = {
+		{ 0x10, 0x01, 0x41, 0x00, 0x00, 0x00, 0x00 },	/* link established */
+		{ 0x10, 0x01, 0x00, 0x03, 0x05, 0x00, 0x00 },	/* for other software */
+		{ 0x10, 0x01, 0x00, 0x09, 0x0c, 0x00, 0x00 },
+		{ 0x10, 0x01, 0xff, 0x00, 0x08, 0x09, 0x00 },	/* unsupported */
+		{ 0x10, 0x01, 0x00, 0x07, 0x0a, 0x00, 0x00 },
+	};
+	g_autoptr(FuIOChannel) io_host = NULL;
+	g_autoptr(FuIOChannel) io_device = NULL;
+	g_autoptr(FuUnifyingHidppDispatcher) dispatcher = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) msgs = g_ptr_array_new_with_free_func (g_free);
+
+	/* hidraw preserves report boundaries */
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, sv), ==, 0);
+	io_host = fu_io_channel_unix_new (sv[0]);
+	io_device = fu_io_channel_unix_new (sv[1]);
+	dispatcher = fu_unifying_hidpp_dispatcher_new (io_host);
+	fu_unifying_hidpp_dispatcher_subscribe (dispatcher,
+						HIDPP_DEVICE_ID_UNSET,
+						fu_unifying_hidpp_dispatcher_notify_cb,
+						&notify_cnt);
+
+	/* look up three features without waiting for the replies */
+	for (guint i = 0; i < 3; i++) {
+		FuUnifyingHidppMsg *msg = fu_unifying_hidpp_msg_new ();
+		msg->report_id = HIDPP_REPORT_ID_SHORT;
+		msg->device_id = 0x01;
+		msg->sub_id = 0x00; /* rootIndex */
+		msg->function_id = 0x00 << 4; /* getFeature */
+		msg->data[1] = i;
+		msg->hidpp_version = 2;
+		ret = fu_unifying_hidpp_dispatcher_submit (dispatcher, msg, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_ptr_array_add (msgs, msg);
+	}
+	g_assert_cmpint (fu_unifying_hidpp_dispatcher_get_in_flight (dispatcher), ==, 3);
+
+	/* each request got a different SwID */
+	for (guint i = 0; i < 3; i++) {
+		guint8 buf[64] = { 0x0 };
+		gsize bufsz = 0;
+		ret = fu_io_channel_read_raw (io_device, buf, sizeof(buf), &bufsz, 100,
+					      FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpint (bufsz, ==, 7);
+		g_assert_cmpint (buf[3], ==, FU_UNIFYING_HIDPP_MSG_SW_ID + i);
+		g_assert_cmpint (buf[5], ==, i);
+	}
+
+	/* reply out of order, with other reports mixed in */
+	for (guint i = 0; i < G_N_ELEMENTS (replies); i++) {
+		ret = fu_io_channel_write_raw (io_device, replies[i], sizeof(replies[i]), 100,
+					       FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+
+	/* each reply went to the right request */
+	ret = fu_unifying_hidpp_dispatcher_wait (dispatcher, g_ptr_array_index (msgs, 0), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (((FuUnifyingHidppMsg *) g_ptr_array_index (msgs, 0))->data[0], ==, 0x0a);
+	ret = fu_unifying_hidpp_dispatcher_wait (dispatcher, g_ptr_array_index (msgs, 1), &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+	g_assert (!ret);
+	g_clear_error (&error);
+	ret = fu_unifying_hidpp_dispatcher_wait (dispatcher, g_ptr_array_index (msgs, 2), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (((FuUnifyingHidppMsg *) g_ptr_array_index (msgs, 2))->data[0], ==, 0x0c);
+	g_assert_cmpint (fu_unifying_hidpp_dispatcher_get_in_flight (dispatcher), ==, 0);
+
+	/* the notification was not dropped */
+	g_assert_cmpint (notify_cnt, ==, 1);
+}
+
+static void
+fu_unifying_hidpp_link_notify_cb (FuUnifyingHidppMsg *msg, gpointer user_data)
+{
+	GString *str = (GString *) user_data;
+	g_assert_cmpint (msg->sub_id, ==, HIDPP_SUBID_DEVICE_CONNECTION);
+	g_string_append_c (str, fu_unifying_hidpp_msg_is_link_established (msg) ? '+' : '-');
+}
+
+static void
+fu_unifying_hidpp_link_func (void)
+{
+	gboolean ret;
+	gint sv[2];
+	const guint8 notifications[][7] = {
+		{ 0x10, 0x01, 0x41, 0x04, 0x00, 0x01, 0x40 },	/* established */
+		{ 0x10, 0x01, 0x41, 0x04, 0x40, 0x01, 0x40 },	/* lost */
+		{ 0x10, 0x01, 0x41, 0x00, 0x61, 0x01, 0x40 },	/* lost, encrypted */
+		{ 0x10, 0x01, 0x41, 0x40, 0x20, 0x01, 0x40 },	/* established, encrypted */
+	};
+	g_autoptr(FuIOChannel) io_host = NULL;
+	g_autoptr(FuIOChannel) io_device = NULL;
+	g_autoptr(FuUnifyingHidppDispatcher) dispatcher = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, sv), ==, 0);
+	io_host = fu_io_channel_unix_new (sv[0]);
+	io_device = fu_io_channel_unix_new (sv[1]);
+	dispatcher = fu_unifying_hidpp_dispatcher_new (io_host);
+	fu_unifying_hidpp_dispatcher_subscribe (dispatcher,
+						HIDPP_DEVICE_ID_UNSET,
+						fu_unifying_hidpp_link_notify_cb,
+						str);
+
+	/* the link status is in r1, not in the protocol type */
+	for (guint i = 0; i < G_N_ELEMENTS (notifications); i++) {
+		ret = fu_io_channel_write_raw (io_device, notifications[i],
+					       sizeof(notifications[i]), 100,
+					       FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	ret = fu_unifying_hidpp_dispatcher_poll (dispatcher, 100, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (str->str, ==, "+--+");
+}
+
 int
 main (int argc, char **argv)
 {
@@ -37,5 +181,7 @@ main (int argc, char **argv)
 
 	/* tests go here */
 	g_test_add_func ("/unifying/common", fu_unifying_common);
+	g_test_add_func ("/unifying/hidpp-dispatcher", fu_unifying_hidpp_dispatcher_func);
+	g_test_add_func ("/unifying/hidpp-link", fu_unifying_hidpp_link_func);
 	return g_test_run ();
 }
@@ -487,11 +487,14 @@ fu_wac_device_write_firmware (FuDevice *device, GBytes *blob, GError **error)
 	DfuElement *element;
 	DfuImage *image;
 	FuWacDevice *self = FU_WAC_DEVICE (device);
+	gboolean full_rewrite;
+	guint blocks_written = 0;
 	gsize blocks_done = 0;
 	gsize blocks_total = 0;
 	g_autoptr(DfuFirmware) firmware = dfu_firmware_new ();
 	g_autoptr(GHashTable) fd_blobs = NULL;
 	g_autofree guint32 *csum_local = NULL;
+	g_autofree gboolean *block_skip = NULL;
 
 	/* load .wac file, including metadata */
 	if (!fu_wac_firmware_parse_data (firmware, blob,
@@ -549,16 +552,6 @@ fu_wac_device_write_firmware (FuDevice *device, GBytes *blob, GError **error)
 	if (!fu_wac_device_ensure_checksums (self, error))
 		return FALSE;
 
-	/* clear all checksums of pages */
-	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
-	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
-		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
-		if (fu_wav_device_flash_descriptor_is_wp (fd))
-			continue;
-		if (!fu_wac_device_set_checksum_of_block (self, i, 0x0, error))
-			return FALSE;
-	}
-
 	/* get the blobs for each chunk */
 	fd_blobs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 					  NULL, (GDestroyNotify) g_bytes_unref);
@@ -579,12 +572,42 @@ fu_wac_device_write_firmware (FuDevice *device, GBytes *blob, GError **error)
 		g_hash_table_insert (fd_blobs, fd, blob_block);
 	}
 
+	/* only rewrite the blocks where the device checksum differs */
+	full_rewrite = fu_device_has_custom_flag (device, "full-rewrite");
+	csum_local = g_new0 (guint32, self->flash_descriptors->len);
+	block_skip = g_new0 (gboolean, self->flash_descriptors->len);
+	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+		GBytes *blob_block = g_hash_table_lookup (fd_blobs, fd);
+		if (blob_block == NULL)
+			continue;
+		csum_local[i] = fu_wac_calculate_checksum32le_bytes (blob_block);
+		if (full_rewrite || i >= self->checksums->len)
+			continue;
+		if (g_array_index (self->checksums, guint32, i) == csum_local[i]) {
+			g_debug ("block %02u unchanged at 0x%08x, skipping",
+				 i, csum_local[i]);
+			block_skip[i] = TRUE;
+		}
+	}
+
+	/* clear all checksums of pages */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
+	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+		if (fu_wav_device_flash_descriptor_is_wp (fd))
+			continue;
+		if (block_skip[i])
+			continue;
+		if (!fu_wac_device_set_checksum_of_block (self, i, 0x0, error))
+			return FALSE;
+	}
+
 	/* checksum actions post-write */
 	blocks_total = g_hash_table_size (fd_blobs) + 2;
 
 	/* write the data into the flash page */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	csum_local = g_new0 (guint32, self->flash_descriptors->len);
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
 		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
 		GBytes *blob_block;
@@ -606,6 +629,12 @@ fu_wac_device_write_firmware (FuDevice *device, GBytes *blob, GError **error)
 			continue;
 		}
 
+		/* already has the correct contents */
+		if (block_skip[i]) {
+			fu_device_set_progress_full (device, blocks_done++, blocks_total);
+			continue;
+		}
+
 		/* erase entire block */
 		if (!fu_wac_device_erase_block (self, i, error))
 			return FALSE;
@@ -622,15 +651,17 @@ fu_wac_device_write_firmware (FuDevice *device, GBytes *blob, GError **error)
 				return FALSE;
 		}
 
-		/* calculate expected checksum and save to device RAM */
-		csum_local[i] = fu_wac_calculate_checksum32le_bytes (blob_block);
+		/* save expected checksum to device RAM */
 		g_debug ("block checksum %02u: 0x%08x", i, csum_local[i]);
 		if (!fu_wac_device_set_checksum_of_block (self, i, csum_local[i], error))
 			return FALSE;
+		blocks_written++;
 
 		/* update device progress */
 		fu_device_set_progress_full (device, blocks_done++, blocks_total);
 	}
+	g_debug ("wrote %u of %u blocks",
+		 blocks_written, g_hash_table_size (fd_blobs));
 
 	/* calculate CRC inside device */
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-fuzzer.h"
+#include "fu-wac-firmware.h"
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autoptr(DfuFirmware) firmware = dfu_firmware_new ();
+	g_autoptr(GBytes) blob = g_bytes_new_static (data, size);
+	fu_wac_firmware_parse_data (firmware, blob, DFU_FIRMWARE_PARSE_FLAG_NONE, NULL);
+	return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+/*
+ * This is loaded into `fwupdtool benchmark` using LD_PRELOAD to count the
+ * allocations made during each benchmark step. It is never installed, and it
+ * does not use GLib as it sits underneath it.
+ *
+ * The tool looks up fu_alloc_counter_start() and fu_alloc_counter_stop() at
+ * runtime, and skips the allocation counts when they are not found.
+ */
+
+#define _GNU_SOURCE
+
+#include "config.h"
+
+#include <dlfcn.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* dlsym() may itself call calloc() before the real one has been found */
+#define FU_ALLOC_COUNTER_BOOTSTRAP_SIZE		4096
+
+static void	*(*real_malloc)		(size_t) = NULL;
+static void	*(*real_calloc)		(size_t, size_t) = NULL;
+static void	*(*real_realloc)	(void *, size_t) = NULL;
+static void	*(*real_reallocarray)	(void *, size_t, size_t) = NULL;
+static void	*(*real_memalign)	(size_t, size_t) = NULL;
+static void	*(*real_aligned_alloc)	(size_t, size_t) = NULL;
+static int	 (*real_posix_memalign)	(void **, size_t, size_t) = NULL;
+static void	*(*real_valloc)		(size_t) = NULL;
+static void	*(*real_pvalloc)	(size_t) = NULL;
+static void	 (*real_free)		(void *) = NULL;
+
+static unsigned char	 fu_alloc_counter_bootstrap[FU_ALLOC_COUNTER_BOOTSTRAP_SIZE];
+static size_t		 fu_alloc_counter_bootstrap_used = 0;
+static int		 fu_alloc_counter_resolving = 0;
+static int		 fu_alloc_counter_enabled = 0;	/* atomic */
+static unsigned int	 fu_alloc_counter_count = 0;	/* atomic */
+
+static void
+fu_alloc_counter_resolve (void)
+{
+	if (real_free != NULL || fu_alloc_counter_resolving)
+		return;
+	fu_alloc_counter_resolving = 1;
+	real_malloc = dlsym (RTLD_NEXT, "malloc");
+	real_calloc = dlsym (RTLD_NEXT, "calloc");
+	real_realloc = dlsym (RTLD_NEXT, "realloc");
+	real_reallocarray = dlsym (RTLD_NEXT, "reallocarray");
+	real_memalign = dlsym (RTLD_NEXT, "memalign");
+	real_aligned_alloc = dlsym (RTLD_NEXT, "aligned_alloc");
+	real_posix_memalign = dlsym (RTLD_NEXT, "posix_memalign");
+	real_valloc = dlsym (RTLD_NEXT, "valloc");
+	real_pvalloc = dlsym (RTLD_NEXT, "pvalloc");
+	real_free = dlsym (RTLD_NEXT, "free");
+	fu_alloc_counter_resolving = 0;
+}
+
+static void *
+fu_alloc_counter_bootstrap_alloc (size_t size)
+{
+	void *ptr;
+	size = (size + 15) & ~((size_t) 15);
+	if (fu_alloc_counter_bootstrap_used + size > sizeof(fu_alloc_counter_bootstrap))
+		return NULL;
+	ptr = fu_alloc_counter_bootstrap + fu_alloc_counter_bootstrap_used;
+	fu_alloc_counter_bootstrap_used += size;
+	memset (ptr, 0, size);
+	return ptr;
+}
+
+static int
+fu_alloc_counter_is_bootstrap (void *ptr)
+{
+	return (unsigned char *) ptr >= fu_alloc_counter_bootstrap &&
+	       (unsigned char *) ptr < fu_alloc_counter_bootstrap + sizeof(fu_alloc_counter_bootstrap);
+}
+
+static void
+fu_alloc_counter_inc (void)
+{
+	if (__atomic_load_n (&fu_alloc_counter_enabled, __ATOMIC_RELAXED))
+		__atomic_add_fetch (&fu_alloc_counter_count, 1, __ATOMIC_RELAXED);
+}
+
+void
+fu_alloc_counter_start (void)
+{
+	__atomic_store_n (&fu_alloc_counter_count, 0, __ATOMIC_RELAXED);
+	__atomic_store_n (&fu_alloc_counter_enabled, 1, __ATOMIC_RELAXED);
+}
+
+unsigned int
+fu_alloc_counter_stop (void)
+{
+	__atomic_store_n (&fu_alloc_counter_enabled, 0, __ATOMIC_RELAXED);
+	return __atomic_load_n (&fu_alloc_counter_count, __ATOMIC_RELAXED);
+}
+
+void *
+malloc (size_t size)
+{
+	fu_alloc_counter_resolve ();
+	if (real_malloc == NULL)
+		return fu_alloc_counter_bootstrap_alloc (size);
+	fu_alloc_counter_inc ();
+	return real_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	fu_alloc_counter_resolve ();
+	if (real_calloc == NULL) {
+		if (size != 0 && nmemb > SIZE_MAX / size)
+			return NULL;
+		return fu_alloc_counter_bootstrap_alloc (nmemb * size);
+	}
+	fu_alloc_counter_inc ();
+	return real_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	fu_alloc_counter_resolve ();
+	if (fu_alloc_counter_is_bootstrap (ptr)) {
+		void *ptr_new = malloc (size);
+		size_t avail = sizeof(fu_alloc_counter_bootstrap) -
+			       ((unsigned char *) ptr - fu_alloc_counter_bootstrap);
+		if (ptr_new != NULL)
+			memcpy (ptr_new, ptr, size < avail ? size : avail);
+		return ptr_new;
+	}
+	fu_alloc_counter_inc ();
+	return real_realloc (ptr, size);
+}
+
+void *
+reallocarray (void *ptr, size_t nmemb, size_t size)
+{
+	fu_alloc_counter_resolve ();
+	if (fu_alloc_counter_is_bootstrap (ptr)) {
+		if (size != 0 && nmemb > SIZE_MAX / size)
+			return NULL;
+		return realloc (ptr, nmemb * size);
+	}
+	fu_alloc_counter_inc ();
+	return real_reallocarray (ptr, nmemb, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+	fu_alloc_counter_resolve ();
+	fu_alloc_counter_inc ();
+	return real_memalign (alignment, size);
+}
+
+void *
+aligned_alloc (size_t alignment, size_t size)
+{
+	fu_alloc_counter_resolve ();
+	fu_alloc_counter_inc ();
+	return real_aligned_alloc (alignment, size);
+}
+
+int
+posix_memalign (void **memptr, size_t alignment, size_t size)
+{
+	fu_alloc_counter_resolve ();
+	fu_alloc_counter_inc ();
+	return real_posix_memalign (memptr, alignment, size);
+}
+
+void *
+valloc (size_t size)
+{
+	fu_alloc_counter_resolve ();
+	fu_alloc_counter_inc ();
+	return real_valloc (size);
+}
+
+void *
+pvalloc (size_t size)
+{
+	fu_alloc_counter_resolve ();
+	fu_alloc_counter_inc ();
+	return real_pvalloc (size);
+}
+
+void
+free (void *ptr)
+{
+	if (ptr == NULL || fu_alloc_counter_is_bootstrap (ptr))
+		return;
+	fu_alloc_counter_resolve ();
+	real_free (ptr);
+}
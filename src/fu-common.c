@@ -6,6 +6,9 @@
 
 #define G_LOG_DOMAIN				"FuCommon"
 
+/* for F_GET_SEALS */
+#define _GNU_SOURCE
+
 #include <config.h>
 
 #include <gio/gunixinputstream.h>
@@ -14,7 +17,10 @@
 #include <archive_entry.h>
 #include <archive.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "fwupd-error.h"
 
@@ -198,6 +204,38 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
 	return g_bytes_new_take (data, len);
 }
 
+#ifdef HAVE_MEMFD_SEALS
+static gboolean
+fu_common_fd_is_sealed (gint fd)
+{
+	gint seals = fcntl (fd, F_GET_SEALS);
+	if (seals < 0)
+		return FALSE;
+	return (seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) == (F_SEAL_SHRINK | F_SEAL_WRITE);
+}
+#endif
+
+static GBytes *
+fu_common_get_contents_stream (GInputStream *stream, gsize count, GError **error)
+{
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+
+	/* a pipe has no size, so read in chunks until EOF or the limit */
+	while (buf->len < count) {
+		guint len = buf->len;
+		gsize chunksz = MIN (0x8000, count - len);
+		gssize sz;
+		g_byte_array_set_size (buf, len + chunksz);
+		sz = g_input_stream_read (stream, buf->data + len, chunksz, NULL, error);
+		if (sz < 0)
+			return NULL;
+		g_byte_array_set_size (buf, len + sz);
+		if (sz == 0)
+			break;
+	}
+	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+}
+
 /**
  * fu_common_get_contents_fd:
  * @fd: A file descriptor
@@ -206,6 +244,10 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
  *
  * Reads a blob from a specific file descriptor.
  *
+ * A memfd sealed against writing and shrinking is mapped rather than copied,
+ * as the contents cannot change once validated. Regular files are not mapped
+ * as the sender could truncate them, which would cause SIGBUS.
+ *
  * Note: this will close the fd when done
  *
  * Returns: (transfer full): a #GBytes, or %NULL
@@ -213,6 +255,9 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
 GBytes *
 fu_common_get_contents_fd (gint fd, gsize count, GError **error)
 {
+	gsize bytes_read = 0;
+	struct stat st = { 0x0 };
+	g_autofree guint8 *data = NULL;
 	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GInputStream) stream = NULL;
@@ -226,12 +271,53 @@ fu_common_get_contents_fd (gint fd, gsize count, GError **error)
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_NOT_SUPPORTED,
 				     "A maximum read size must be specified");
+		close (fd);
 		return NULL;
 	}
 
-	/* read the entire fd to a data blob */
+	/* the size is known up front for anything but a pipe */
 	stream = g_unix_input_stream_new (fd, TRUE);
-	blob = g_input_stream_read_bytes (stream, count, NULL, &error_local);
+	if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode)) {
+		if ((guint64) st.st_size > count) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "file size 0x%x exceeds the maximum of 0x%x",
+				     (guint) st.st_size, (guint) count);
+			return NULL;
+		}
+#ifdef HAVE_MEMFD_SEALS
+		if (fu_common_fd_is_sealed (fd)) {
+			g_autoptr(GMappedFile) mapped = NULL;
+			mapped = g_mapped_file_new_from_fd (fd, FALSE, &error_local);
+			if (mapped == NULL) {
+				g_set_error_literal (error,
+						     FWUPD_ERROR,
+						     FWUPD_ERROR_INVALID_FILE,
+						     error_local->message);
+				return NULL;
+			}
+			g_debug ("mapped sealed memfd with %" G_GSIZE_FORMAT " bytes",
+				 g_mapped_file_get_length (mapped));
+			return g_mapped_file_get_bytes (mapped);
+		}
+#endif
+
+		/* read directly into a buffer of the right size */
+		data = g_malloc (st.st_size);
+		if (!g_input_stream_read_all (stream, data, st.st_size,
+					      &bytes_read, NULL, &error_local)) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     error_local->message);
+			return NULL;
+		}
+		return g_bytes_new_take (g_steal_pointer (&data), bytes_read);
+	}
+
+	/* read the entire pipe to a data blob */
+	blob = fu_common_get_contents_stream (stream, count, &error_local);
 	if (blob == NULL) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -33,6 +33,7 @@ struct _FuConfig
 	GPtrArray		*approved_firmware;
 	guint64			 archive_size_max;
 	guint			 idle_timeout;
+	gboolean		 startup_snapshot;
 	XbSilo			*silo;
 	GHashTable		*os_release;
 };
@@ -438,6 +439,12 @@ fu_config_load_from_file (FuConfig *self, const gchar *config_file,
 					      NULL);
 	if (idle_timeout > 0)
 		self->idle_timeout = idle_timeout;
+
+	/* reuse the hardware state from the last startup */
+	self->startup_snapshot = g_key_file_get_boolean (self->keyfile,
+							 "fwupd",
+							 "StartupSnapshot",
+							 NULL);
 	return TRUE;
 }
 
@@ -546,6 +553,13 @@ fu_config_get_idle_timeout (FuConfig *self)
 	return self->idle_timeout;
 }
 
+gboolean
+fu_config_get_startup_snapshot (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->startup_snapshot;
+}
+
 FwupdRemote *
 fu_config_get_remote_by_id (FuConfig *self, const gchar *remote_id)
 {
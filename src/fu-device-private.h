@@ -29,5 +29,7 @@ gboolean	 fu_device_ensure_id			(FuDevice	*self,
 void		 fu_device_incorporate_from_component	(FuDevice	*device,
 							 XbNode		*component);
 void		 fu_device_convert_instance_ids		(FuDevice	*self);
+gint64		 fu_device_get_probe_duration		(FuDevice	*self);
+gint64		 fu_device_get_setup_duration		(FuDevice	*self);
 
 G_END_DECLS
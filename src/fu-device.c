@@ -16,10 +16,13 @@
 #include "fu-common-version.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
+#include "fu-trace.h"
 
-#include "fwupd-common.h"
+#include "fwupd-common-private.h"
 #include "fwupd-device-private.h"
 
+#define FU_DEVICE_GUID_CACHE_MAX		4096
+
 /**
  * SECTION:fu-device
  * @short_description: a physical or logical device
@@ -49,8 +52,15 @@ typedef struct {
 	guint				 order;
 	guint				 priority;
 	guint				 poll_id;
+	GMutex				 wait_mutex;
+	GCond				 wait_cond;
+	GMainContext			*wait_context;	/* only set while waiting */
+	gboolean			 wait_woken;
+	guint64				 wait_time;	/* ms */
 	gboolean			 done_probe;
 	gboolean			 done_setup;
+	gint64				 probe_duration;	/* us */
+	gint64				 setup_duration;	/* us */
 	guint64				 size_min;
 	guint64				 size_max;
 	gint				 open_refcount;	/* atomic */
@@ -205,6 +215,192 @@ fu_device_set_poll_interval (FuDevice *self, guint interval)
 	}
 }
 
+static gboolean
+fu_device_wait_timeout_cb (gpointer user_data)
+{
+	gboolean *timed_out = (gboolean *) user_data;
+	*timed_out = TRUE;
+	return G_SOURCE_REMOVE;
+}
+
+/* iterate the thread-default main context until the delay has passed, or
+ * until woken; if another thread is running that context then just block */
+static void
+fu_device_wait_sleep (FuDevice *self, guint delay_ms)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gboolean timed_out = FALSE;
+	gint64 end_time = g_get_monotonic_time () + (gint64) delay_ms * 1000;
+	g_autoptr(GMainContext) context = g_main_context_ref_thread_default ();
+
+	/* only a wake that arrives during this wait counts */
+	g_mutex_lock (&priv->wait_mutex);
+	priv->wait_woken = FALSE;
+	priv->wait_context = context;
+	g_mutex_unlock (&priv->wait_mutex);
+
+	if (g_main_context_acquire (context)) {
+		g_autoptr(GSource) source = g_timeout_source_new (delay_ms);
+		g_source_set_callback (source, fu_device_wait_timeout_cb, &timed_out, NULL);
+		g_source_attach (source, context);
+		while (!timed_out) {
+			gboolean woken;
+			g_mutex_lock (&priv->wait_mutex);
+			woken = priv->wait_woken;
+			g_mutex_unlock (&priv->wait_mutex);
+			if (woken)
+				break;
+			g_main_context_iteration (context, TRUE);
+		}
+		g_source_destroy (source);
+		g_main_context_release (context);
+		g_mutex_lock (&priv->wait_mutex);
+	} else {
+		g_mutex_lock (&priv->wait_mutex);
+		while (!priv->wait_woken) {
+			if (!g_cond_wait_until (&priv->wait_cond, &priv->wait_mutex, end_time))
+				break;
+		}
+	}
+	priv->wait_woken = FALSE;
+	priv->wait_context = NULL;
+	g_mutex_unlock (&priv->wait_mutex);
+}
+
+/**
+ * fu_device_wait_for:
+ * @self: A #FuDevice
+ * @func: (scope call) (allow-none): A #FuDeviceWaitFunc, or %NULL
+ * @user_data: user data for @func
+ * @delay_ms: the time to wait before first calling @func, in ms
+ * @timeout_ms: the maximum time to wait, in ms
+ * @error: A #GError, or %NULL
+ *
+ * Waits for the device to become ready. @func is called after @delay_ms and
+ * then with an exponentially increasing interval until it returns %TRUE or
+ * @timeout_ms has elapsed. If @func returns %FALSE and sets @error then
+ * waiting is aborted. If @func is %NULL then this just waits for @delay_ms.
+ *
+ * The thread-default main context is iterated while waiting, so D-Bus and
+ * other events are still dispatched and the main loop is not blocked. If
+ * that context is being run by another thread then this thread just blocks.
+ * fu_device_wait_wake() can be used to call @func early.
+ *
+ * Returns: %TRUE if the device is ready
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_device_wait_for (FuDevice *self,
+		    FuDeviceWaitFunc func,
+		    gpointer user_data,
+		    guint delay_ms,
+		    guint timeout_ms,
+		    GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	guint interval = FU_DEVICE_WAIT_INTERVAL_MIN;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (delay_ms > 0)
+		fu_device_wait_sleep (self, delay_ms);
+	while (func != NULL) {
+		guint elapsed;
+		g_autoptr(GError) error_local = NULL;
+
+		/* ready, or failed in a way that waiting will not fix */
+		if (func (self, user_data, &error_local))
+			break;
+		if (error_local != NULL) {
+			priv->wait_time += g_timer_elapsed (timer, NULL) * 1000;
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+
+		/* out of time */
+		elapsed = g_timer_elapsed (timer, NULL) * 1000;
+		if (elapsed >= timeout_ms) {
+			priv->wait_time += elapsed;
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_TIMED_OUT,
+				     "device not ready after %ums",
+				     elapsed);
+			return FALSE;
+		}
+
+		/* back off */
+		fu_device_wait_sleep (self, MIN (interval, timeout_ms - elapsed));
+		interval = MIN (interval * 2, FU_DEVICE_WAIT_INTERVAL_MAX);
+	}
+	priv->wait_time += g_timer_elapsed (timer, NULL) * 1000;
+	return TRUE;
+}
+
+/**
+ * fu_device_wait_wake:
+ * @self: A #FuDevice
+ *
+ * Wakes up any fu_device_wait_for() in progress so that the ready function is
+ * called without waiting for the rest of the interval. This would typically
+ * be called from an event handler or a thread reading events from the
+ * device. If nothing is waiting then this does nothing, so it never cuts
+ * short a later delay.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_device_wait_wake (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	g_mutex_lock (&priv->wait_mutex);
+	if (priv->wait_context != NULL) {
+		priv->wait_woken = TRUE;
+		g_cond_signal (&priv->wait_cond);
+		g_main_context_wakeup (priv->wait_context);
+	}
+	g_mutex_unlock (&priv->wait_mutex);
+}
+
+/**
+ * fu_device_get_wait_time:
+ * @self: A #FuDevice
+ *
+ * Gets the total time spent in fu_device_wait_for() since the device was
+ * created or fu_device_reset_wait_time() was last called.
+ *
+ * Returns: time in ms
+ *
+ * Since: 1.2.6
+ **/
+guint64
+fu_device_get_wait_time (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->wait_time;
+}
+
+/**
+ * fu_device_reset_wait_time:
+ * @self: A #FuDevice
+ *
+ * Resets the time returned by fu_device_get_wait_time().
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_device_reset_wait_time (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	priv->wait_time = 0;
+}
+
 /**
  * fu_device_get_order:
  * @self: a #FuPlugin
@@ -472,6 +668,64 @@ fu_device_add_child (FuDevice *self, FuDevice *child)
 	}
 }
 
+/* instance IDs are hashed for every match, so remember the result */
+static GHashTable *fu_device_guid_cache = NULL;	/* instance-id : fwupd_guid_t */
+G_LOCK_DEFINE_STATIC (fu_device_guid_cache);
+
+static void
+fu_device_instance_id_to_guid_raw (const gchar *instance_id, fwupd_guid_t *guid)
+{
+	fwupd_guid_t *guid_tmp;
+
+	G_LOCK (fu_device_guid_cache);
+	if (fu_device_guid_cache == NULL) {
+		fu_device_guid_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+							      g_free, g_free);
+	}
+	guid_tmp = g_hash_table_lookup (fu_device_guid_cache, instance_id);
+	if (guid_tmp == NULL) {
+		if (g_hash_table_size (fu_device_guid_cache) >= FU_DEVICE_GUID_CACHE_MAX)
+			g_hash_table_remove_all (fu_device_guid_cache);
+		guid_tmp = g_new (fwupd_guid_t, 1);
+		fwupd_guid_hash_data_raw ((const guint8 *) instance_id,
+					  strlen (instance_id),
+					  FWUPD_GUID_FLAG_NONE,
+					  guid_tmp);
+		g_hash_table_insert (fu_device_guid_cache,
+				     g_strdup (instance_id),
+				     guid_tmp);
+	}
+	memcpy (guid, guid_tmp, sizeof(fwupd_guid_t));
+	G_UNLOCK (fu_device_guid_cache);
+}
+
+/* converts a GUID or instance ID to binary, parsing and hashing just once */
+static gboolean
+fu_device_guid_to_raw (const gchar *guid, fwupd_guid_t *guid_raw)
+{
+	static const fwupd_guid_t guid_zero = { 0x0 };
+
+	if (guid == NULL || guid[0] == '\0')
+		return FALSE;
+	if (fwupd_guid_from_string (guid, guid_raw, FWUPD_GUID_FLAG_NONE, NULL) &&
+	    memcmp (guid_raw, &guid_zero, sizeof(guid_zero)) != 0)
+		return TRUE;
+	fu_device_instance_id_to_guid_raw (guid, guid_raw);
+	return TRUE;
+}
+
+/* same as fwupd_guid_hash_string(), but memoised */
+static gchar *
+fu_device_hash_instance_id (const gchar *instance_id)
+{
+	fwupd_guid_t guid_raw;
+	if (instance_id == NULL || instance_id[0] == '\0')
+		return NULL;
+	fu_device_instance_id_to_guid_raw (instance_id, &guid_raw);
+	return fwupd_guid_to_string ((const fwupd_guid_t *) &guid_raw,
+				     FWUPD_GUID_FLAG_NONE);
+}
+
 /**
  * fu_device_get_parent_guids:
  * @self: A #FuDevice
@@ -545,7 +799,7 @@ fu_device_add_parent_guid (FuDevice *self, const gchar *guid)
 
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		g_autofree gchar *tmp = fu_device_hash_instance_id (guid);
 		if (fu_device_has_parent_guid (self, tmp))
 			return;
 		g_debug ("using %s for %s", tmp, guid);
@@ -718,12 +972,15 @@ fu_device_add_guid_quirks (FuDevice *self, const gchar *guid)
 	const gchar *key;
 	const gchar *value;
 	GHashTableIter iter;
+	g_autoptr(GHashTable) kvs = NULL;
 
 	/* not set */
 	if (priv->quirks == NULL)
 		return;
-	if (!fu_quirks_get_kvs_for_guid (priv->quirks, guid, &iter))
+	kvs = fu_quirks_get_kvs_for_guid (priv->quirks, guid);
+	if (kvs == NULL)
 		return;
+	g_hash_table_iter_init (&iter, kvs);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &value)) {
 		g_autoptr(GError) error = NULL;
 		if (!fu_device_set_quirk_kv (self, key, value, &error)) {
@@ -792,14 +1049,12 @@ fu_device_add_guid_safe (FuDevice *self, const gchar *guid)
 gboolean
 fu_device_has_guid (FuDevice *self, const gchar *guid)
 {
-	/* make valid */
-	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
-		return fwupd_device_has_guid (FWUPD_DEVICE (self), tmp);
-	}
+	fwupd_guid_t guid_raw;
 
-	/* already valid */
-	return fwupd_device_has_guid (FWUPD_DEVICE (self), guid);
+	/* make valid */
+	if (!fu_device_guid_to_raw (guid, &guid_raw))
+		return FALSE;
+	return fwupd_device_has_guid_raw (FWUPD_DEVICE (self), &guid_raw);
 }
 
 /**
@@ -825,7 +1080,7 @@ fu_device_add_instance_id (FuDevice *self, const gchar *instance_id)
 	 * calling fu_device_add_guid_safe() -- but we want the quirks to match
 	 * so the plugin is set, but not the LVFS metadata to match firmware
 	 * until we're sure the device isn't using _NO_AUTO_INSTANCE_IDS */
-	guid = fwupd_guid_hash_string (instance_id);
+	guid = fu_device_hash_instance_id (instance_id);
 	fu_device_add_guid_quirks (self, guid);
 	fwupd_device_add_instance_id (FWUPD_DEVICE (self), instance_id);
 }
@@ -869,7 +1124,7 @@ fu_device_add_counterpart_guid (FuDevice *self, const gchar *guid)
 {
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		g_autofree gchar *tmp = fu_device_hash_instance_id (guid);
 		fwupd_device_add_guid (FWUPD_DEVICE (self), tmp);
 		return;
 	}
@@ -914,11 +1169,15 @@ const gchar *
 fu_device_get_metadata (FuDevice *self, const gchar *key)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	g_autoptr(FuMutexLocker) locker = fu_mutex_read_locker_new (priv->metadata_mutex);
+	const gchar *value;
 	g_return_val_if_fail (FU_IS_DEVICE (self), NULL);
 	g_return_val_if_fail (key != NULL, NULL);
-	g_return_val_if_fail (locker != NULL, NULL);
-	return g_hash_table_lookup (priv->metadata, key);
+
+	/* this is called a lot, so avoid allocating a locker */
+	fu_mutex_read_lock (priv->metadata_mutex);
+	value = g_hash_table_lookup (priv->metadata, key);
+	fu_mutex_read_unlock (priv->metadata_mutex);
+	return value;
 }
 
 /**
@@ -936,15 +1195,13 @@ gboolean
 fu_device_get_metadata_boolean (FuDevice *self, const gchar *key)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	const gchar *tmp;
-	g_autoptr(FuMutexLocker) locker = fu_mutex_read_locker_new (priv->metadata_mutex);
+	gboolean value;
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (key != NULL, FALSE);
-	g_return_val_if_fail (locker != NULL, FALSE);
-	tmp = g_hash_table_lookup (priv->metadata, key);
-	if (tmp == NULL)
-		return FALSE;
-	return g_strcmp0 (tmp, "true") == 0;
+	fu_mutex_read_lock (priv->metadata_mutex);
+	value = g_strcmp0 (g_hash_table_lookup (priv->metadata, key), "true") == 0;
+	fu_mutex_read_unlock (priv->metadata_mutex);
+	return value;
 }
 
 /**
@@ -964,19 +1221,19 @@ fu_device_get_metadata_integer (FuDevice *self, const gchar *key)
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	const gchar *tmp;
 	gchar *endptr = NULL;
-	guint64 val;
-	g_autoptr(FuMutexLocker) locker = fu_mutex_read_locker_new (priv->metadata_mutex);
+	guint64 val = G_MAXUINT;
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), G_MAXUINT);
 	g_return_val_if_fail (key != NULL, G_MAXUINT);
-	g_return_val_if_fail (locker != NULL, G_MAXUINT);
 
+	fu_mutex_read_lock (priv->metadata_mutex);
 	tmp = g_hash_table_lookup (priv->metadata, key);
-	if (tmp == NULL)
-		return G_MAXUINT;
-	val = g_ascii_strtoull (tmp, &endptr, 10);
-	if (endptr != NULL && endptr[0] != '\0')
-		return G_MAXUINT;
+	if (tmp != NULL) {
+		val = g_ascii_strtoull (tmp, &endptr, 10);
+		if (endptr != NULL && endptr[0] != '\0')
+			val = G_MAXUINT;
+	}
+	fu_mutex_read_unlock (priv->metadata_mutex);
 	if (val > G_MAXUINT)
 		return G_MAXUINT;
 	return (guint) val;
@@ -996,12 +1253,16 @@ void
 fu_device_set_metadata (FuDevice *self, const gchar *key, const gchar *value)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	g_autoptr(FuMutexLocker) locker = fu_mutex_write_locker_new (priv->metadata_mutex);
+	gchar *key_new;
+	gchar *value_new;
 	g_return_if_fail (FU_IS_DEVICE (self));
 	g_return_if_fail (key != NULL);
 	g_return_if_fail (value != NULL);
-	g_return_if_fail (locker != NULL);
-	g_hash_table_insert (priv->metadata, g_strdup (key), g_strdup (value));
+	key_new = g_strdup (key);
+	value_new = g_strdup (value);
+	fu_mutex_write_lock (priv->metadata_mutex);
+	g_hash_table_insert (priv->metadata, key_new, value_new);
+	fu_mutex_write_unlock (priv->metadata_mutex);
 }
 
 /**
@@ -1598,6 +1859,10 @@ fu_device_to_string (FuDevice *self)
 		g_autofree gchar *sz = g_strdup_printf ("%" G_GUINT64_FORMAT, priv->size_max);
 		fwupd_pad_kv_str (str, "FirmwareSizeMax", sz);
 	}
+	if (priv->wait_time > 0) {
+		g_autofree gchar *sz = g_strdup_printf ("%" G_GUINT64_FORMAT "ms", priv->wait_time);
+		fwupd_pad_kv_str (str, "WaitTime", sz);
+	}
 	keys = g_hash_table_get_keys (priv->metadata);
 	for (GList *l = keys; l != NULL; l = l->next) {
 		const gchar *key = l->data;
@@ -1687,6 +1952,7 @@ gboolean
 fu_device_write_firmware (FuDevice *self, GBytes *fw, GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	gboolean ret;
 	g_autoptr(GBytes) fw_new = NULL;
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
@@ -1707,7 +1973,10 @@ fu_device_write_firmware (FuDevice *self, GBytes *fw, GError **error)
 		return FALSE;
 
 	/* call vfunc */
-	return klass->write_firmware (self, fw_new, error);
+	FU_TRACE_BEGIN ("device", "write-firmware", fu_device_get_id (self));
+	ret = klass->write_firmware (self, fw_new, error);
+	FU_TRACE_END ("device", "write-firmware", fu_device_get_id (self));
+	return ret;
 }
 
 /**
@@ -1912,7 +2181,11 @@ fu_device_open (FuDevice *self, GError **error)
 
 	/* subclassed */
 	if (klass->open != NULL) {
-		if (!klass->open (self, error))
+		gboolean ret;
+		FU_TRACE_BEGIN ("device", "open", fu_device_get_id (self));
+		ret = klass->open (self, error);
+		FU_TRACE_END ("device", "open", fu_device_get_id (self));
+		if (!ret)
 			return FALSE;
 	}
 
@@ -2002,13 +2275,24 @@ fu_device_probe (FuDevice *self, GError **error)
 
 	/* subclassed */
 	if (klass->probe != NULL) {
+		gint64 start = g_get_monotonic_time ();
 		if (!klass->probe (self, error))
 			return FALSE;
+		priv->probe_duration = g_get_monotonic_time () - start;
 	}
 	priv->done_probe = TRUE;
 	return TRUE;
 }
 
+/* used by the engine to keep performance counters */
+gint64
+fu_device_get_probe_duration (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->probe_duration;
+}
+
 /**
  * fu_device_convert_instance_ids:
  * @self: A #FuDevice
@@ -2034,7 +2318,7 @@ fu_device_convert_instance_ids (FuDevice *self)
 		return;
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
-		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		g_autofree gchar *guid = fu_device_hash_instance_id (instance_id);
 		fwupd_device_add_guid (FWUPD_DEVICE (self), guid);
 	}
 
@@ -2073,8 +2357,14 @@ fu_device_setup (FuDevice *self, GError **error)
 
 	/* subclassed */
 	if (klass->setup != NULL) {
-		if (!klass->setup (self, error))
+		gboolean ret;
+		gint64 start = g_get_monotonic_time ();
+		FU_TRACE_BEGIN ("device", "setup", fu_device_get_id (self));
+		ret = klass->setup (self, error);
+		FU_TRACE_END ("device", "setup", fu_device_get_id (self));
+		if (!ret)
 			return FALSE;
+		priv->setup_duration = g_get_monotonic_time () - start;
 	}
 
 	/* convert the instance IDs to GUIDs */
@@ -2084,6 +2374,15 @@ fu_device_setup (FuDevice *self, GError **error)
 	return TRUE;
 }
 
+/* used by the engine to keep performance counters */
+gint64
+fu_device_get_setup_duration (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->setup_duration;
+}
+
 /**
  * fu_device_activate:
  * @self: A #FuDevice
@@ -2265,6 +2564,8 @@ fu_device_init (FuDevice *self)
 	priv->metadata = g_hash_table_new_full (g_str_hash, g_str_equal,
 						g_free, g_free);
 	priv->metadata_mutex = fu_mutex_new (G_OBJECT_TYPE_NAME(self), "metadata");
+	g_mutex_init (&priv->wait_mutex);
+	g_cond_init (&priv->wait_cond);
 }
 
 static void
@@ -2283,6 +2584,8 @@ fu_device_finalize (GObject *object)
 		g_source_remove (priv->poll_id);
 	g_object_unref (priv->metadata_mutex);
 	g_object_unref (priv->parent_guids_mutex);
+	g_mutex_clear (&priv->wait_mutex);
+	g_cond_clear (&priv->wait_cond);
 	g_hash_table_unref (priv->metadata);
 	g_ptr_array_unref (priv->children);
 	g_ptr_array_unref (priv->parent_guids);
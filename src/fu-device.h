@@ -74,6 +74,36 @@ struct _FuDeviceClass
  */
 #define FU_DEVICE_REMOVE_DELAY_USER_REPLUG		40000
 
+/**
+ * FU_DEVICE_WAIT_INTERVAL_MIN:
+ *
+ * The initial interval in ms between calls to the #FuDeviceWaitFunc, which
+ * doubles each time the device is not ready.
+ */
+#define FU_DEVICE_WAIT_INTERVAL_MIN			1
+
+/**
+ * FU_DEVICE_WAIT_INTERVAL_MAX:
+ *
+ * The maximum interval in ms between calls to the #FuDeviceWaitFunc.
+ */
+#define FU_DEVICE_WAIT_INTERVAL_MAX			500
+
+/**
+ * FuDeviceWaitFunc:
+ * @self: A #FuDevice
+ * @user_data: user data
+ * @error: A #GError, or %NULL
+ *
+ * Checks if the device is ready. Return %FALSE without setting @error to be
+ * called again later, or set @error to stop waiting.
+ *
+ * Returns: %TRUE if the device is ready
+ */
+typedef gboolean (*FuDeviceWaitFunc)			(FuDevice	*self,
+							 gpointer	 user_data,
+							 GError		**error);
+
 FuDevice	*fu_device_new				(void);
 
 /* helpful casting macros */
@@ -229,5 +259,14 @@ gboolean	 fu_device_poll				(FuDevice	*self,
 							 GError		**error);
 void		 fu_device_set_poll_interval		(FuDevice	*self,
 							 guint		 interval);
+gboolean	 fu_device_wait_for			(FuDevice	*self,
+							 FuDeviceWaitFunc func,
+							 gpointer	 user_data,
+							 guint		 delay_ms,
+							 guint		 timeout_ms,
+							 GError		**error);
+void		 fu_device_wait_wake			(FuDevice	*self);
+guint64		 fu_device_get_wait_time		(FuDevice	*self);
+void		 fu_device_reset_wait_time		(FuDevice	*self);
 
 G_END_DECLS
@@ -11,6 +11,7 @@
 #include <gio/gio.h>
 #include <gio/gunixinputstream.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <gudev/gudev.h>
 #include <fnmatch.h>
 #include <string.h>
@@ -37,13 +38,20 @@
 #include "fu-history.h"
 #include "fu-mutex.h"
 #include "fu-plugin.h"
+#include "fu-plugin-builtin.h"
 #include "fu-plugin-list.h"
 #include "fu-plugin-private.h"
 #include "fu-quirks.h"
 #include "fu-smbios.h"
+#include "fu-snapshot.h"
+#include "fu-stats.h"
+#include "fu-trace.h"
 #include "fu-udev-device-private.h"
 #include "fu-usb-device-private.h"
 
+/* how long to wait before unloading on-demand plugins with no devices */
+#define FU_ENGINE_PLUGIN_UNLOAD_DELAY		30	/* s */
+
 static void fu_engine_finalize	 (GObject *obj);
 
 struct _FuEngine
@@ -59,16 +67,19 @@ struct _FuEngine
 	guint			 percentage;
 	FuHistory		*history;
 	FuIdle			*idle;
+	FuStats			*stats;
 	XbSilo			*silo;
 	gboolean		 coldplug_running;
 	guint			 coldplug_id;
 	guint			 coldplug_delay;
+	guint			 unload_id;
 	FuPluginList		*plugin_list;
 	GPtrArray		*plugin_filter;
 	GPtrArray		*udev_subsystems;
 	FuSmbios		*smbios;
 	FuHwids			*hwids;
 	FuQuirks		*quirks;
+	FuSnapshot		*snapshot;	/* nullable */
 	GHashTable		*runtime_versions;
 	GHashTable		*compile_versions;
 	GHashTable		*approved_firmware;
@@ -185,19 +196,63 @@ fu_engine_device_added_cb (FuDeviceList *device_list, FuDevice *device, FuEngine
 static void
 fu_engine_device_runner_device_removed (FuEngine *self, FuDevice *device)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_DEVICE_REMOVED);
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
 		fu_plugin_runner_device_removed (plugin_tmp, device);
 	}
 }
 
+static gboolean
+fu_engine_plugins_unload_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	g_autoptr(GHashTable) plugins_inuse = g_hash_table_new (g_str_hash, g_str_equal);
+	g_autoptr(GPtrArray) devices = fu_device_list_get_all (self->device_list);
+
+	/* any plugin still providing a device has to stay loaded */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		const gchar *plugin_name = fu_device_get_plugin (device);
+		if (plugin_name != NULL)
+			g_hash_table_add (plugins_inuse, (gpointer) plugin_name);
+	}
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		if (!fu_plugin_get_lazy (plugin) ||
+		    !fu_plugin_is_loaded (plugin) ||
+		    !fu_plugin_get_enabled (plugin))
+			continue;
+		if (g_hash_table_contains (plugins_inuse, fu_plugin_get_name (plugin)))
+			continue;
+		g_debug ("unloading idle plugin %s", fu_plugin_get_name (plugin));
+		fu_plugin_unload (plugin);
+	}
+	self->unload_id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_engine_plugins_schedule_unload (FuEngine *self)
+{
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		return;
+	if (self->unload_id != 0)
+		g_source_remove (self->unload_id);
+	self->unload_id = g_timeout_add_seconds (FU_ENGINE_PLUGIN_UNLOAD_DELAY,
+						 fu_engine_plugins_unload_cb,
+						 self);
+}
+
 static void
 fu_engine_device_removed_cb (FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
 	fu_engine_device_runner_device_removed (self, device);
 	g_signal_handlers_disconnect_by_data (device, self);
 	g_signal_emit (self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
+	fu_engine_plugins_schedule_unload (self);
 }
 
 static void
@@ -348,6 +403,18 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 		fwupd_release_set_update_message (rel, tmp);
 }
 
+/* query the system silo, keeping track of the latency and hit rate */
+static XbNode *
+fu_engine_silo_query_first (FuEngine *self, const gchar *xpath)
+{
+	gint64 start = g_get_monotonic_time ();
+	g_autoptr(XbNode) n = NULL;
+	n = xb_silo_query_first (self->silo, xpath, NULL);
+	fu_stats_add_elapsed (self->stats, "silo.query", start);
+	fu_stats_add_value (self->stats, n != NULL ? "silo.query.hit" : "silo.query.miss", 1);
+	return g_steal_pointer (&n);
+}
+
 /* finds the remote-id for the first firmware in the silo that matches this
  * container checksum */
 static const gchar *
@@ -358,7 +425,7 @@ fu_engine_get_remote_id_for_checksum (FuEngine *self, const gchar *csum)
 	xpath = g_strdup_printf ("components/component/releases/release/"
 				 "checksum[@target='container'][text()='%s']/../../"
 				 "../../custom/value[@key='fwupd::RemoteId']", csum);
-	key = xb_silo_query_first (self->silo, xpath, NULL);
+	key = fu_engine_silo_query_first (self, xpath);
 	if (key == NULL)
 		return NULL;
 	return xb_node_get_text (key);
@@ -656,7 +723,9 @@ fu_engine_get_component_by_guids (FuEngine *self, FuDevice *device)
 					"provides/firmware[@type='flashed'][text()='%s']/"
 					"../..", guid);
 	}
-	component = xb_silo_query_first (self->silo, xpath->str, NULL);
+	FU_TRACE_BEGIN ("xmlb", "query", xpath->str);
+	component = fu_engine_silo_query_first (self, xpath->str);
+	FU_TRACE_END ("xmlb", "query", xpath->str);
 	if (component != NULL)
 		return g_steal_pointer (&component);
 	return NULL;
@@ -728,7 +797,9 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 		if (silo == NULL)
 			return FALSE;
 		xpath = g_strdup_printf ("component/releases/release[@version='%s']", version);
+		FU_TRACE_BEGIN ("xmlb", "query", xpath);
 		release = xb_silo_query_first (silo, xpath, NULL);
+		FU_TRACE_END ("xmlb", "query", xpath);
 	}
 
 	/* try again with the system metadata */
@@ -741,7 +812,9 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 						  "provides/firmware[@type='flashed'][text()='%s']/"
 						  "../../releases/release[@version='%s']",
 						  guid, version);
-			release = xb_silo_query_first (self->silo, xpath2, NULL);
+			FU_TRACE_BEGIN ("xmlb", "query", xpath2);
+			release = fu_engine_silo_query_first (self, xpath2);
+			FU_TRACE_END ("xmlb", "query", xpath2);
 			if (release != NULL)
 				break;
 		}
@@ -1187,7 +1260,8 @@ fu_engine_get_report_metadata (FuEngine *self)
 gboolean
 fu_engine_composite_prepare (FuEngine *self, GPtrArray *devices, GError **error)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_COMPOSITE_PREPARE);
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
 		if (!fu_plugin_runner_composite_prepare (plugin_tmp, devices, error))
@@ -1209,7 +1283,8 @@ fu_engine_composite_prepare (FuEngine *self, GPtrArray *devices, GError **error)
 gboolean
 fu_engine_composite_cleanup (FuEngine *self, GPtrArray *devices, GError **error)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_COMPOSITE_CLEANUP);
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
 		if (!fu_plugin_runner_composite_cleanup (plugin_tmp, devices, error))
@@ -1602,7 +1677,8 @@ fu_engine_update_prepare (FuEngine *self,
 			  const gchar *device_id,
 			  GError **error)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_UPDATE_PREPARE);
 	g_autoptr(FuDevice) device = NULL;
 
 	/* the device and plugin both may have changed */
@@ -1623,7 +1699,8 @@ fu_engine_update_cleanup (FuEngine *self,
 			  const gchar *device_id,
 			  GError **error)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_UPDATE_CLEANUP);
 	g_autoptr(FuDevice) device = NULL;
 
 	/* the device and plugin both may have changed */
@@ -1776,6 +1853,21 @@ fu_engine_update (FuEngine *self,
 	return TRUE;
 }
 
+/* only one device is updated at a time, so all waiting is for this update */
+static guint64
+fu_engine_get_wait_time (FuEngine *self, gboolean reset)
+{
+	guint64 wait_time = 0;
+	g_autoptr(GPtrArray) devices = fu_device_list_get_all (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		wait_time += fu_device_get_wait_time (device);
+		if (reset)
+			fu_device_reset_wait_time (device);
+	}
+	return wait_time;
+}
+
 gboolean
 fu_engine_install_blob (FuEngine *self,
 			FuDevice *device,
@@ -1783,6 +1875,7 @@ fu_engine_install_blob (FuEngine *self,
 			FwupdInstallFlags flags,
 			GError **error)
 {
+	gint64 start;
 	guint retries = 0;
 	g_autofree gchar *device_id = NULL;
 	g_autoptr(GTimer) timer = g_timer_new ();
@@ -1799,6 +1892,9 @@ fu_engine_install_blob (FuEngine *self,
 	/* mark this as modified even if we actually fail to do the update */
 	fu_device_set_modified (device, (guint64) g_get_real_time () / G_USEC_PER_SEC);
 
+	/* record how long is spent waiting for the hardware */
+	fu_engine_get_wait_time (self, TRUE);
+
 	/* plugins can set FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED to run again, but they
 	 * must return TRUE rather than an error */
 	device_id = g_strdup (fu_device_get_id (device));
@@ -1816,36 +1912,53 @@ fu_engine_install_blob (FuEngine *self,
 		fu_device_remove_flag (device, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED);
 
 		/* signal to all the plugins the update is about to happen */
+		start = g_get_monotonic_time ();
 		if (!fu_engine_update_prepare (self, flags, device_id, error))
 			return FALSE;
+		fu_stats_add_elapsed (self->stats, "install.prepare", start);
 
 		/* detach to bootloader mode */
+		start = g_get_monotonic_time ();
 		if (!fu_engine_update_detach (self, device_id, error))
 			return FALSE;
+		fu_stats_add_elapsed (self->stats, "install.detach", start);
 
 		/* install */
+		start = g_get_monotonic_time ();
 		if (!fu_engine_update (self, device_id, blob_fw, flags, error))
 			return FALSE;
+		fu_stats_add_elapsed (self->stats, "install.write", start);
+		fu_stats_add_value (self->stats, "install.write-bytes",
+				    g_bytes_get_size (blob_fw));
 
 		/* attach into runtime mode */
+		start = g_get_monotonic_time ();
 		if (!fu_engine_update_attach (self, device_id, error))
 			return FALSE;
+		fu_stats_add_elapsed (self->stats, "install.attach", start);
 
 	} while (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED));
 
 	/* get the new version number */
+	start = g_get_monotonic_time ();
 	if (!fu_engine_update_reload (self, device_id, error))
 		return FALSE;
+	fu_stats_add_elapsed (self->stats, "install.reload", start);
 
 	/* signal to all the plugins the update has happened */
+	start = g_get_monotonic_time ();
 	if (!fu_engine_update_cleanup (self, flags, device_id, error))
 		return FALSE;
+	fu_stats_add_elapsed (self->stats, "install.cleanup", start);
+	fu_stats_add_duration (self->stats, "install.total",
+			       g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC);
 
 	/* make the UI update */
 	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
 	fu_engine_emit_changed (self);
-	g_debug ("Updating %s took %f seconds", fu_device_get_name (device),
-		 g_timer_elapsed (timer, NULL));
+	g_debug ("Updating %s took %f seconds, %" G_GUINT64_FORMAT "ms of which "
+		 "was waiting for the hardware", fu_device_get_name (device),
+		 g_timer_elapsed (timer, NULL), fu_engine_get_wait_time (self, FALSE));
 	return TRUE;
 }
 
@@ -2035,6 +2148,9 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) components = NULL;
 	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	gint64 start = g_get_monotonic_time ();
+	gint64 start_compile;
+	FU_TRACE_SCOPE ("engine", "load-metadata", NULL);
 
 	/* clear existing silo */
 	g_clear_object (&self->silo);
@@ -2124,14 +2240,20 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 	cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
 	xmlbfn = g_build_filename (cachedirpkg, "metadata.xmlb", NULL);
 	xmlb = g_file_new_for_path (xmlbfn);
+	start_compile = g_get_monotonic_time ();
+	FU_TRACE_BEGIN ("xmlb", "ensure", NULL);
 	self->silo = xb_builder_ensure (builder, xmlb, compile_flags, NULL, error);
+	FU_TRACE_END ("xmlb", "ensure", NULL);
+	fu_stats_add_elapsed (self->stats, "metadata.compile", start_compile);
 	if (self->silo == NULL)
 		return FALSE;
 
 	/* print what we've got */
 	components = xb_silo_query (self->silo, "components/component", 0, NULL);
-	if (components != NULL)
+	if (components != NULL) {
 		g_debug ("%u components now in silo", components->len);
+		FU_TRACE_COUNTER ("xmlb", "components", components->len);
+	}
 
 	/* build the index */
 	if (!xb_silo_query_build_index (self->silo,
@@ -2162,6 +2284,7 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 		}
 	}
 
+	fu_stats_add_elapsed (self->stats, "metadata.load", start);
 	return TRUE;
 }
 
@@ -2183,6 +2306,39 @@ fu_engine_get_existing_keyring_result (FuEngine *self,
 				       FU_KEYRING_VERIFY_FLAG_NONE, error);
 }
 
+/* returns TRUE if the file already contains exactly @blob */
+static gboolean
+fu_engine_cache_file_matches (const gchar *filename, GBytes *blob)
+{
+	g_autofree gchar *checksum_new = NULL;
+	g_autofree gchar *checksum_old = NULL;
+	g_autoptr(GBytes) blob_old = NULL;
+
+	if (filename == NULL)
+		return FALSE;
+	blob_old = fu_common_get_contents_bytes (filename, NULL);
+	if (blob_old == NULL)
+		return FALSE;
+	if (g_bytes_get_size (blob_old) != g_bytes_get_size (blob))
+		return FALSE;
+	checksum_old = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_old);
+	checksum_new = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+	return g_strcmp0 (checksum_old, checksum_new) == 0;
+}
+
+/* the metadata age is the mtime of the cache file, so update it even
+ * though the contents have not changed */
+static void
+fu_engine_remote_touch (FwupdRemote *remote)
+{
+	const gchar *filename = fwupd_remote_get_filename_cache (remote);
+	if (g_utime (filename, NULL) != 0) {
+		g_warning ("failed to update mtime of %s", filename);
+		return;
+	}
+	fwupd_remote_set_mtime (remote, (guint64) (g_get_real_time () / G_USEC_PER_SEC));
+}
+
 /**
  * fu_engine_update_metadata:
  * @self: A #FuEngine
@@ -2203,6 +2359,7 @@ fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
 {
 	FwupdKeyringKind keyring_kind;
 	FwupdRemote *remote;
+	gboolean unchanged;
 	g_autoptr(GBytes) bytes_raw = NULL;
 	g_autoptr(GBytes) bytes_sig = NULL;
 	g_autoptr(GInputStream) stream_fd = NULL;
@@ -2247,8 +2404,20 @@ fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
 	if (bytes_sig == NULL)
 		return FALSE;
 
-	/* verify file */
+	/* nothing has changed since the last refresh */
 	keyring_kind = fwupd_remote_get_keyring_kind (remote);
+	unchanged = fu_engine_cache_file_matches (fwupd_remote_get_filename_cache (remote),
+						  bytes_raw);
+	if (unchanged &&
+	    (keyring_kind == FWUPD_KEYRING_KIND_NONE ||
+	     fu_engine_cache_file_matches (fwupd_remote_get_filename_cache_sig (remote),
+					   bytes_sig))) {
+		g_debug ("metadata for %s unchanged, skipping", remote_id);
+		fu_engine_remote_touch (remote);
+		return TRUE;
+	}
+
+	/* verify file */
 	if (keyring_kind != FWUPD_KEYRING_KIND_NONE) {
 		g_autoptr(FuKeyring) kr = NULL;
 		g_autoptr(FuKeyringResult) kr_result = NULL;
@@ -2306,14 +2475,23 @@ fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
 	}
 
 	/* save XML and signature to remotes.d */
-	if (!fu_common_set_contents_bytes (fwupd_remote_get_filename_cache (remote),
-					   bytes_raw, error))
-		return FALSE;
+	if (!unchanged) {
+		if (!fu_common_set_contents_bytes (fwupd_remote_get_filename_cache (remote),
+						   bytes_raw, error))
+			return FALSE;
+	}
 	if (keyring_kind != FWUPD_KEYRING_KIND_NONE) {
 		if (!fu_common_set_contents_bytes (fwupd_remote_get_filename_cache_sig (remote),
 						   bytes_sig, error))
 			return FALSE;
 	}
+
+	/* only the signature was refreshed, so the silo is still valid */
+	if (unchanged) {
+		g_debug ("metadata for %s re-signed, not rebuilding silo", remote_id);
+		fu_engine_remote_touch (remote);
+		return TRUE;
+	}
 	return fu_engine_load_metadata_store (self, FU_ENGINE_LOAD_FLAG_NONE, error);
 }
 
@@ -2485,7 +2663,9 @@ fu_engine_get_details (FuEngine *self, gint fd, GError **error)
 	silo = fu_engine_get_silo_from_blob (self, blob, error);
 	if (silo == NULL)
 		return NULL;
+	FU_TRACE_BEGIN ("xmlb", "query", "components/component");
 	components = xb_silo_query (silo, "components/component", 0, &error_local);
+	FU_TRACE_END ("xmlb", "query", "components/component");
 	if (components == NULL) {
 		g_set_error (error,
 			     FWUPD_ERROR,
@@ -3037,6 +3217,21 @@ fu_engine_get_downgrades (FuEngine *self, const gchar *device_id, GError **error
 	return g_steal_pointer (&releases);
 }
 
+/**
+ * fu_engine_get_stats:
+ * @self: A #FuEngine
+ *
+ * Gets the performance counters kept by the engine.
+ *
+ * Returns: (transfer none): a #FuStats
+ **/
+FuStats *
+fu_engine_get_stats (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	return self->stats;
+}
+
 GPtrArray *
 fu_engine_get_approved_firmware (FuEngine *self)
 {
@@ -3278,6 +3473,29 @@ fu_engine_get_results (FuEngine *self, const gchar *device_id, GError **error)
 	return g_object_ref (FWUPD_DEVICE (device));
 }
 
+static const gchar *fu_engine_snapshot_keys_hwids[] = {
+	FU_SNAPSHOT_KEY_FWUPD_VERSION,
+	FU_SNAPSHOT_KEY_KERNEL_VERSION,
+	FU_SNAPSHOT_KEY_DMI_CHECKSUM,
+	NULL
+};
+static const gchar *fu_engine_snapshot_keys_quirks[] = {
+	FU_SNAPSHOT_KEY_FWUPD_VERSION,
+	FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM,
+	NULL
+};
+
+static void
+fu_engine_add_plugin_stat (FuEngine *self, FuPlugin *plugin,
+			   const gchar *action, gint64 start)
+{
+	g_autofree gchar *id = NULL;
+	if (!fu_plugin_is_loaded (plugin))
+		return;
+	id = g_strdup_printf ("plugin.%s.%s", fu_plugin_get_name (plugin), action);
+	fu_stats_add_elapsed (self->stats, id, start);
+}
+
 static void
 fu_engine_plugins_setup (FuEngine *self)
 {
@@ -3285,10 +3503,12 @@ fu_engine_plugins_setup (FuEngine *self)
 	for (guint i = 0; i < plugins->len; i++) {
 		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		gint64 start = g_get_monotonic_time ();
 		if (!fu_plugin_runner_startup (plugin, &error)) {
 			fu_plugin_set_enabled (plugin, FALSE);
 			g_message ("disabling plugin because: %s", error->message);
 		}
+		fu_engine_add_plugin_stat (self, plugin, "startup", start);
 	}
 }
 
@@ -3297,6 +3517,7 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 {
 	GPtrArray *plugins;
 	g_autoptr(GString) str = g_string_new (NULL);
+	FU_TRACE_SCOPE ("engine", is_recoldplug ? "recoldplug" : "coldplug", NULL);
 
 	/* don't allow coldplug to be scheduled when in coldplug */
 	self->coldplug_running = TRUE;
@@ -3320,6 +3541,7 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 	for (guint i = 0; i < plugins->len; i++) {
 		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		gint64 start = g_get_monotonic_time ();
 		if (is_recoldplug) {
 			if (!fu_plugin_runner_recoldplug (plugin, &error))
 				g_message ("failed recoldplug: %s", error->message);
@@ -3330,6 +3552,9 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 					   error->message);
 			}
 		}
+		fu_engine_add_plugin_stat (self, plugin,
+					   is_recoldplug ? "recoldplug" : "coldplug",
+					   start);
 	}
 
 	/* cleanup */
@@ -3343,7 +3568,7 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 	/* print what we do have */
 	for (guint i = 0; i < plugins->len; i++) {
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
-		if (!fu_plugin_get_enabled (plugin))
+		if (!fu_plugin_get_enabled (plugin) || !fu_plugin_is_loaded (plugin))
 			continue;
 		g_string_append_printf (str, "%s, ", fu_plugin_get_name (plugin));
 	}
@@ -3365,7 +3590,8 @@ fu_engine_plugin_device_register (FuEngine *self, FuDevice *device)
 			   fu_device_get_id (device));
 		return;
 	}
-	plugins = fu_plugin_list_get_all (self->plugin_list);
+	plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+					      FU_PLUGIN_HOOK_DEVICE_REGISTERED);
 	for (guint i = 0; i < plugins->len; i++) {
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
 		fu_plugin_runner_device_register (plugin, device);
@@ -3399,6 +3625,20 @@ fu_engine_plugin_device_added_cb (FuPlugin *plugin,
 	}
 	fu_device_set_priority (device, priority);
 	fu_engine_add_device (self, device);
+
+	/* only record devices that actually did some work */
+	if (fu_device_get_probe_duration (device) > 0) {
+		g_autofree gchar *id = NULL;
+		id = g_strdup_printf ("device.%s.probe", fu_plugin_get_name (plugin));
+		fu_stats_add_duration (self->stats, id,
+				       fu_device_get_probe_duration (device));
+	}
+	if (fu_device_get_setup_duration (device) > 0) {
+		g_autofree gchar *id = NULL;
+		id = g_strdup_printf ("device.%s.setup", fu_plugin_get_name (plugin));
+		fu_stats_add_duration (self->stats, id,
+				       fu_device_get_setup_duration (device));
+	}
 }
 
 static void
@@ -3616,7 +3856,8 @@ fu_engine_recoldplug_delay_cb (gpointer user_data)
 static void
 fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_UDEV_DEVICE_ADDED);
 	const gchar *plugin_name;
 	g_autoptr(FuUdevDevice) device = fu_udev_device_new (udev_device);
 	g_autoptr(GError) error_local = NULL;
@@ -3641,6 +3882,11 @@ fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 				   plugin_name, error->message);
 			return;
 		}
+		if (!fu_engine_plugin_ensure_loaded (self, plugin, &error)) {
+			g_warning ("failed to load specified plugin %s: %s",
+				   plugin_name, error->message);
+			return;
+		}
 		if (!fu_plugin_runner_udev_device_added (plugin, device, &error)) {
 			g_warning ("failed to add udev device %s: %s",
 				   g_udev_device_get_sysfs_path (udev_device),
@@ -3663,6 +3909,18 @@ fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 			continue;
 		}
 
+		/* only open on-demand plugins for matching hardware */
+		if (!fu_plugin_is_loaded (plugin_tmp) && fu_plugin_get_lazy (plugin_tmp)) {
+			if (!fu_plugin_manifest_matches_device (plugin_tmp, FU_DEVICE (device)))
+				continue;
+			if (!fu_engine_plugin_ensure_loaded (self, plugin_tmp, &error)) {
+				g_debug ("%s ignoring: %s",
+					 fu_plugin_get_name (plugin_tmp),
+					 error->message);
+				continue;
+			}
+		}
+
 		/* run all plugins */
 		if (!fu_plugin_runner_udev_device_added (plugin_tmp, device, &error)) {
 			if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
@@ -3762,9 +4020,8 @@ fu_engine_plugin_set_coldplug_delay_cb (FuPlugin *plugin, guint duration, FuEngi
 		 duration, self->coldplug_delay);
 }
 
-/* this is called by the self tests as well */
-void
-fu_engine_add_plugin (FuEngine *self, FuPlugin *plugin)
+static void
+fu_engine_check_plugin_build_hash (FuEngine *self, FuPlugin *plugin)
 {
 	/* plugin does not match built version */
 	if (fu_plugin_get_build_hash (plugin) == NULL) {
@@ -3777,10 +4034,70 @@ fu_engine_add_plugin (FuEngine *self, FuPlugin *plugin)
 				name, fu_plugin_get_build_hash (plugin));
 		self->tainted = TRUE;
 	}
+}
 
+/* this is called by the self tests as well */
+void
+fu_engine_add_plugin (FuEngine *self, FuPlugin *plugin)
+{
+	/* checked when opened on demand */
+	if (!fu_plugin_get_lazy (plugin) || fu_plugin_is_loaded (plugin))
+		fu_engine_check_plugin_build_hash (self, plugin);
 	fu_plugin_list_add (self->plugin_list, plugin);
 }
 
+static gboolean
+fu_engine_plugin_ensure_loaded (FuEngine *self, FuPlugin *plugin, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	/* already done */
+	if (fu_plugin_is_loaded (plugin))
+		return TRUE;
+	if (!fu_plugin_get_enabled (plugin)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "%s is disabled",
+			     fu_plugin_get_name (plugin));
+		return FALSE;
+	}
+
+	/* open module and run the same vfuncs as at daemon startup */
+	g_debug ("loading plugin %s on demand", fu_plugin_get_name (plugin));
+	if (!fu_plugin_open (plugin, fu_plugin_get_filename (plugin), error)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		return FALSE;
+	}
+	fu_engine_check_plugin_build_hash (self, plugin);
+	if (!fu_plugin_get_enabled (plugin)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "%s self disabled",
+			     fu_plugin_get_name (plugin));
+		return FALSE;
+	}
+	if (!fu_plugin_runner_startup (plugin, error)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		return FALSE;
+	}
+	if (!fu_plugin_runner_coldplug_prepare (plugin, &error_local)) {
+		g_warning ("failed to prepare coldplug: %s", error_local->message);
+		g_clear_error (&error_local);
+	}
+	if (!fu_plugin_runner_coldplug (plugin, error)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		return FALSE;
+	}
+	if (!fu_plugin_runner_coldplug_cleanup (plugin, &error_local))
+		g_warning ("failed to cleanup coldplug: %s", error_local->message);
+
+	/* unload again if no device is claimed */
+	fu_engine_plugins_schedule_unload (self);
+	return TRUE;
+}
+
 static gboolean
 fu_engine_is_plugin_name_blacklisted (FuEngine *self, const gchar *name)
 {
@@ -3822,7 +4139,7 @@ fu_engine_plugin_check_supported_cb (FuPlugin *plugin, const gchar *guid, FuEngi
 	xpath = g_strdup_printf ("components/component/"
 				 "provides/firmware[@type='flashed'][text()='%s']",
 				 guid);
-	n = xb_silo_query_first (self->silo, xpath, NULL);
+	n = fu_engine_silo_query_first (self, xpath);
 	return n != NULL;
 }
 
@@ -3832,100 +4149,151 @@ fu_engine_get_tainted (FuEngine *self)
 	return self->tainted;
 }
 
+static void
+fu_engine_load_plugin (FuEngine *self,
+		       const gchar *plugin_path,
+		       const gchar *name,
+		       const gchar *filename,
+		       const gpointer *vfuncs)
+{
+	g_autofree gchar *manifest = NULL;
+	g_autoptr(FuPlugin) plugin = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* is blacklisted */
+	if (fu_engine_is_plugin_name_blacklisted (self, name)) {
+		g_debug ("plugin %s is blacklisted", name);
+		return;
+	}
+	if (!fu_engine_is_plugin_name_whitelisted (self, name)) {
+		g_debug ("plugin %s is not whitelisted", name);
+		return;
+	}
+
+	/* open module */
+	plugin = fu_plugin_new ();
+	fu_plugin_set_name (plugin, name);
+	fu_plugin_set_usb_context (plugin, self->usb_ctx);
+	fu_plugin_set_hwids (plugin, self->hwids);
+	fu_plugin_set_smbios (plugin, self->smbios);
+	fu_plugin_set_udev_subsystems (plugin, self->udev_subsystems);
+	fu_plugin_set_quirks (plugin, self->quirks);
+	fu_plugin_set_runtime_versions (plugin, self->runtime_versions);
+	fu_plugin_set_compile_versions (plugin, self->compile_versions);
+	fu_plugin_set_filename (plugin, filename);
+	if (vfuncs != NULL) {
+		fu_plugin_set_builtin (plugin, vfuncs);
+		g_debug ("adding builtin plugin %s", name);
+	} else {
+		g_debug ("adding plugin %s", filename);
+	}
+
+	/* only open when required hardware appears */
+	manifest = g_strdup_printf ("%s/%s.manifest", plugin_path, name);
+	if (g_file_test (manifest, G_FILE_TEST_EXISTS)) {
+		if (!fu_plugin_load_manifest (plugin, manifest, &error_local)) {
+			g_warning ("failed to load manifest %s: %s",
+				   manifest, error_local->message);
+			g_clear_error (&error_local);
+		}
+	}
+
+	/* if loaded from fu_engine_load() open the plugin */
+	if (self->usb_ctx != NULL &&
+	    (!fu_plugin_get_lazy (plugin) ||
+	     fu_plugin_manifest_matches_hwids (plugin))) {
+		if (!fu_plugin_open (plugin, filename, &error_local)) {
+			g_warning ("failed to open plugin %s: %s",
+				   name, error_local->message);
+			return;
+		}
+	}
+
+	/* self disabled */
+	if (!fu_plugin_get_enabled (plugin)) {
+		g_debug ("%s self disabled",
+			 fu_plugin_get_name (plugin));
+		return;
+	}
+
+	/* watch for changes */
+	g_signal_connect (plugin, "device-added",
+			  G_CALLBACK (fu_engine_plugin_device_added_cb),
+			  self);
+	g_signal_connect (plugin, "device-removed",
+			  G_CALLBACK (fu_engine_plugin_device_removed_cb),
+			  self);
+	g_signal_connect (plugin, "device-register",
+			  G_CALLBACK (fu_engine_plugin_device_register_cb),
+			  self);
+	g_signal_connect (plugin, "recoldplug",
+			  G_CALLBACK (fu_engine_plugin_recoldplug_cb),
+			  self);
+	g_signal_connect (plugin, "set-coldplug-delay",
+			  G_CALLBACK (fu_engine_plugin_set_coldplug_delay_cb),
+			  self);
+	g_signal_connect (plugin, "check-supported",
+			  G_CALLBACK (fu_engine_plugin_check_supported_cb),
+			  self);
+	g_signal_connect (plugin, "rules-changed",
+			  G_CALLBACK (fu_engine_plugin_rules_changed_cb),
+			  self);
+
+	/* add */
+	fu_engine_add_plugin (self, plugin);
+}
+
 gboolean
 fu_engine_load_plugins (FuEngine *self, GError **error)
 {
 	const gchar *fn;
+	g_autofree const gchar **builtins = fu_plugin_builtin_get_names ();
 	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GError) error_local = NULL;
 	g_autofree gchar *plugin_path = NULL;
+	FU_TRACE_SCOPE ("engine", "load-plugins", NULL);
 
-	/* search */
+	/* linked into this binary */
 	plugin_path = fu_common_get_path (FU_PATH_KIND_PLUGINDIR_PKG);
-	dir = g_dir_open (plugin_path, 0, error);
-	if (dir == NULL)
-		return FALSE;
-	while ((fn = g_dir_read_name (dir)) != NULL) {
+	for (guint i = 0; builtins[i] != NULL; i++) {
+		fu_engine_load_plugin (self, plugin_path, builtins[i], NULL,
+				       fu_plugin_builtin_get_vfuncs (builtins[i]));
+	}
+
+	/* search, although every plugin may have been linked in */
+	dir = g_dir_open (plugin_path, 0, &error_local);
+	if (dir == NULL) {
+		if (builtins[0] == NULL) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+		g_debug ("no modules: %s", error_local->message);
+	}
+	while (dir != NULL && (fn = g_dir_read_name (dir)) != NULL) {
 		g_autofree gchar *filename = NULL;
 		g_autofree gchar *name = NULL;
-		g_autoptr(FuPlugin) plugin = NULL;
-		g_autoptr(GError) error_local = NULL;
 
 		/* ignore non-plugins */
 		if (!g_str_has_suffix (fn, ".so"))
 			continue;
-
-		/* is blacklisted */
 		name = fu_plugin_guess_name_from_fn (fn);
 		if (name == NULL)
 			continue;
-		if (fu_engine_is_plugin_name_blacklisted (self, name)) {
-			g_debug ("plugin %s is blacklisted", name);
-			continue;
-		}
-		if (!fu_engine_is_plugin_name_whitelisted (self, name)) {
-			g_debug ("plugin %s is not whitelisted", name);
-			continue;
-		}
 
-		/* open module */
-		filename = g_build_filename (plugin_path, fn, NULL);
-		plugin = fu_plugin_new ();
-		fu_plugin_set_name (plugin, name);
-		fu_plugin_set_usb_context (plugin, self->usb_ctx);
-		fu_plugin_set_hwids (plugin, self->hwids);
-		fu_plugin_set_smbios (plugin, self->smbios);
-		fu_plugin_set_udev_subsystems (plugin, self->udev_subsystems);
-		fu_plugin_set_quirks (plugin, self->quirks);
-		fu_plugin_set_runtime_versions (plugin, self->runtime_versions);
-		fu_plugin_set_compile_versions (plugin, self->compile_versions);
-		g_debug ("adding plugin %s", filename);
-
-		/* if loaded from fu_engine_load() open the plugin */
-		if (self->usb_ctx != NULL) {
-			if (!fu_plugin_open (plugin, filename, &error_local)) {
-				g_warning ("failed to open plugin %s: %s",
-					   filename, error_local->message);
-				continue;
-			}
-		}
-
-		/* self disabled */
-		if (!fu_plugin_get_enabled (plugin)) {
-			g_debug ("%s self disabled",
-				 fu_plugin_get_name (plugin));
+		/* already linked in */
+		if (g_strv_contains ((const gchar * const *) builtins, name)) {
+			g_debug ("ignoring %s as builtin", fn);
 			continue;
 		}
-
-		/* watch for changes */
-		g_signal_connect (plugin, "device-added",
-				  G_CALLBACK (fu_engine_plugin_device_added_cb),
-				  self);
-		g_signal_connect (plugin, "device-removed",
-				  G_CALLBACK (fu_engine_plugin_device_removed_cb),
-				  self);
-		g_signal_connect (plugin, "device-register",
-				  G_CALLBACK (fu_engine_plugin_device_register_cb),
-				  self);
-		g_signal_connect (plugin, "recoldplug",
-				  G_CALLBACK (fu_engine_plugin_recoldplug_cb),
-				  self);
-		g_signal_connect (plugin, "set-coldplug-delay",
-				  G_CALLBACK (fu_engine_plugin_set_coldplug_delay_cb),
-				  self);
-		g_signal_connect (plugin, "check-supported",
-				  G_CALLBACK (fu_engine_plugin_check_supported_cb),
-				  self);
-		g_signal_connect (plugin, "rules-changed",
-				  G_CALLBACK (fu_engine_plugin_rules_changed_cb),
-				  self);
-
-		/* add */
-		fu_engine_add_plugin (self, plugin);
+		filename = g_build_filename (plugin_path, fn, NULL);
+		fu_engine_load_plugin (self, plugin_path, name, filename, NULL);
 	}
 
 	/* depsolve into the correct order */
 	if (!fu_plugin_list_depsolve (self->plugin_list, error))
 		return FALSE;
+	FU_TRACE_COUNTER ("engine", "plugins",
+			  fu_plugin_list_get_all (self->plugin_list)->len);
 
 	/* success */
 	return TRUE;
@@ -3980,7 +4348,8 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 			       GUsbDevice *usb_device,
 			       FuEngine *self)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GPtrArray *plugins = fu_plugin_list_get_by_hook (self->plugin_list,
+							 FU_PLUGIN_HOOK_USB_DEVICE_ADDED);
 	const gchar *plugin_name;
 	g_autoptr(FuUsbDevice) device = fu_usb_device_new (usb_device);
 	g_autoptr(GError) error_local = NULL;
@@ -4005,6 +4374,11 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 				   plugin_name, error->message);
 			return;
 		}
+		if (!fu_engine_plugin_ensure_loaded (self, plugin, &error)) {
+			g_warning ("failed to load specified plugin %s: %s",
+				   plugin_name, error->message);
+			return;
+		}
 		if (!fu_plugin_runner_usb_device_added (plugin, device, &error)) {
 			g_warning ("failed to add USB device %04x:%04x: %s",
 				   g_usb_device_get_vid (usb_device),
@@ -4029,6 +4403,18 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 			continue;
 		}
 
+		/* only open on-demand plugins for matching hardware */
+		if (!fu_plugin_is_loaded (plugin_tmp) && fu_plugin_get_lazy (plugin_tmp)) {
+			if (!fu_plugin_manifest_matches_device (plugin_tmp, FU_DEVICE (device)))
+				continue;
+			if (!fu_engine_plugin_ensure_loaded (self, plugin_tmp, &error)) {
+				g_debug ("%s ignoring: %s",
+					 fu_plugin_get_name (plugin_tmp),
+					 error->message);
+				continue;
+			}
+		}
+
 		/* create a device, then probe */
 		if (!fu_plugin_runner_usb_device_added (plugin_tmp, device, &error)) {
 			if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
@@ -4051,6 +4437,14 @@ static void
 fu_engine_load_quirks (FuEngine *self)
 {
 	g_autoptr(GError) error = NULL;
+	if (self->snapshot != NULL &&
+	    fu_snapshot_has_valid_keys (self->snapshot, fu_engine_snapshot_keys_quirks)) {
+		GKeyFile *kf = fu_snapshot_get_previous (self->snapshot);
+		if (fu_quirks_load_from_keyfile (self->quirks, kf, &error))
+			return;
+		g_debug ("failed to restore quirks: %s", error->message);
+		g_clear_error (&error);
+	}
 	if (!fu_quirks_load (self->quirks, &error))
 		g_warning ("Failed to load quirks: %s", error->message);
 }
@@ -4067,10 +4461,76 @@ static void
 fu_engine_load_hwids (FuEngine *self)
 {
 	g_autoptr(GError) error = NULL;
+	if (self->snapshot != NULL &&
+	    fu_snapshot_has_valid_keys (self->snapshot, fu_engine_snapshot_keys_hwids)) {
+		GKeyFile *kf = fu_snapshot_get_previous (self->snapshot);
+		if (fu_hwids_setup_from_keyfile (self->hwids, kf, &error))
+			return;
+		g_debug ("failed to restore HWIDs: %s", error->message);
+		g_clear_error (&error);
+	}
 	if (!fu_hwids_setup (self->hwids, self->smbios, &error))
 		g_warning ("Failed to load HWIDs: %s", error->message);
 }
 
+static gchar *
+fu_engine_get_snapshot_filename (void)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedirpkg, "startup.snapshot", NULL);
+}
+
+static void
+fu_engine_load_snapshot (FuEngine *self)
+{
+	struct utsname name_tmp;
+	g_autofree gchar *filename = fu_engine_get_snapshot_filename ();
+	g_autofree gchar *quirks_csum = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* opt-in */
+	if (!fu_config_get_startup_snapshot (self->config))
+		return;
+
+	self->snapshot = fu_snapshot_new ();
+	if (!fu_snapshot_load (self->snapshot, filename, &error)) {
+		g_debug ("not using startup snapshot: %s", error->message);
+		g_clear_error (&error);
+	}
+
+	/* everything the saved state depends on */
+	fu_snapshot_set_key (self->snapshot, FU_SNAPSHOT_KEY_FWUPD_VERSION, PACKAGE_VERSION);
+	memset (&name_tmp, 0, sizeof (struct utsname));
+	if (uname (&name_tmp) >= 0) {
+		fu_snapshot_set_key (self->snapshot, FU_SNAPSHOT_KEY_KERNEL_VERSION,
+				     name_tmp.release);
+	}
+	fu_snapshot_set_key (self->snapshot, FU_SNAPSHOT_KEY_DMI_CHECKSUM,
+			     fu_smbios_get_checksum (self->smbios));
+	quirks_csum = fu_quirks_get_checksum (self->quirks, &error);
+	if (quirks_csum == NULL)
+		g_debug ("failed to get quirks checksum: %s", error->message);
+	fu_snapshot_set_key (self->snapshot, FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM, quirks_csum);
+}
+
+static void
+fu_engine_save_snapshot (FuEngine *self)
+{
+	GKeyFile *kf;
+	g_autofree gchar *filename = fu_engine_get_snapshot_filename ();
+	g_autoptr(GError) error = NULL;
+
+	if (self->snapshot == NULL)
+		return;
+	kf = fu_snapshot_get_current (self->snapshot);
+
+	/* save the state */
+	fu_hwids_to_keyfile (self->hwids, kf);
+	fu_quirks_to_keyfile (self->quirks, kf);
+	if (!fu_snapshot_save (self->snapshot, filename, &error))
+		g_warning ("failed to save startup snapshot: %s", error->message);
+}
+
 static gboolean
 fu_engine_update_history_device (FuEngine *self, FuDevice *dev_history, GError **error)
 {
@@ -4234,6 +4694,7 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 {
 	FuConfigLoadFlags config_flags = FU_CONFIG_LOAD_FLAG_NONE;
 	g_autoptr(GPtrArray) checksums = NULL;
+	FU_TRACE_SCOPE ("engine", "load", NULL);
 
 	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -4274,9 +4735,12 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (self->config));
 
 	/* load quirks, SMBIOS and the hwids */
+	FU_TRACE_BEGIN ("engine", "load-hardware", NULL);
 	fu_engine_load_smbios (self);
+	fu_engine_load_snapshot (self);
 	fu_engine_load_hwids (self);
 	fu_engine_load_quirks (self);
+	FU_TRACE_END ("engine", "load-hardware", NULL);
 
 	/* load AppStream metadata */
 	if (!fu_engine_load_metadata_store (self, flags, error)) {
@@ -4329,7 +4793,9 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	fu_engine_set_status (self, FWUPD_STATUS_LOADING);
 
 	/* add devices */
+	FU_TRACE_BEGIN ("engine", "startup", NULL);
 	fu_engine_plugins_setup (self);
+	FU_TRACE_END ("engine", "startup", NULL);
 	fu_engine_plugins_coldplug (self, FALSE);
 
 	/* coldplug USB devices */
@@ -4339,15 +4805,24 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	g_signal_connect (self->usb_ctx, "device-removed",
 			  G_CALLBACK (fu_engine_usb_device_removed_cb),
 			  self);
+	FU_TRACE_BEGIN ("engine", "usb-enumerate", NULL);
 	g_usb_context_enumerate (self->usb_ctx);
+	FU_TRACE_END ("engine", "usb-enumerate", NULL);
 
 	/* coldplug udev devices */
+	FU_TRACE_BEGIN ("engine", "udev-enumerate", NULL);
 	fu_engine_enumerate_udev (self);
+	FU_TRACE_END ("engine", "udev-enumerate", NULL);
 
 	/* update the db for devices that were updated during the reboot */
 	if (!fu_engine_update_history_database (self, error))
 		return FALSE;
 
+	/* record what we found for the next startup */
+	if ((flags & FU_ENGINE_LOAD_FLAG_READONLY_FS) == 0)
+		fu_engine_save_snapshot (self);
+	g_clear_object (&self->snapshot);
+
 	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
 	self->loaded = TRUE;
 
@@ -4423,6 +4898,7 @@ fu_engine_init (FuEngine *self)
 	self->idle = fu_idle_new ();
 	self->quirks = fu_quirks_new ();
 	self->history = fu_history_new ();
+	self->stats = fu_stats_new ();
 	self->plugin_list = fu_plugin_list_new ();
 	self->plugin_filter = g_ptr_array_new_with_free_func (g_free);
 	self->udev_subsystems = g_ptr_array_new_with_free_func (g_free);
@@ -4469,13 +4945,18 @@ fu_engine_finalize (GObject *obj)
 		g_object_unref (self->gudev_client);
 	if (self->coldplug_id != 0)
 		g_source_remove (self->coldplug_id);
+	if (self->unload_id != 0)
+		g_source_remove (self->unload_id);
 
 	g_object_unref (self->idle);
 	g_object_unref (self->config);
 	g_object_unref (self->smbios);
 	g_object_unref (self->quirks);
+	if (self->snapshot != NULL)
+		g_object_unref (self->snapshot);
 	g_object_unref (self->hwids);
 	g_object_unref (self->history);
+	g_object_unref (self->stats);
 	g_object_unref (self->device_list);
 	g_ptr_array_unref (self->plugin_filter);
 	g_ptr_array_unref (self->udev_subsystems);
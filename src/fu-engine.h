@@ -16,6 +16,7 @@
 #include "fu-keyring.h"
 #include "fu-install-task.h"
 #include "fu-plugin.h"
+#include "fu-stats.h"
 
 G_BEGIN_DECLS
 
@@ -122,6 +123,7 @@ GPtrArray	*fu_engine_get_details			(FuEngine	*self,
 gboolean	 fu_engine_activate			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
+FuStats		*fu_engine_get_stats			(FuEngine	*self);
 GPtrArray	*fu_engine_get_approved_firmware	(FuEngine	*self);
 void		 fu_engine_add_approved_firmware	(FuEngine	*self,
 							 const gchar	*checksum);
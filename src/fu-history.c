@@ -18,6 +18,7 @@
 #include "fu-device-private.h"
 #include "fu-history.h"
 #include "fu-mutex.h"
+#include "fu-trace.h"
 
 #define FU_HISTORY_CURRENT_SCHEMA_VERSION	5
 
@@ -439,6 +440,7 @@ fu_history_modify_device (FuHistory *self, FuDevice *device,
 	gint rc;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 	g_return_val_if_fail (FU_IS_DEVICE (device), FALSE);
@@ -518,6 +520,7 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 	g_autofree gchar *metadata = NULL;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 	g_return_val_if_fail (FU_IS_DEVICE (device), FALSE);
@@ -599,6 +602,7 @@ fu_history_remove_all_with_state (FuHistory *self,
 	gint rc;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 
@@ -630,6 +634,7 @@ fu_history_remove_all (FuHistory *self, GError **error)
 	gint rc;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 
@@ -658,6 +663,7 @@ fu_history_remove_device (FuHistory *self,  FuDevice *device,
 	gint rc;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 	g_return_val_if_fail (FU_IS_DEVICE (device), FALSE);
@@ -696,6 +702,7 @@ fu_history_get_device_by_id (FuHistory *self, const gchar *device_id, GError **e
 	g_autoptr(GPtrArray) array_tmp = NULL;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
 	g_return_val_if_fail (device_id != NULL, NULL);
@@ -754,6 +761,7 @@ fu_history_get_devices (FuHistory *self, GError **error)
 	gint rc;
 	g_autoptr(GPtrArray) array_tmp = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
 
@@ -805,6 +813,7 @@ fu_history_get_approved_firmware (FuHistory *self, GError **error)
 	g_autoptr(FuMutexLocker) locker = NULL;
 	g_autoptr(GPtrArray) array = NULL;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
 
@@ -846,6 +855,7 @@ fu_history_clear_approved_firmware (FuHistory *self, GError **error)
 	gint rc;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 
@@ -876,6 +886,7 @@ fu_history_add_approved_firmware (FuHistory *self,
 	gint rc;
 	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(FuMutexLocker) locker = NULL;
+	FU_TRACE_SCOPE ("history", G_STRFUNC, NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 	g_return_val_if_fail (checksum != NULL, FALSE);
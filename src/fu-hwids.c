@@ -307,6 +307,29 @@ fu_hwids_convert_integer_cb (FuSmbios *smbios,
 	return g_strdup_printf ("%x", data_raw[offset]);
 }
 
+static void
+fu_hwids_add_dmi_value (FuHwids *self, const gchar *key, const gchar *value)
+{
+	g_autofree gchar *value_safe = NULL;
+
+	g_hash_table_insert (self->hash_dmi_hw, g_strdup (key), g_strdup (value));
+
+	/* make suitable for display */
+	value_safe = g_str_to_ascii (value, "C");
+	g_strdelimit (value_safe, "\n\r", '\0');
+	g_strchomp (value_safe);
+	g_hash_table_insert (self->hash_dmi_display,
+			     g_strdup (key),
+			     g_steal_pointer (&value_safe));
+}
+
+static void
+fu_hwids_add_guid (FuHwids *self, const gchar *guid)
+{
+	g_hash_table_insert (self->hash_guid, g_strdup (guid), GUINT_TO_POINTER (1));
+	g_ptr_array_add (self->array_guids, g_strdup (guid));
+}
+
 /**
  * fu_hwids_setup:
  * @self: A #FuHwids
@@ -358,7 +381,6 @@ fu_hwids_setup (FuHwids *self, FuSmbios *smbios, GError **error)
 	for (guint i = 0; map[i].key != NULL; i++) {
 		const gchar *contents_hdr;
 		g_autofree gchar *contents = NULL;
-		g_autofree gchar *contents_safe = NULL;
 		g_autoptr(GError) error_local = NULL;
 
 		/* get the data from a SMBIOS table */
@@ -374,17 +396,7 @@ fu_hwids_setup (FuHwids *self, FuSmbios *smbios, GError **error)
 		while (contents_hdr[0] == '0' &&
 		       map[i].func != fu_hwids_convert_padded_integer_cb)
 			contents_hdr++;
-		g_hash_table_insert (self->hash_dmi_hw,
-				     g_strdup (map[i].key),
-				     g_strdup (contents_hdr));
-
-		/* make suitable for display */
-		contents_safe = g_str_to_ascii (contents_hdr, "C");
-		g_strdelimit (contents_safe, "\n\r", '\0');
-		g_strchomp (contents_safe);
-		g_hash_table_insert (self->hash_dmi_display,
-				     g_strdup (map[i].key),
-				     g_steal_pointer (&contents_safe));
+		fu_hwids_add_dmi_value (self, map[i].key, contents_hdr);
 	}
 
 	/* add GUIDs */
@@ -400,15 +412,88 @@ fu_hwids_setup (FuHwids *self, FuSmbios *smbios, GError **error)
 			g_debug ("%s is not available, %s", key, error_local->message);
 			continue;
 		}
-		g_hash_table_insert (self->hash_guid,
-				     g_strdup (guid),
-				     GUINT_TO_POINTER (1));
-		g_ptr_array_add (self->array_guids, g_steal_pointer (&guid));
+		fu_hwids_add_guid (self, guid);
 	}
 
 	return TRUE;
 }
 
+/**
+ * fu_hwids_setup_from_keyfile:
+ * @self: A #FuHwids
+ * @keyfile: A #GKeyFile
+ * @error: A #GError or %NULL
+ *
+ * Restores the SMBIOS values and GUIDs saved with fu_hwids_to_keyfile(),
+ * which avoids recomputing every HardwareID when the tables are unchanged.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_hwids_setup_from_keyfile (FuHwids *self, GKeyFile *keyfile, GError **error)
+{
+	g_auto(GStrv) guids = NULL;
+	g_auto(GStrv) keys = NULL;
+
+	g_return_val_if_fail (FU_IS_HWIDS (self), FALSE);
+	g_return_val_if_fail (keyfile != NULL, FALSE);
+
+	/* check everything is valid before modifying any state */
+	keys = g_key_file_get_keys (keyfile, "HwidsValues", NULL, error);
+	if (keys == NULL)
+		return FALSE;
+	guids = g_key_file_get_string_list (keyfile, "Hwids", "Guids", NULL, error);
+	if (guids == NULL)
+		return FALSE;
+	for (guint i = 0; guids[i] != NULL; i++) {
+		if (!fwupd_guid_is_valid (guids[i])) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid GUID %s", guids[i]);
+			return FALSE;
+		}
+	}
+	for (guint i = 0; keys[i] != NULL; i++) {
+		g_autofree gchar *value = NULL;
+		value = g_key_file_get_string (keyfile, "HwidsValues", keys[i], error);
+		if (value == NULL)
+			return FALSE;
+		fu_hwids_add_dmi_value (self, keys[i], value);
+	}
+	for (guint i = 0; guids[i] != NULL; i++)
+		fu_hwids_add_guid (self, guids[i]);
+	return TRUE;
+}
+
+/**
+ * fu_hwids_to_keyfile:
+ * @self: A #FuHwids
+ * @keyfile: A #GKeyFile
+ *
+ * Saves the SMBIOS values and GUIDs so they can be restored using
+ * fu_hwids_setup_from_keyfile().
+ **/
+void
+fu_hwids_to_keyfile (FuHwids *self, GKeyFile *keyfile)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_return_if_fail (FU_IS_HWIDS (self));
+	g_return_if_fail (keyfile != NULL);
+
+	g_hash_table_iter_init (&iter, self->hash_dmi_hw);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_key_file_set_string (keyfile, "HwidsValues",
+				       (const gchar *) key,
+				       (const gchar *) value);
+	}
+	g_key_file_set_string_list (keyfile, "Hwids", "Guids",
+				    (const gchar * const *) self->array_guids->pdata,
+				    self->array_guids->len);
+}
+
 static void
 fu_hwids_finalize (GObject *object)
 {
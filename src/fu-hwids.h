@@ -46,5 +46,10 @@ gboolean	 fu_hwids_has_guid		(FuHwids	*self,
 gboolean	 fu_hwids_setup			(FuHwids	*self,
 						 FuSmbios	*smbios,
 						 GError		**error);
+gboolean	 fu_hwids_setup_from_keyfile	(FuHwids	*self,
+						 GKeyFile	*keyfile,
+						 GError		**error);
+void		 fu_hwids_to_keyfile		(FuHwids	*self,
+						 GKeyFile	*keyfile);
 
 G_END_DECLS
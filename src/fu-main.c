@@ -27,6 +27,7 @@
 #include "fu-device-private.h"
 #include "fu-engine.h"
 #include "fu-install-task.h"
+#include "fu-trace.h"
 
 #ifndef HAVE_POLKIT_0_114
 #pragma clang diagnostic push
@@ -766,6 +767,7 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 	fu_engine_idle_reset (priv->engine);
 
 	if (g_strcmp0 (method_name, "GetDevices") == 0) {
+		gint64 start = g_get_monotonic_time ();
 		g_autoptr(GPtrArray) devices = NULL;
 		g_debug ("Called %s()", method_name);
 		devices = fu_engine_get_devices (priv->engine, &error);
@@ -778,6 +780,8 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
+		fu_stats_add_elapsed (fu_engine_get_stats (priv->engine),
+				      "dbus.GetDevices", start);
 		g_dbus_method_invocation_return_value (invocation, val);
 		return;
 	}
@@ -812,6 +816,13 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 						       g_variant_new_tuple (&val, 1));
 		return;
 	}
+	if (g_strcmp0 (method_name, "GetStats") == 0) {
+		g_debug ("Called %s()", method_name);
+		val = fu_stats_to_variant (fu_engine_get_stats (priv->engine));
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new_tuple (&val, 1));
+		return;
+	}
 	if (g_strcmp0 (method_name, "SetApprovedFirmware") == 0) {
 		g_autofree gchar *checksums_str = NULL;
 		g_auto(GStrv) checksums = NULL;
@@ -899,6 +910,7 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 	}
 	if (g_strcmp0 (method_name, "GetUpgrades") == 0) {
 		const gchar *device_id;
+		gint64 start = g_get_monotonic_time ();
 		g_autoptr(GPtrArray) releases = NULL;
 		g_variant_get (parameters, "(&s)", &device_id);
 		g_debug ("Called %s(%s)", method_name, device_id);
@@ -912,6 +924,8 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			return;
 		}
 		val = fu_main_release_array_to_variant (releases);
+		fu_stats_add_elapsed (fu_engine_get_stats (priv->engine),
+				      "dbus.GetUpgrades", start);
 		g_dbus_method_invocation_return_value (invocation, val);
 		return;
 	}
@@ -1433,6 +1447,15 @@ fu_main_private_free (FuMainPrivate *priv)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuMainPrivate, fu_main_private_free)
 #pragma clang diagnostic pop
 
+/* set using FWUPD_TRACE */
+static void
+fu_main_save_trace (void)
+{
+	g_autoptr(GError) error = NULL;
+	if (!fu_trace_save (&error))
+		g_warning ("failed to save trace: %s", error->message);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1497,6 +1520,7 @@ main (int argc, char *argv[])
 		g_printerr ("Failed to load engine: %s\n", error->message);
 		return EXIT_FAILURE;
 	}
+	fu_main_save_trace ();
 
 	g_unix_signal_add_full (G_PRIORITY_DEFAULT,
 				SIGTERM, fu_main_sigterm_cb,
@@ -1539,6 +1563,7 @@ main (int argc, char *argv[])
 	/* wait */
 	g_message ("Daemon ready for requests");
 	g_main_loop_run (priv->loop);
+	fu_main_save_trace ();
 
 	/* success */
 	return EXIT_SUCCESS;
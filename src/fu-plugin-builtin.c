@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuPlugin"
+
+#include "config.h"
+
+#include "fu-plugin-builtin.h"
+#include "fu-plugin-private.h"
+
+/**
+ * SECTION:fu-plugin-builtin
+ * @short_description: plugins linked into the daemon
+ *
+ * Plugins selected using the `plugin_builtin` build option are linked into
+ * the daemon and fwupdtool rather than being loaded with #GModule. Each
+ * plugin is compiled with `FU_PLUGIN_BUILTIN` defined to the plugin name so
+ * that fu-plugin-vfuncs.h gives every vfunc a unique symbol name.
+ *
+ * All the vfuncs are declared weak as a plugin only implements some of them,
+ * and so the table entry is %NULL for anything not defined.
+ */
+
+#ifndef FU_PLUGIN_BUILTINS
+#define FU_PLUGIN_BUILTINS
+#endif
+
+#define FU_PLUGIN_BUILTIN_VFUNCS(X, name) \
+	X (name, INIT, init) \
+	X (name, DESTROY, destroy) \
+	X (name, STARTUP, startup) \
+	X (name, COLDPLUG, coldplug) \
+	X (name, COLDPLUG_PREPARE, coldplug_prepare) \
+	X (name, COLDPLUG_CLEANUP, coldplug_cleanup) \
+	X (name, RECOLDPLUG, recoldplug) \
+	X (name, USB_DEVICE_ADDED, usb_device_added) \
+	X (name, UDEV_DEVICE_ADDED, udev_device_added) \
+	X (name, DEVICE_REMOVED, device_removed) \
+	X (name, DEVICE_REGISTERED, device_registered) \
+	X (name, COMPOSITE_PREPARE, composite_prepare) \
+	X (name, COMPOSITE_CLEANUP, composite_cleanup) \
+	X (name, UPDATE_PREPARE, update_prepare) \
+	X (name, UPDATE_CLEANUP, update_cleanup) \
+	X (name, UPDATE_DETACH, update_detach) \
+	X (name, UPDATE_ATTACH, update_attach) \
+	X (name, UPDATE_RELOAD, update_reload) \
+	X (name, UPDATE, update) \
+	X (name, VERIFY, verify) \
+	X (name, VERIFY_DETACH, verify_detach) \
+	X (name, VERIFY_ATTACH, verify_attach) \
+	X (name, ACTIVATE, activate) \
+	X (name, UNLOCK, unlock) \
+	X (name, CLEAR_RESULTS, clear_results) \
+	X (name, GET_RESULTS, get_results)
+
+#define FU_PLUGIN_BUILTIN_EXTERN(name, hook, vfunc) \
+	extern void fu_plugin_builtin_##name##_##vfunc (void) __attribute__ ((weak));
+#define FU_PLUGIN_BUILTIN_ENTRY(name, hook, vfunc) \
+	[FU_PLUGIN_HOOK_##hook] = (gpointer) fu_plugin_builtin_##name##_##vfunc,
+
+#define FU_PLUGIN_BUILTIN(name) \
+	FU_PLUGIN_BUILTIN_VFUNCS (FU_PLUGIN_BUILTIN_EXTERN, name)
+FU_PLUGIN_BUILTINS
+#undef FU_PLUGIN_BUILTIN
+
+typedef struct {
+	const gchar	*name;
+	gpointer	 vfuncs[FU_PLUGIN_HOOK_LAST];
+} FuPluginBuiltin;
+
+static const FuPluginBuiltin fu_plugin_builtins[] = {
+#define FU_PLUGIN_BUILTIN(name) \
+	{ #name, { FU_PLUGIN_BUILTIN_VFUNCS (FU_PLUGIN_BUILTIN_ENTRY, name) } },
+	FU_PLUGIN_BUILTINS
+#undef FU_PLUGIN_BUILTIN
+	{ NULL, { NULL } }
+};
+
+/**
+ * fu_plugin_builtin_get_names:
+ *
+ * Gets the names of all the plugins linked into this binary.
+ *
+ * Returns: (transfer container): a %NULL terminated array of plugin names
+ **/
+const gchar **
+fu_plugin_builtin_get_names (void)
+{
+	const gchar **names;
+	guint j = 0;
+
+	names = g_new0 (const gchar *, G_N_ELEMENTS (fu_plugin_builtins));
+	for (guint i = 0; fu_plugin_builtins[i].name != NULL; i++) {
+		/* not linked in, e.g. the self tests */
+		if (fu_plugin_builtins[i].vfuncs[FU_PLUGIN_HOOK_INIT] == NULL)
+			continue;
+		names[j++] = fu_plugin_builtins[i].name;
+	}
+	return names;
+}
+
+/**
+ * fu_plugin_builtin_get_vfuncs:
+ * @name: A plugin name, e.g. `colorhug`
+ *
+ * Gets the vfuncs for a plugin linked into this binary.
+ *
+ * Returns: an array of %FU_PLUGIN_HOOK_LAST entry points, or %NULL if not found
+ **/
+const gpointer *
+fu_plugin_builtin_get_vfuncs (const gchar *name)
+{
+	g_return_val_if_fail (name != NULL, NULL);
+	for (guint i = 0; fu_plugin_builtins[i].name != NULL; i++) {
+		if (fu_plugin_builtins[i].vfuncs[FU_PLUGIN_HOOK_INIT] == NULL)
+			continue;
+		if (g_strcmp0 (fu_plugin_builtins[i].name, name) == 0)
+			return (const gpointer *) fu_plugin_builtins[i].vfuncs;
+	}
+	return NULL;
+}
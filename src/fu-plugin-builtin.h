@@ -0,0 +1,16 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+const gchar	**fu_plugin_builtin_get_names		(void);
+const gpointer	*fu_plugin_builtin_get_vfuncs		(const gchar	*name);
+
+G_END_DECLS
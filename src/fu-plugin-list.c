@@ -33,6 +33,7 @@ struct _FuPluginList
 	GObject			 parent_instance;
 	GPtrArray		*plugins;		/* of FuPlugin */
 	GHashTable		*plugins_hash;		/* of name : FuPlugin */
+	GPtrArray		*plugins_by_hook[FU_PLUGIN_HOOK_LAST];	/* of FuPlugin */
 };
 
 G_DEFINE_TYPE (FuPluginList, fu_plugin_list, G_TYPE_OBJECT)
@@ -54,6 +55,52 @@ fu_plugin_list_get_all (FuPluginList *self)
 	return self->plugins;
 }
 
+static void
+fu_plugin_list_invalidate_hooks (FuPluginList *self)
+{
+	for (guint i = 0; i < FU_PLUGIN_HOOK_LAST; i++)
+		g_clear_pointer (&self->plugins_by_hook[i], g_ptr_array_unref);
+}
+
+/**
+ * fu_plugin_list_get_by_hook:
+ * @self: A #FuPluginList
+ * @hook: A #FuPluginHook, e.g. %FU_PLUGIN_HOOK_USB_DEVICE_ADDED
+ *
+ * Gets the plugins that implement a specific vfunc, in depsolved order.
+ * Plugins that are opened on demand are always included as the symbols are
+ * not known until the module has been loaded.
+ *
+ * The returned array is only valid until a plugin is added or the list is
+ * depsolved again.
+ *
+ * Returns: (transfer none) (element-type FuPlugin): the plugins
+ *
+ * Since: 1.2.6
+ **/
+GPtrArray *
+fu_plugin_list_get_by_hook (FuPluginList *self, FuPluginHook hook)
+{
+	GPtrArray *plugins;
+
+	g_return_val_if_fail (FU_IS_PLUGIN_LIST (self), NULL);
+	g_return_val_if_fail (hook < FU_PLUGIN_HOOK_LAST, NULL);
+
+	/* already cached */
+	if (self->plugins_by_hook[hook] != NULL)
+		return self->plugins_by_hook[hook];
+
+	plugins = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < self->plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
+		if (!fu_plugin_get_lazy (plugin) && !fu_plugin_has_hook (plugin, hook))
+			continue;
+		g_ptr_array_add (plugins, g_object_ref (plugin));
+	}
+	self->plugins_by_hook[hook] = plugins;
+	return plugins;
+}
+
 /**
  * fu_plugin_list_add:
  * @self: A #FuPluginList
@@ -74,6 +121,7 @@ fu_plugin_list_add (FuPluginList *self, FuPlugin *plugin)
 	g_hash_table_insert (self->plugins_hash,
 			     g_strdup (fu_plugin_get_name (plugin)),
 			     g_object_ref (plugin));
+	fu_plugin_list_invalidate_hooks (self);
 }
 
 /**
@@ -261,6 +309,7 @@ fu_plugin_list_depsolve (FuPluginList *self, GError **error)
 
 	/* sort by order */
 	g_ptr_array_sort (self->plugins, fu_plugin_list_sort_cb);
+	fu_plugin_list_invalidate_hooks (self);
 	return TRUE;
 }
 
@@ -284,6 +333,7 @@ fu_plugin_list_finalize (GObject *obj)
 {
 	FuPluginList *self = FU_PLUGIN_LIST (obj);
 
+	fu_plugin_list_invalidate_hooks (self);
 	g_ptr_array_unref (self->plugins);
 	g_hash_table_unref (self->plugins_hash);
 
@@ -8,7 +8,7 @@
 
 #include <glib-object.h>
 
-#include "fu-plugin.h"
+#include "fu-plugin-private.h"
 
 G_BEGIN_DECLS
 
@@ -19,6 +19,8 @@ FuPluginList	*fu_plugin_list_new			(void);
 void		 fu_plugin_list_add			(FuPluginList	*self,
 							 FuPlugin	*plugin);
 GPtrArray	*fu_plugin_list_get_all			(FuPluginList	*self);
+GPtrArray	*fu_plugin_list_get_by_hook		(FuPluginList	*self,
+							 FuPluginHook	 hook);
 FuPlugin	*fu_plugin_list_find_by_name		(FuPluginList	*self,
 							 const gchar	*name,
 							 GError		**error);
@@ -14,6 +14,44 @@ G_BEGIN_DECLS
 
 #define FU_OFFLINE_TRIGGER_FILENAME	FU_OFFLINE_DESTDIR "/system-update"
 
+/**
+ * FuPluginHook:
+ *
+ * The optional vfuncs a plugin module can export.
+ **/
+typedef enum {
+	FU_PLUGIN_HOOK_INIT,
+	FU_PLUGIN_HOOK_DESTROY,
+	FU_PLUGIN_HOOK_STARTUP,
+	FU_PLUGIN_HOOK_COLDPLUG,
+	FU_PLUGIN_HOOK_COLDPLUG_PREPARE,
+	FU_PLUGIN_HOOK_COLDPLUG_CLEANUP,
+	FU_PLUGIN_HOOK_RECOLDPLUG,
+	FU_PLUGIN_HOOK_USB_DEVICE_ADDED,
+	FU_PLUGIN_HOOK_UDEV_DEVICE_ADDED,
+	FU_PLUGIN_HOOK_DEVICE_REMOVED,
+	FU_PLUGIN_HOOK_DEVICE_REGISTERED,
+	FU_PLUGIN_HOOK_COMPOSITE_PREPARE,
+	FU_PLUGIN_HOOK_COMPOSITE_CLEANUP,
+	FU_PLUGIN_HOOK_UPDATE_PREPARE,
+	FU_PLUGIN_HOOK_UPDATE_CLEANUP,
+	FU_PLUGIN_HOOK_UPDATE_DETACH,
+	FU_PLUGIN_HOOK_UPDATE_ATTACH,
+	FU_PLUGIN_HOOK_UPDATE_RELOAD,
+	FU_PLUGIN_HOOK_UPDATE,
+	FU_PLUGIN_HOOK_VERIFY,
+	FU_PLUGIN_HOOK_VERIFY_DETACH,
+	FU_PLUGIN_HOOK_VERIFY_ATTACH,
+	FU_PLUGIN_HOOK_ACTIVATE,
+	FU_PLUGIN_HOOK_UNLOCK,
+	FU_PLUGIN_HOOK_CLEAR_RESULTS,
+	FU_PLUGIN_HOOK_GET_RESULTS,
+	/*< private >*/
+	FU_PLUGIN_HOOK_LAST
+} FuPluginHook;
+
+const gchar	*fu_plugin_hook_to_string		(FuPluginHook	 hook);
+
 FuPlugin	*fu_plugin_new				(void);
 void		 fu_plugin_set_usb_context		(FuPlugin	*self,
 							 GUsbContext	*usb_ctx);
@@ -47,6 +85,23 @@ GHashTable	*fu_plugin_get_report_metadata		(FuPlugin	*self);
 gboolean	 fu_plugin_open				(FuPlugin	*self,
 							 const gchar	*filename,
 							 GError		**error);
+void		 fu_plugin_unload			(FuPlugin	*self);
+void		 fu_plugin_set_builtin			(FuPlugin	*self,
+							 const gpointer	*vfuncs);
+gboolean	 fu_plugin_get_builtin			(FuPlugin	*self);
+gboolean	 fu_plugin_is_loaded			(FuPlugin	*self);
+gboolean	 fu_plugin_has_hook			(FuPlugin	*self,
+							 FuPluginHook	 hook);
+gboolean	 fu_plugin_get_lazy			(FuPlugin	*self);
+const gchar	*fu_plugin_get_filename			(FuPlugin	*self);
+void		 fu_plugin_set_filename			(FuPlugin	*self,
+							 const gchar	*filename);
+gboolean	 fu_plugin_load_manifest		(FuPlugin	*self,
+							 const gchar	*filename,
+							 GError		**error);
+gboolean	 fu_plugin_manifest_matches_hwids	(FuPlugin	*self);
+gboolean	 fu_plugin_manifest_matches_device	(FuPlugin	*self,
+							 FuDevice	*device);
 gboolean	 fu_plugin_runner_startup		(FuPlugin	*self,
 							 GError		**error);
 gboolean	 fu_plugin_runner_coldplug		(FuPlugin	*self,
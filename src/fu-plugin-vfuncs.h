@@ -12,6 +12,38 @@
 
 G_BEGIN_DECLS
 
+/* plugins linked into the daemon need a unique name for each vfunc */
+#ifdef FU_PLUGIN_BUILTIN
+#define FU_PLUGIN_BUILTIN_SYMBOL_(name,vfunc)	fu_plugin_builtin_##name##_##vfunc
+#define FU_PLUGIN_BUILTIN_SYMBOL(name,vfunc)	FU_PLUGIN_BUILTIN_SYMBOL_(name,vfunc)
+#define fu_plugin_init				FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,init)
+#define fu_plugin_destroy			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,destroy)
+#define fu_plugin_startup			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,startup)
+#define fu_plugin_coldplug			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,coldplug)
+#define fu_plugin_coldplug_prepare		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,coldplug_prepare)
+#define fu_plugin_coldplug_cleanup		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,coldplug_cleanup)
+#define fu_plugin_recoldplug			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,recoldplug)
+#define fu_plugin_usb_device_added		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,usb_device_added)
+#define fu_plugin_udev_device_added		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,udev_device_added)
+#define fu_plugin_device_removed		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,device_removed)
+#define fu_plugin_device_registered		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,device_registered)
+#define fu_plugin_composite_prepare		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,composite_prepare)
+#define fu_plugin_composite_cleanup		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,composite_cleanup)
+#define fu_plugin_update_prepare		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,update_prepare)
+#define fu_plugin_update_cleanup		FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,update_cleanup)
+#define fu_plugin_update_detach			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,update_detach)
+#define fu_plugin_update_attach			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,update_attach)
+#define fu_plugin_update_reload			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,update_reload)
+#define fu_plugin_update			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,update)
+#define fu_plugin_verify			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,verify)
+#define fu_plugin_verify_detach			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,verify_detach)
+#define fu_plugin_verify_attach			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,verify_attach)
+#define fu_plugin_activate			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,activate)
+#define fu_plugin_unlock			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,unlock)
+#define fu_plugin_clear_results			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,clear_results)
+#define fu_plugin_get_results			FU_PLUGIN_BUILTIN_SYMBOL(FU_PLUGIN_BUILTIN,get_results)
+#endif
+
 void		 fu_plugin_init				(FuPlugin	*plugin);
 void		 fu_plugin_destroy			(FuPlugin	*plugin);
 gboolean	 fu_plugin_startup			(FuPlugin	*plugin,
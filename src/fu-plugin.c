@@ -22,6 +22,7 @@
 #include "fu-plugin-private.h"
 #include "fu-history.h"
 #include "fu-mutex.h"
+#include "fu-trace.h"
 
 /**
  * SECTION:fu-plugin
@@ -33,16 +34,25 @@
  */
 
 #define	FU_PLUGIN_COLDPLUG_DELAY_MAXIMUM	3000u	/* ms */
+#define	FU_PLUGIN_MANIFEST_GROUP		"fwupd Plugin"
 
 static void fu_plugin_finalize			 (GObject *object);
 
 typedef struct {
 	GModule			*module;
+	GModule			*module_resident;	/* after unloading */
+	gchar			*filename;
+	gboolean		 lazy;
+	GPtrArray		*manifest_instance_ids;
+	GPtrArray		*manifest_hwids;
+	GPtrArray		*manifest_udev_subsystems;
 	GUsbContext		*usb_ctx;
 	gboolean		 enabled;
 	guint			 order;
 	guint			 priority;
 	GPtrArray		*rules[FU_PLUGIN_RULE_LAST];
+	gpointer		 vfuncs[FU_PLUGIN_HOOK_LAST];
+	const gpointer		*builtin_vfuncs;	/* linked in */
 	gchar			*name;
 	gchar			*build_hash;
 	FuHwids			*hwids;
@@ -73,6 +83,35 @@ static guint signals[SIGNAL_LAST] = { 0 };
 G_DEFINE_TYPE_WITH_PRIVATE (FuPlugin, fu_plugin, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (fu_plugin_get_instance_private (o))
 
+static const gchar *fu_plugin_hook_symbols[FU_PLUGIN_HOOK_LAST] = {
+	[FU_PLUGIN_HOOK_INIT] = "fu_plugin_init",
+	[FU_PLUGIN_HOOK_DESTROY] = "fu_plugin_destroy",
+	[FU_PLUGIN_HOOK_STARTUP] = "fu_plugin_startup",
+	[FU_PLUGIN_HOOK_COLDPLUG] = "fu_plugin_coldplug",
+	[FU_PLUGIN_HOOK_COLDPLUG_PREPARE] = "fu_plugin_coldplug_prepare",
+	[FU_PLUGIN_HOOK_COLDPLUG_CLEANUP] = "fu_plugin_coldplug_cleanup",
+	[FU_PLUGIN_HOOK_RECOLDPLUG] = "fu_plugin_recoldplug",
+	[FU_PLUGIN_HOOK_USB_DEVICE_ADDED] = "fu_plugin_usb_device_added",
+	[FU_PLUGIN_HOOK_UDEV_DEVICE_ADDED] = "fu_plugin_udev_device_added",
+	[FU_PLUGIN_HOOK_DEVICE_REMOVED] = "fu_plugin_device_removed",
+	[FU_PLUGIN_HOOK_DEVICE_REGISTERED] = "fu_plugin_device_registered",
+	[FU_PLUGIN_HOOK_COMPOSITE_PREPARE] = "fu_plugin_composite_prepare",
+	[FU_PLUGIN_HOOK_COMPOSITE_CLEANUP] = "fu_plugin_composite_cleanup",
+	[FU_PLUGIN_HOOK_UPDATE_PREPARE] = "fu_plugin_update_prepare",
+	[FU_PLUGIN_HOOK_UPDATE_CLEANUP] = "fu_plugin_update_cleanup",
+	[FU_PLUGIN_HOOK_UPDATE_DETACH] = "fu_plugin_update_detach",
+	[FU_PLUGIN_HOOK_UPDATE_ATTACH] = "fu_plugin_update_attach",
+	[FU_PLUGIN_HOOK_UPDATE_RELOAD] = "fu_plugin_update_reload",
+	[FU_PLUGIN_HOOK_UPDATE] = "fu_plugin_update",
+	[FU_PLUGIN_HOOK_VERIFY] = "fu_plugin_verify",
+	[FU_PLUGIN_HOOK_VERIFY_DETACH] = "fu_plugin_verify_detach",
+	[FU_PLUGIN_HOOK_VERIFY_ATTACH] = "fu_plugin_verify_attach",
+	[FU_PLUGIN_HOOK_ACTIVATE] = "fu_plugin_activate",
+	[FU_PLUGIN_HOOK_UNLOCK] = "fu_plugin_unlock",
+	[FU_PLUGIN_HOOK_CLEAR_RESULTS] = "fu_plugin_clear_results",
+	[FU_PLUGIN_HOOK_GET_RESULTS] = "fu_plugin_get_results",
+};
+
 typedef const gchar	*(*FuPluginGetNameFunc)		(void);
 typedef void		 (*FuPluginInitFunc)		(FuPlugin	*self);
 typedef gboolean	 (*FuPluginStartupFunc)		(FuPlugin	*self,
@@ -347,7 +386,14 @@ fu_plugin_open (FuPlugin *self, const gchar *filename, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginInitFunc func = NULL;
 
-	priv->module = g_module_open (filename, 0);
+	/* the module cannot be closed when unloaded as it registers GTypes */
+	if (priv->module_resident != NULL) {
+		priv->module = g_steal_pointer (&priv->module_resident);
+	} else if (priv->builtin_vfuncs != NULL) {
+		priv->module = g_module_open (NULL, 0);
+	} else {
+		priv->module = g_module_open (filename, G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
+	}
 	if (priv->module == NULL) {
 		g_set_error (error,
 			     G_IO_ERROR,
@@ -358,19 +404,331 @@ fu_plugin_open (FuPlugin *self, const gchar *filename, GError **error)
 	}
 
 	/* set automatically */
-	if (priv->name == NULL)
+	if (priv->name == NULL && filename != NULL)
 		priv->name = fu_plugin_guess_name_from_fn (filename);
+	if (priv->filename != filename) {
+		g_free (priv->filename);
+		priv->filename = g_strdup (filename);
+	}
+
+	/* resolve all the optional entry points once */
+	if (priv->builtin_vfuncs != NULL) {
+		memcpy (priv->vfuncs, priv->builtin_vfuncs, sizeof (priv->vfuncs));
+	} else {
+		for (guint i = 0; i < FU_PLUGIN_HOOK_LAST; i++)
+			g_module_symbol (priv->module, fu_plugin_hook_symbols[i], &priv->vfuncs[i]);
+	}
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_init", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_INIT];
 	if (func != NULL) {
-		g_debug ("performing init() on %s", filename);
+		g_debug ("performing init() on %s", priv->name);
 		func (self);
 	}
 
 	return TRUE;
 }
 
+/**
+ * fu_plugin_set_builtin:
+ * @self: A #FuPlugin
+ * @vfuncs: An array of %FU_PLUGIN_HOOK_LAST entry points
+ *
+ * Sets the entry points for a plugin that is linked into the daemon rather
+ * than being loaded from a shared module. When set, fu_plugin_open() uses
+ * these rather than looking up the symbols, and the filename may be %NULL.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_plugin_set_builtin (FuPlugin *self, const gpointer *vfuncs)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	priv->builtin_vfuncs = vfuncs;
+}
+
+/**
+ * fu_plugin_get_builtin:
+ * @self: A #FuPlugin
+ *
+ * Gets if the plugin is linked into the daemon.
+ *
+ * Returns: %TRUE if set with fu_plugin_set_builtin()
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_plugin_get_builtin (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	return priv->builtin_vfuncs != NULL;
+}
+
+/**
+ * fu_plugin_hook_to_string:
+ * @hook: A #FuPluginHook, e.g. %FU_PLUGIN_HOOK_COLDPLUG
+ *
+ * Gets the name of the vfunc without the `fu_plugin_` prefix.
+ *
+ * Returns: a string, e.g. `coldplug`
+ **/
+const gchar *
+fu_plugin_hook_to_string (FuPluginHook hook)
+{
+	g_return_val_if_fail (hook < FU_PLUGIN_HOOK_LAST, NULL);
+	return fu_plugin_hook_symbols[hook] + 10;
+}
+
+/**
+ * fu_plugin_has_hook:
+ * @self: A #FuPlugin
+ * @hook: A #FuPluginHook, e.g. %FU_PLUGIN_HOOK_COLDPLUG
+ *
+ * Gets if the opened module implements a specific vfunc.
+ *
+ * Returns: %TRUE if the symbol was found when the plugin was opened
+ **/
+gboolean
+fu_plugin_has_hook (FuPlugin *self, FuPluginHook hook)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	g_return_val_if_fail (hook < FU_PLUGIN_HOOK_LAST, FALSE);
+	return priv->vfuncs[hook] != NULL;
+}
+
+/**
+ * fu_plugin_unload:
+ * @self: A #FuPlugin
+ *
+ * Destroys the plugin state so that it can be opened again when required.
+ * The module itself is kept resident as it may have registered types.
+ **/
+void
+fu_plugin_unload (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	FuPluginInitFunc func = NULL;
+
+	g_return_if_fail (FU_IS_PLUGIN (self));
+
+	if (priv->module == NULL)
+		return;
+	func = priv->vfuncs[FU_PLUGIN_HOOK_DESTROY];
+	if (func != NULL) {
+		g_debug ("performing destroy() on %s", priv->name);
+		func (self);
+	}
+	memset (priv->vfuncs, 0, sizeof (priv->vfuncs));
+	g_hash_table_remove_all (priv->devices);
+	g_clear_pointer (&priv->data, g_free);
+	g_module_make_resident (priv->module);
+	priv->module_resident = g_steal_pointer (&priv->module);
+	priv->enabled = TRUE;
+}
+
+/**
+ * fu_plugin_is_loaded:
+ * @self: A #FuPlugin
+ *
+ * Gets if the plugin module has been opened and initialized.
+ *
+ * Returns: %TRUE if loaded
+ **/
+gboolean
+fu_plugin_is_loaded (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	return priv->module != NULL;
+}
+
+/**
+ * fu_plugin_get_lazy:
+ * @self: A #FuPlugin
+ *
+ * Gets if the plugin should only be opened when matching hardware appears.
+ *
+ * Returns: %TRUE if a manifest was loaded
+ **/
+gboolean
+fu_plugin_get_lazy (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	return priv->lazy;
+}
+
+const gchar *
+fu_plugin_get_filename (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), NULL);
+	return priv->filename;
+}
+
+void
+fu_plugin_set_filename (FuPlugin *self, const gchar *filename)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	g_free (priv->filename);
+	priv->filename = g_strdup (filename);
+}
+
+static GPtrArray *
+fu_plugin_manifest_get_strv (GKeyFile *kf, const gchar *key)
+{
+	GPtrArray *array = g_ptr_array_new_with_free_func (g_free);
+	g_auto(GStrv) values = NULL;
+
+	values = g_key_file_get_string_list (kf, FU_PLUGIN_MANIFEST_GROUP, key, NULL, NULL);
+	for (guint i = 0; values != NULL && values[i] != NULL; i++) {
+		if (values[i][0] == '\0')
+			continue;
+		g_ptr_array_add (array, g_strdup (values[i]));
+	}
+	return array;
+}
+
+static void
+fu_plugin_manifest_add_rules (FuPlugin *self, GKeyFile *kf,
+			      const gchar *key, FuPluginRule rule)
+{
+	g_autoptr(GPtrArray) values = fu_plugin_manifest_get_strv (kf, key);
+	for (guint i = 0; i < values->len; i++)
+		fu_plugin_add_rule (self, rule, g_ptr_array_index (values, i));
+}
+
+/**
+ * fu_plugin_load_manifest:
+ * @self: A #FuPlugin
+ * @filename: A manifest filename, e.g. `colorhug.manifest`
+ * @error: A #GError, or %NULL
+ *
+ * Loads a declarative description of the hardware the plugin supports, which
+ * allows the daemon to defer opening the module until it is actually needed.
+ *
+ * The ordering rules and udev subsystems would normally be set in
+ * fu_plugin_init() and so must be duplicated in the manifest.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_plugin_load_manifest (FuPlugin *self, const gchar *filename, GError **error)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!g_key_file_load_from_file (kf, filename, G_KEY_FILE_NONE, error))
+		return FALSE;
+	if (!g_key_file_has_group (kf, FU_PLUGIN_MANIFEST_GROUP)) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "no [%s] group in %s",
+			     FU_PLUGIN_MANIFEST_GROUP, filename);
+		return FALSE;
+	}
+
+	/* hardware that causes the plugin to be loaded */
+	if (priv->manifest_instance_ids != NULL)
+		g_ptr_array_unref (priv->manifest_instance_ids);
+	priv->manifest_instance_ids = fu_plugin_manifest_get_strv (kf, "InstanceIds");
+	if (priv->manifest_hwids != NULL)
+		g_ptr_array_unref (priv->manifest_hwids);
+	priv->manifest_hwids = fu_plugin_manifest_get_strv (kf, "Hwids");
+	if (priv->manifest_udev_subsystems != NULL)
+		g_ptr_array_unref (priv->manifest_udev_subsystems);
+	priv->manifest_udev_subsystems = fu_plugin_manifest_get_strv (kf, "UdevSubsystems");
+	if (priv->udev_subsystems != NULL) {
+		for (guint i = 0; i < priv->manifest_udev_subsystems->len; i++) {
+			const gchar *tmp = g_ptr_array_index (priv->manifest_udev_subsystems, i);
+			fu_plugin_add_udev_subsystem (self, tmp);
+		}
+	}
+
+	/* ordering and quirk rules */
+	fu_plugin_manifest_add_rules (self, kf, "RequiresQuirk", FU_PLUGIN_RULE_REQUIRES_QUIRK);
+	fu_plugin_manifest_add_rules (self, kf, "RunAfter", FU_PLUGIN_RULE_RUN_AFTER);
+	fu_plugin_manifest_add_rules (self, kf, "RunBefore", FU_PLUGIN_RULE_RUN_BEFORE);
+	fu_plugin_manifest_add_rules (self, kf, "BetterThan", FU_PLUGIN_RULE_BETTER_THAN);
+	fu_plugin_manifest_add_rules (self, kf, "Conflicts", FU_PLUGIN_RULE_CONFLICTS);
+	fu_plugin_manifest_add_rules (self, kf, "SupportsProtocol", FU_PLUGIN_RULE_SUPPORTS_PROTOCOL);
+
+	/* success */
+	priv->lazy = TRUE;
+	return TRUE;
+}
+
+/**
+ * fu_plugin_manifest_matches_hwids:
+ * @self: A #FuPlugin
+ *
+ * Gets if any of the HWIDs listed in the manifest match the system.
+ *
+ * Returns: %TRUE if the plugin should be loaded
+ **/
+gboolean
+fu_plugin_manifest_matches_hwids (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	if (priv->hwids == NULL || priv->manifest_hwids == NULL)
+		return FALSE;
+	for (guint i = 0; i < priv->manifest_hwids->len; i++) {
+		const gchar *hwid = g_ptr_array_index (priv->manifest_hwids, i);
+		if (fu_hwids_has_guid (priv->hwids, hwid))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * fu_plugin_manifest_matches_device:
+ * @self: A #FuPlugin
+ * @device: A #FuDevice
+ *
+ * Gets if the device matches any instance ID or udev subsystem listed in the
+ * manifest.
+ *
+ * Returns: %TRUE if the plugin should be loaded
+ **/
+gboolean
+fu_plugin_manifest_matches_device (FuPlugin *self, FuDevice *device)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	g_return_val_if_fail (FU_IS_DEVICE (device), FALSE);
+
+	/* specified using a quirk */
+	if (g_strcmp0 (fu_device_get_plugin (device), priv->name) == 0)
+		return TRUE;
+	if (priv->manifest_instance_ids != NULL) {
+		for (guint i = 0; i < priv->manifest_instance_ids->len; i++) {
+			const gchar *tmp = g_ptr_array_index (priv->manifest_instance_ids, i);
+			if (fu_device_has_guid (device, tmp))
+				return TRUE;
+		}
+	}
+	if (priv->manifest_udev_subsystems != NULL && FU_IS_UDEV_DEVICE (device)) {
+		const gchar *subsystem = fu_udev_device_get_subsystem (FU_UDEV_DEVICE (device));
+		for (guint i = 0; i < priv->manifest_udev_subsystems->len; i++) {
+			const gchar *tmp = g_ptr_array_index (priv->manifest_udev_subsystems, i);
+			if (g_strcmp0 (subsystem, tmp) == 0)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 /**
  * fu_plugin_device_add:
  * @self: A #FuPlugin
@@ -804,6 +1162,7 @@ gboolean
 fu_plugin_runner_startup (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -816,11 +1175,14 @@ fu_plugin_runner_startup (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_startup", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_STARTUP];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing startup() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "startup", priv->name);
+	ret = func (self, &error_local);
+	FU_TRACE_END ("plugin", "startup", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for startup()",
 				    priv->name);
@@ -883,9 +1245,10 @@ fu_plugin_runner_offline_setup (GError **error)
 
 static gboolean
 fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
-				 const gchar *symbol_name, GError **error)
+				 FuPluginHook hook, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -898,14 +1261,17 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	func = priv->vfuncs[hook];
 	if (func == NULL)
 		return TRUE;
-	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, device, &error_local)) {
+	g_debug ("performing %s() on %s", fu_plugin_hook_to_string (hook), priv->name);
+	FU_TRACE_BEGIN ("plugin", fu_plugin_hook_to_string (hook), priv->name);
+	ret = func (self, device, &error_local);
+	FU_TRACE_END ("plugin", fu_plugin_hook_to_string (hook), priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
-				    priv->name, symbol_name + 10);
+				    priv->name, fu_plugin_hook_to_string (hook));
 			g_set_error_literal (&error_local,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INTERNAL,
@@ -913,7 +1279,7 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 		}
 		g_propagate_prefixed_error (error, g_steal_pointer (&error_local),
 					    "failed to %s using %s: ",
-					    symbol_name + 10, priv->name);
+					    fu_plugin_hook_to_string (hook), priv->name);
 		return FALSE;
 	}
 	return TRUE;
@@ -922,9 +1288,10 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 static gboolean
 fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags,
 					 FuDevice *device,
-					 const gchar *symbol_name, GError **error)
+					 FuPluginHook hook, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginFlaggedDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -937,14 +1304,17 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	func = priv->vfuncs[hook];
 	if (func == NULL)
 		return TRUE;
-	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, flags, device, &error_local)) {
+	g_debug ("performing %s() on %s", fu_plugin_hook_to_string (hook), priv->name);
+	FU_TRACE_BEGIN ("plugin", fu_plugin_hook_to_string (hook), priv->name);
+	ret = func (self, flags, device, &error_local);
+	FU_TRACE_END ("plugin", fu_plugin_hook_to_string (hook), priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
-				    priv->name, symbol_name + 10);
+				    priv->name, fu_plugin_hook_to_string (hook));
 			g_set_error_literal (&error_local,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INTERNAL,
@@ -952,7 +1322,7 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 		}
 		g_propagate_prefixed_error (error, g_steal_pointer (&error_local),
 					    "failed to %s using %s: ",
-					    symbol_name + 10, priv->name);
+					    fu_plugin_hook_to_string (hook), priv->name);
 		return FALSE;
 	}
 	return TRUE;
@@ -961,9 +1331,10 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 
 static gboolean
 fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
-				       const gchar *symbol_name, GError **error)
+				       FuPluginHook hook, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginDeviceArrayFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -976,14 +1347,17 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	func = priv->vfuncs[hook];
 	if (func == NULL)
 		return TRUE;
-	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, devices, &error_local)) {
+	g_debug ("performing %s() on %s", fu_plugin_hook_to_string (hook), priv->name);
+	FU_TRACE_BEGIN ("plugin", fu_plugin_hook_to_string (hook), priv->name);
+	ret = func (self, devices, &error_local);
+	FU_TRACE_END ("plugin", fu_plugin_hook_to_string (hook), priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
-				    priv->name, symbol_name + 10);
+				    priv->name, fu_plugin_hook_to_string (hook));
 			g_set_error_literal (&error_local,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INTERNAL,
@@ -991,7 +1365,7 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 		}
 		g_propagate_prefixed_error (error, g_steal_pointer (&error_local),
 					    "failed to %s using %s: ",
-					    symbol_name + 10, priv->name);
+					    fu_plugin_hook_to_string (hook), priv->name);
 		return FALSE;
 	}
 	return TRUE;
@@ -1001,6 +1375,7 @@ gboolean
 fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1013,11 +1388,14 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_coldplug", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_COLDPLUG];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "coldplug", priv->name);
+	ret = func (self, &error_local);
+	FU_TRACE_END ("plugin", "coldplug", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug()",
 				    priv->name);
@@ -1037,6 +1415,7 @@ gboolean
 fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1049,11 +1428,14 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_recoldplug", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_RECOLDPLUG];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing recoldplug() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "recoldplug", priv->name);
+	ret = func (self, &error_local);
+	FU_TRACE_END ("plugin", "recoldplug", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for recoldplug()",
 				    priv->name);
@@ -1074,6 +1456,7 @@ gboolean
 fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1086,11 +1469,14 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_coldplug_prepare", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_COLDPLUG_PREPARE];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug_prepare() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "coldplug_prepare", priv->name);
+	ret = func (self, &error_local);
+	FU_TRACE_END ("plugin", "coldplug_prepare", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug_prepare()",
 				    priv->name);
@@ -1111,6 +1497,7 @@ gboolean
 fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1123,11 +1510,14 @@ fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_coldplug_cleanup", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_COLDPLUG_CLEANUP];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug_cleanup() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "coldplug_cleanup", priv->name);
+	ret = func (self, &error_local);
+	FU_TRACE_END ("plugin", "coldplug_cleanup", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug_cleanup()",
 				    priv->name);
@@ -1148,7 +1538,7 @@ gboolean
 fu_plugin_runner_composite_prepare (FuPlugin *self, GPtrArray *devices, GError **error)
 {
 	return fu_plugin_runner_device_array_generic (self, devices,
-						      "fu_plugin_composite_prepare",
+						      FU_PLUGIN_HOOK_COMPOSITE_PREPARE,
 						      error);
 }
 
@@ -1156,7 +1546,7 @@ gboolean
 fu_plugin_runner_composite_cleanup (FuPlugin *self, GPtrArray *devices, GError **error)
 {
 	return fu_plugin_runner_device_array_generic (self, devices,
-						      "fu_plugin_composite_cleanup",
+						      FU_PLUGIN_HOOK_COMPOSITE_CLEANUP,
 						      error);
 }
 
@@ -1165,7 +1555,7 @@ fu_plugin_runner_update_prepare (FuPlugin *self, FwupdInstallFlags flags, FuDevi
 				 GError **error)
 {
 	return fu_plugin_runner_flagged_device_generic (self, flags, device,
-							"fu_plugin_update_prepare",
+							FU_PLUGIN_HOOK_UPDATE_PREPARE,
 							error);
 }
 
@@ -1174,7 +1564,7 @@ fu_plugin_runner_update_cleanup (FuPlugin *self, FwupdInstallFlags flags, FuDevi
 				 GError **error)
 {
 	return fu_plugin_runner_flagged_device_generic (self, flags, device,
-							"fu_plugin_update_cleanup",
+							FU_PLUGIN_HOOK_UPDATE_CLEANUP,
 							error);
 }
 
@@ -1182,21 +1572,21 @@ gboolean
 fu_plugin_runner_update_attach (FuPlugin *self, FuDevice *device, GError **error)
 {
 	return fu_plugin_runner_device_generic (self, device,
-						"fu_plugin_update_attach", error);
+						FU_PLUGIN_HOOK_UPDATE_ATTACH, error);
 }
 
 gboolean
 fu_plugin_runner_update_detach (FuPlugin *self, FuDevice *device, GError **error)
 {
 	return fu_plugin_runner_device_generic (self, device,
-						"fu_plugin_update_detach", error);
+						FU_PLUGIN_HOOK_UPDATE_DETACH, error);
 }
 
 gboolean
 fu_plugin_runner_update_reload (FuPlugin *self, FuDevice *device, GError **error)
 {
 	return fu_plugin_runner_device_generic (self, device,
-						"fu_plugin_update_reload", error);
+						FU_PLUGIN_HOOK_UPDATE_RELOAD, error);
 }
 
 /**
@@ -1225,6 +1615,7 @@ gboolean
 fu_plugin_runner_usb_device_added (FuPlugin *self, FuUsbDevice *device, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginUsbDeviceAddedFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1237,11 +1628,14 @@ fu_plugin_runner_usb_device_added (FuPlugin *self, FuUsbDevice *device, GError *
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_usb_device_added", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_USB_DEVICE_ADDED];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing usb_device_added() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "usb_device_added", priv->name);
+	ret = func (self, device, &error_local);
+	FU_TRACE_END ("plugin", "usb_device_added", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for usb_device_added()",
 				    priv->name);
@@ -1262,6 +1656,7 @@ gboolean
 fu_plugin_runner_udev_device_added (FuPlugin *self, FuUdevDevice *device, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginUdevDeviceAddedFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1274,11 +1669,14 @@ fu_plugin_runner_udev_device_added (FuPlugin *self, FuUdevDevice *device, GError
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_udev_device_added", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_UDEV_DEVICE_ADDED];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing udev_device_added() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "udev_device_added", priv->name);
+	ret = func (self, device, &error_local);
+	FU_TRACE_END ("plugin", "udev_device_added", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for udev_device_added()",
 				    priv->name);
@@ -1301,7 +1699,7 @@ fu_plugin_runner_device_removed (FuPlugin *self, FuDevice *device)
 	g_autoptr(GError) error_local= NULL;
 
 	if (!fu_plugin_runner_device_generic (self, device,
-					      "fu_plugin_device_removed",
+					      FU_PLUGIN_HOOK_DEVICE_REMOVED,
 					      &error_local))
 		g_warning ("%s", error_local->message);
 }
@@ -1323,10 +1721,12 @@ fu_plugin_runner_device_register (FuPlugin *self, FuDevice *device)
 		return;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_device_registered", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_DEVICE_REGISTERED];
 	if (func != NULL) {
 		g_debug ("performing fu_plugin_device_registered() on %s", priv->name);
+		FU_TRACE_BEGIN ("plugin", "device_registered", priv->name);
 		func (self, device);
+		FU_TRACE_END ("plugin", "device_registered", priv->name);
 	}
 }
 
@@ -1401,6 +1801,7 @@ fu_plugin_runner_verify (FuPlugin *self,
 			 GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginVerifyFunc func = NULL;
 	GPtrArray *checksums;
 	g_autoptr(GError) error_local = NULL;
@@ -1414,7 +1815,7 @@ fu_plugin_runner_verify (FuPlugin *self,
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_verify", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_VERIFY];
 	if (func == NULL)
 		return TRUE;
 
@@ -1424,13 +1825,16 @@ fu_plugin_runner_verify (FuPlugin *self,
 
 	/* run additional detach */
 	if (!fu_plugin_runner_device_generic (self, device,
-					      "fu_plugin_verify_detach",
+					      FU_PLUGIN_HOOK_VERIFY_DETACH,
 					      error))
 		return FALSE;
 
 	/* run vfunc */
 	g_debug ("performing verify() on %s", priv->name);
-	if (!func (self, device, flags, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "verify", priv->name);
+	ret = func (self, device, flags, &error_local);
+	FU_TRACE_END ("plugin", "verify", priv->name);
+	if (!ret) {
 		g_autoptr(GError) error_attach = NULL;
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for verify()",
@@ -1445,7 +1849,7 @@ fu_plugin_runner_verify (FuPlugin *self,
 					    priv->name);
 		/* make the device "work" again, but don't prefix the error */
 		if (!fu_plugin_runner_device_generic (self, device,
-						      "fu_plugin_verify_attach",
+						      FU_PLUGIN_HOOK_VERIFY_ATTACH,
 						      &error_attach)) {
 			g_warning ("failed to attach whilst aborting verify(): %s",
 				   error_attach->message);
@@ -1455,7 +1859,7 @@ fu_plugin_runner_verify (FuPlugin *self,
 
 	/* run optional attach */
 	if (!fu_plugin_runner_device_generic (self, device,
-					      "fu_plugin_verify_attach",
+					      FU_PLUGIN_HOOK_VERIFY_ATTACH,
 					      error))
 		return FALSE;
 
@@ -1481,7 +1885,7 @@ fu_plugin_runner_activate (FuPlugin *self, FuDevice *device, GError **error)
 
 	/* run vfunc */
 	if (!fu_plugin_runner_device_generic (self, device,
-					      "fu_plugin_activate", error))
+					      FU_PLUGIN_HOOK_ACTIVATE, error))
 		return FALSE;
 
 	/* update with correct flags */
@@ -1508,7 +1912,7 @@ fu_plugin_runner_unlock (FuPlugin *self, FuDevice *device, GError **error)
 
 	/* run vfunc */
 	if (!fu_plugin_runner_device_generic (self, device,
-					      "fu_plugin_unlock", error))
+					      FU_PLUGIN_HOOK_UNLOCK, error))
 		return FALSE;
 
 	/* update with correct flags */
@@ -1526,6 +1930,7 @@ fu_plugin_runner_update (FuPlugin *self,
 			 GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginUpdateFunc update_func;
 	g_autoptr(FuHistory) history = NULL;
 	g_autoptr(FuDevice) device_pending = NULL;
@@ -1544,7 +1949,7 @@ fu_plugin_runner_update (FuPlugin *self,
 	}
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_update", (gpointer *) &update_func);
+	update_func = priv->vfuncs[FU_PLUGIN_HOOK_UPDATE];
 	if (update_func == NULL) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -1560,7 +1965,10 @@ fu_plugin_runner_update (FuPlugin *self,
 	/* online */
 	history = fu_history_new ();
 	device_pending = fu_history_get_device_by_id (history, fu_device_get_id (device), NULL);
-	if (!update_func (self, device, blob_fw, flags, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "update", priv->name);
+	ret = update_func (self, device, blob_fw, flags, &error_local);
+	FU_TRACE_END ("plugin", "update", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for update()",
 				    priv->name);
@@ -1618,6 +2026,7 @@ gboolean
 fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1630,11 +2039,14 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_get_results", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_CLEAR_RESULTS];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing clear_result() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "clear_results", priv->name);
+	ret = func (self, device, &error_local);
+	FU_TRACE_END ("plugin", "clear_results", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for clear_result()",
 				    priv->name);
@@ -1655,6 +2067,7 @@ gboolean
 fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	FuPluginDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -1667,11 +2080,14 @@ fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_get_results", (gpointer *) &func);
+	func = priv->vfuncs[FU_PLUGIN_HOOK_GET_RESULTS];
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing get_results() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	FU_TRACE_BEGIN ("plugin", "get_results", priv->name);
+	ret = func (self, device, &error_local);
+	FU_TRACE_END ("plugin", "get_results", priv->name);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for get_results()",
 				    priv->name);
@@ -1765,6 +2181,9 @@ void
 fu_plugin_add_rule (FuPlugin *self, FuPluginRule rule, const gchar *name)
 {
 	FuPluginPrivate *priv = fu_plugin_get_instance_private (self);
+	/* may already be set from the manifest */
+	if (fu_plugin_has_rule (self, rule, name))
+		return;
 	g_ptr_array_add (priv->rules[rule], g_strdup (name));
 	g_signal_emit (self, signals[SIGNAL_RULES_CHANGED], 0);
 }
@@ -1981,7 +2400,7 @@ fu_plugin_finalize (GObject *object)
 
 	/* optional */
 	if (priv->module != NULL) {
-		g_module_symbol (priv->module, "fu_plugin_destroy", (gpointer *) &func);
+		func = priv->vfuncs[FU_PLUGIN_HOOK_DESTROY];
 		if (func != NULL) {
 			g_debug ("performing destroy() on %s", priv->name);
 			func (self);
@@ -2008,13 +2427,22 @@ fu_plugin_finalize (GObject *object)
 	g_hash_table_unref (priv->devices);
 	g_hash_table_unref (priv->report_metadata);
 	g_object_unref (priv->devices_mutex);
+	if (priv->manifest_instance_ids != NULL)
+		g_ptr_array_unref (priv->manifest_instance_ids);
+	if (priv->manifest_hwids != NULL)
+		g_ptr_array_unref (priv->manifest_hwids);
+	if (priv->manifest_udev_subsystems != NULL)
+		g_ptr_array_unref (priv->manifest_udev_subsystems);
 	g_free (priv->name);
+	g_free (priv->filename);
 	g_free (priv->data);
 	/* Must happen as the last step to avoid prematurely
 	 * freeing memory held by the plugin */
 #ifndef RUNNING_ON_VALGRIND
 	if (priv->module != NULL)
 		g_module_close (priv->module);
+	if (priv->module_resident != NULL)
+		g_module_close (priv->module_resident);
 #endif
 
 	G_OBJECT_CLASS (fu_plugin_parent_class)->finalize (object);
@@ -47,14 +47,28 @@
 
 static void fu_quirks_finalize	 (GObject *obj);
 
+/* the published table and the per-group tables inside it are never modified:
+ * readers take a reference to the table, and writers build a new table that
+ * shares the unchanged groups and swap it in, so an old table is freed when
+ * the last reader drops its reference; all keys and values are interned in
+ * a string chunk so values can be returned without a reference */
 struct _FuQuirks
 {
 	GObject			 parent_instance;
 	GPtrArray		*monitors;
-	GHashTable		*hash;	/* of group:{key:value} */
-	FuMutex			*hash_mutex;
+	GHashTable		*hash;		/* of group:{key:value} */
+	GMutex			 hash_mutex;	/* only protects swapping hash */
+	gpointer		 pending;	/* (atomic) FuQuirksBuilder */
+	GStringChunk		*strings;
+	FuMutex			*write_mutex;
 };
 
+typedef struct {
+	GHashTable		*hash;		/* of group:{key:value} */
+	GHashTable		*owned;		/* of {key:value} not yet published */
+	GStringChunk		*strings;	/* not owned */
+} FuQuirksBuilder;
+
 G_DEFINE_TYPE (FuQuirks, fu_quirks, G_TYPE_OBJECT)
 
 static void
@@ -107,6 +121,142 @@ fu_quirks_build_group_key (const gchar *group)
 	return g_strdup (group);
 }
 
+static void
+fu_quirks_builder_init (FuQuirksBuilder *builder, GHashTable *hash, GStringChunk *strings)
+{
+	builder->hash = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+					       (GDestroyNotify) g_hash_table_unref);
+	builder->owned = g_hash_table_new (g_direct_hash, g_direct_equal);
+	builder->strings = strings;
+
+	/* share every group with the published table until it is modified */
+	if (hash != NULL) {
+		GHashTableIter iter;
+		gpointer key, value;
+		g_hash_table_iter_init (&iter, hash);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			g_hash_table_insert (builder->hash, key,
+					     g_hash_table_ref (value));
+		}
+	}
+}
+
+static GHashTable *
+fu_quirks_builder_get_kvs (FuQuirksBuilder *builder, const gchar *group_key)
+{
+	GHashTable *kvs = g_hash_table_lookup (builder->hash, group_key);
+	GHashTable *kvs_new;
+
+	/* already writable */
+	if (kvs != NULL && g_hash_table_contains (builder->owned, kvs))
+		return kvs;
+
+	/* new, or a copy of the published group; the strings are interned */
+	kvs_new = g_hash_table_new (g_str_hash, g_str_equal);
+	if (kvs != NULL) {
+		GHashTableIter iter;
+		gpointer key, value;
+		g_hash_table_iter_init (&iter, kvs);
+		while (g_hash_table_iter_next (&iter, &key, &value))
+			g_hash_table_insert (kvs_new, key, value);
+	}
+	g_hash_table_add (builder->owned, kvs_new);
+	g_hash_table_insert (builder->hash,
+			     g_string_chunk_insert_const (builder->strings, group_key),
+			     kvs_new);
+	return kvs_new;
+}
+
+static void
+fu_quirks_builder_clear (FuQuirksBuilder *builder)
+{
+	g_clear_pointer (&builder->hash, g_hash_table_unref);
+	g_clear_pointer (&builder->owned, g_hash_table_unref);
+}
+
+/* must be called with the write mutex held */
+static void
+fu_quirks_builder_publish (FuQuirks *self, FuQuirksBuilder *builder)
+{
+	GHashTable *hash_old;
+
+	/* readers that start after this see the new table */
+	g_mutex_lock (&self->hash_mutex);
+	hash_old = self->hash;
+	self->hash = g_steal_pointer (&builder->hash);
+	g_mutex_unlock (&self->hash_mutex);
+	fu_quirks_builder_clear (builder);
+
+	/* freed now, or when the last reader has finished with it */
+	g_hash_table_unref (hash_old);
+}
+
+/* must be called with the write mutex held */
+static FuQuirksBuilder *
+fu_quirks_get_pending (FuQuirks *self)
+{
+	FuQuirksBuilder *builder = self->pending;
+	if (builder == NULL) {
+		builder = g_new0 (FuQuirksBuilder, 1);
+		fu_quirks_builder_init (builder, self->hash, self->strings);
+		g_atomic_pointer_set (&self->pending, builder);
+	}
+	return builder;
+}
+
+/* must be called with the write mutex held */
+static void
+fu_quirks_clear_pending (FuQuirks *self, gboolean publish)
+{
+	FuQuirksBuilder *builder = self->pending;
+	if (builder == NULL)
+		return;
+	if (publish)
+		fu_quirks_builder_publish (self, builder);
+	else
+		fu_quirks_builder_clear (builder);
+	g_atomic_pointer_set (&self->pending, NULL);
+	g_free (builder);
+}
+
+/* the caller must unref the table when done, which may be the last reference
+ * if the quirks have been reloaded in the meantime */
+static GHashTable *
+fu_quirks_get_hash (FuQuirks *self)
+{
+	GHashTable *hash;
+
+	/* publish any values added one at a time */
+	if (g_atomic_pointer_get (&self->pending) != NULL) {
+		fu_mutex_write_lock (self->write_mutex);
+		fu_quirks_clear_pending (self, TRUE);
+		fu_mutex_write_unlock (self->write_mutex);
+	}
+	g_mutex_lock (&self->hash_mutex);
+	hash = g_hash_table_ref (self->hash);
+	g_mutex_unlock (&self->hash_mutex);
+	return hash;
+}
+
+static GHashTable *
+fu_quirks_lookup_kvs (GHashTable *hash, const gchar *group)
+{
+	const gchar *guid_prefixes[] = { "DeviceInstanceId=", "Guid=", "HwId=", NULL };
+	g_autofree gchar *group_key = NULL;
+
+	/* avoid building the key when it does not need to be hashed */
+	for (guint i = 0; guid_prefixes[i] != NULL; i++) {
+		if (g_str_has_prefix (group, guid_prefixes[i])) {
+			gsize len = strlen (guid_prefixes[i]);
+			if (fwupd_guid_is_valid (group + len))
+				return g_hash_table_lookup (hash, group + len);
+			group_key = fwupd_guid_hash_string (group + len);
+			return g_hash_table_lookup (hash, group_key);
+		}
+	}
+	return g_hash_table_lookup (hash, group);
+}
+
 /**
  * fu_quirks_lookup_by_id:
  * @self: A #FuPlugin
@@ -114,6 +264,7 @@ fu_quirks_build_group_key (const gchar *group)
  * @key: An ID to match the entry, e.g. "Name"
  *
  * Looks up an entry in the hardware database using a string value.
+ * Values are never freed before @self, even if the quirks are reloaded.
  *
  * Returns: (transfer none): values from the database, or %NULL if not found
  *
@@ -122,45 +273,48 @@ fu_quirks_build_group_key (const gchar *group)
 const gchar *
 fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
 {
+	GHashTable *hash;
 	GHashTable *kvs;
-	g_autofree gchar *group_key = NULL;
-	g_autoptr(FuMutexLocker) locker = fu_mutex_read_locker_new (self->hash_mutex);
+	const gchar *value = NULL;
 
 	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
 	g_return_val_if_fail (group != NULL, NULL);
 	g_return_val_if_fail (key != NULL, NULL);
-	g_return_val_if_fail (locker != NULL, NULL);
 
-	group_key = fu_quirks_build_group_key (group);
-	kvs = g_hash_table_lookup (self->hash, group_key);
-	if (kvs == NULL)
-		return NULL;
-	return g_hash_table_lookup (kvs, key);
+	hash = fu_quirks_get_hash (self);
+	kvs = fu_quirks_lookup_kvs (hash, group);
+	if (kvs != NULL)
+		value = g_hash_table_lookup (kvs, key);
+	g_hash_table_unref (hash);
+	return value;
 }
 
 /**
  * fu_quirks_get_kvs_for_guid:
  * @self: A #FuPlugin
  * @guid: a GUID
- * @iter: A #GHashTableIter, typically allocated on the stack by the caller
  *
  * Looks up all entries in the hardware database using a GUID value.
+ * The returned table is never modified, even if the quirks are reloaded, and
+ * the strings in it are valid for the lifetime of @self.
  *
- * Returns: %TRUE if the GUID was found, and @iter was set
+ * Returns: (transfer container) (element-type utf8 utf8): the entries,
+ * or %NULL if the GUID was not found
  *
  * Since: 1.1.2
  **/
-gboolean
-fu_quirks_get_kvs_for_guid (FuQuirks *self, const gchar *guid, GHashTableIter *iter)
+GHashTable *
+fu_quirks_get_kvs_for_guid (FuQuirks *self, const gchar *guid)
 {
 	GHashTable *kvs;
-	g_autoptr(FuMutexLocker) locker = fu_mutex_read_locker_new (self->hash_mutex);
-	g_return_val_if_fail (locker != NULL, FALSE);
-	kvs = g_hash_table_lookup (self->hash, guid);
+	g_autoptr(GHashTable) hash = NULL;
+	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
+	g_return_val_if_fail (guid != NULL, NULL);
+	hash = fu_quirks_get_hash (self);
+	kvs = g_hash_table_lookup (hash, guid);
 	if (kvs == NULL)
-		return FALSE;
-	g_hash_table_iter_init (iter, kvs);
-	return TRUE;
+		return NULL;
+	return g_hash_table_ref (kvs);
 }
 
 static gchar *
@@ -194,54 +348,66 @@ fu_quirks_merge_values (const gchar *old, const gchar *new)
  * Adds a value to the quirk database. Normally this is achieved by loading a
  * quirk file using fu_quirks_load().
  *
+ * Values added together are published when the quirks are next read, so
+ * adding many values only copies the list of groups once.
+ *
  * Since: 1.1.2
  **/
-void
-fu_quirks_add_value (FuQuirks *self, const gchar *group, const gchar *key, const gchar *value)
+static void
+fu_quirks_builder_add_value (FuQuirksBuilder *builder,
+			     const gchar *group,
+			     const gchar *key,
+			     const gchar *value)
 {
 	GHashTable *kvs;
-	const gchar *value_old;
+	const gchar *value_old = NULL;
 	g_autofree gchar *group_key = NULL;
 	g_autofree gchar *value_new = NULL;
-	g_autoptr(FuMutexLocker) locker = fu_mutex_write_locker_new (self->hash_mutex);
-
-	g_return_if_fail (locker != NULL);
 
 	/* does the key already exists in our hash */
 	group_key = fu_quirks_build_group_key (group);
-	kvs = g_hash_table_lookup (self->hash, group_key);
-	if (kvs == NULL) {
-		kvs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-		g_hash_table_insert (self->hash,
-				     g_steal_pointer (&group_key),
-				     kvs);
-		value_new = g_strdup (value);
-	} else {
-		/* look up in the 2nd level hash */
+	kvs = g_hash_table_lookup (builder->hash, group_key);
+
+	/* look up in the 2nd level hash */
+	if (kvs != NULL)
 		value_old = g_hash_table_lookup (kvs, key);
-		if (value_old != NULL) {
-			g_debug ("already found %s=%s, merging with %s",
-				 group_key, value_old, value);
-			value_new = fu_quirks_merge_values (value_old, value);
-		} else {
-			value_new = g_strdup (value);
-		}
+	if (value_old != NULL) {
+		g_debug ("already found %s=%s, merging with %s",
+			 group_key, value_old, value);
+		value_new = fu_quirks_merge_values (value_old, value);
+
+		/* do not copy the group if nothing changed */
+		if (g_strcmp0 (value_new, value_old) == 0)
+			return;
+	} else {
+		value_new = g_strdup (value);
 	}
 
 	/* insert the new value */
-	g_hash_table_insert (kvs, g_strdup (key), g_steal_pointer (&value_new));
+	kvs = fu_quirks_builder_get_kvs (builder, group_key);
+	g_hash_table_insert (kvs,
+			     g_string_chunk_insert_const (builder->strings, key),
+			     g_string_chunk_insert_const (builder->strings, value_new));
+}
+
+void
+fu_quirks_add_value (FuQuirks *self, const gchar *group, const gchar *key, const gchar *value)
+{
+	g_return_if_fail (FU_IS_QUIRKS (self));
+	g_return_if_fail (group != NULL);
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (value != NULL);
+
+	fu_mutex_write_lock (self->write_mutex);
+	fu_quirks_builder_add_value (fu_quirks_get_pending (self), group, key, value);
+	fu_mutex_write_unlock (self->write_mutex);
 }
 
 static gboolean
-fu_quirks_add_quirks_from_filename (FuQuirks *self, const gchar *filename, GError **error)
+fu_quirks_builder_add_keyfile (FuQuirksBuilder *builder, GKeyFile *kf, GError **error)
 {
-	g_autoptr(GKeyFile) kf = g_key_file_new ();
 	g_auto(GStrv) groups = NULL;
 
-	/* load keyfile */
-	if (!g_key_file_load_from_file (kf, filename, G_KEY_FILE_NONE, error))
-		return FALSE;
-
 	/* add each set of groups and keys */
 	groups = g_key_file_get_groups (kf, NULL);
 	for (guint i = 0; groups[i] != NULL; i++) {
@@ -255,12 +421,64 @@ fu_quirks_add_quirks_from_filename (FuQuirks *self, const gchar *filename, GErro
 			value = g_key_file_get_value (kf, groups[i], keys[j], error);
 			if (value == NULL)
 				return FALSE;
-			fu_quirks_add_value (self, groups[i], keys[j], value);
+			fu_quirks_builder_add_value (builder, groups[i], keys[j], value);
 		}
 	}
 	return TRUE;
 }
 
+static gboolean
+fu_quirks_builder_add_filename (FuQuirksBuilder *builder, const gchar *filename, GError **error)
+{
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+	if (!g_key_file_load_from_file (kf, filename, G_KEY_FILE_NONE, error))
+		return FALSE;
+	return fu_quirks_builder_add_keyfile (builder, kf, error);
+}
+
+/**
+ * fu_quirks_add_quirks_from_data: (skip)
+ * @self: A #FuQuirks
+ * @data: The contents of a quirk file
+ * @length: The size of @data, or -1 if it is NUL terminated
+ * @error: A #GError, or %NULL
+ *
+ * Adds quirks in the same format as the files installed into `quirks.d`,
+ * without removing any that have already been loaded.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_quirks_add_quirks_from_data (FuQuirks *self,
+				const gchar *data,
+				gssize length,
+				GError **error)
+{
+	FuQuirksBuilder builder;
+	gboolean ret;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), FALSE);
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	if (!g_key_file_load_from_data (kf, data, length, G_KEY_FILE_NONE, error))
+		return FALSE;
+
+	/* nothing is published unless the whole file is valid */
+	fu_mutex_write_lock (self->write_mutex);
+	fu_quirks_clear_pending (self, TRUE);
+	fu_quirks_builder_init (&builder, self->hash, self->strings);
+	ret = fu_quirks_builder_add_keyfile (&builder, kf, error);
+	if (ret)
+		fu_quirks_builder_publish (self, &builder);
+	else
+		fu_quirks_builder_clear (&builder);
+	fu_mutex_write_unlock (self->write_mutex);
+	return ret;
+}
+
 static gint
 fu_quirks_filename_sort_cb (gconstpointer a, gconstpointer b)
 {
@@ -270,12 +488,12 @@ fu_quirks_filename_sort_cb (gconstpointer a, gconstpointer b)
 }
 
 static gboolean
-fu_quirks_add_quirks_for_path (FuQuirks *self, const gchar *path, GError **error)
+fu_quirks_add_filenames_for_path (GPtrArray *filenames, const gchar *path, GError **error)
 {
 	const gchar *tmp;
 	g_autofree gchar *path_hw = NULL;
 	g_autoptr(GDir) dir = NULL;
-	g_autoptr(GPtrArray) filenames = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) filenames_tmp = g_ptr_array_new ();
 
 	/* add valid files to the array */
 	path_hw = g_build_filename (path, "quirks.d", NULL);
@@ -291,19 +509,64 @@ fu_quirks_add_quirks_for_path (FuQuirks *self, const gchar *path, GError **error
 			g_debug ("skipping invalid file %s", tmp);
 			continue;
 		}
-		g_ptr_array_add (filenames, g_build_filename (path_hw, tmp, NULL));
+		g_ptr_array_add (filenames_tmp, g_build_filename (path_hw, tmp, NULL));
 	}
 
 	/* sort */
-	g_ptr_array_sort (filenames, fu_quirks_filename_sort_cb);
+	g_ptr_array_sort (filenames_tmp, fu_quirks_filename_sort_cb);
+	for (guint i = 0; i < filenames_tmp->len; i++)
+		g_ptr_array_add (filenames, g_ptr_array_index (filenames_tmp, i));
+	return TRUE;
+}
+
+static GPtrArray *
+fu_quirks_get_filenames (GError **error)
+{
+	g_autofree gchar *datadir = NULL;
+	g_autofree gchar *localstatedir = NULL;
+	g_autoptr(GPtrArray) filenames = g_ptr_array_new_with_free_func (g_free);
+
+	/* system datadir */
+	datadir = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
+	if (!fu_quirks_add_filenames_for_path (filenames, datadir, error))
+		return NULL;
+
+	/* something we can write when using Ostree */
+	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	if (!fu_quirks_add_filenames_for_path (filenames, localstatedir, error))
+		return NULL;
+
+	/* success */
+	return g_steal_pointer (&filenames);
+}
+
+/**
+ * fu_quirks_load: (skip)
+ * @self: A #FuQuirks
+ * @error: A #GError, or %NULL
+ *
+ * Loads the various files that define the hardware quirks used in plugins,
+ * replacing any quirks that were previously loaded.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.0.1
+ **/
+static gboolean
+fu_quirks_builder_add_filenames (FuQuirks *self, FuQuirksBuilder *builder, GError **error)
+{
+	g_autoptr(GPtrArray) filenames = NULL;
 
 	/* process files */
+	filenames = fu_quirks_get_filenames (error);
+	if (filenames == NULL)
+		return FALSE;
 	for (guint i = 0; i < filenames->len; i++) {
 		const gchar *filename = g_ptr_array_index (filenames, i);
 
 		/* load from keyfile */
 		g_debug ("loading quirks from %s", filename);
-		if (!fu_quirks_add_quirks_from_filename (self, filename, error)) {
+		if (!fu_quirks_builder_add_filename (builder, filename, error)) {
 			g_prefix_error (error, "failed to load %s: ", filename);
 			return FALSE;
 		}
@@ -312,51 +575,195 @@ fu_quirks_add_quirks_for_path (FuQuirks *self, const gchar *path, GError **error
 		if (!fu_quirks_add_inotify (self, filename, error))
 			return FALSE;
 	}
+	return TRUE;
+}
+
+gboolean
+fu_quirks_load (FuQuirks *self, GError **error)
+{
+	FuQuirksBuilder builder;
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), FALSE);
+
+	/* start from empty in case we're called from a monitor change, but keep
+	 * using the existing quirks until the new ones are ready */
+	fu_mutex_write_lock (self->write_mutex);
+	fu_quirks_clear_pending (self, FALSE);
+	g_ptr_array_set_size (self->monitors, 0);
+	fu_quirks_builder_init (&builder, NULL, self->strings);
+	if (!fu_quirks_builder_add_filenames (self, &builder, error)) {
+		fu_quirks_builder_clear (&builder);
+		fu_mutex_write_unlock (self->write_mutex);
+		return FALSE;
+	}
 
 	/* success */
-	g_debug ("now %u quirk entries", g_hash_table_size (self->hash));
+	g_debug ("now %u quirk entries", g_hash_table_size (builder.hash));
+	fu_quirks_builder_publish (self, &builder);
+	fu_mutex_write_unlock (self->write_mutex);
 	return TRUE;
 }
 
 /**
- * fu_quirks_load: (skip)
+ * fu_quirks_get_checksum: (skip)
+ * @self: A #FuQuirks
+ * @error: A #GError, or %NULL
+ *
+ * Gets a checksum of the names, sizes and modification times of all the
+ * quirk files that would be loaded by fu_quirks_load().
+ *
+ * Returns: a SHA1 hash, or %NULL for error
+ *
+ * Since: 1.2.6
+ **/
+gchar *
+fu_quirks_get_checksum (FuQuirks *self, GError **error)
+{
+	g_autoptr(GChecksum) csum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_autoptr(GPtrArray) filenames = NULL;
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
+
+	filenames = fu_quirks_get_filenames (error);
+	if (filenames == NULL)
+		return NULL;
+	for (guint i = 0; i < filenames->len; i++) {
+		const gchar *filename = g_ptr_array_index (filenames, i);
+		g_autofree gchar *str = NULL;
+		g_autoptr(GFile) file = g_file_new_for_path (filename);
+		g_autoptr(GFileInfo) info = NULL;
+		info = g_file_query_info (file,
+					  G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+					  G_FILE_ATTRIBUTE_TIME_MODIFIED,
+					  G_FILE_QUERY_INFO_NONE,
+					  NULL, error);
+		if (info == NULL)
+			return NULL;
+		str = g_strdup_printf ("%s:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT ";",
+				       filename,
+				       (guint64) g_file_info_get_size (info),
+				       g_file_info_get_attribute_uint64 (info,
+									 G_FILE_ATTRIBUTE_TIME_MODIFIED));
+		g_checksum_update (csum, (const guchar *) str, -1);
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+/**
+ * fu_quirks_load_from_keyfile: (skip)
  * @self: A #FuQuirks
+ * @keyfile: A #GKeyFile
  * @error: A #GError, or %NULL
  *
- * Loads the various files that define the hardware quirks used in plugins.
+ * Restores the quirk database saved with fu_quirks_to_keyfile(), which avoids
+ * parsing every quirk file and hashing every instance ID. The caller is
+ * responsible for checking the files have not changed using
+ * fu_quirks_get_checksum().
  *
  * Returns: %TRUE for success
  *
- * Since: 1.0.1
+ * Since: 1.2.6
  **/
 gboolean
-fu_quirks_load (FuQuirks *self, GError **error)
+fu_quirks_load_from_keyfile (FuQuirks *self, GKeyFile *keyfile, GError **error)
 {
-	g_autofree gchar *datadir = NULL;
-	g_autofree gchar *localstatedir = NULL;
+	FuQuirksBuilder builder;
+	guint cnt;
+	g_auto(GStrv) groups = NULL;
+	g_autoptr(GPtrArray) filenames = NULL;
 
 	g_return_val_if_fail (FU_IS_QUIRKS (self), FALSE);
+	g_return_val_if_fail (keyfile != NULL, FALSE);
 
-	/* ensure empty in case we're called from a monitor change */
+	fu_mutex_write_lock (self->write_mutex);
+	fu_quirks_clear_pending (self, FALSE);
 	g_ptr_array_set_size (self->monitors, 0);
-	fu_mutex_write_lock (self->hash_mutex);
-	g_hash_table_remove_all (self->hash);
-	fu_mutex_write_unlock (self->hash_mutex);
+	fu_quirks_builder_init (&builder, NULL, self->strings);
 
-	/* system datadir */
-	datadir = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
-	if (!fu_quirks_add_quirks_for_path (self, datadir, error))
-		return FALSE;
+	/* the group keys have already been converted to GUIDs */
+	groups = g_key_file_get_groups (keyfile, NULL);
+	for (guint i = 0; groups[i] != NULL; i++) {
+		GHashTable *kvs;
+		g_auto(GStrv) keys = NULL;
+		if (!g_str_has_prefix (groups[i], "Quirk "))
+			continue;
+		keys = g_key_file_get_keys (keyfile, groups[i], NULL, error);
+		if (keys == NULL) {
+			fu_quirks_builder_clear (&builder);
+			fu_mutex_write_unlock (self->write_mutex);
+			return FALSE;
+		}
+		kvs = fu_quirks_builder_get_kvs (&builder, groups[i] + 6);
+		for (guint j = 0; keys[j] != NULL; j++) {
+			g_autofree gchar *value = NULL;
+			value = g_key_file_get_value (keyfile, groups[i], keys[j], NULL);
+			if (value == NULL)
+				continue;
+			g_hash_table_insert (kvs,
+					     g_string_chunk_insert_const (self->strings, keys[j]),
+					     g_string_chunk_insert_const (self->strings, value));
+		}
+	}
 
-	/* something we can write when using Ostree */
-	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
-	if (!fu_quirks_add_quirks_for_path (self, localstatedir, error))
+	/* still watch the files for changes */
+	filenames = fu_quirks_get_filenames (error);
+	if (filenames == NULL) {
+		fu_quirks_builder_clear (&builder);
+		fu_mutex_write_unlock (self->write_mutex);
 		return FALSE;
+	}
+	for (guint i = 0; i < filenames->len; i++) {
+		const gchar *filename = g_ptr_array_index (filenames, i);
+		if (!fu_quirks_add_inotify (self, filename, error)) {
+			fu_quirks_builder_clear (&builder);
+			fu_mutex_write_unlock (self->write_mutex);
+			return FALSE;
+		}
+	}
 
 	/* success */
+	cnt = g_hash_table_size (builder.hash);
+	fu_quirks_builder_publish (self, &builder);
+	fu_mutex_write_unlock (self->write_mutex);
+	g_debug ("restored %u quirk entries", cnt);
 	return TRUE;
 }
 
+/**
+ * fu_quirks_to_keyfile: (skip)
+ * @self: A #FuQuirks
+ * @keyfile: A #GKeyFile
+ *
+ * Saves the quirk database so it can be restored using
+ * fu_quirks_load_from_keyfile().
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_quirks_to_keyfile (FuQuirks *self, GKeyFile *keyfile)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	g_autoptr(GHashTable) hash = NULL;
+
+	g_return_if_fail (FU_IS_QUIRKS (self));
+	g_return_if_fail (keyfile != NULL);
+
+	hash = fu_quirks_get_hash (self);
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		GHashTableIter iter_kvs;
+		gpointer key_kv, value_kv;
+		g_autofree gchar *group = g_strdup_printf ("Quirk %s", (const gchar *) key);
+		g_hash_table_iter_init (&iter_kvs, (GHashTable *) value);
+		while (g_hash_table_iter_next (&iter_kvs, &key_kv, &value_kv)) {
+			g_key_file_set_value (keyfile, group,
+					      (const gchar *) key_kv,
+					      (const gchar *) value_kv);
+		}
+	}
+}
+
 static void
 fu_quirks_class_init (FuQuirksClass *klass)
 {
@@ -368,17 +775,22 @@ static void
 fu_quirks_init (FuQuirks *self)
 {
 	self->monitors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	self->hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
-	self->hash_mutex = fu_mutex_new (G_OBJECT_TYPE_NAME(self), "hash");
+	self->hash = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_hash_table_unref);
+	self->strings = g_string_chunk_new (1024);
+	g_mutex_init (&self->hash_mutex);
+	self->write_mutex = fu_mutex_new (G_OBJECT_TYPE_NAME(self), "write");
 }
 
 static void
 fu_quirks_finalize (GObject *obj)
 {
 	FuQuirks *self = FU_QUIRKS (obj);
+	fu_quirks_clear_pending (self, FALSE);
 	g_ptr_array_unref (self->monitors);
-	g_object_unref (self->hash_mutex);
+	g_object_unref (self->write_mutex);
 	g_hash_table_unref (self->hash);
+	g_mutex_clear (&self->hash_mutex);
+	g_string_chunk_free (self->strings);
 	G_OBJECT_CLASS (fu_quirks_parent_class)->finalize (obj);
 }
 
@@ -17,6 +17,17 @@ G_DECLARE_FINAL_TYPE (FuQuirks, fu_quirks, FU, QUIRKS, GObject)
 FuQuirks	*fu_quirks_new				(void);
 gboolean	 fu_quirks_load				(FuQuirks	*self,
 							 GError		**error);
+gboolean	 fu_quirks_load_from_keyfile		(FuQuirks	*self,
+							 GKeyFile	*keyfile,
+							 GError		**error);
+gboolean	 fu_quirks_add_quirks_from_data		(FuQuirks	*self,
+							 const gchar	*data,
+							 gssize		 length,
+							 GError		**error);
+void		 fu_quirks_to_keyfile			(FuQuirks	*self,
+							 GKeyFile	*keyfile);
+gchar		*fu_quirks_get_checksum			(FuQuirks	*self,
+							 GError		**error);
 const gchar	*fu_quirks_lookup_by_id			(FuQuirks	*self,
 							 const gchar	*group,
 							 const gchar	*key);
@@ -24,9 +35,8 @@ void		 fu_quirks_add_value			(FuQuirks	*self,
 							 const gchar	*group,
 							 const gchar	*key,
 							 const gchar	*value);
-gboolean	 fu_quirks_get_kvs_for_guid		(FuQuirks	*self,
-							 const gchar	*guid,
-							 GHashTableIter *iter);
+GHashTable	*fu_quirks_get_kvs_for_guid		(FuQuirks	*self,
+							 const gchar	*guid);
 
 #define	FU_QUIRKS_PLUGIN			"Plugin"
 #define	FU_QUIRKS_UEFI_VERSION_FORMAT		"UefiVersionFormat"
@@ -4,6 +4,9 @@
  * SPDX-License-Identifier: LGPL-2.1+
  */
 
+/* for memfd_create() */
+#define _GNU_SOURCE
+
 #include "config.h"
 
 #include <xmlb.h>
@@ -14,6 +17,9 @@
 #include <libgcab.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "fu-archive.h"
 #include "fu-common-cab.h"
@@ -27,13 +33,20 @@
 #include "fu-keyring.h"
 #include "fu-history.h"
 #include "fu-install-task.h"
+#include "fu-plugin-builtin.h"
 #include "fu-plugin-private.h"
 #include "fu-plugin-list.h"
 #include "fu-progressbar.h"
 #include "fu-hash.h"
 #include "fu-hwids.h"
 #include "fu-smbios.h"
+#include "fu-snapshot.h"
+#include "fu-stats.h"
+#include "fu-trace.h"
 #include "fu-test.h"
+#include "fu-usb-device.h"
+
+#include "fwupd-remote-private.h"
 
 #ifdef ENABLE_GPG
 #include "fu-keyring-gpg.h"
@@ -655,6 +668,84 @@ fu_engine_require_hwid_func (void)
 	g_assert (!ret);
 }
 
+static void
+fu_engine_update_metadata_func (void)
+{
+	FwupdRemote *remote;
+	gboolean ret;
+	gint fd;
+	gint fd_sig;
+	g_autofree gchar *sig = NULL;
+	g_autofree gchar *testdatadir = NULL;
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* ensure empty tree */
+	fu_self_test_mkroot ();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo (engine, silo_empty);
+
+	/* metadata and signature saved by a previous refresh */
+	ret = g_file_set_contents ("/tmp/fwupd-self-test/stable.xml",
+				   "<components/>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_set_contents ("/tmp/fwupd-self-test/stable.xml.asc",
+				   "old signature", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_set_contents ("/tmp/fwupd-self-test/new.xml.asc",
+				   "new signature", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	testdatadir = fu_test_get_filename (TESTDATADIR, ".");
+	g_assert (testdatadir != NULL);
+	g_setenv ("FU_SELF_TEST_REMOTES_DIR", testdatadir, TRUE);
+	ret = fu_engine_load (engine, FU_ENGINE_LOAD_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	remote = fu_engine_get_remote_by_id (engine, "stable", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (remote);
+	g_assert_cmpint (fwupd_remote_get_keyring_kind (remote), ==, FWUPD_KEYRING_KIND_GPG);
+	g_assert_cmpstr (fwupd_remote_get_filename_cache_sig (remote), ==,
+			 "/tmp/fwupd-self-test/stable.xml.asc");
+	fwupd_remote_set_mtime (remote, 0);
+	g_assert_cmpint (fwupd_remote_get_age (remote), >, 60);
+
+	/* unchanged, so nothing is verified but the age is reset */
+	fd = g_open ("/tmp/fwupd-self-test/stable.xml", O_RDONLY, 0);
+	g_assert_cmpint (fd, >, 0);
+	fd_sig = g_open ("/tmp/fwupd-self-test/stable.xml.asc", O_RDONLY, 0);
+	g_assert_cmpint (fd_sig, >, 0);
+	ret = fu_engine_update_metadata (engine, "stable", fd, fd_sig, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (fwupd_remote_get_age (remote), <, 60);
+
+	/* re-signed, so the new signature has to be verified */
+	fwupd_remote_set_mtime (remote, 0);
+	fd = g_open ("/tmp/fwupd-self-test/stable.xml", O_RDONLY, 0);
+	g_assert_cmpint (fd, >, 0);
+	fd_sig = g_open ("/tmp/fwupd-self-test/new.xml.asc", O_RDONLY, 0);
+	g_assert_cmpint (fd_sig, >, 0);
+	ret = fu_engine_update_metadata (engine, "stable", fd, fd_sig, &error);
+	g_assert_nonnull (error);
+	g_assert_false (ret);
+	g_clear_error (&error);
+
+	/* the old signature is kept and the remote is not touched */
+	ret = g_file_get_contents ("/tmp/fwupd-self-test/stable.xml.asc",
+				   &sig, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (sig, ==, "old signature");
+	g_assert_cmpint (fwupd_remote_get_age (remote), >, 60);
+}
+
 static void
 fu_engine_downgrade_func (void)
 {
@@ -1648,6 +1739,59 @@ fu_device_version_format_func (void)
 	g_assert_cmpstr (fu_device_get_version (device), ==, "1.2.3");
 }
 
+static void
+fu_device_guids_func (void)
+{
+	g_autoptr(FuDevice) device = fu_device_new ();
+
+	/* instance IDs are hashed, GUIDs are compared as binary */
+	fu_device_add_guid (device, "2082B5E0-7A64-478A-B1B2-E3404FAB6DAD");
+	fu_device_add_guid (device, "2082b5e0-7a64-478a-b1b2-e3404fab6dad");
+	fu_device_add_counterpart_guid (device, "USB\\VID_273F&PID_1004");
+	g_assert_cmpint (fwupd_device_get_guids (FWUPD_DEVICE (device))->len, ==, 2);
+	g_assert_true (fu_device_has_guid (device, "2082b5e0-7a64-478a-b1b2-e3404fab6dad"));
+	g_assert_true (fu_device_has_guid (device, "2082B5E0-7A64-478A-B1B2-E3404FAB6DAD"));
+	g_assert_true (fu_device_has_guid (device, "USB\\VID_273F&PID_1004"));
+	g_assert_true (fu_device_has_guid (device, "2fa8891f-3ece-53a4-adc4-0dd875685f30"));
+	g_assert_false (fu_device_has_guid (device, "USB\\VID_273F&PID_1005"));
+	g_assert_false (fu_device_has_guid (device, ""));
+	g_assert_false (fu_device_has_guid (device, NULL));
+}
+
+static void
+fu_device_guids_perf_func (void)
+{
+	const guint iterations = 100000;
+	gdouble elapsed;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(GPtrArray) instance_ids = g_ptr_array_new_with_free_func (g_free);
+
+	/* a typical device has a handful of instance IDs */
+	for (guint i = 0; i < 8; i++) {
+		g_ptr_array_add (instance_ids,
+				 g_strdup_printf ("USB\\VID_273F&PID_%04X", i));
+	}
+
+	g_test_timer_start ();
+	for (guint i = 0; i < iterations; i++) {
+		const gchar *instance_id = g_ptr_array_index (instance_ids, i % instance_ids->len);
+		fu_device_add_instance_id (device, instance_id);
+	}
+	elapsed = g_test_timer_elapsed ();
+	g_test_minimized_result (elapsed, "add_instance_id: %.0f calls/s",
+				 iterations / elapsed);
+	fu_device_convert_instance_ids (device);
+
+	g_test_timer_start ();
+	for (guint i = 0; i < iterations; i++) {
+		const gchar *instance_id = g_ptr_array_index (instance_ids, i % instance_ids->len);
+		g_assert_true (fu_device_has_guid (device, instance_id));
+	}
+	elapsed = g_test_timer_elapsed ();
+	g_test_minimized_result (elapsed, "has_guid: %.0f calls/s",
+				 iterations / elapsed);
+}
+
 static void
 fu_device_open_refcount_func (void)
 {
@@ -1765,6 +1909,32 @@ fu_smbios3_func (void)
 	g_assert_cmpstr (str, ==, "Dell Inc.");
 }
 
+static void
+fu_smbios_truncated_func (void)
+{
+	gboolean ret;
+	gsize sz = 0;
+	g_autofree gchar *buf = NULL;
+	g_autofree gchar *path = NULL;
+	g_autoptr(GError) error = NULL;
+
+	path = fu_test_get_filename (TESTDATADIR, "dmi/tables64/DMI");
+	g_assert_nonnull (path);
+	ret = g_file_get_contents (path, &buf, &sz, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* no table can be read past the end of the data */
+	for (gsize i = 0; i < MIN (sz, 0x200); i++) {
+		g_autoptr(FuSmbios) smbios = fu_smbios_new ();
+		g_autoptr(GError) error_local = NULL;
+		g_autofree gchar *dump = NULL;
+		fu_smbios_setup_from_data (smbios, (const guint8 *) buf, i, &error_local);
+		dump = fu_smbios_to_string (smbios);
+		g_assert_nonnull (dump);
+	}
+}
+
 static void
 fu_hwids_func (void)
 {
@@ -1831,6 +2001,84 @@ fu_hwids_func (void)
 		g_assert (fu_hwids_has_guid (hwids, guids[i].value));
 }
 
+static void
+fu_snapshot_func (void)
+{
+	const gchar *keys[] = { FU_SNAPSHOT_KEY_DMI_CHECKSUM,
+				FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM,
+				NULL };
+	const gchar *fn = "/tmp/fwupd-self-test/startup.snapshot";
+	const gchar *tmp;
+	gboolean ret;
+	g_autofree gchar *quirks_csum = NULL;
+	g_autoptr(FuHwids) hwids = fu_hwids_new ();
+	g_autoptr(FuHwids) hwids2 = fu_hwids_new ();
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(FuQuirks) quirks2 = fu_quirks_new ();
+	g_autoptr(FuSmbios) smbios = fu_smbios_new ();
+	g_autoptr(FuSnapshot) snapshot = fu_snapshot_new ();
+	g_autoptr(FuSnapshot) snapshot2 = fu_snapshot_new ();
+	g_autoptr(FuSnapshot) snapshot3 = fu_snapshot_new ();
+	g_autoptr(GError) error = NULL;
+
+	ret = fu_smbios_setup (smbios, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_nonnull (fu_smbios_get_checksum (smbios));
+	ret = fu_hwids_setup (hwids, smbios, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_quirks_load (quirks, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	quirks_csum = fu_quirks_get_checksum (quirks, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (quirks_csum);
+
+	/* nothing saved yet */
+	fu_snapshot_set_key (snapshot, FU_SNAPSHOT_KEY_DMI_CHECKSUM,
+			     fu_smbios_get_checksum (smbios));
+	fu_snapshot_set_key (snapshot, FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM, quirks_csum);
+	g_assert_false (fu_snapshot_has_valid_keys (snapshot, keys));
+	fu_hwids_to_keyfile (hwids, fu_snapshot_get_current (snapshot));
+	fu_quirks_to_keyfile (quirks, fu_snapshot_get_current (snapshot));
+	ret = fu_snapshot_save (snapshot, fn, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* same keys, so restore */
+	ret = fu_snapshot_load (snapshot2, fn, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fu_snapshot_set_key (snapshot2, FU_SNAPSHOT_KEY_DMI_CHECKSUM,
+			     fu_smbios_get_checksum (smbios));
+	fu_snapshot_set_key (snapshot2, FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM, quirks_csum);
+	g_assert_true (fu_snapshot_has_valid_keys (snapshot2, keys));
+	ret = fu_hwids_setup_from_keyfile (hwids2, fu_snapshot_get_previous (snapshot2), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (fu_hwids_get_value (hwids2, FU_HWIDS_KEY_BIOS_VERSION), ==,
+			 "GJET75WW (2.25 )");
+	g_assert_cmpint (fu_hwids_get_guids (hwids2)->len, ==,
+			 fu_hwids_get_guids (hwids)->len);
+	g_assert_true (fu_hwids_has_guid (hwids2, "147efce9-f201-5fc8-ab0c-c859751c3440"));
+	ret = fu_quirks_load_from_keyfile (quirks2, fu_snapshot_get_previous (snapshot2), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	tmp = fu_quirks_lookup_by_id (quirks2, "USB\\VID_0A5C&PID_6412", "Flags");
+	g_assert_cmpstr (tmp, ==, "MERGE_ME,ignore-runtime");
+	tmp = fu_quirks_lookup_by_id (quirks2, "CORP*", "Test");
+	g_assert_cmpstr (tmp, ==, "town");
+
+	/* different hardware */
+	ret = fu_snapshot_load (snapshot3, fn, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fu_snapshot_set_key (snapshot3, FU_SNAPSHOT_KEY_DMI_CHECKSUM, "deadbeef");
+	fu_snapshot_set_key (snapshot3, FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM, quirks_csum);
+	g_assert_false (fu_snapshot_has_valid_keys (snapshot3, keys));
+}
+
 static void
 _plugin_status_changed_cb (FuDevice *device, GParamSpec *pspec, gpointer user_data)
 {
@@ -1887,6 +2135,207 @@ _plugin_device_register_cb (FuPlugin *plugin, FuDevice *device, gpointer user_da
 	fu_plugin_runner_device_register (plugin, device);
 }
 
+static void
+fu_plugin_manifest_func (void)
+{
+	gboolean ret;
+	const gchar *data =
+		"[fwupd Plugin]\n"
+		"InstanceIds=USB\\VID_273F&PID_1004;\n"
+		"UdevSubsystems=hidraw;\n"
+		"RunAfter=upower;\n"
+		"RequiresQuirk=Plugin;\n";
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) udev_subsystems = g_ptr_array_new_with_free_func (g_free);
+
+	/* load the manifest without opening the module */
+	ret = g_file_set_contents ("/tmp/fwupd-self-test/test.manifest", data, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fu_plugin_set_name (plugin, "test");
+	fu_plugin_set_udev_subsystems (plugin, udev_subsystems);
+	ret = fu_plugin_load_manifest (plugin, "/tmp/fwupd-self-test/test.manifest", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (fu_plugin_get_lazy (plugin));
+	g_assert_false (fu_plugin_is_loaded (plugin));
+	g_assert_true (fu_plugin_has_rule (plugin, FU_PLUGIN_RULE_RUN_AFTER, "upower"));
+	g_assert_true (fu_plugin_has_rule (plugin, FU_PLUGIN_RULE_REQUIRES_QUIRK, FU_QUIRKS_PLUGIN));
+	g_assert_cmpint (udev_subsystems->len, ==, 1);
+	g_assert_cmpstr (g_ptr_array_index (udev_subsystems, 0), ==, "hidraw");
+
+	/* only matching hardware */
+	g_assert_false (fu_plugin_manifest_matches_device (plugin, device));
+	fu_device_add_instance_id (device, "USB\\VID_273F&PID_1004");
+	fu_device_convert_instance_ids (device);
+	g_assert_true (fu_plugin_manifest_matches_device (plugin, device));
+
+	/* can be opened again after being unloaded */
+	ret = fu_plugin_open (plugin, PLUGINBUILDDIR "/libfu_plugin_test.so", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (fu_plugin_is_loaded (plugin));
+	fu_plugin_unload (plugin);
+	g_assert_false (fu_plugin_is_loaded (plugin));
+	ret = fu_plugin_open (plugin, fu_plugin_get_filename (plugin), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (fu_plugin_is_loaded (plugin));
+}
+
+static void
+fu_test_plugin_builtin_init (FuPlugin *plugin)
+{
+	fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_RUN_AFTER, "upower");
+}
+
+static void
+fu_plugin_builtin_func (void)
+{
+	gboolean ret;
+	gpointer vfuncs[FU_PLUGIN_HOOK_LAST] = {
+		[FU_PLUGIN_HOOK_INIT] = (gpointer) fu_test_plugin_builtin_init,
+	};
+	g_autofree const gchar **names = fu_plugin_builtin_get_names ();
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(GError) error = NULL;
+
+	/* nothing linked into the self tests */
+	g_assert_null (names[0]);
+	g_assert_null (fu_plugin_builtin_get_vfuncs ("test"));
+
+	/* opened without a module */
+	fu_plugin_set_name (plugin, "builtin");
+	fu_plugin_set_builtin (plugin, (const gpointer *) vfuncs);
+	g_assert_true (fu_plugin_get_builtin (plugin));
+	ret = fu_plugin_open (plugin, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (fu_plugin_is_loaded (plugin));
+	g_assert_true (fu_plugin_has_rule (plugin, FU_PLUGIN_RULE_RUN_AFTER, "upower"));
+	g_assert_true (fu_plugin_has_hook (plugin, FU_PLUGIN_HOOK_INIT));
+	g_assert_false (fu_plugin_has_hook (plugin, FU_PLUGIN_HOOK_COLDPLUG));
+	g_assert_cmpstr (fu_plugin_get_name (plugin), ==, "builtin");
+
+	/* and again after being unloaded */
+	fu_plugin_unload (plugin);
+	g_assert_false (fu_plugin_is_loaded (plugin));
+	ret = fu_plugin_open (plugin, fu_plugin_get_filename (plugin), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (fu_plugin_is_loaded (plugin));
+}
+
+static void
+fu_trace_func (void)
+{
+	gboolean ret;
+	g_autofree gchar *newest = NULL;
+	g_autofree gchar *str = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* disabled */
+	fu_trace_begin ("test", "ignored", NULL);
+	g_assert_false (fu_trace_get_enabled ());
+	g_assert_null (fu_trace_span_new ("test", "ignored", NULL));
+
+	/* record some nested spans */
+	fu_trace_set_filename ("/tmp/fwupd-self-test/trace.json");
+	g_assert_true (fu_trace_get_enabled ());
+	fu_trace_begin ("test", "outer", NULL);
+	{
+		g_autoptr(FuTraceSpan) span = fu_trace_span_new ("test", "inner", "a\"b");
+		g_assert_nonnull (span);
+	}
+	fu_trace_counter ("test", "devices", 42);
+	fu_trace_end ("test", "outer", NULL);
+	str = fu_trace_to_string ();
+	g_assert_null (g_strstr_len (str, -1, "ignored"));
+	g_assert_nonnull (g_strstr_len (str, -1, "\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"B\""));
+	g_assert_nonnull (g_strstr_len (str, -1, "\"name\":\"inner(a\\\"b)\",\"cat\":\"test\",\"ph\":\"E\""));
+	g_assert_nonnull (g_strstr_len (str, -1, "\"args\":{\"devices\":42}"));
+	ret = fu_trace_save (&error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (g_file_test ("/tmp/fwupd-self-test/trace.json", G_FILE_TEST_EXISTS));
+
+	/* only the newest events are kept */
+	fu_trace_clear ();
+	fu_trace_counter ("test", "oldest", 1);
+	for (guint i = 0; i < FU_TRACE_EVENTS_MAX; i++)
+		fu_trace_counter ("test", "newer", i);
+	g_free (str);
+	str = fu_trace_to_string ();
+	g_assert_null (g_strstr_len (str, -1, "oldest"));
+	g_assert_nonnull (g_strstr_len (str, -1, "\"args\":{\"newer\":0}"));
+	newest = g_strdup_printf ("\"args\":{\"newer\":%u}", (guint) FU_TRACE_EVENTS_MAX - 1);
+	g_assert_nonnull (g_strstr_len (str, -1, newest));
+
+	/* stop recording for the other tests */
+	fu_trace_clear ();
+	fu_trace_set_filename (NULL);
+	g_assert_false (fu_trace_get_enabled ());
+}
+
+static void
+fu_stats_func (void)
+{
+	guint64 count = 0;
+	guint64 total = 0;
+	guint64 min = 0;
+	guint64 max = 0;
+	gsize n_elements = 0;
+	const guint64 *histogram;
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuStats) stats = fu_stats_new ();
+	g_autoptr(GVariant) dict = NULL;
+	g_autoptr(GVariant) dict_bytes = NULL;
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariant) val_histogram = NULL;
+
+	/* durations go into buckets */
+	fu_stats_add_duration (stats, "install.write", 500);
+	fu_stats_add_duration (stats, "install.write", 25000);
+	fu_stats_add_duration (stats, "install.write", 20 * G_USEC_PER_SEC);
+	fu_stats_add_value (stats, "install.write-bytes", 1024);
+	fu_stats_add_value (stats, "install.write-bytes", 2048);
+
+	val = g_variant_ref_sink (fu_stats_to_variant (stats));
+	g_assert_cmpint (g_variant_n_children (val), ==, 2);
+	dict = g_variant_lookup_value (val, "install.write", G_VARIANT_TYPE_VARDICT);
+	g_assert_nonnull (dict);
+	g_assert_true (g_variant_lookup (dict, "Count", "t", &count));
+	g_assert_true (g_variant_lookup (dict, "Total", "t", &total));
+	g_assert_true (g_variant_lookup (dict, "Min", "t", &min));
+	g_assert_true (g_variant_lookup (dict, "Max", "t", &max));
+	g_assert_cmpint (count, ==, 3);
+	g_assert_cmpint (total, ==, 20025500);
+	g_assert_cmpint (min, ==, 500);
+	g_assert_cmpint (max, ==, 20 * G_USEC_PER_SEC);
+	val_histogram = g_variant_lookup_value (dict, "Histogram", G_VARIANT_TYPE ("at"));
+	g_assert_nonnull (val_histogram);
+	histogram = g_variant_get_fixed_array (val_histogram, &n_elements, sizeof (guint64));
+	g_assert_cmpint (n_elements, ==, 6);
+	g_assert_cmpint (histogram[0], ==, 1);
+	g_assert_cmpint (histogram[2], ==, 1);
+	g_assert_cmpint (histogram[5], ==, 1);
+
+	/* values have no histogram */
+	dict_bytes = g_variant_lookup_value (val, "install.write-bytes", G_VARIANT_TYPE_VARDICT);
+	g_assert_nonnull (dict_bytes);
+	g_assert_true (g_variant_lookup (dict_bytes, "Total", "t", &total));
+	g_assert_cmpint (total, ==, 3072);
+	g_assert_false (g_variant_lookup (dict_bytes, "Histogram", "at", NULL));
+
+	/* sorted by ID */
+	str = fu_stats_to_string (stats);
+	g_assert_cmpstr (str, ==,
+			 "install.write: count=3 total=20025500 min=500 max=20000000\n"
+			 "install.write-bytes: count=2 total=3072 min=1024 max=2048\n");
+}
+
 static void
 fu_plugin_quirks_func (void)
 {
@@ -1951,6 +2400,108 @@ fu_plugin_quirks_performance_func (void)
 	g_print ("lookup=%.3fms ", g_timer_elapsed (timer, NULL) * 1000.f);
 }
 
+static gpointer
+fu_plugin_quirks_reader_thread_cb (gpointer user_data)
+{
+	FuQuirks *quirks = FU_QUIRKS (user_data);
+	g_autofree gchar *guid = fwupd_guid_hash_string ("USB\\VID_0BDA&PID_0000");
+	for (guint i = 0; i < 10000; i++) {
+		const gchar *key;
+		const gchar *value;
+		const gchar *tmp;
+		GHashTableIter iter;
+		g_autoptr(GHashTable) kvs = NULL;
+
+		/* the group is being rewritten while this runs */
+		tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", "Name");
+		g_assert_cmpstr (tmp, ==, "Stable");
+		kvs = fu_quirks_get_kvs_for_guid (quirks, guid);
+		g_assert_nonnull (kvs);
+		g_hash_table_iter_init (&iter, kvs);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &value)) {
+			g_assert_nonnull (key);
+			g_assert_nonnull (value);
+		}
+		g_assert_cmpstr (g_hash_table_lookup (kvs, "Name"), ==, "Stable");
+		g_assert_cmpstr (tmp, ==, "Stable");
+	}
+	return NULL;
+}
+
+static void
+fu_plugin_quirks_snapshot_func (void)
+{
+	const gchar *tmp;
+	gboolean ret;
+	GThread *threads[4];
+	g_autofree gchar *guid = NULL;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) kvs = NULL;
+
+	fu_quirks_add_value (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", "Name", "Stable");
+	tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", "Name");
+	g_assert_cmpstr (tmp, ==, "Stable");
+
+	/* groups that are not modified are shared with the new table */
+	fu_quirks_add_value (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0001", "Name", "Other");
+	g_assert_cmpstr (tmp, ==, "Stable");
+	g_assert_true (tmp == fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", "Name"));
+
+	/* modified groups are copied, and values merged */
+	fu_quirks_add_value (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0001", "Flags", "foo");
+	fu_quirks_add_value (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0001", "Flags", "bar,foo");
+	tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0001", "Flags");
+	g_assert_cmpstr (tmp, ==, "foo,bar");
+	tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0001", "Name");
+	g_assert_cmpstr (tmp, ==, "Other");
+
+	/* an invalid file does not change anything */
+	ret = fu_quirks_add_quirks_from_data (quirks, "[DeviceInstanceId=USB\\VID_0BDA&PID_0001]\nFlags=baz\n[invalid", -1, &error);
+	g_assert_nonnull (error);
+	g_assert_false (ret);
+	g_clear_error (&error);
+	tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0001", "Flags");
+	g_assert_cmpstr (tmp, ==, "foo,bar");
+
+	/* GUIDs are hashed when added */
+	ret = fu_quirks_add_quirks_from_data (quirks, "[Guid=USB\\VID_0BDA&PID_0002]\nName=Hashed\n", -1, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	guid = fwupd_guid_hash_string ("USB\\VID_0BDA&PID_0002");
+	kvs = fu_quirks_get_kvs_for_guid (quirks, guid);
+	g_assert_nonnull (kvs);
+	g_assert_cmpstr (g_hash_table_lookup (kvs, "Name"), ==, "Hashed");
+	tmp = fu_quirks_lookup_by_id (quirks, guid, "Name");
+	g_assert_cmpstr (tmp, ==, "Hashed");
+
+	/* a table that has been replaced is still valid while referenced */
+	fu_quirks_add_value (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0002", "Name", "Rewritten");
+	g_assert_cmpstr (fu_quirks_lookup_by_id (quirks, guid, "Name"), ==, "Hashed,Rewritten");
+	g_assert_cmpstr (g_hash_table_lookup (kvs, "Name"), ==, "Hashed");
+	g_assert_cmpstr (tmp, ==, "Hashed");
+
+	/* rewrite the group while it is being read from other threads */
+	for (guint i = 0; i < G_N_ELEMENTS (threads); i++)
+		threads[i] = g_thread_new (NULL, fu_plugin_quirks_reader_thread_cb, quirks);
+	for (guint i = 0; i < 1000; i++) {
+		g_autofree gchar *key = g_strdup_printf ("Key%04u", i);
+		g_autofree gchar *group = g_strdup_printf ("DeviceInstanceId=USB\\VID_0BDA&PID_%04X", i + 0x100);
+		fu_quirks_add_value (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", key, "Value");
+		fu_quirks_add_value (quirks, group, "Name", "Value");
+
+		/* publish each change rather than batching them */
+		tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", key);
+		g_assert_cmpstr (tmp, ==, "Value");
+	}
+	for (guint i = 0; i < G_N_ELEMENTS (threads); i++)
+		g_thread_join (threads[i]);
+	tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0163", "Name");
+	g_assert_cmpstr (tmp, ==, "Value");
+	tmp = fu_quirks_lookup_by_id (quirks, "DeviceInstanceId=USB\\VID_0BDA&PID_0000", "Key0999");
+	g_assert_cmpstr (tmp, ==, "Value");
+}
+
 static void
 fu_plugin_quirks_device_func (void)
 {
@@ -2136,13 +2687,16 @@ fu_plugin_list_func (void)
 {
 	GPtrArray *plugins;
 	FuPlugin *plugin;
+	gboolean ret;
 	g_autoptr(FuPluginList) plugin_list = fu_plugin_list_new ();
 	g_autoptr(FuPlugin) plugin1 = fu_plugin_new ();
 	g_autoptr(FuPlugin) plugin2 = fu_plugin_new ();
+	g_autoptr(FuPlugin) plugin3 = fu_plugin_new ();
 	g_autoptr(GError) error = NULL;
 
 	fu_plugin_set_name (plugin1, "plugin1");
 	fu_plugin_set_name (plugin2, "plugin2");
+	fu_plugin_set_name (plugin3, "test");
 
 	/* get all the plugins */
 	fu_plugin_list_add (plugin_list, plugin1);
@@ -2160,6 +2714,22 @@ fu_plugin_list_func (void)
 	plugin = fu_plugin_list_find_by_name (plugin_list, "nope", &error);
 	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
 	g_assert (plugin == NULL);
+	g_clear_error (&error);
+
+	/* only plugins implementing a vfunc */
+	plugins = fu_plugin_list_get_by_hook (plugin_list, FU_PLUGIN_HOOK_COLDPLUG);
+	g_assert_cmpint (plugins->len, ==, 0);
+	ret = fu_plugin_open (plugin3, PLUGINBUILDDIR "/libfu_plugin_test.so", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_true (fu_plugin_has_hook (plugin3, FU_PLUGIN_HOOK_COLDPLUG));
+	g_assert_false (fu_plugin_has_hook (plugin3, FU_PLUGIN_HOOK_USB_DEVICE_ADDED));
+	fu_plugin_list_add (plugin_list, plugin3);
+	plugins = fu_plugin_list_get_by_hook (plugin_list, FU_PLUGIN_HOOK_COLDPLUG);
+	g_assert_cmpint (plugins->len, ==, 1);
+	g_assert_true (g_ptr_array_index (plugins, 0) == plugin3);
+	plugins = fu_plugin_list_get_by_hook (plugin_list, FU_PLUGIN_HOOK_USB_DEVICE_ADDED);
+	g_assert_cmpint (plugins->len, ==, 0);
 }
 
 static void
@@ -2957,6 +3527,53 @@ fu_plugin_composite_func (void)
 	}
 }
 
+static void
+fu_plugin_benchmark_func (void)
+{
+	gboolean ret;
+	guint children = 0;
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* 3 devices, each with 2 GUIDs and a child */
+	g_setenv ("FWUPD_PLUGIN_TEST", "benchmark", TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_DEVICES", "3", TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_GUIDS", "2", TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_CHILDREN", "1", TRUE);
+	ret = fu_plugin_open (plugin, PLUGINBUILDDIR "/libfu_plugin_test.so", &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_plugin_runner_startup (plugin, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_signal_connect (plugin, "device-added",
+			  G_CALLBACK (_plugin_composite_device_added_cb),
+			  devices);
+	ret = fu_plugin_runner_coldplug (plugin, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (devices->len, ==, 6);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_assert_true (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE));
+		g_assert_cmpstr (fu_device_get_version (device), ==, "1.2.2");
+		if (fu_device_get_parent (device) != NULL) {
+			g_assert_cmpint (fu_device_get_guids (device)->len, ==, 1);
+			children++;
+		} else {
+			g_assert_cmpint (fu_device_get_guids (device)->len, ==, 2);
+		}
+	}
+	g_assert_cmpint (children, ==, 3);
+
+	g_unsetenv ("FWUPD_PLUGIN_TEST");
+	g_unsetenv ("FWUPD_PLUGIN_TEST_DEVICES");
+	g_unsetenv ("FWUPD_PLUGIN_TEST_GUIDS");
+	g_unsetenv ("FWUPD_PLUGIN_TEST_CHILDREN");
+}
+
 static void
 fu_common_store_cab_func (void)
 {
@@ -3270,6 +3887,103 @@ fu_device_poll_func (void)
 	g_assert_cmpint (fu_device_get_metadata_integer (device, "cnt"), ==, cnt);
 }
 
+static gboolean
+fu_device_wait_for_cb (FuDevice *device, gpointer user_data, GError **error)
+{
+	guint cnt = fu_device_get_metadata_integer (device, "cnt");
+	fu_device_set_metadata_integer (device, "cnt", cnt + 1);
+	if (cnt == 99) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED, "fatal");
+		return FALSE;
+	}
+	return cnt >= GPOINTER_TO_UINT (user_data);
+}
+
+static gpointer
+fu_device_wait_wake_thread_cb (gpointer user_data)
+{
+	FuDevice *device = FU_DEVICE (user_data);
+	fu_device_set_metadata_integer (device, "woken", 1);
+	fu_device_wait_wake (device);
+	return NULL;
+}
+
+typedef struct {
+	FuDevice	*device;
+	GThread		*thread;
+} FuDeviceWaitHelper;
+
+/* only runs if the main context is iterated during the wait */
+static gboolean
+fu_device_wait_dispatched_cb (gpointer user_data)
+{
+	FuDeviceWaitHelper *helper = (FuDeviceWaitHelper *) user_data;
+	fu_device_set_metadata_integer (helper->device, "dispatched", 1);
+	helper->thread = g_thread_new ("wake", fu_device_wait_wake_thread_cb,
+				       helper->device);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_device_wait_for_func (void)
+{
+	FuDeviceWaitHelper helper = { NULL, NULL };
+	gboolean ret;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* ready after a few checks, with the interval backing off */
+	fu_device_set_metadata_integer (device, "cnt", 0);
+	ret = fu_device_wait_for (device, fu_device_wait_for_cb,
+				  GUINT_TO_POINTER (4), 0, 1000, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "cnt"), ==, 5);
+	g_assert_cmpint (fu_device_get_wait_time (device), <, 500);
+
+	/* never ready */
+	fu_device_reset_wait_time (device);
+	fu_device_set_metadata_integer (device, "cnt", 0);
+	ret = fu_device_wait_for (device, fu_device_wait_for_cb,
+				  GUINT_TO_POINTER (1000), 0, 50, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_assert_false (ret);
+	g_assert_cmpint (fu_device_get_wait_time (device), >=, 50);
+	g_clear_error (&error);
+
+	/* fatal error stops the wait */
+	fu_device_set_metadata_integer (device, "cnt", 99);
+	ret = fu_device_wait_for (device, fu_device_wait_for_cb,
+				  GUINT_TO_POINTER (1000), 0, 5000, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+	g_assert_false (ret);
+	g_clear_error (&error);
+
+	/* a wake when nothing is waiting does not cut short the next delay */
+	fu_device_wait_wake (device);
+	g_timer_reset (timer);
+	ret = fu_device_wait_for (device, NULL, NULL, 50, 0, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpfloat (g_timer_elapsed (timer, NULL), >=, 0.05f);
+
+	/* events are dispatched while waiting, and another thread can wake
+	 * the waiter */
+	helper.device = device;
+	fu_device_set_metadata_integer (device, "dispatched", 0);
+	g_idle_add (fu_device_wait_dispatched_cb, &helper);
+	g_timer_reset (timer);
+	ret = fu_device_wait_for (device, NULL, NULL, 5000, 0, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_nonnull (helper.thread);
+	g_thread_join (helper.thread);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "dispatched"), ==, 1);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "woken"), ==, 1);
+	g_assert_cmpfloat (g_timer_elapsed (timer, NULL), <, 1.f);
+}
+
 static void
 fu_device_incorporate_func (void)
 {
@@ -3305,6 +4019,153 @@ fu_device_incorporate_func (void)
 	g_assert_cmpint (fu_device_get_icons(device)->len, ==, 1);
 }
 
+/* a loopback device that handles one transfer at a time, with the completion
+ * reaching the host some time after the device has finished */
+#define FU_TYPE_TEST_USB_DEVICE (fu_test_usb_device_get_type ())
+G_DECLARE_FINAL_TYPE (FuTestUsbDevice, fu_test_usb_device, FU, TEST_USB_DEVICE, FuUsbDevice)
+
+struct _FuTestUsbDevice {
+	FuUsbDevice		 parent_instance;
+	GByteArray		*received;
+	gint64			 busy_until;	/* ms */
+	guint			 wire_ms;
+	guint			 latency_ms;
+	guint			 in_flight;
+	guint			 in_flight_max;
+	guint			 fail_idx;
+};
+
+G_DEFINE_TYPE (FuTestUsbDevice, fu_test_usb_device, FU_TYPE_USB_DEVICE)
+
+static gboolean
+fu_test_usb_device_complete_cb (gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	FuTestUsbDevice *self = g_task_get_source_object (task);
+	FuChunk *chk = g_task_get_task_data (task);
+
+	self->in_flight--;
+	if (chk->idx == self->fail_idx) {
+		g_task_return_new_error (task,
+					 G_IO_ERROR,
+					 G_IO_ERROR_BROKEN_PIPE,
+					 "stalled on chunk %u", chk->idx);
+		return G_SOURCE_REMOVE;
+	}
+	g_byte_array_append (self->received, chk->data, chk->data_sz);
+	g_task_return_boolean (task, TRUE);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_test_usb_device_transfer_async (FuUsbDevice *device,
+				   guint8 endpoint,
+				   FuChunk *chk,
+				   guint timeout_ms,
+				   FuUsbDeviceTransferFlags flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer user_data)
+{
+	FuTestUsbDevice *self = FU_TEST_USB_DEVICE (device);
+	GTask *task = g_task_new (device, cancellable, callback, user_data);
+	gint64 now = g_get_monotonic_time () / 1000;
+	g_autoptr(GSource) source = NULL;
+
+	/* the device starts on this transfer when it finishes the last */
+	self->busy_until = MAX (now, self->busy_until) + self->wire_ms;
+	self->in_flight++;
+	self->in_flight_max = MAX (self->in_flight_max, self->in_flight);
+	g_task_set_task_data (task, chk, NULL);
+	source = g_timeout_source_new ((guint) (self->busy_until + self->latency_ms - now));
+	g_source_set_callback (source, fu_test_usb_device_complete_cb, task, g_object_unref);
+	g_source_attach (source, g_main_context_get_thread_default ());
+}
+
+static gboolean
+fu_test_usb_device_transfer_finish (FuUsbDevice *device, GAsyncResult *res, GError **error)
+{
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+fu_test_usb_device_finalize (GObject *object)
+{
+	FuTestUsbDevice *self = FU_TEST_USB_DEVICE (object);
+	g_byte_array_unref (self->received);
+	G_OBJECT_CLASS (fu_test_usb_device_parent_class)->finalize (object);
+}
+
+static void
+fu_test_usb_device_class_init (FuTestUsbDeviceClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	FuUsbDeviceClass *klass_usb_device = FU_USB_DEVICE_CLASS (klass);
+	object_class->finalize = fu_test_usb_device_finalize;
+	klass_usb_device->transfer_async = fu_test_usb_device_transfer_async;
+	klass_usb_device->transfer_finish = fu_test_usb_device_transfer_finish;
+}
+
+static void
+fu_test_usb_device_init (FuTestUsbDevice *self)
+{
+	self->received = g_byte_array_new ();
+	self->wire_ms = 1;
+	self->latency_ms = 2;
+	self->fail_idx = G_MAXUINT;
+}
+
+static void
+fu_usb_device_queue_func (void)
+{
+	guint8 buf[0x8000];
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	for (gsize i = 0; i < sizeof(buf); i++)
+		buf[i] = (guint8) i;
+	chunks = fu_chunk_array_new (buf, sizeof(buf), 0x0, 0x0, 0x100);
+
+	/* deeper queues hide the completion latency */
+	for (guint depth = 1; depth <= 8; depth *= 2) {
+		gboolean ret;
+		g_autoptr(FuTestUsbDevice) device = g_object_new (FU_TYPE_TEST_USB_DEVICE, NULL);
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GTimer) timer = g_timer_new ();
+
+		ret = fu_usb_device_write_chunks (FU_USB_DEVICE (device), 0x01, chunks,
+						  depth, 1000,
+						  FU_USB_DEVICE_TRANSFER_FLAG_NONE,
+						  &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpint (device->received->len, ==, sizeof(buf));
+		g_assert_cmpint (memcmp (device->received->data, buf, sizeof(buf)), ==, 0);
+		g_assert_cmpint (device->in_flight_max, ==, depth);
+		g_assert_cmpint (fu_device_get_progress (FU_DEVICE (device)), ==, 100);
+		g_print ("depth=%u:%.3fms ", depth, g_timer_elapsed (timer, NULL) * 1000.f);
+	}
+}
+
+static void
+fu_usb_device_queue_error_func (void)
+{
+	gboolean ret;
+	guint8 buf[0x1000] = { 0x0 };
+	g_autoptr(FuTestUsbDevice) device = g_object_new (FU_TYPE_TEST_USB_DEVICE, NULL);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	/* the transfers already in flight complete, but nothing more is sent */
+	chunks = fu_chunk_array_new (buf, sizeof(buf), 0x0, 0x0, 0x100);
+	device->fail_idx = 2;
+	ret = fu_usb_device_write_chunks (FU_USB_DEVICE (device), 0x01, chunks, 4, 1000,
+					  FU_USB_DEVICE_TRANSFER_FLAG_NONE, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_BROKEN_PIPE);
+	g_assert (!ret);
+	g_assert_cmpint (device->in_flight, ==, 0);
+	g_assert_cmpint (device->received->len, ==, 0x500);
+}
+
 static void
 fu_chunk_func (void)
 {
@@ -3349,6 +4210,62 @@ fu_chunk_func (void)
 					   "#05: page:02 addr:0004 len:02 ZZ\n");
 }
 
+static void
+fu_common_get_contents_fd_func (void)
+{
+	const gchar *data = "hello world";
+	gint fds[2] = { -1, -1 };
+	gsize len = 0;
+	g_autofree gchar *buf = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* regular file */
+	filename = fu_test_get_filename (TESTDATADIR, "metadata.xml");
+	g_assert_nonnull (filename);
+	g_assert_true (g_file_get_contents (filename, &buf, &len, NULL));
+	blob = fu_common_get_contents_fd (open (filename, O_RDONLY), len, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob);
+	g_assert_cmpint (g_bytes_get_size (blob), ==, len);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob, NULL), buf, len), ==, 0);
+
+	/* larger than the limit */
+	blob2 = fu_common_get_contents_fd (open (filename, O_RDONLY), len - 1, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_null (blob2);
+	g_clear_error (&error);
+
+	/* pipe */
+	g_assert_cmpint (pipe (fds), ==, 0);
+	g_assert_cmpint (write (fds[1], data, strlen (data)), ==, strlen (data));
+	close (fds[1]);
+	blob3 = fu_common_get_contents_fd (fds[0], 0x100, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob3);
+	g_assert_cmpint (g_bytes_get_size (blob3), ==, strlen (data));
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob3, NULL), data, strlen (data)), ==, 0);
+
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_MEMFD_SEALS)
+	/* sealed memfd is mapped */
+	{
+		gint fd = memfd_create ("fu-self-test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		g_autoptr(GBytes) blob4 = NULL;
+		g_assert_cmpint (fd, >=, 0);
+		g_assert_cmpint (write (fd, buf, len), ==, len);
+		g_assert_cmpint (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE), ==, 0);
+		blob4 = fu_common_get_contents_fd (fd, len, &error);
+		g_assert_no_error (error);
+		g_assert_nonnull (blob4);
+		g_assert_cmpint (g_bytes_get_size (blob4), ==, len);
+		g_assert_cmpint (memcmp (g_bytes_get_data (blob4, NULL), buf, len), ==, 0);
+	}
+#endif
+}
+
 static void
 fu_common_strstrip_func (void)
 {
@@ -3527,11 +4444,15 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/engine{requirements-other-device}", fu_engine_requirements_other_device_func);
 	g_test_add_func ("/fwupd/device{incorporate}", fu_device_incorporate_func);
 	g_test_add_func ("/fwupd/device{poll}", fu_device_poll_func);
+	g_test_add_func ("/fwupd/device{wait-for}", fu_device_wait_for_func);
 	g_test_add_func ("/fwupd/device-locker{success}", fu_device_locker_func);
 	g_test_add_func ("/fwupd/device-locker{fail}", fu_device_locker_fail_func);
 	g_test_add_func ("/fwupd/device{metadata}", fu_device_metadata_func);
 	g_test_add_func ("/fwupd/device{open-refcount}", fu_device_open_refcount_func);
 	g_test_add_func ("/fwupd/device{version-format}", fu_device_version_format_func);
+	g_test_add_func ("/fwupd/device{guids}", fu_device_guids_func);
+	if (g_test_perf ())
+		g_test_add_func ("/fwupd/device{guids-perf}", fu_device_guids_perf_func);
 	g_test_add_func ("/fwupd/device-list", fu_device_list_func);
 	g_test_add_func ("/fwupd/device-list{delay}", fu_device_list_delay_func);
 	g_test_add_func ("/fwupd/device-list{compatible}", fu_device_list_compatible_func);
@@ -3545,6 +4466,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/engine{history-inherit}", fu_engine_history_inherit);
 	g_test_add_func ("/fwupd/engine{partial-hash}", fu_engine_partial_hash_func);
 	g_test_add_func ("/fwupd/engine{downgrade}", fu_engine_downgrade_func);
+	g_test_add_func ("/fwupd/engine{update-metadata}", fu_engine_update_metadata_func);
 	g_test_add_func ("/fwupd/engine{requirements-success}", fu_engine_requirements_func);
 	g_test_add_func ("/fwupd/engine{requirements-missing}", fu_engine_requirements_missing_func);
 	g_test_add_func ("/fwupd/engine{requirements-unsupported}", fu_engine_requirements_unsupported_func);
@@ -3556,25 +4478,36 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/hwids", fu_hwids_func);
 	g_test_add_func ("/fwupd/smbios", fu_smbios_func);
 	g_test_add_func ("/fwupd/smbios3", fu_smbios3_func);
+	g_test_add_func ("/fwupd/smbios{truncated}", fu_smbios_truncated_func);
 	g_test_add_func ("/fwupd/history", fu_history_func);
 	g_test_add_func ("/fwupd/history{migrate}", fu_history_migrate_func);
 	g_test_add_func ("/fwupd/plugin-list", fu_plugin_list_func);
 	g_test_add_func ("/fwupd/plugin-list{depsolve}", fu_plugin_list_depsolve_func);
 	g_test_add_func ("/fwupd/plugin{delay}", fu_plugin_delay_func);
 	g_test_add_func ("/fwupd/plugin{module}", fu_plugin_module_func);
+	g_test_add_func ("/fwupd/plugin{manifest}", fu_plugin_manifest_func);
+	g_test_add_func ("/fwupd/plugin{builtin}", fu_plugin_builtin_func);
+	g_test_add_func ("/fwupd/trace", fu_trace_func);
+	g_test_add_func ("/fwupd/stats", fu_stats_func);
+	g_test_add_func ("/fwupd/snapshot", fu_snapshot_func);
 	g_test_add_func ("/fwupd/plugin{quirks}", fu_plugin_quirks_func);
 	g_test_add_func ("/fwupd/plugin{quirks-performance}", fu_plugin_quirks_performance_func);
+	g_test_add_func ("/fwupd/plugin{quirks-snapshot}", fu_plugin_quirks_snapshot_func);
 	g_test_add_func ("/fwupd/plugin{quirks-device}", fu_plugin_quirks_device_func);
 	g_test_add_func ("/fwupd/plugin{composite}", fu_plugin_composite_func);
+	g_test_add_func ("/fwupd/plugin{benchmark}", fu_plugin_benchmark_func);
 	g_test_add_func ("/fwupd/keyring{gpg}", fu_keyring_gpg_func);
 	g_test_add_func ("/fwupd/keyring{pkcs7}", fu_keyring_pkcs7_func);
 	g_test_add_func ("/fwupd/keyring{pkcs7-self-signed}", fu_keyring_pkcs7_self_signed_func);
 	g_test_add_func ("/fwupd/plugin{build-hash}", fu_plugin_hash_func);
 	g_test_add_func ("/fwupd/chunk", fu_chunk_func);
+	g_test_add_func ("/fwupd/usb-device{queue}", fu_usb_device_queue_func);
+	g_test_add_func ("/fwupd/usb-device{queue-error}", fu_usb_device_queue_error_func);
 	g_test_add_func ("/fwupd/common{version-guess-format}", fu_common_version_guess_format_func);
 	g_test_add_func ("/fwupd/common{version}", fu_common_version_func);
 	g_test_add_func ("/fwupd/common{vercmp}", fu_common_vercmp_func);
 	g_test_add_func ("/fwupd/common{strstrip}", fu_common_strstrip_func);
+	g_test_add_func ("/fwupd/common{get-contents-fd}", fu_common_get_contents_fd_func);
 	g_test_add_func ("/fwupd/common{endian}", fu_common_endian_func);
 	g_test_add_func ("/fwupd/common{cab-success}", fu_common_store_cab_func);
 	g_test_add_func ("/fwupd/common{cab-success-unsigned}", fu_common_store_cab_unsigned_func);
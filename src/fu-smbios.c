@@ -18,6 +18,7 @@
 struct _FuSmbios {
 	GObject			 parent_instance;
 	gchar			*smbios_ver;
+	gchar			*checksum;
 	guint32			 structure_table_len;
 	GPtrArray		*items;
 };
@@ -70,18 +71,40 @@ typedef struct {
 
 G_DEFINE_TYPE (FuSmbios, fu_smbios, G_TYPE_OBJECT)
 
-static gboolean
+/**
+ * fu_smbios_setup_from_data:
+ * @self: A #FuSmbios
+ * @buf: The DMI table
+ * @sz: The size of @buf
+ * @error: A #GError or %NULL
+ *
+ * Reads all the SMBIOS values from the DMI table, which is not trusted.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
 fu_smbios_setup_from_data (FuSmbios *self, const guint8 *buf, gsize sz, GError **error)
 {
+	g_return_val_if_fail (FU_IS_SMBIOS (self), FALSE);
+	g_return_val_if_fail (buf != NULL || sz == 0, FALSE);
+
+	/* used to detect when the tables have changed */
+	g_free (self->checksum);
+	self->checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, buf, sz);
+
 	/* go through each structure */
 	for (gsize i = 0; i < sz; i++) {
 		FuSmbiosStructure *str = (FuSmbiosStructure *) &buf[i];
 		FuSmbiosItem *item;
 
 		/* invalid */
+		if (i + sizeof(FuSmbiosStructure) > sz)
+			break;
 		if (str->len == 0x00)
 			break;
-		if (str->len >= sz) {
+		if (str->len >= sz - i) {
 			g_set_error_literal (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INVALID_FILE,
@@ -99,7 +122,7 @@ fu_smbios_setup_from_data (FuSmbios *self, const guint8 *buf, gsize sz, GError *
 
 		/* jump to the end of the struct */
 		i += str->len;
-		if (buf[i] == '\0' && buf[i+1] == '\0') {
+		if (i + 1 < sz && buf[i] == '\0' && buf[i+1] == '\0') {
 			i++;
 			continue;
 		}
@@ -351,6 +374,22 @@ fu_smbios_to_string (FuSmbios *self)
 	return g_string_free (str, FALSE);
 }
 
+/**
+ * fu_smbios_get_checksum:
+ * @self: A #FuSmbios
+ *
+ * Gets the checksum of the raw DMI structure table, which can be used to
+ * find out if the hardware or BIOS configuration has changed.
+ *
+ * Returns: a SHA1 hash, or %NULL if no tables were loaded
+ **/
+const gchar *
+fu_smbios_get_checksum (FuSmbios *self)
+{
+	g_return_val_if_fail (FU_IS_SMBIOS (self), NULL);
+	return self->checksum;
+}
+
 static FuSmbiosItem *
 fu_smbios_get_item_for_type (FuSmbios *self, guint8 type)
 {
@@ -463,6 +502,7 @@ fu_smbios_finalize (GObject *object)
 {
 	FuSmbios *self = FU_SMBIOS (object);
 	g_free (self->smbios_ver);
+	g_free (self->checksum);
 	g_ptr_array_unref (self->items);
 	G_OBJECT_CLASS (fu_smbios_parent_class)->finalize (object);
 }
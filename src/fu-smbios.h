@@ -29,7 +29,12 @@ gboolean	 fu_smbios_setup_from_path	(FuSmbios	*self,
 gboolean	 fu_smbios_setup_from_file	(FuSmbios	*self,
 						 const gchar	*filename,
 						 GError		**error);
+gboolean	 fu_smbios_setup_from_data	(FuSmbios	*self,
+						 const guint8	*buf,
+						 gsize		 sz,
+						 GError		**error);
 gchar		*fu_smbios_to_string		(FuSmbios	*self);
+const gchar	*fu_smbios_get_checksum		(FuSmbios	*self);
 
 const gchar	*fu_smbios_get_string		(FuSmbios	*self,
 						 guint8		 type,
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuSnapshot"
+
+#include "config.h"
+
+#include "fu-common.h"
+#include "fu-snapshot.h"
+
+/**
+ * SECTION:fu-snapshot
+ * @short_description: a record of the state computed at startup
+ *
+ * A snapshot records things that are expensive to compute at startup, for
+ * instance the HardwareIDs or the quirk database, along with the keys that
+ * the data was derived from. On the next startup the keys are recomputed and
+ * each section is only restored if all the keys it depends on are unchanged.
+ *
+ * See also: #FuEngine
+ */
+
+struct _FuSnapshot
+{
+	GObject			 parent_instance;
+	GKeyFile		*previous;	/* as loaded */
+	GKeyFile		*current;	/* to be saved */
+};
+
+G_DEFINE_TYPE (FuSnapshot, fu_snapshot, G_TYPE_OBJECT)
+
+/**
+ * fu_snapshot_load:
+ * @self: A #FuSnapshot
+ * @filename: A filename
+ * @error: A #GError or %NULL
+ *
+ * Loads a snapshot saved by fu_snapshot_save() on a previous startup.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_snapshot_load (FuSnapshot *self, const gchar *filename, GError **error)
+{
+	g_return_val_if_fail (FU_IS_SNAPSHOT (self), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+	return g_key_file_load_from_file (self->previous, filename,
+					  G_KEY_FILE_NONE, error);
+}
+
+/**
+ * fu_snapshot_save:
+ * @self: A #FuSnapshot
+ * @filename: A filename
+ * @error: A #GError or %NULL
+ *
+ * Saves the current keys and data, replacing any existing snapshot.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_snapshot_save (FuSnapshot *self, const gchar *filename, GError **error)
+{
+	g_autofree gchar *data = NULL;
+
+	g_return_val_if_fail (FU_IS_SNAPSHOT (self), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	if (!fu_common_mkdir_parent (filename, error))
+		return FALSE;
+	data = g_key_file_to_data (self->current, NULL, error);
+	if (data == NULL)
+		return FALSE;
+	return g_file_set_contents (filename, data, -1, error);
+}
+
+/**
+ * fu_snapshot_set_key:
+ * @self: A #FuSnapshot
+ * @key: A key, e.g. %FU_SNAPSHOT_KEY_KERNEL_VERSION
+ * @value: (nullable): A value, e.g. `5.0.7`
+ *
+ * Sets a value that the data in the snapshot depends on. A %NULL value is
+ * never considered valid.
+ **/
+void
+fu_snapshot_set_key (FuSnapshot *self, const gchar *key, const gchar *value)
+{
+	g_return_if_fail (FU_IS_SNAPSHOT (self));
+	g_return_if_fail (key != NULL);
+	if (value == NULL) {
+		g_key_file_remove_key (self->current, FU_SNAPSHOT_GROUP_KEYS, key, NULL);
+		return;
+	}
+	g_key_file_set_string (self->current, FU_SNAPSHOT_GROUP_KEYS, key, value);
+}
+
+/**
+ * fu_snapshot_has_valid_keys:
+ * @self: A #FuSnapshot
+ * @keys: A %NULL terminated array of keys
+ *
+ * Finds out if all the keys set with fu_snapshot_set_key() have the same
+ * value as when the snapshot was saved.
+ *
+ * Returns: %TRUE if the previous data can be used
+ **/
+gboolean
+fu_snapshot_has_valid_keys (FuSnapshot *self, const gchar **keys)
+{
+	g_return_val_if_fail (FU_IS_SNAPSHOT (self), FALSE);
+	g_return_val_if_fail (keys != NULL, FALSE);
+
+	for (guint i = 0; keys[i] != NULL; i++) {
+		g_autofree gchar *value_old = NULL;
+		g_autofree gchar *value_new = NULL;
+		value_old = g_key_file_get_string (self->previous,
+						   FU_SNAPSHOT_GROUP_KEYS,
+						   keys[i], NULL);
+		value_new = g_key_file_get_string (self->current,
+						   FU_SNAPSHOT_GROUP_KEYS,
+						   keys[i], NULL);
+		if (value_old == NULL || value_new == NULL)
+			return FALSE;
+		if (g_strcmp0 (value_old, value_new) != 0) {
+			g_debug ("%s changed from %s to %s",
+				 keys[i], value_old, value_new);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * fu_snapshot_get_previous:
+ * @self: A #FuSnapshot
+ *
+ * Gets the data loaded from the snapshot, which should only be used after
+ * checking the keys with fu_snapshot_has_valid_keys().
+ *
+ * Returns: (transfer none): a #GKeyFile
+ **/
+GKeyFile *
+fu_snapshot_get_previous (FuSnapshot *self)
+{
+	g_return_val_if_fail (FU_IS_SNAPSHOT (self), NULL);
+	return self->previous;
+}
+
+/**
+ * fu_snapshot_get_current:
+ * @self: A #FuSnapshot
+ *
+ * Gets the data that will be written by fu_snapshot_save().
+ *
+ * Returns: (transfer none): a #GKeyFile
+ **/
+GKeyFile *
+fu_snapshot_get_current (FuSnapshot *self)
+{
+	g_return_val_if_fail (FU_IS_SNAPSHOT (self), NULL);
+	return self->current;
+}
+
+static void
+fu_snapshot_finalize (GObject *obj)
+{
+	FuSnapshot *self = FU_SNAPSHOT (obj);
+	g_key_file_unref (self->previous);
+	g_key_file_unref (self->current);
+	G_OBJECT_CLASS (fu_snapshot_parent_class)->finalize (obj);
+}
+
+static void
+fu_snapshot_class_init (FuSnapshotClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_snapshot_finalize;
+}
+
+static void
+fu_snapshot_init (FuSnapshot *self)
+{
+	self->previous = g_key_file_new ();
+	self->current = g_key_file_new ();
+}
+
+/**
+ * fu_snapshot_new:
+ *
+ * Creates a new #FuSnapshot.
+ *
+ * Returns: (transfer full): a #FuSnapshot
+ **/
+FuSnapshot *
+fu_snapshot_new (void)
+{
+	return FU_SNAPSHOT (g_object_new (FU_TYPE_SNAPSHOT, NULL));
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FU_TYPE_SNAPSHOT (fu_snapshot_get_type ())
+G_DECLARE_FINAL_TYPE (FuSnapshot, fu_snapshot, FU, SNAPSHOT, GObject)
+
+#define FU_SNAPSHOT_GROUP_KEYS			"Snapshot"
+
+#define FU_SNAPSHOT_KEY_FWUPD_VERSION		"FwupdVersion"
+#define FU_SNAPSHOT_KEY_KERNEL_VERSION		"KernelVersion"
+#define FU_SNAPSHOT_KEY_DMI_CHECKSUM		"DmiChecksum"
+#define FU_SNAPSHOT_KEY_QUIRKS_CHECKSUM		"QuirksChecksum"
+
+FuSnapshot	*fu_snapshot_new		(void);
+gboolean	 fu_snapshot_load		(FuSnapshot	*self,
+						 const gchar	*filename,
+						 GError		**error);
+gboolean	 fu_snapshot_save		(FuSnapshot	*self,
+						 const gchar	*filename,
+						 GError		**error);
+void		 fu_snapshot_set_key		(FuSnapshot	*self,
+						 const gchar	*key,
+						 const gchar	*value);
+gboolean	 fu_snapshot_has_valid_keys	(FuSnapshot	*self,
+						 const gchar	**keys);
+GKeyFile	*fu_snapshot_get_previous	(FuSnapshot	*self);
+GKeyFile	*fu_snapshot_get_current	(FuSnapshot	*self);
+
+G_END_DECLS
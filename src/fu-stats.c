@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuStats"
+
+#include "config.h"
+
+#include "fu-stats.h"
+
+/**
+ * SECTION:fu-stats
+ * @short_description: performance counters and histograms
+ *
+ * Durations are recorded in microseconds, along with a histogram with one
+ * bucket for each order of magnitude from 1ms to 10s. Values are things like
+ * bytes written or cache hits, and only the count and total is useful.
+ *
+ * See also: #FuEngine
+ */
+
+/* upper bounds in microseconds, with the last bucket being unbounded */
+static const gint64 fu_stats_buckets[] = {
+	1000, 10000, 100000, 1000000, 10000000, G_MAXINT64
+};
+
+typedef struct {
+	gboolean	 is_duration;
+	guint64		 count;
+	guint64		 total;
+	guint64		 min;
+	guint64		 max;
+	guint64		 histogram[G_N_ELEMENTS (fu_stats_buckets)];
+} FuStatsItem;
+
+struct _FuStats
+{
+	GObject			 parent_instance;
+	GMutex			 mutex;
+	GHashTable		*items;		/* id:FuStatsItem */
+};
+
+G_DEFINE_TYPE (FuStats, fu_stats, G_TYPE_OBJECT)
+
+static FuStatsItem *
+fu_stats_ensure_item (FuStats *self, const gchar *id, gboolean is_duration)
+{
+	FuStatsItem *item = g_hash_table_lookup (self->items, id);
+	if (item == NULL) {
+		item = g_new0 (FuStatsItem, 1);
+		item->is_duration = is_duration;
+		item->min = G_MAXUINT64;
+		g_hash_table_insert (self->items, g_strdup (id), item);
+	}
+	return item;
+}
+
+static void
+fu_stats_item_add (FuStatsItem *item, guint64 value)
+{
+	item->count++;
+	item->total += value;
+	item->min = MIN (item->min, value);
+	item->max = MAX (item->max, value);
+}
+
+/**
+ * fu_stats_add_duration:
+ * @self: A #FuStats
+ * @id: An ID, e.g. `install.write`
+ * @duration: A duration in microseconds
+ *
+ * Records how long something took.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_stats_add_duration (FuStats *self, const gchar *id, gint64 duration)
+{
+	FuStatsItem *item;
+
+	g_return_if_fail (FU_IS_STATS (self));
+	g_return_if_fail (id != NULL);
+
+	if (duration < 0)
+		duration = 0;
+	g_mutex_lock (&self->mutex);
+	item = fu_stats_ensure_item (self, id, TRUE);
+	fu_stats_item_add (item, (guint64) duration);
+	for (guint i = 0; i < G_N_ELEMENTS (fu_stats_buckets); i++) {
+		if (duration < fu_stats_buckets[i]) {
+			item->histogram[i]++;
+			break;
+		}
+	}
+	g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * fu_stats_add_elapsed:
+ * @self: A #FuStats
+ * @id: An ID, e.g. `install.write`
+ * @start: A time from g_get_monotonic_time()
+ *
+ * Records how long something took since @start.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_stats_add_elapsed (FuStats *self, const gchar *id, gint64 start)
+{
+	fu_stats_add_duration (self, id, g_get_monotonic_time () - start);
+}
+
+/**
+ * fu_stats_add_value:
+ * @self: A #FuStats
+ * @id: An ID, e.g. `install.write-bytes`
+ * @value: A value, e.g. the number of bytes
+ *
+ * Adds a value to a counter.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_stats_add_value (FuStats *self, const gchar *id, guint64 value)
+{
+	FuStatsItem *item;
+
+	g_return_if_fail (FU_IS_STATS (self));
+	g_return_if_fail (id != NULL);
+
+	g_mutex_lock (&self->mutex);
+	item = fu_stats_ensure_item (self, id, FALSE);
+	fu_stats_item_add (item, value);
+	g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * fu_stats_to_variant:
+ * @self: A #FuStats
+ *
+ * Exports all the counters, typically for sending over D-Bus. Each ID maps
+ * to a dictionary with the keys `Count`, `Total`, `Min` and `Max`, and for
+ * durations also `Histogram`.
+ *
+ * Returns: (transfer floating): a #GVariant of type `a{sa{sv}}`
+ *
+ * Since: 1.2.6
+ **/
+GVariant *
+fu_stats_to_variant (FuStats *self)
+{
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key, value;
+
+	g_return_val_if_fail (FU_IS_STATS (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+	g_mutex_lock (&self->mutex);
+	g_hash_table_iter_init (&iter, self->items);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		FuStatsItem *item = (FuStatsItem *) value;
+		GVariantBuilder builder_item;
+		g_variant_builder_init (&builder_item, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add (&builder_item, "{sv}", "Count",
+				       g_variant_new_uint64 (item->count));
+		g_variant_builder_add (&builder_item, "{sv}", "Total",
+				       g_variant_new_uint64 (item->total));
+		g_variant_builder_add (&builder_item, "{sv}", "Min",
+				       g_variant_new_uint64 (item->min));
+		g_variant_builder_add (&builder_item, "{sv}", "Max",
+				       g_variant_new_uint64 (item->max));
+		if (item->is_duration) {
+			GVariant *histogram;
+			histogram = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64,
+							       item->histogram,
+							       G_N_ELEMENTS (item->histogram),
+							       sizeof (guint64));
+			g_variant_builder_add (&builder_item, "{sv}", "Histogram", histogram);
+		}
+		g_variant_builder_add (&builder, "{sa{sv}}",
+				       (const gchar *) key, &builder_item);
+	}
+	g_mutex_unlock (&self->mutex);
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * fu_stats_to_string:
+ * @self: A #FuStats
+ *
+ * Gets a plain text summary of all the counters, sorted by ID.
+ *
+ * Returns: (transfer full): a string
+ *
+ * Since: 1.2.6
+ **/
+gchar *
+fu_stats_to_string (FuStats *self)
+{
+	GString *str = g_string_new (NULL);
+	g_autoptr(GList) ids = NULL;
+
+	g_return_val_if_fail (FU_IS_STATS (self), NULL);
+
+	g_mutex_lock (&self->mutex);
+	ids = g_list_sort (g_hash_table_get_keys (self->items),
+			   (GCompareFunc) g_strcmp0);
+	for (GList *l = ids; l != NULL; l = l->next) {
+		const gchar *id = l->data;
+		FuStatsItem *item = g_hash_table_lookup (self->items, id);
+		g_string_append_printf (str, "%s: count=%" G_GUINT64_FORMAT
+					" total=%" G_GUINT64_FORMAT
+					" min=%" G_GUINT64_FORMAT
+					" max=%" G_GUINT64_FORMAT "\n",
+					id, item->count, item->total,
+					item->min, item->max);
+	}
+	g_mutex_unlock (&self->mutex);
+	return g_string_free (str, FALSE);
+}
+
+static void
+fu_stats_finalize (GObject *obj)
+{
+	FuStats *self = FU_STATS (obj);
+	g_mutex_clear (&self->mutex);
+	g_hash_table_unref (self->items);
+	G_OBJECT_CLASS (fu_stats_parent_class)->finalize (obj);
+}
+
+static void
+fu_stats_class_init (FuStatsClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_stats_finalize;
+}
+
+static void
+fu_stats_init (FuStats *self)
+{
+	g_mutex_init (&self->mutex);
+	self->items = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+/**
+ * fu_stats_new:
+ *
+ * Creates a new #FuStats.
+ *
+ * Returns: (transfer full): a #FuStats
+ *
+ * Since: 1.2.6
+ **/
+FuStats *
+fu_stats_new (void)
+{
+	return FU_STATS (g_object_new (FU_TYPE_STATS, NULL));
+}
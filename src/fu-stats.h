@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FU_TYPE_STATS (fu_stats_get_type ())
+G_DECLARE_FINAL_TYPE (FuStats, fu_stats, FU, STATS, GObject)
+
+FuStats		*fu_stats_new			(void);
+void		 fu_stats_add_duration		(FuStats	*self,
+						 const gchar	*id,
+						 gint64		 duration);
+void		 fu_stats_add_elapsed		(FuStats	*self,
+						 const gchar	*id,
+						 gint64		 start);
+void		 fu_stats_add_value		(FuStats	*self,
+						 const gchar	*id,
+						 guint64	 value);
+GVariant	*fu_stats_to_variant		(FuStats	*self);
+gchar		*fu_stats_to_string		(FuStats	*self);
+
+G_END_DECLS
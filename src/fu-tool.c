@@ -12,17 +12,23 @@
 #include <glib/gstdio.h>
 #include <glib/gi18n.h>
 #include <glib-unix.h>
+#include <gmodule.h>
+#include <libgcab.h>
 #include <locale.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <libsoup/soup.h>
+#include <xmlb.h>
 
 #include "fu-device-private.h"
 #include "fu-engine.h"
 #include "fu-history.h"
+#include "fu-plugin-builtin.h"
 #include "fu-plugin-private.h"
 #include "fu-progressbar.h"
 #include "fu-smbios.h"
+#include "fu-trace.h"
 #include "fu-util-common.h"
 #include "fu-debug.h"
 #include "fwupd-common-private.h"
@@ -43,6 +49,10 @@ typedef enum {
 	FU_UTIL_OPERATION_LAST
 } FuUtilOperation;
 
+/* only found when run with LD_PRELOAD=libfu_alloc_counter.so */
+typedef void	 (*FuUtilAllocCounterStartFunc)	(void);
+typedef guint	 (*FuUtilAllocCounterStopFunc)	(void);
+
 struct FuUtilPrivate {
 	GCancellable		*cancellable;
 	GMainLoop		*loop;
@@ -60,6 +70,9 @@ struct FuUtilPrivate {
 	FwupdDevice		*current_device;
 	gchar			*current_message;
 	FwupdDeviceFlags	 completion_flags;
+	/* only set in benchmark */
+	FuUtilAllocCounterStartFunc	 alloc_counter_start;
+	FuUtilAllocCounterStopFunc	 alloc_counter_stop;
 };
 
 static gboolean
@@ -1284,6 +1297,497 @@ fu_util_verify_update (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+#define FU_UTIL_BENCHMARK_ITERATIONS		10
+#define FU_UTIL_BENCHMARK_FIRMWARE_SIZE		0x8000
+
+static void
+fu_util_benchmark_allocations_start (FuUtilPrivate *priv)
+{
+	if (priv->alloc_counter_start != NULL)
+		priv->alloc_counter_start ();
+}
+
+static void
+fu_util_benchmark_allocations_stop (FuUtilPrivate *priv, FuStats *stats, const gchar *id)
+{
+	if (priv->alloc_counter_stop == NULL) {
+		g_debug ("cannot count allocations, skipping %s", id);
+		return;
+	}
+	fu_stats_add_value (stats, id, priv->alloc_counter_stop ());
+}
+
+static void
+fu_util_benchmark_allocations_setup (FuUtilPrivate *priv)
+{
+	GModule *self = g_module_open (NULL, 0);
+	if (self == NULL)
+		return;
+	if (!g_module_symbol (self, "fu_alloc_counter_start",
+			      (gpointer *) &priv->alloc_counter_start) ||
+	    !g_module_symbol (self, "fu_alloc_counter_stop",
+			      (gpointer *) &priv->alloc_counter_stop)) {
+		g_debug ("libfu_alloc_counter.so not preloaded");
+		priv->alloc_counter_start = NULL;
+		priv->alloc_counter_stop = NULL;
+	}
+	g_module_close (self);
+}
+
+/* the optional arguments, in order */
+static const gchar *fu_util_benchmark_args[] = {
+	"Devices", "Guids", "Children", "Components", "Releases", NULL };
+
+static void
+fu_util_benchmark_device_added_cb (FuPlugin *plugin, FuDevice *device, gpointer user_data)
+{
+	FuUtilPrivate *priv = (FuUtilPrivate *) user_data;
+	fu_engine_add_device (priv->engine, device);
+}
+
+static FuPlugin *
+fu_util_benchmark_get_plugin (FuUtilPrivate *priv, GError **error)
+{
+	GPtrArray *plugins = fu_engine_get_plugins (priv->engine);
+	const gpointer *vfuncs = fu_plugin_builtin_get_vfuncs ("test");
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuPlugin) plugin = NULL;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+
+	/* not blacklisted in daemon.conf, so already set up by the engine */
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, i);
+		if (g_strcmp0 (fu_plugin_get_name (plugin_tmp), "test") == 0)
+			return g_object_ref (plugin_tmp);
+	}
+
+	/* load it manually like the self tests */
+	plugin = fu_plugin_new ();
+	fu_plugin_set_name (plugin, "test");
+	if (vfuncs != NULL) {
+		fu_plugin_set_builtin (plugin, vfuncs);
+	} else {
+		g_autofree gchar *plugin_path = NULL;
+		plugin_path = fu_common_get_path (FU_PATH_KIND_PLUGINDIR_PKG);
+		filename = g_build_filename (plugin_path, "libfu_plugin_test.so", NULL);
+	}
+	if (!fu_plugin_open (plugin, filename, error)) {
+		g_prefix_error (error, "the test plugin is required: ");
+		return NULL;
+	}
+	fu_engine_add_plugin (priv->engine, plugin);
+
+	/* the engine does not share the quirks it loaded */
+	if (!fu_quirks_load (quirks, error))
+		return NULL;
+	fu_plugin_set_quirks (plugin, quirks);
+	if (!fu_plugin_runner_startup (plugin, error))
+		return NULL;
+	g_signal_connect (plugin, "device-added",
+			  G_CALLBACK (fu_util_benchmark_device_added_cb),
+			  priv);
+	return g_steal_pointer (&plugin);
+}
+
+/* LVFS-style metadata, with the first components matching the devices */
+static XbSilo *
+fu_util_benchmark_build_silo (GPtrArray *devices,
+			      guint components,
+			      guint releases,
+			      GError **error)
+{
+	g_autoptr(GString) xml = g_string_new (NULL);
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
+	g_autoptr(XbSilo) silo = NULL;
+
+	g_string_append (xml, "<components origin=\"lvfs\" version=\"0.9\">\n");
+	for (guint i = 0; i < components; i++) {
+		g_autofree gchar *guid = NULL;
+		if (i < devices->len) {
+			FuDevice *device = g_ptr_array_index (devices, i);
+			guid = g_strdup (fu_device_get_guid_default (device));
+		} else {
+			g_autofree gchar *instance_id = NULL;
+			instance_id = g_strdup_printf ("BENCHMARK\\UNKNOWN_%04u", i);
+			guid = fwupd_guid_hash_string (instance_id);
+		}
+		g_string_append_printf (xml,
+					"<component type=\"firmware\">\n"
+					"  <id>com.acme.benchmark%04u.firmware</id>\n"
+					"  <name>Benchmark</name>\n"
+					"  <summary>Firmware for a synthetic device</summary>\n"
+					"  <provides>\n"
+					"    <firmware type=\"flashed\">%s</firmware>\n"
+					"  </provides>\n"
+					"  <releases>\n",
+					i, guid);
+
+		/* newest first, as on the LVFS */
+		for (guint j = releases; j > 0; j--) {
+			g_autofree gchar *basename = NULL;
+			g_autofree gchar *csum = NULL;
+			basename = g_strdup_printf ("benchmark%04u-1.2.%u.cab", i, j + 2);
+			csum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, basename, -1);
+			g_string_append_printf (xml,
+						"    <release version=\"1.2.%u\" timestamp=\"%u\">\n"
+						"      <location>https://fwupd.org/downloads/%s</location>\n"
+						"      <checksum filename=\"%s\" target=\"container\" type=\"sha1\">%s</checksum>\n"
+						"      <description><p>Fixes a synthetic bug.</p></description>\n"
+						"      <size type=\"installed\">%u</size>\n"
+						"    </release>\n",
+						j + 2, 1500000000 + j, basename, basename, csum,
+						(guint) FU_UTIL_BENCHMARK_FIRMWARE_SIZE);
+		}
+		g_string_append (xml, "  </releases>\n</component>\n");
+	}
+	g_string_append (xml, "</components>\n");
+
+	/* compile and index in the same way as the engine */
+	if (!xb_builder_source_load_xml (source, xml->str,
+					 XB_BUILDER_SOURCE_FLAG_NONE, error))
+		return NULL;
+	xb_builder_import_source (builder, source);
+	silo = xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+	if (silo == NULL)
+		return NULL;
+	if (!xb_silo_query_build_index (silo, "components/component/provides/firmware",
+					"type", error))
+		return NULL;
+	if (!xb_silo_query_build_index (silo, "components/component/provides/firmware",
+					NULL, error))
+		return NULL;
+	return g_steal_pointer (&silo);
+}
+
+#ifdef HAVE_GCAB_1_0
+static GBytes *
+fu_util_benchmark_build_cab (FuDevice *device, GBytes *blob_fw, GError **error)
+{
+	g_autofree gchar *metainfo = NULL;
+	g_autoptr(GBytes) blob_metainfo = NULL;
+	g_autoptr(GCabCabinet) cabinet = gcab_cabinet_new ();
+	g_autoptr(GCabFile) cabfile_fw = NULL;
+	g_autoptr(GCabFile) cabfile_metainfo = NULL;
+	g_autoptr(GCabFolder) cabfolder = gcab_folder_new (GCAB_COMPRESSION_NONE);
+	g_autoptr(GOutputStream) op = g_memory_output_stream_new_resizable ();
+
+	metainfo = g_strdup_printf ("<component type=\"firmware\">\n"
+				    "  <id>com.acme.benchmark.firmware</id>\n"
+				    "  <name>Benchmark</name>\n"
+				    "  <summary>Firmware for a synthetic device</summary>\n"
+				    "  <provides>\n"
+				    "    <firmware type=\"flashed\">%s</firmware>\n"
+				    "  </provides>\n"
+				    "  <releases>\n"
+				    "    <release version=\"1.2.3\" timestamp=\"1500000000\"/>\n"
+				    "  </releases>\n"
+				    "</component>\n",
+				    fu_device_get_guid_default (device));
+	blob_metainfo = g_bytes_new (metainfo, strlen (metainfo));
+
+	/* create a new archive */
+	if (!gcab_cabinet_add_folder (cabinet, cabfolder, error))
+		return NULL;
+	cabfile_fw = gcab_file_new_with_bytes ("firmware.bin", blob_fw);
+	if (!gcab_folder_add_file (cabfolder, cabfile_fw, FALSE, NULL, error))
+		return NULL;
+	cabfile_metainfo = gcab_file_new_with_bytes ("benchmark.metainfo.xml", blob_metainfo);
+	if (!gcab_folder_add_file (cabfolder, cabfile_metainfo, FALSE, NULL, error))
+		return NULL;
+
+	/* write the archive to a blob */
+	if (!gcab_cabinet_write_simple (cabinet, op, NULL, NULL, NULL, error))
+		return NULL;
+	if (!g_output_stream_close (op, NULL, error))
+		return NULL;
+	return g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (op));
+}
+
+static gboolean
+fu_util_benchmark_get_details (FuUtilPrivate *priv,
+			       FuStats *stats,
+			       FuDevice *device,
+			       GBytes *blob_fw,
+			       GError **error)
+{
+	gint fd;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GBytes) blob_cab = NULL;
+
+	blob_cab = fu_util_benchmark_build_cab (device, blob_fw, error);
+	if (blob_cab == NULL)
+		return FALSE;
+	fd = g_file_open_tmp ("fwupd-benchmark-XXXXXX.cab", &filename, error);
+	if (fd < 0)
+		return FALSE;
+	close (fd);
+	if (!fu_common_set_contents_bytes (filename, blob_cab, error))
+		return FALSE;
+
+	/* the engine closes the fd each time */
+	for (guint i = 0; i < FU_UTIL_BENCHMARK_ITERATIONS; i++) {
+		gint64 start;
+		g_autoptr(GPtrArray) details = NULL;
+		fd = open (filename, O_RDONLY);
+		if (fd < 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "failed to open %s",
+				     filename);
+			g_unlink (filename);
+			return FALSE;
+		}
+		start = g_get_monotonic_time ();
+		details = fu_engine_get_details (priv->engine, fd, error);
+		if (details == NULL) {
+			g_unlink (filename);
+			return FALSE;
+		}
+		fu_stats_add_elapsed (stats, "get-details", start);
+	}
+	g_unlink (filename);
+	return TRUE;
+}
+#endif
+
+static void
+fu_util_benchmark_stats_to_json (FuStats *stats, JsonBuilder *builder)
+{
+	GVariantIter iter;
+	GVariant *child;
+	g_autoptr(GPtrArray) items = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+	g_autoptr(GVariant) val = g_variant_ref_sink (fu_stats_to_variant (stats));
+
+	/* sorted so that results from different versions can be diffed */
+	g_variant_iter_init (&iter, val);
+	while ((child = g_variant_iter_next_value (&iter)) != NULL)
+		g_ptr_array_add (items, child);
+	g_ptr_array_sort (items, fu_util_sort_stats_cb);
+	json_builder_begin_object (builder);
+	for (guint i = 0; i < items->len; i++) {
+		const gchar *id = NULL;
+		guint64 count = 0;
+		guint64 total = 0;
+		guint64 min = 0;
+		guint64 max = 0;
+		g_autoptr(GVariant) dict = NULL;
+		g_autoptr(GVariant) histogram = NULL;
+
+		g_variant_get (g_ptr_array_index (items, i), "{&s@a{sv}}", &id, &dict);
+		g_variant_lookup (dict, "Count", "t", &count);
+		g_variant_lookup (dict, "Total", "t", &total);
+		g_variant_lookup (dict, "Min", "t", &min);
+		g_variant_lookup (dict, "Max", "t", &max);
+		json_builder_set_member_name (builder, id);
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "Count");
+		json_builder_add_int_value (builder, count);
+		json_builder_set_member_name (builder, "Total");
+		json_builder_add_int_value (builder, total);
+		json_builder_set_member_name (builder, "Min");
+		json_builder_add_int_value (builder, min);
+		json_builder_set_member_name (builder, "Max");
+		json_builder_add_int_value (builder, max);
+		json_builder_set_member_name (builder, "Mean");
+		json_builder_add_int_value (builder, count > 0 ? total / count : 0);
+		histogram = g_variant_lookup_value (dict, "Histogram",
+						    G_VARIANT_TYPE ("at"));
+		if (histogram != NULL) {
+			gsize n_elements = 0;
+			const guint64 *buckets;
+			buckets = g_variant_get_fixed_array (histogram, &n_elements,
+							     sizeof (guint64));
+			json_builder_set_member_name (builder, "Histogram");
+			json_builder_begin_array (builder);
+			for (gsize j = 0; j < n_elements; j++)
+				json_builder_add_int_value (builder, buckets[j]);
+			json_builder_end_array (builder);
+		}
+		json_builder_end_object (builder);
+	}
+	json_builder_end_object (builder);
+}
+
+static gboolean
+fu_util_benchmark (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	gint64 start;
+	guint args[] = { 100, 4, 2, 1000, 5 };
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *tmp_children = NULL;
+	g_autofree gchar *tmp_devices = NULL;
+	g_autofree gchar *tmp_guids = NULL;
+	g_autoptr(FuPlugin) plugin = NULL;
+	g_autoptr(FuStats) stats = fu_stats_new ();
+	g_autoptr(GBytes) blob_fw = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* check args */
+	if (g_strv_length (values) > G_N_ELEMENTS (args)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments");
+		return FALSE;
+	}
+	for (guint i = 0; values[i] != NULL; i++) {
+		guint64 tmp = fu_common_strtoull (values[i]);
+		if (tmp > 0xffff) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "%s value %s is too large",
+				     fu_util_benchmark_args[i], values[i]);
+			return FALSE;
+		}
+		args[i] = tmp;
+	}
+
+	/* count allocations if run with the counter preloaded */
+	fu_util_benchmark_allocations_setup (priv);
+
+	/* only load the test plugin, which creates devices without hardware */
+	tmp_devices = g_strdup_printf ("%u", args[0]);
+	tmp_guids = g_strdup_printf ("%u", args[1]);
+	tmp_children = g_strdup_printf ("%u", args[2]);
+	g_setenv ("FWUPD_PLUGIN_TEST", "benchmark", TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_DEVICES", tmp_devices, TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_GUIDS", tmp_guids, TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_CHILDREN", tmp_children, TRUE);
+	fu_engine_add_plugin_filter (priv->engine, "test");
+
+	/* load engine, without touching the system state */
+	start = g_get_monotonic_time ();
+	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_READONLY_FS, error))
+		return FALSE;
+	fu_stats_add_elapsed (stats, "engine.load", start);
+
+	/* do not depend on the metadata downloaded to this machine */
+	fu_engine_set_silo (priv->engine, silo_empty);
+
+	/* create the synthetic devices */
+	plugin = fu_util_benchmark_get_plugin (priv, error);
+	if (plugin == NULL)
+		return FALSE;
+	start = g_get_monotonic_time ();
+	fu_util_benchmark_allocations_start (priv);
+	if (!fu_plugin_runner_coldplug (plugin, error))
+		return FALSE;
+	fu_util_benchmark_allocations_stop (priv, stats, "coldplug.allocations");
+	fu_stats_add_elapsed (stats, "coldplug", start);
+
+	/* GetDevices */
+	for (guint i = 0; i < FU_UTIL_BENCHMARK_ITERATIONS; i++) {
+		g_clear_pointer (&devices, g_ptr_array_unref);
+		start = g_get_monotonic_time ();
+		devices = fu_engine_get_devices (priv->engine, error);
+		if (devices == NULL)
+			return FALSE;
+		fu_stats_add_elapsed (stats, "get-devices", start);
+	}
+
+	/* reading metadata and quirks is done a lot and should not allocate */
+	fu_util_benchmark_allocations_start (priv);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		fu_device_get_physical_id (device);
+		fu_device_get_metadata_boolean (device, "BenchmarkBoolean");
+		fu_device_get_metadata_integer (device, "BenchmarkInteger");
+	}
+	fu_util_benchmark_allocations_stop (priv, stats, "get-metadata.allocations");
+	fu_util_benchmark_allocations_start (priv);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		GPtrArray *guids = fu_device_get_guids (device);
+		for (guint j = 0; j < guids->len; j++) {
+			const gchar *guid = g_ptr_array_index (guids, j);
+			fu_plugin_lookup_quirk_by_id (plugin, guid, FU_QUIRKS_PLUGIN);
+		}
+	}
+	fu_util_benchmark_allocations_stop (priv, stats, "quirks.lookup.allocations");
+
+	/* generate metadata */
+	start = g_get_monotonic_time ();
+	silo = fu_util_benchmark_build_silo (devices, args[3], args[4], error);
+	if (silo == NULL)
+		return FALSE;
+	fu_stats_add_elapsed (stats, "metadata.compile", start);
+	fu_engine_set_silo (priv->engine, silo);
+
+	/* GetUpgrades, where devices without components are also counted */
+	for (guint i = 0; i < FU_UTIL_BENCHMARK_ITERATIONS; i++) {
+		for (guint j = 0; j < devices->len; j++) {
+			FuDevice *device = g_ptr_array_index (devices, j);
+			g_autoptr(GError) error_local = NULL;
+			g_autoptr(GPtrArray) rels = NULL;
+			start = g_get_monotonic_time ();
+			rels = fu_engine_get_upgrades (priv->engine,
+						       fu_device_get_id (device),
+						       &error_local);
+			fu_stats_add_elapsed (stats, "get-upgrades", start);
+			if (rels == NULL) {
+				g_debug ("no upgrades for %s: %s",
+					 fu_device_get_id (device),
+					 error_local->message);
+			}
+		}
+	}
+
+	/* GetDetails on a generated cabinet archive */
+	blob_fw = g_bytes_new_take (g_malloc0 (FU_UTIL_BENCHMARK_FIRMWARE_SIZE),
+				    FU_UTIL_BENCHMARK_FIRMWARE_SIZE);
+#ifdef HAVE_GCAB_1_0
+	if (devices->len > 0) {
+		if (!fu_util_benchmark_get_details (priv, stats,
+						    g_ptr_array_index (devices, 0),
+						    blob_fw, error))
+			return FALSE;
+	}
+#else
+	g_debug ("libgcab too old to generate archives, skipping get-details");
+#endif
+
+	/* install to each device, where the plugin does not write anything */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		start = g_get_monotonic_time ();
+		if (!fu_engine_install_blob (priv->engine, device, blob_fw,
+					     FWUPD_INSTALL_FLAG_NONE, error))
+			return FALSE;
+		fu_stats_add_elapsed (stats, "install", start);
+	}
+
+	/* export everything as JSON */
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "FwupdVersion");
+	json_builder_add_string_value (builder, PACKAGE_VERSION);
+	json_builder_set_member_name (builder, "Iterations");
+	json_builder_add_int_value (builder, FU_UTIL_BENCHMARK_ITERATIONS);
+	for (guint i = 0; fu_util_benchmark_args[i] != NULL; i++) {
+		json_builder_set_member_name (builder, fu_util_benchmark_args[i]);
+		json_builder_add_int_value (builder, args[i]);
+	}
+	json_builder_set_member_name (builder, "Benchmark");
+	fu_util_benchmark_stats_to_json (stats, builder);
+	json_builder_set_member_name (builder, "Engine");
+	fu_util_benchmark_stats_to_json (fu_engine_get_stats (priv->engine), builder);
+	json_builder_end_object (builder);
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	g_print ("%s\n", data);
+	return TRUE;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1294,6 +1798,7 @@ main (int argc, char *argv[])
 	gboolean version = FALSE;
 	gboolean interactive = isatty (fileno (stdout)) != 0;
 	g_auto(GStrv) plugin_glob = NULL;
+	g_autofree gchar *trace_fn = NULL;
 	g_autoptr(FuUtilPrivate) priv = g_new0 (FuUtilPrivate, 1);
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) cmd_array = fu_util_cmd_array_new ();
@@ -1329,6 +1834,9 @@ main (int argc, char *argv[])
 		{ "enable-json-state", '\0', 0, G_OPTION_ARG_NONE, &priv->enable_json_state,
 			/* TRANSLATORS: command line option */
 			_("Save device state into a JSON file between executions"), NULL },
+		{ "trace", '\0', 0, G_OPTION_ARG_FILENAME, &trace_fn,
+			/* TRANSLATORS: command line option */
+			_("Save a trace of where time was spent to a file"), NULL },
 		{ NULL}
 	};
 
@@ -1348,6 +1856,12 @@ main (int argc, char *argv[])
 	priv->progressbar = fu_progressbar_new ();
 
 	/* add commands */
+	fu_util_cmd_array_add (cmd_array,
+		     "benchmark",
+		     "[DEVICES] [GUIDS] [CHILDREN] [COMPONENTS] [RELEASES]",
+		     /* TRANSLATORS: command description */
+		     _("Measure the daemon overhead using synthetic devices"),
+		     fu_util_benchmark);
 	fu_util_cmd_array_add (cmd_array,
 		     "build-firmware",
 		     "FILE-IN FILE-OUT [SCRIPT] [OUTPUT]",
@@ -1494,6 +2008,10 @@ main (int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	/* record spans from here on */
+	if (trace_fn != NULL)
+		fu_trace_set_filename (trace_fn);
+
 	/* set flags */
 	priv->flags |= FWUPD_INSTALL_FLAG_NO_HISTORY;
 	if (allow_reinstall)
@@ -1530,7 +2048,14 @@ main (int argc, char *argv[])
 		fu_engine_add_plugin_filter (priv->engine, plugin_glob[i]);
 
 	/* run the specified command */
+	FU_TRACE_BEGIN ("tool", "command", argv[1]);
 	ret = fu_util_cmd_array_run (cmd_array, priv, argv[1], (gchar**) &argv[2], &error);
+	FU_TRACE_END ("tool", "command", argv[1]);
+	if (fu_trace_get_enabled ()) {
+		g_autoptr(GError) error_trace = NULL;
+		if (!fu_trace_save (&error_trace))
+			g_warning ("failed to save trace: %s", error_trace->message);
+	}
 	if (!ret) {
 		if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_ARGS)) {
 			g_autofree gchar *tmp = NULL;
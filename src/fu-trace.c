@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuTrace"
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include "fu-trace.h"
+
+/**
+ * SECTION:fu-trace
+ * @short_description: lightweight tracing of where time is spent
+ *
+ * Spans and counters are recorded when the `FWUPD_TRACE` environment variable
+ * is set to a filename, or when fwupdtool is run with `--trace`, and saved
+ * in the Chrome trace-event format which can be loaded in `chrome://tracing`
+ * or https://ui.perfetto.dev/
+ *
+ * The category and name of each event must be static strings as they are not
+ * copied. Only the newest %FU_TRACE_EVENTS_MAX events are kept so that a
+ * long-running daemon does not grow without bound. Unless fwupd is built with
+ * `-Dtrace=true` the FU_TRACE_*() macros compile to nothing.
+ */
+
+typedef struct {
+	gchar		 phase;
+	const gchar	*category;
+	const gchar	*name;
+	gchar		*detail;
+	gint64		 ts;
+	guint		 tid;
+	gint64		 value;
+} FuTraceEvent;
+
+struct _FuTraceSpan {
+	const gchar	*category;
+	const gchar	*name;
+	gchar		*detail;
+};
+
+static GMutex fu_trace_mutex;
+static GArray *fu_trace_events = NULL;
+static guint fu_trace_events_head = 0;		/* oldest event once full */
+static guint64 fu_trace_events_dropped = 0;
+static gchar *fu_trace_filename = NULL;
+static gint64 fu_trace_start = 0;
+static guint fu_trace_tid_next = 1;
+static GPrivate fu_trace_tid = G_PRIVATE_INIT (NULL);
+static volatile gboolean fu_trace_enabled = FALSE;
+
+static void
+fu_trace_event_clear (FuTraceEvent *event)
+{
+	g_free (event->detail);
+}
+
+static void
+fu_trace_ensure_env (void)
+{
+	static gsize once = 0;
+	if (g_once_init_enter (&once)) {
+		const gchar *tmp = g_getenv ("FWUPD_TRACE");
+		if (tmp != NULL && tmp[0] != '\0' && fu_trace_filename == NULL)
+			fu_trace_set_filename (tmp);
+		g_once_init_leave (&once, 1);
+	}
+}
+
+/**
+ * fu_trace_get_enabled:
+ *
+ * Gets if events are being recorded.
+ *
+ * Returns: %TRUE if enabled
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_trace_get_enabled (void)
+{
+	fu_trace_ensure_env ();
+	return fu_trace_enabled;
+}
+
+/**
+ * fu_trace_set_filename:
+ * @filename: (nullable): A filename, e.g. `/tmp/fwupd.json`
+ *
+ * Sets the file that fu_trace_save() writes to, which also starts recording
+ * events. Setting to %NULL stops recording.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_trace_set_filename (const gchar *filename)
+{
+	g_mutex_lock (&fu_trace_mutex);
+	g_free (fu_trace_filename);
+	fu_trace_filename = g_strdup (filename);
+	if (fu_trace_events == NULL) {
+		fu_trace_events = g_array_new (FALSE, FALSE, sizeof (FuTraceEvent));
+		g_array_set_clear_func (fu_trace_events,
+					(GDestroyNotify) fu_trace_event_clear);
+		fu_trace_start = g_get_monotonic_time ();
+	}
+	fu_trace_enabled = filename != NULL;
+	g_mutex_unlock (&fu_trace_mutex);
+}
+
+/**
+ * fu_trace_get_filename:
+ *
+ * Gets the file that fu_trace_save() writes to.
+ *
+ * Returns: a filename, or %NULL if not enabled
+ *
+ * Since: 1.2.6
+ **/
+const gchar *
+fu_trace_get_filename (void)
+{
+	fu_trace_ensure_env ();
+	return fu_trace_filename;
+}
+
+static guint
+fu_trace_get_tid (void)
+{
+	guint tid = GPOINTER_TO_UINT (g_private_get (&fu_trace_tid));
+	if (tid == 0) {
+		tid = fu_trace_tid_next++;
+		g_private_set (&fu_trace_tid, GUINT_TO_POINTER (tid));
+	}
+	return tid;
+}
+
+static void
+fu_trace_add_event (gchar phase,
+		    const gchar *category,
+		    const gchar *name,
+		    const gchar *detail,
+		    gint64 value)
+{
+	FuTraceEvent event = {
+		.phase		= phase,
+		.category	= category,
+		.name		= name,
+		.detail		= g_strdup (detail),
+		.ts		= g_get_monotonic_time (),
+		.value		= value,
+	};
+	g_mutex_lock (&fu_trace_mutex);
+	event.tid = fu_trace_get_tid ();
+	if (fu_trace_events->len < FU_TRACE_EVENTS_MAX) {
+		g_array_append_val (fu_trace_events, event);
+	} else {
+		/* overwrite the oldest event */
+		FuTraceEvent *old = &g_array_index (fu_trace_events,
+						    FuTraceEvent,
+						    fu_trace_events_head);
+		if (fu_trace_events_dropped++ == 0)
+			g_debug ("more than %u events, dropping the oldest",
+				 (guint) FU_TRACE_EVENTS_MAX);
+		fu_trace_event_clear (old);
+		*old = event;
+		fu_trace_events_head = (fu_trace_events_head + 1) % FU_TRACE_EVENTS_MAX;
+	}
+	g_mutex_unlock (&fu_trace_mutex);
+}
+
+/**
+ * fu_trace_begin:
+ * @category: A static string, e.g. `plugin`
+ * @name: A static string, e.g. `coldplug`
+ * @detail: (nullable): An optional string, e.g. the plugin name
+ *
+ * Records the start of a span, which must be matched with fu_trace_end()
+ * on the same thread.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_trace_begin (const gchar *category, const gchar *name, const gchar *detail)
+{
+	if (!fu_trace_get_enabled ())
+		return;
+	fu_trace_add_event ('B', category, name, detail, 0);
+}
+
+/**
+ * fu_trace_end:
+ * @category: A static string, e.g. `plugin`
+ * @name: A static string, e.g. `coldplug`
+ * @detail: (nullable): An optional string, e.g. the plugin name
+ *
+ * Records the end of a span started with fu_trace_begin().
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_trace_end (const gchar *category, const gchar *name, const gchar *detail)
+{
+	if (!fu_trace_get_enabled ())
+		return;
+	fu_trace_add_event ('E', category, name, detail, 0);
+}
+
+/**
+ * fu_trace_counter:
+ * @category: A static string, e.g. `engine`
+ * @name: A static string, e.g. `devices`
+ * @value: The new value
+ *
+ * Records the value of a counter at this point in time.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_trace_counter (const gchar *category, const gchar *name, gint64 value)
+{
+	if (!fu_trace_get_enabled ())
+		return;
+	fu_trace_add_event ('C', category, name, NULL, value);
+}
+
+/**
+ * fu_trace_span_new:
+ * @category: A static string, e.g. `device`
+ * @name: A static string, e.g. `setup`
+ * @detail: (nullable): An optional string, e.g. the device ID
+ *
+ * Records the start of a span that ends when the returned object is freed,
+ * typically used with g_autoptr() using FU_TRACE_SCOPE().
+ *
+ * Returns: (transfer full): a #FuTraceSpan, or %NULL if not enabled
+ *
+ * Since: 1.2.6
+ **/
+FuTraceSpan *
+fu_trace_span_new (const gchar *category, const gchar *name, const gchar *detail)
+{
+	FuTraceSpan *span;
+	if (!fu_trace_get_enabled ())
+		return NULL;
+	span = g_new0 (FuTraceSpan, 1);
+	span->category = category;
+	span->name = name;
+	span->detail = g_strdup (detail);
+	fu_trace_add_event ('B', category, name, detail, 0);
+	return span;
+}
+
+/**
+ * fu_trace_span_free:
+ * @span: A #FuTraceSpan
+ *
+ * Records the end of the span and frees it.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_trace_span_free (FuTraceSpan *span)
+{
+	if (span == NULL)
+		return;
+	fu_trace_end (span->category, span->name, span->detail);
+	g_free (span->detail);
+	g_free (span);
+}
+
+static void
+fu_trace_string_append_escaped (GString *str, const gchar *tmp)
+{
+	g_string_append_c (str, '"');
+	for (guint i = 0; tmp[i] != '\0'; i++) {
+		if (tmp[i] == '"' || tmp[i] == '\\') {
+			g_string_append_c (str, '\\');
+			g_string_append_c (str, tmp[i]);
+		} else if ((guchar) tmp[i] < 0x20) {
+			g_string_append_printf (str, "\\u%04x", (guint) tmp[i]);
+		} else {
+			g_string_append_c (str, tmp[i]);
+		}
+	}
+	g_string_append_c (str, '"');
+}
+
+/**
+ * fu_trace_to_string:
+ *
+ * Exports all the recorded events in the Chrome trace-event JSON format.
+ *
+ * Returns: (transfer full): a JSON string
+ *
+ * Since: 1.2.6
+ **/
+gchar *
+fu_trace_to_string (void)
+{
+	GString *str = g_string_new ("{\"traceEvents\":[");
+	pid_t pid = getpid ();
+
+	g_mutex_lock (&fu_trace_mutex);
+	for (guint i = 0; fu_trace_events != NULL && i < fu_trace_events->len; i++) {
+		guint idx = (fu_trace_events_head + i) % fu_trace_events->len;
+		FuTraceEvent *event = &g_array_index (fu_trace_events, FuTraceEvent, idx);
+		if (i > 0)
+			g_string_append_c (str, ',');
+		g_string_append (str, "\n{\"name\":");
+		if (event->detail != NULL) {
+			g_autofree gchar *name = g_strdup_printf ("%s(%s)",
+								  event->name,
+								  event->detail);
+			fu_trace_string_append_escaped (str, name);
+		} else {
+			fu_trace_string_append_escaped (str, event->name);
+		}
+		g_string_append (str, ",\"cat\":");
+		fu_trace_string_append_escaped (str, event->category);
+		g_string_append_printf (str, ",\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT
+					",\"pid\":%i,\"tid\":%u",
+					event->phase,
+					event->ts - fu_trace_start,
+					(gint) pid, event->tid);
+		if (event->phase == 'C') {
+			g_string_append (str, ",\"args\":{");
+			fu_trace_string_append_escaped (str, event->name);
+			g_string_append_printf (str, ":%" G_GINT64_FORMAT "}", event->value);
+		}
+		g_string_append_c (str, '}');
+	}
+	g_mutex_unlock (&fu_trace_mutex);
+	g_string_append (str, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * fu_trace_save:
+ * @error: A #GError, or %NULL
+ *
+ * Saves all the recorded events to the file set with fu_trace_set_filename()
+ * or the `FWUPD_TRACE` environment variable. Nothing is written if tracing
+ * is not enabled.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_trace_save (GError **error)
+{
+	g_autofree gchar *data = NULL;
+	if (!fu_trace_get_enabled ())
+		return TRUE;
+	data = fu_trace_to_string ();
+	g_debug ("saving trace to %s", fu_trace_filename);
+	return g_file_set_contents (fu_trace_filename, data, -1, error);
+}
+
+/**
+ * fu_trace_clear:
+ *
+ * Clears all the recorded events.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_trace_clear (void)
+{
+	g_mutex_lock (&fu_trace_mutex);
+	if (fu_trace_events != NULL)
+		g_array_set_size (fu_trace_events, 0);
+	fu_trace_events_head = 0;
+	fu_trace_events_dropped = 0;
+	fu_trace_start = g_get_monotonic_time ();
+	g_mutex_unlock (&fu_trace_mutex);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FuTraceSpan FuTraceSpan;
+
+#define		 FU_TRACE_EVENTS_MAX		 50000
+
+#ifdef HAVE_TRACE
+#define		 FU_TRACE_BEGIN(c,n,d)		 fu_trace_begin(c,n,d)
+#define		 FU_TRACE_END(c,n,d)		 fu_trace_end(c,n,d)
+#define		 FU_TRACE_COUNTER(c,n,v)	 fu_trace_counter(c,n,v)
+#define		 FU_TRACE_SCOPE(c,n,d)		 g_autoptr(FuTraceSpan) G_PASTE(fu_trace_span_,__LINE__) = fu_trace_span_new(c,n,d)
+#else
+#define		 FU_TRACE_BEGIN(c,n,d)		 G_STMT_START { } G_STMT_END
+#define		 FU_TRACE_END(c,n,d)		 G_STMT_START { } G_STMT_END
+#define		 FU_TRACE_COUNTER(c,n,v)	 G_STMT_START { } G_STMT_END
+#define		 FU_TRACE_SCOPE(c,n,d)		 G_GNUC_UNUSED gpointer G_PASTE(fu_trace_span_,__LINE__) = NULL
+#endif
+
+gboolean	 fu_trace_get_enabled		(void);
+void		 fu_trace_set_filename		(const gchar	*filename);
+const gchar	*fu_trace_get_filename		(void);
+void		 fu_trace_begin			(const gchar	*category,
+						 const gchar	*name,
+						 const gchar	*detail);
+void		 fu_trace_end			(const gchar	*category,
+						 const gchar	*name,
+						 const gchar	*detail);
+void		 fu_trace_counter		(const gchar	*category,
+						 const gchar	*name,
+						 gint64		 value);
+gchar		*fu_trace_to_string		(void);
+gboolean	 fu_trace_save			(GError		**error);
+void		 fu_trace_clear			(void);
+
+FuTraceSpan	*fu_trace_span_new		(const gchar	*category,
+						 const gchar	*name,
+						 const gchar	*detail);
+void		 fu_trace_span_free		(FuTraceSpan	*span);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuTraceSpan, fu_trace_span_free)
+
+G_END_DECLS
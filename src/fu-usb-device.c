@@ -392,6 +392,329 @@ fu_usb_device_get_dev (FuUsbDevice *device)
 	return priv->usb_device;
 }
 
+static void
+fu_usb_device_transfer_finish_cb (GObject *source, GAsyncResult *res,
+				  gboolean interrupt, GTask *task)
+{
+	FuChunk *chk = g_task_get_task_data (task);
+	GError *error = NULL;
+	gssize actual_len;
+
+	if (interrupt) {
+		actual_len = g_usb_device_interrupt_transfer_finish (G_USB_DEVICE (source),
+								     res, &error);
+	} else {
+		actual_len = g_usb_device_bulk_transfer_finish (G_USB_DEVICE (source),
+								res, &error);
+	}
+	if (actual_len < 0) {
+		g_task_return_error (task, error);
+		return;
+	}
+	if ((gsize) actual_len != chk->data_sz) {
+		g_task_return_new_error (task,
+					 G_IO_ERROR,
+					 G_IO_ERROR_INVALID_DATA,
+					 "only wrote 0x%04x of 0x%04x bytes",
+					 (guint) actual_len, chk->data_sz);
+		return;
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+fu_usb_device_bulk_transfer_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	fu_usb_device_transfer_finish_cb (source, res, FALSE, task);
+}
+
+static void
+fu_usb_device_interrupt_transfer_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	fu_usb_device_transfer_finish_cb (source, res, TRUE, task);
+}
+
+static void
+fu_usb_device_transfer_async (FuUsbDevice *self,
+			      guint8 endpoint,
+			      FuChunk *chk,
+			      guint timeout_ms,
+			      FuUsbDeviceTransferFlags flags,
+			      GCancellable *cancellable,
+			      GAsyncReadyCallback callback,
+			      gpointer user_data)
+{
+	FuUsbDevicePrivate *priv = GET_PRIVATE (self);
+	GTask *task = g_task_new (self, cancellable, callback, user_data);
+
+	if (priv->usb_device == NULL) {
+		g_task_return_new_error (task,
+					 G_IO_ERROR,
+					 G_IO_ERROR_NOT_INITIALIZED,
+					 "no GUsbDevice");
+		g_object_unref (task);
+		return;
+	}
+
+	/* the data is only read for OUT endpoints */
+	g_task_set_task_data (task, chk, NULL);
+	if (flags & FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT) {
+		g_usb_device_interrupt_transfer_async (priv->usb_device,
+						       endpoint,
+						       (guint8 *) chk->data,
+						       chk->data_sz,
+						       timeout_ms,
+						       cancellable,
+						       fu_usb_device_interrupt_transfer_cb,
+						       task);
+		return;
+	}
+	g_usb_device_bulk_transfer_async (priv->usb_device,
+					  endpoint,
+					  (guint8 *) chk->data,
+					  chk->data_sz,
+					  timeout_ms,
+					  cancellable,
+					  fu_usb_device_bulk_transfer_cb,
+					  task);
+}
+
+static gboolean
+fu_usb_device_transfer_finish (FuUsbDevice *self, GAsyncResult *res, GError **error)
+{
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+typedef struct {
+	guint8			 endpoint;
+	GPtrArray		*chunks;	/* of FuChunk */
+	guint			 queue_depth;
+	guint			 timeout_ms;
+	FuUsbDeviceTransferFlags flags;
+	guint			 idx_next;
+	guint			 in_flight;
+	gsize			 done_sz;
+	gsize			 total_sz;
+	GError			*error;
+} FuUsbDeviceQueueHelper;
+
+static void
+fu_usb_device_queue_helper_free (FuUsbDeviceQueueHelper *helper)
+{
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_ptr_array_unref (helper->chunks);
+	g_free (helper);
+}
+
+typedef struct {
+	GTask			*task;
+	FuChunk			*chk;
+} FuUsbDeviceQueueItem;
+
+static void fu_usb_device_queue_submit (GTask *task);
+
+static void
+fu_usb_device_queue_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUsbDevice *self = FU_USB_DEVICE (source);
+	FuUsbDeviceClass *klass = FU_USB_DEVICE_GET_CLASS (self);
+	FuUsbDeviceQueueItem *item = (FuUsbDeviceQueueItem *) user_data;
+	g_autoptr(GTask) task = item->task;
+	FuUsbDeviceQueueHelper *helper = g_task_get_task_data (task);
+	GError *error_local = NULL;
+
+	helper->in_flight--;
+	if (!klass->transfer_finish (self, res, &error_local)) {
+		/* keep the first error; anything after that is fallout */
+		if (helper->error == NULL)
+			helper->error = error_local;
+		else
+			g_error_free (error_local);
+	} else {
+		helper->done_sz += item->chk->data_sz;
+		fu_device_set_progress_full (FU_DEVICE (self),
+					     helper->done_sz,
+					     helper->total_sz);
+	}
+	g_free (item);
+
+	/* refill the queue, or finish when everything has drained */
+	fu_usb_device_queue_submit (task);
+}
+
+static void
+fu_usb_device_queue_submit (GTask *task)
+{
+	FuUsbDevice *self = FU_USB_DEVICE (g_task_get_source_object (task));
+	FuUsbDeviceClass *klass = FU_USB_DEVICE_GET_CLASS (self);
+	FuUsbDeviceQueueHelper *helper = g_task_get_task_data (task);
+
+	/* stop submitting on the first failure */
+	while (helper->error == NULL &&
+	       helper->in_flight < helper->queue_depth &&
+	       helper->idx_next < helper->chunks->len) {
+		FuUsbDeviceQueueItem *item = g_new0 (FuUsbDeviceQueueItem, 1);
+		item->task = g_object_ref (task);
+		item->chk = g_ptr_array_index (helper->chunks, helper->idx_next++);
+		helper->in_flight++;
+		klass->transfer_async (self,
+				       helper->endpoint,
+				       item->chk,
+				       helper->timeout_ms,
+				       helper->flags,
+				       g_task_get_cancellable (task),
+				       fu_usb_device_queue_cb,
+				       item);
+	}
+	if (helper->in_flight > 0)
+		return;
+	if (helper->error != NULL) {
+		g_task_return_error (task, g_steal_pointer (&helper->error));
+		return;
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * fu_usb_device_write_chunks_async:
+ * @device: A #FuUsbDevice
+ * @endpoint: the OUT endpoint address
+ * @chunks: (element-type FuChunk): data to send
+ * @queue_depth: the number of transfers to keep in flight, e.g. %FU_USB_DEVICE_TRANSFER_QUEUE_DEPTH
+ * @timeout_ms: timeout for each transfer in ms
+ * @flags: some #FuUsbDeviceTransferFlags, e.g. %FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT
+ * @cancellable: A #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Sends each chunk as a separate transfer, submitting the next chunk as soon
+ * as a previous transfer completes so that the bus is never idle. The device
+ * progress is updated as each chunk is written.
+ *
+ * If any transfer fails no more chunks are submitted, and the first error is
+ * returned once the in-flight transfers have completed.
+ *
+ * Since: 1.2.6
+ **/
+void
+fu_usb_device_write_chunks_async (FuUsbDevice *device,
+				  guint8 endpoint,
+				  GPtrArray *chunks,
+				  guint queue_depth,
+				  guint timeout_ms,
+				  FuUsbDeviceTransferFlags flags,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer user_data)
+{
+	FuUsbDeviceQueueHelper *helper;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FU_IS_USB_DEVICE (device));
+	g_return_if_fail (chunks != NULL);
+	g_return_if_fail (queue_depth > 0);
+
+	helper = g_new0 (FuUsbDeviceQueueHelper, 1);
+	helper->endpoint = endpoint;
+	helper->chunks = g_ptr_array_ref (chunks);
+	helper->queue_depth = queue_depth;
+	helper->timeout_ms = timeout_ms;
+	helper->flags = flags;
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		helper->total_sz += chk->data_sz;
+	}
+	task = g_task_new (device, cancellable, callback, user_data);
+	g_task_set_task_data (task, helper, (GDestroyNotify) fu_usb_device_queue_helper_free);
+	fu_usb_device_queue_submit (task);
+}
+
+/**
+ * fu_usb_device_write_chunks_finish:
+ * @device: A #FuUsbDevice
+ * @res: A #GAsyncResult
+ * @error: A #GError, or %NULL
+ *
+ * Gets the result of fu_usb_device_write_chunks_async().
+ *
+ * Returns: %TRUE if every chunk was written
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_usb_device_write_chunks_finish (FuUsbDevice *device, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FU_IS_USB_DEVICE (device), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, device), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+typedef struct {
+	GMainLoop		*loop;
+	GAsyncResult		*res;
+} FuUsbDeviceSyncHelper;
+
+static void
+fu_usb_device_write_chunks_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUsbDeviceSyncHelper *helper = (FuUsbDeviceSyncHelper *) user_data;
+	helper->res = g_object_ref (res);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fu_usb_device_write_chunks:
+ * @device: A #FuUsbDevice
+ * @endpoint: the OUT endpoint address
+ * @chunks: (element-type FuChunk): data to send
+ * @queue_depth: the number of transfers to keep in flight, e.g. %FU_USB_DEVICE_TRANSFER_QUEUE_DEPTH
+ * @timeout_ms: timeout for each transfer in ms
+ * @flags: some #FuUsbDeviceTransferFlags, e.g. %FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT
+ * @error: A #GError, or %NULL
+ *
+ * Synchronously sends each chunk using fu_usb_device_write_chunks_async().
+ * This can be used in place of a loop of g_usb_device_bulk_transfer() calls.
+ *
+ * Returns: %TRUE if every chunk was written
+ *
+ * Since: 1.2.6
+ **/
+gboolean
+fu_usb_device_write_chunks (FuUsbDevice *device,
+			    guint8 endpoint,
+			    GPtrArray *chunks,
+			    guint queue_depth,
+			    guint timeout_ms,
+			    FuUsbDeviceTransferFlags flags,
+			    GError **error)
+{
+	gboolean ret;
+	FuUsbDeviceSyncHelper helper = { NULL };
+	g_autoptr(GMainContext) context = g_main_context_new ();
+
+	g_return_val_if_fail (FU_IS_USB_DEVICE (device), FALSE);
+	g_return_val_if_fail (chunks != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* run the queue on a private context so nothing else is dispatched */
+	g_main_context_push_thread_default (context);
+	helper.loop = g_main_loop_new (context, FALSE);
+	fu_usb_device_write_chunks_async (device, endpoint, chunks,
+					  MAX (queue_depth, 1), timeout_ms, flags,
+					  NULL, fu_usb_device_write_chunks_cb, &helper);
+	if (helper.res == NULL)
+		g_main_loop_run (helper.loop);
+	g_main_context_pop_thread_default (context);
+	ret = fu_usb_device_write_chunks_finish (device, helper.res, error);
+	g_object_unref (helper.res);
+	g_main_loop_unref (helper.loop);
+	return ret;
+}
+
 static void
 fu_usb_device_incorporate (FuDevice *self, FuDevice *donor)
 {
@@ -433,6 +756,8 @@ fu_usb_device_class_init (FuUsbDeviceClass *klass)
 	device_class->close = fu_usb_device_close;
 	device_class->probe = fu_usb_device_probe;
 	device_class->incorporate = fu_usb_device_incorporate;
+	klass->transfer_async = fu_usb_device_transfer_async;
+	klass->transfer_finish = fu_usb_device_transfer_finish;
 
 	pspec = g_param_spec_object ("usb-device", NULL, NULL,
 				     G_USB_TYPE_DEVICE,
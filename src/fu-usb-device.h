@@ -9,6 +9,7 @@
 #include <glib-object.h>
 #include <gusb.h>
 
+#include "fu-chunk.h"
 #include "fu-plugin.h"
 
 G_BEGIN_DECLS
@@ -26,6 +27,23 @@ G_DECLARE_DERIVABLE_TYPE (FuUsbDevice, fu_usb_device, FU, USB_DEVICE, FuDevice)
 
 #define HID_FEATURE					0x0300
 
+/**
+ * FuUsbDeviceTransferFlags:
+ * @FU_USB_DEVICE_TRANSFER_FLAG_NONE:		No flags set
+ * @FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT:	Use interrupt rather than bulk transfers
+ *
+ * Flags used when queuing transfers.
+ **/
+typedef enum {
+	FU_USB_DEVICE_TRANSFER_FLAG_NONE	= 0,		/* Since: 1.2.6 */
+	FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT	= 1 << 0,	/* Since: 1.2.6 */
+	/*< private >*/
+	FU_USB_DEVICE_TRANSFER_FLAG_LAST
+} FuUsbDeviceTransferFlags;
+
+/* the number of transfers that should be kept in flight by default */
+#define FU_USB_DEVICE_TRANSFER_QUEUE_DEPTH		4
+
 struct _FuUsbDeviceClass
 {
 	FuDeviceClass	parent_class;
@@ -35,7 +53,18 @@ struct _FuUsbDeviceClass
 						 GError			**error);
 	gboolean	 (*probe)		(FuUsbDevice		*device,
 						 GError			**error);
-	gpointer	__reserved[28];
+	void		 (*transfer_async)	(FuUsbDevice		*device,
+						 guint8			 endpoint,
+						 FuChunk		*chk,
+						 guint			 timeout_ms,
+						 FuUsbDeviceTransferFlags flags,
+						 GCancellable		*cancellable,
+						 GAsyncReadyCallback	 callback,
+						 gpointer		 user_data);
+	gboolean	 (*transfer_finish)	(FuUsbDevice		*device,
+						 GAsyncResult		*res,
+						 GError			**error);
+	gpointer	__reserved[26];
 };
 
 FuUsbDevice	*fu_usb_device_new			(GUsbDevice	*usb_device);
@@ -45,5 +74,24 @@ GUsbDevice	*fu_usb_device_get_dev			(FuUsbDevice	*device);
 void		 fu_usb_device_set_dev			(FuUsbDevice	*device,
 							 GUsbDevice	*usb_device);
 gboolean	 fu_usb_device_is_open			(FuUsbDevice	*device);
+void		 fu_usb_device_write_chunks_async	(FuUsbDevice	*device,
+							 guint8		 endpoint,
+							 GPtrArray	*chunks,
+							 guint		 queue_depth,
+							 guint		 timeout_ms,
+							 FuUsbDeviceTransferFlags flags,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fu_usb_device_write_chunks_finish	(FuUsbDevice	*device,
+							 GAsyncResult	*res,
+							 GError		**error);
+gboolean	 fu_usb_device_write_chunks		(FuUsbDevice	*device,
+							 guint8		 endpoint,
+							 GPtrArray	*chunks,
+							 guint		 queue_depth,
+							 guint		 timeout_ms,
+							 FuUsbDeviceTransferFlags flags,
+							 GError		**error);
 
 G_END_DECLS
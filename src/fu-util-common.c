@@ -460,3 +460,16 @@ fu_util_setup_networking (GError **error)
 	soup_session_remove_feature_by_type (session, SOUP_TYPE_CONTENT_DECODER);
 	return g_steal_pointer (&session);
 }
+
+/* sorts the {sa{sv}} items from fu_stats_to_variant() by ID */
+gint
+fu_util_sort_stats_cb (gconstpointer a, gconstpointer b)
+{
+	GVariant *va = *((GVariant **) a);
+	GVariant *vb = *((GVariant **) b);
+	const gchar *ida = NULL;
+	const gchar *idb = NULL;
+	g_variant_get_child (va, 0, "&s", &ida);
+	g_variant_get_child (vb, 0, "&s", &idb);
+	return g_strcmp0 (ida, idb);
+}
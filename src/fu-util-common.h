@@ -37,6 +37,8 @@ gchar		*fu_util_get_user_cache_path	(const gchar	*fn);
 SoupSession	*fu_util_setup_networking	(GError		**error);
 
 gchar		*fu_util_get_versions		(void);
+gint		 fu_util_sort_stats_cb		(gconstpointer	 a,
+						 gconstpointer	 b);
 
 gboolean	fu_util_prompt_complete		(FwupdDeviceFlags flags,
 						 gboolean prompt,
@@ -10,6 +10,7 @@
 
 #include <fwupd.h>
 #include <xmlb.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <glib/gstdio.h>
 #include <gio/gio.h>
@@ -20,6 +21,7 @@
 #include <json-glib/json-glib.h>
 #include <locale.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "fu-history.h"
@@ -31,6 +33,9 @@
 /* custom return code */
 #define EXIT_NOTHING_TO_DO		2
 
+#define FU_UTIL_DOWNLOAD_CHUNK_SIZE	0x8000	/* bytes */
+#define FU_UTIL_DOWNLOAD_MAX_PARALLEL	4
+
 typedef enum {
 	FU_UTIL_OPERATION_UNKNOWN,
 	FU_UTIL_OPERATION_UPDATE,
@@ -39,6 +44,8 @@ typedef enum {
 	FU_UTIL_OPERATION_LAST
 } FuUtilOperation;
 
+typedef struct FuUtilDownload FuUtilDownload;
+
 struct FuUtilPrivate {
 	GCancellable		*cancellable;
 	GMainLoop		*loop;
@@ -58,6 +65,33 @@ struct FuUtilPrivate {
 	FwupdDevice		*current_device;
 	gchar			*current_message;
 	FwupdDeviceFlags	 completion_flags;
+	FuUtilDownload		*current_download;
+};
+
+struct FuUtilDownload {
+	FuUtilPrivate		*priv;
+	FwupdDevice		*device;	/* nullable */
+	FwupdRelease		*release;	/* nullable */
+	FuUtilDownload		*shared;	/* nullable, not owned */
+	GCancellable		*cancellable;
+	gulong			 cancellable_id;
+	SoupURI			*uri;
+	SoupMessage		*msg;
+	GInputStream		*istream;
+	GOutputStream		*ostream;
+	GChecksum		*checksum;
+	gchar			*uri_str;
+	gchar			*filename;
+	gchar			*filename_part;
+	gchar			*checksum_expected;
+	gchar			*etag;
+	gchar			*last_modified;
+	goffset			 size_done;
+	goffset			 size_total;
+	gboolean		 conditional;
+	gboolean		 not_modified;
+	gboolean		 done;
+	GError			*error;
 };
 
 static gboolean	fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error);
@@ -959,53 +993,421 @@ fu_util_file_exists_with_checksum (const gchar *fn,
 }
 
 static void
-fu_util_download_chunk_cb (SoupMessage *msg, SoupBuffer *chunk, gpointer user_data)
+fu_util_download_free (FuUtilDownload *dl)
+{
+	if (dl->device != NULL)
+		g_object_unref (dl->device);
+	if (dl->release != NULL)
+		g_object_unref (dl->release);
+	if (dl->uri != NULL)
+		soup_uri_free (dl->uri);
+	if (dl->msg != NULL)
+		g_object_unref (dl->msg);
+	if (dl->istream != NULL)
+		g_object_unref (dl->istream);
+	if (dl->ostream != NULL)
+		g_object_unref (dl->ostream);
+	if (dl->checksum != NULL)
+		g_checksum_free (dl->checksum);
+	if (dl->error != NULL)
+		g_error_free (dl->error);
+	g_cancellable_disconnect (dl->priv->cancellable, dl->cancellable_id);
+	g_object_unref (dl->cancellable);
+	g_free (dl->uri_str);
+	g_free (dl->filename);
+	g_free (dl->filename_part);
+	g_free (dl->checksum_expected);
+	g_free (dl->etag);
+	g_free (dl->last_modified);
+	g_free (dl);
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuUtilDownload, fu_util_download_free)
+#pragma clang diagnostic pop
+
+/* SIGINT cancels every download in flight */
+static void
+fu_util_download_cancelled_cb (GCancellable *cancellable, gpointer user_data)
+{
+	FuUtilDownload *dl = (FuUtilDownload *) user_data;
+	g_cancellable_cancel (dl->cancellable);
+}
+
+static FuUtilDownload *
+fu_util_download_new (FuUtilPrivate *priv,
+		      SoupURI *uri,
+		      const gchar *fn,
+		      const gchar *checksum_expected)
+{
+	FuUtilDownload *dl = g_new0 (FuUtilDownload, 1);
+	dl->priv = priv;
+	dl->cancellable = g_cancellable_new ();
+	dl->cancellable_id = g_cancellable_connect (priv->cancellable,
+						    G_CALLBACK (fu_util_download_cancelled_cb),
+						    dl, NULL);
+	dl->filename = g_strdup (fn);
+	dl->filename_part = g_strdup_printf ("%s.part", fn);
+	dl->checksum_expected = g_strdup (checksum_expected);
+	if (uri != NULL) {
+		dl->uri = soup_uri_copy (uri);
+		dl->uri_str = soup_uri_to_string (uri, FALSE);
+	}
+	return dl;
+}
+
+static void
+fu_util_download_done (FuUtilDownload *dl, GError *error)
+{
+	if (error != NULL) {
+		g_debug ("failed to download %s: %s", dl->uri_str, error->message);
+		g_propagate_error (&dl->error, error);
+	}
+	if (dl->ostream != NULL)
+		g_output_stream_close (dl->ostream, NULL, NULL);
+	g_clear_object (&dl->istream);
+	g_clear_object (&dl->ostream);
+	g_clear_object (&dl->msg);
+	dl->done = TRUE;
+}
+
+static void
+fu_util_download_update_progress (FuUtilDownload *dl)
 {
 	guint percentage;
-	goffset header_size;
-	goffset body_length;
-	FuUtilPrivate *priv = (FuUtilPrivate *) user_data;
 
-	/* if it's returning "Found" or an error, ignore the percentage */
-	if (msg->status_code != SOUP_STATUS_OK) {
-		g_debug ("ignoring status code %u (%s)",
-			 msg->status_code, msg->reason_phrase);
+	/* only the download being waited for is shown */
+	if (dl->priv->current_download != dl)
 		return;
-	}
-
-	/* get data */
-	body_length = msg->response_body->length;
-	header_size = soup_message_headers_get_content_length (msg->response_headers);
 
 	/* size is not known */
-	if (header_size < body_length)
+	if (dl->size_total == 0 || dl->size_total < dl->size_done)
 		return;
 
 	/* calulate percentage */
-	percentage = (guint) ((100 * body_length) / header_size);
+	percentage = (guint) ((100 * dl->size_done) / dl->size_total);
 	g_debug ("progress: %u%%", percentage);
-	fu_progressbar_update (priv->progressbar, FWUPD_STATUS_DOWNLOADING, percentage);
+	fu_progressbar_update (dl->priv->progressbar, FWUPD_STATUS_DOWNLOADING, percentage);
+}
+
+/* the ETag and Last-Modified values are stored next to the cached file */
+static gchar *
+fu_util_download_get_validators_fn (FuUtilDownload *dl)
+{
+	return g_strdup_printf ("%s.validators", dl->filename);
+}
+
+static void
+fu_util_download_save_validators (FuUtilDownload *dl)
+{
+	g_autofree gchar *fn = fu_util_download_get_validators_fn (dl);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	if (dl->etag == NULL && dl->last_modified == NULL) {
+		g_unlink (fn);
+		return;
+	}
+	if (dl->etag != NULL)
+		g_key_file_set_string (kf, "fwupd", "ETag", dl->etag);
+	if (dl->last_modified != NULL)
+		g_key_file_set_string (kf, "fwupd", "LastModified", dl->last_modified);
+	if (!g_key_file_save_to_file (kf, fn, &error_local))
+		g_debug ("failed to save %s: %s", fn, error_local->message);
+}
+
+static void
+fu_util_download_add_validators (FuUtilDownload *dl)
+{
+	g_autofree gchar *etag = NULL;
+	g_autofree gchar *fn = fu_util_download_get_validators_fn (dl);
+	g_autofree gchar *last_modified = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	/* the validators are useless without the file they describe */
+	if (!g_file_test (dl->filename, G_FILE_TEST_EXISTS))
+		return;
+	if (!g_key_file_load_from_file (kf, fn, G_KEY_FILE_NONE, NULL))
+		return;
+	etag = g_key_file_get_string (kf, "fwupd", "ETag", NULL);
+	if (etag != NULL) {
+		soup_message_headers_replace (dl->msg->request_headers,
+					      "If-None-Match", etag);
+	}
+	last_modified = g_key_file_get_string (kf, "fwupd", "LastModified", NULL);
+	if (last_modified != NULL) {
+		soup_message_headers_replace (dl->msg->request_headers,
+					      "If-Modified-Since", last_modified);
+	}
+}
+
+static void
+fu_util_download_finish (FuUtilDownload *dl)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	/* flush before the file is moved into place */
+	if (!g_output_stream_close (dl->ostream, dl->cancellable, &error_local)) {
+		fu_util_download_done (dl, g_error_new (FWUPD_ERROR,
+							FWUPD_ERROR_WRITE,
+							"Failed to save file: %s",
+							error_local->message));
+		return;
+	}
+
+	/* verify checksum */
+	if (dl->checksum != NULL) {
+		const gchar *checksum_actual = g_checksum_get_string (dl->checksum);
+		if (g_strcmp0 (dl->checksum_expected, checksum_actual) != 0) {
+			g_unlink (dl->filename_part);
+			fu_util_download_done (dl, g_error_new (FWUPD_ERROR,
+								FWUPD_ERROR_INVALID_FILE,
+								"Checksum invalid, expected %s got %s",
+								dl->checksum_expected,
+								checksum_actual));
+			return;
+		}
+	}
+
+	/* save file */
+	if (g_rename (dl->filename_part, dl->filename) != 0) {
+		fu_util_download_done (dl, g_error_new (FWUPD_ERROR,
+							FWUPD_ERROR_WRITE,
+							"Failed to save file: %s",
+							g_strerror (errno)));
+		return;
+	}
+	if (dl->conditional)
+		fu_util_download_save_validators (dl);
+	fu_util_download_done (dl, NULL);
+}
+
+static void
+fu_util_download_read_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUtilDownload *dl = (FuUtilDownload *) user_data;
+	GError *error = NULL;
+	g_autoptr(GBytes) blob = NULL;
+
+	blob = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source), res, &error);
+	if (blob == NULL) {
+		fu_util_download_done (dl, error);
+		return;
+	}
+
+	/* EOF */
+	if (g_bytes_get_size (blob) == 0) {
+		fu_util_download_finish (dl);
+		return;
+	}
+
+	/* write straight to disk, hashing as the data arrives */
+	if (!g_output_stream_write_all (dl->ostream,
+					g_bytes_get_data (blob, NULL),
+					g_bytes_get_size (blob),
+					NULL, dl->cancellable, &error)) {
+		fu_util_download_done (dl, error);
+		return;
+	}
+	if (dl->checksum != NULL) {
+		g_checksum_update (dl->checksum,
+				   g_bytes_get_data (blob, NULL),
+				   g_bytes_get_size (blob));
+	}
+	dl->size_done += g_bytes_get_size (blob);
+	fu_util_download_update_progress (dl);
+
+	/* next chunk */
+	g_input_stream_read_bytes_async (dl->istream,
+					 FU_UTIL_DOWNLOAD_CHUNK_SIZE,
+					 G_PRIORITY_DEFAULT,
+					 dl->cancellable,
+					 fu_util_download_read_cb,
+					 dl);
+}
+
+/* seed the checksum with the data we already have; this is only done
+ * when there is a checksum to verify as we otherwise cannot know if
+ * the partial file is from an older version of the same URI */
+static void
+fu_util_download_seed_part (FuUtilDownload *dl, gboolean resume)
+{
+	g_autofree guchar *buf = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFileInputStream) istream = NULL;
+
+	/* start again from scratch */
+	if (dl->checksum != NULL)
+		g_checksum_reset (dl->checksum);
+	dl->size_done = 0;
+	if (!resume || dl->checksum == NULL)
+		return;
+
+	/* hash in chunks rather than loading the whole file */
+	file = g_file_new_for_path (dl->filename_part);
+	istream = g_file_read (file, NULL, NULL);
+	if (istream == NULL)
+		return;
+	buf = g_malloc (FU_UTIL_DOWNLOAD_CHUNK_SIZE);
+	for (;;) {
+		gssize len = g_input_stream_read (G_INPUT_STREAM (istream), buf,
+						  FU_UTIL_DOWNLOAD_CHUNK_SIZE,
+						  NULL, NULL);
+		if (len < 0) {
+			g_checksum_reset (dl->checksum);
+			dl->size_done = 0;
+			return;
+		}
+		if (len == 0)
+			break;
+		g_checksum_update (dl->checksum, buf, len);
+		dl->size_done += len;
+	}
 }
 
 static gboolean
-fu_util_download_file (FuUtilPrivate *priv,
-		       SoupURI *uri,
-		       const gchar *fn,
-		       const gchar *checksum_expected,
-		       GError **error)
+fu_util_download_open_part (FuUtilDownload *dl, gboolean append, GError **error)
 {
-	GChecksumType checksum_type;
+	g_autoptr(GFile) file = g_file_new_for_path (dl->filename_part);
+	if (append) {
+		dl->ostream = G_OUTPUT_STREAM (g_file_append_to (file,
+								 G_FILE_CREATE_NONE,
+								 dl->cancellable,
+								 error));
+	} else {
+		dl->ostream = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
+							       G_FILE_CREATE_NONE,
+							       dl->cancellable,
+							       error));
+	}
+	return dl->ostream != NULL;
+}
+
+static void fu_util_download_send (FuUtilDownload *dl, gboolean resume);
+
+static void
+fu_util_download_send_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUtilDownload *dl = (FuUtilDownload *) user_data;
+	GError *error = NULL;
 	guint status_code;
-	g_autoptr(GError) error_local = NULL;
-	g_autofree gchar *checksum_actual = NULL;
-	g_autofree gchar *uri_str = NULL;
-	g_autoptr(SoupMessage) msg = NULL;
+
+	dl->istream = soup_session_send_finish (SOUP_SESSION (source), res, &error);
+	if (dl->istream == NULL) {
+		fu_util_download_done (dl, error);
+		return;
+	}
+	status_code = dl->msg->status_code;
+
+	/* the partial file is bigger than the remote file, so try again */
+	if (status_code == SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE &&
+	    dl->size_done > 0) {
+		g_debug ("cannot resume %s, restarting", dl->uri_str);
+		g_clear_object (&dl->istream);
+		g_clear_object (&dl->msg);
+		fu_util_download_send (dl, FALSE);
+		return;
+	}
+	if (status_code == 429) {
+		fu_util_download_done (dl, g_error_new (FWUPD_ERROR,
+							FWUPD_ERROR_INVALID_FILE,
+							/* TRANSLATORS: the server is rate-limiting downloads */
+							"%s", _("Failed to download due to server limit")));
+		return;
+	}
+	if (status_code == SOUP_STATUS_NOT_MODIFIED && dl->conditional) {
+		g_debug ("%s not modified", dl->uri_str);
+		dl->not_modified = TRUE;
+		fu_util_download_done (dl, NULL);
+		return;
+	}
+	if (status_code != SOUP_STATUS_OK &&
+	    status_code != SOUP_STATUS_PARTIAL_CONTENT) {
+		fu_util_download_done (dl, g_error_new (FWUPD_ERROR,
+							FWUPD_ERROR_INVALID_FILE,
+							"Failed to download %s: %s",
+							dl->uri_str,
+							soup_status_get_phrase (status_code)));
+		return;
+	}
+	if (status_code == SOUP_STATUS_OK && dl->size_done > 0) {
+		g_debug ("server ignored range request for %s", dl->uri_str);
+		fu_util_download_seed_part (dl, FALSE);
+	}
+	if (!fu_util_download_open_part (dl, dl->size_done > 0, &error)) {
+		fu_util_download_done (dl, error);
+		return;
+	}
+	dl->etag = g_strdup (soup_message_headers_get_one (dl->msg->response_headers,
+							   "ETag"));
+	dl->last_modified = g_strdup (soup_message_headers_get_one (dl->msg->response_headers,
+								    "Last-Modified"));
+	dl->size_total = dl->size_done +
+		soup_message_headers_get_content_length (dl->msg->response_headers);
+
+	/* read the first chunk */
+	g_input_stream_read_bytes_async (dl->istream,
+					 FU_UTIL_DOWNLOAD_CHUNK_SIZE,
+					 G_PRIORITY_DEFAULT,
+					 dl->cancellable,
+					 fu_util_download_read_cb,
+					 dl);
+}
+
+static void
+fu_util_download_send (FuUtilDownload *dl, gboolean resume)
+{
+	fu_util_download_seed_part (dl, resume);
+	dl->msg = soup_message_new_from_uri (SOUP_METHOD_GET, dl->uri);
+	if (dl->msg == NULL) {
+		fu_util_download_done (dl, g_error_new (FWUPD_ERROR,
+							FWUPD_ERROR_INVALID_FILE,
+							"Failed to parse URI %s",
+							dl->uri_str));
+		return;
+	}
+	if (dl->size_done > 0) {
+		g_debug ("resuming %s from %" G_GOFFSET_FORMAT,
+			 dl->uri_str, dl->size_done);
+		soup_message_headers_set_range (dl->msg->request_headers,
+						dl->size_done, -1);
+	}
+	if (dl->conditional)
+		fu_util_download_add_validators (dl);
+	soup_session_send_async (dl->priv->soup_session, dl->msg,
+				 dl->cancellable,
+				 fu_util_download_send_cb,
+				 dl);
+}
+
+/* starts downloading in the background, streaming the body to disk */
+static gboolean
+fu_util_download_start (FuUtilDownload *dl, GError **error)
+{
+	FuUtilPrivate *priv = dl->priv;
+	GChecksumType checksum_type;
 
 	/* check if the file already exists with the right checksum */
-	checksum_type = fwupd_checksum_guess_kind (checksum_expected);
-	if (fu_util_file_exists_with_checksum (fn, checksum_expected, checksum_type)) {
-		g_debug ("skpping download as file already exists");
-		return TRUE;
+	if (dl->checksum_expected != NULL) {
+		checksum_type = fwupd_checksum_guess_kind (dl->checksum_expected);
+		if (fu_util_file_exists_with_checksum (dl->filename,
+						       dl->checksum_expected,
+						       checksum_type)) {
+			g_debug ("skpping download as file already exists");
+			dl->done = TRUE;
+			return TRUE;
+		}
+		dl->checksum = g_checksum_new (checksum_type);
+	}
+
+	/* invalid URI */
+	if (dl->uri == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "Failed to parse URI for %s", dl->filename);
+		return FALSE;
 	}
 
 	/* set up networking */
@@ -1013,92 +1415,107 @@ fu_util_download_file (FuUtilPrivate *priv,
 		priv->soup_session = fu_util_setup_networking (error);
 		if (priv->soup_session == NULL)
 			return FALSE;
+		g_object_set (priv->soup_session,
+			      SOUP_SESSION_MAX_CONNS_PER_HOST,
+			      FU_UTIL_DOWNLOAD_MAX_PARALLEL,
+			      NULL);
 	}
 
 	/* download data */
-	uri_str = soup_uri_to_string (uri, FALSE);
-	g_debug ("downloading %s to %s", uri_str, fn);
-	msg = soup_message_new_from_uri (SOUP_METHOD_GET, uri);
-	if (msg == NULL) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "Failed to parse URI %s", uri_str);
-		return FALSE;
-	}
-	if (g_str_has_suffix (uri_str, ".asc") ||
-	    g_str_has_suffix (uri_str, ".p7b") ||
-	    g_str_has_suffix (uri_str, ".p7c")) {
+	g_debug ("downloading %s to %s", dl->uri_str, dl->filename);
+	if (g_str_has_suffix (dl->uri_str, ".asc") ||
+	    g_str_has_suffix (dl->uri_str, ".p7b") ||
+	    g_str_has_suffix (dl->uri_str, ".p7c")) {
 		/* TRANSLATORS: downloading new signing file */
-		g_print ("%s %s\n", _("Fetching signature"), uri_str);
-	} else if (g_str_has_suffix (uri_str, ".gz")) {
+		g_print ("%s %s\n", _("Fetching signature"), dl->uri_str);
+	} else if (g_str_has_suffix (dl->uri_str, ".gz")) {
 		/* TRANSLATORS: downloading new metadata file */
-		g_print ("%s %s\n", _("Fetching metadata"), uri_str);
-	} else if (g_str_has_suffix (uri_str, ".cab")) {
+		g_print ("%s %s\n", _("Fetching metadata"), dl->uri_str);
+	} else if (g_str_has_suffix (dl->uri_str, ".cab")) {
 		/* TRANSLATORS: downloading new firmware file */
-		g_print ("%s %s\n", _("Fetching firmware"), uri_str);
+		g_print ("%s %s\n", _("Fetching firmware"), dl->uri_str);
 	} else {
 		/* TRANSLATORS: downloading unknown file */
-		g_print ("%s %s\n", _("Fetching file"), uri_str);
-	}
-	g_signal_connect (msg, "got-chunk",
-			  G_CALLBACK (fu_util_download_chunk_cb), priv);
-	status_code = soup_session_send_message (priv->soup_session, msg);
-	g_print ("\n");
-	if (status_code == 429) {
-		g_autofree gchar *str = g_strndup (msg->response_body->data,
-						   msg->response_body->length);
-		if (g_strcmp0 (str, "Too Many Requests") == 0) {
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     /* TRANSLATORS: the server is rate-limiting downloads */
-				     "%s", _("Failed to download due to server limit"));
-			return FALSE;
-		}
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "Failed to download due to server limit: %s", str);
-		return FALSE;
+		g_print ("%s %s\n", _("Fetching file"), dl->uri_str);
 	}
-	if (status_code != SOUP_STATUS_OK) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "Failed to download %s: %s",
-			     uri_str, soup_status_get_phrase (status_code));
+	fu_util_download_send (dl, TRUE);
+	return TRUE;
+}
+
+/* blocks until the download has completed, showing progress */
+static gboolean
+fu_util_download_wait (FuUtilDownload *dl, GError **error)
+{
+	FuUtilPrivate *priv = dl->priv;
+	gboolean was_done;
+
+	/* the same file is being fetched for another device */
+	if (dl->shared != NULL)
+		dl = dl->shared;
+	was_done = dl->done;
+	priv->current_download = dl;
+	fu_util_download_update_progress (dl);
+	while (!dl->done)
+		g_main_context_iteration (NULL, TRUE);
+	priv->current_download = NULL;
+	if (!was_done)
+		g_print ("\n");
+	if (dl->error != NULL) {
+		g_propagate_error (error, g_error_copy (dl->error));
 		return FALSE;
 	}
+	return TRUE;
+}
 
-	/* verify checksum */
-	if (checksum_expected != NULL) {
-		checksum_actual = g_compute_checksum_for_data (checksum_type,
-							       (guchar *) msg->response_body->data,
-							       (gsize) msg->response_body->length);
-		if (g_strcmp0 (checksum_expected, checksum_actual) != 0) {
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "Checksum invalid, expected %s got %s",
-				     checksum_expected, checksum_actual);
-			return FALSE;
-		}
+/* cancels any outstanding downloads and waits for the callbacks to fire */
+static void
+fu_util_download_cancel_all (GPtrArray *downloads)
+{
+	for (guint i = 0; i < downloads->len; i++) {
+		FuUtilDownload *dl = g_ptr_array_index (downloads, i);
+		g_cancellable_cancel (dl->cancellable);
 	}
+	for (guint i = 0; i < downloads->len; i++) {
+		FuUtilDownload *dl = g_ptr_array_index (downloads, i);
+		if (dl->shared != NULL)
+			continue;
+		while (!dl->done)
+			g_main_context_iteration (NULL, TRUE);
+	}
+}
 
-	/* save file */
-	if (!g_file_set_contents (fn,
-				  msg->response_body->data,
-				  msg->response_body->length,
-				  &error_local)) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_WRITE,
-			     "Failed to save file: %s",
-			     error_local->message);
+static gboolean
+fu_util_download_file (FuUtilPrivate *priv,
+		       SoupURI *uri,
+		       const gchar *fn,
+		       const gchar *checksum_expected,
+		       GError **error)
+{
+	g_autoptr(FuUtilDownload) dl = fu_util_download_new (priv, uri, fn, checksum_expected);
+	if (!fu_util_download_start (dl, error))
 		return FALSE;
-	}
-	return TRUE;
+	return fu_util_download_wait (dl, error);
+}
+
+/* if the daemon already has this signature it has the same metadata too */
+static gboolean
+fu_util_remote_has_signature (FwupdRemote *remote, const gchar *filename_asc)
+{
+	const gchar *filename_sig = fwupd_remote_get_filename_cache_sig (remote);
+	gsize len = 0;
+	gsize len_old = 0;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *data_old = NULL;
+
+	if (fwupd_remote_get_keyring_kind (remote) == FWUPD_KEYRING_KIND_NONE)
+		return FALSE;
+	if (filename_sig == NULL)
+		return FALSE;
+	if (!g_file_get_contents (filename_sig, &data_old, &len_old, NULL))
+		return FALSE;
+	if (!g_file_get_contents (filename_asc, &data, &len, NULL))
+		return FALSE;
+	return len == len_old && memcmp (data, data_old, len) == 0;
 }
 
 static gboolean
@@ -1106,12 +1523,15 @@ fu_util_download_metadata_for_remote (FuUtilPrivate *priv,
 				      FwupdRemote *remote,
 				      GError **error)
 {
+	gboolean force = (priv->flags & FWUPD_INSTALL_FLAG_FORCE) > 0;
 	g_autofree gchar *basename_asc = NULL;
 	g_autofree gchar *basename_id_asc = NULL;
 	g_autofree gchar *basename_id = NULL;
 	g_autofree gchar *basename = NULL;
 	g_autofree gchar *filename = NULL;
 	g_autofree gchar *filename_asc = NULL;
+	g_autoptr(FuUtilDownload) dl = NULL;
+	g_autoptr(FuUtilDownload) dl_sig = NULL;
 	g_autoptr(SoupURI) uri = NULL;
 	g_autoptr(SoupURI) uri_sig = NULL;
 
@@ -1119,21 +1539,39 @@ fu_util_download_metadata_for_remote (FuUtilPrivate *priv,
 	basename = g_path_get_basename (fwupd_remote_get_filename_cache (remote));
 	basename_id = g_strdup_printf ("%s-%s", fwupd_remote_get_id (remote), basename);
 
-	/* download the metadata */
-	filename = fu_util_get_user_cache_path (basename_id);
-	if (!fu_common_mkdir_parent (filename, error))
-		return FALSE;
-	uri = soup_uri_new (fwupd_remote_get_metadata_uri (remote));
-	if (!fu_util_download_file (priv, uri, filename, NULL, error))
-		return FALSE;
-
-	/* download the signature */
+	/* download the signature first as it is tiny */
 	basename_asc = g_path_get_basename (fwupd_remote_get_filename_cache_sig (remote));
 	basename_id_asc = g_strdup_printf ("%s-%s", fwupd_remote_get_id (remote), basename_asc);
 	filename_asc = fu_util_get_user_cache_path (basename_id_asc);
+	if (!fu_common_mkdir_parent (filename_asc, error))
+		return FALSE;
 	uri_sig = soup_uri_new (fwupd_remote_get_metadata_uri_sig (remote));
-	if (!fu_util_download_file (priv, uri_sig, filename_asc, NULL, error))
+	dl_sig = fu_util_download_new (priv, uri_sig, filename_asc, NULL);
+	dl_sig->conditional = !force;
+	if (!fu_util_download_start (dl_sig, error))
+		return FALSE;
+	if (!fu_util_download_wait (dl_sig, error))
 		return FALSE;
+	if (!force &&
+	    fu_util_remote_has_signature (remote, filename_asc) &&
+	    g_access (fwupd_remote_get_filename_cache (remote), R_OK) == 0) {
+		/* TRANSLATORS: the remote has not changed since the last refresh */
+		g_print ("%s %s\n", _("Metadata is already up to date for"),
+			 fwupd_remote_get_id (remote));
+
+		/* still tell the daemon so that the metadata age is reset */
+		filename = g_strdup (fwupd_remote_get_filename_cache (remote));
+	} else {
+		/* download the metadata, which is only sent if it has changed */
+		filename = fu_util_get_user_cache_path (basename_id);
+		uri = soup_uri_new (fwupd_remote_get_metadata_uri (remote));
+		dl = fu_util_download_new (priv, uri, filename, NULL);
+		dl->conditional = !force;
+		if (!fu_util_download_start (dl, error))
+			return FALSE;
+		if (!fu_util_download_wait (dl, error))
+			return FALSE;
+	}
 
 	/* send all this to fwupd */
 	return fwupd_client_update_metadata (priv->client,
@@ -1732,17 +2170,20 @@ fu_util_get_remotes (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_util_update_device_with_release (FuUtilPrivate *priv,
-				    FwupdDevice *dev,
-				    FwupdRelease *rel,
-				    GError **error)
+/* returns a download for the release, which may already be complete */
+static FuUtilDownload *
+fu_util_download_for_release (FuUtilPrivate *priv,
+			      FwupdDevice *dev,
+			      FwupdRelease *rel,
+			      GPtrArray *downloads,
+			      GError **error)
 {
 	GPtrArray *checksums;
 	const gchar *remote_id;
 	const gchar *uri_tmp;
 	g_autofree gchar *fn = NULL;
 	g_autofree gchar *uri_str = NULL;
+	g_autoptr(FuUtilDownload) dl = NULL;
 	g_autoptr(SoupURI) uri = NULL;
 
 	/* work out what remote-specific URI fields this should use */
@@ -1755,7 +2196,7 @@ fu_util_update_device_with_release (FuUtilPrivate *priv,
 							NULL,
 							error);
 		if (remote == NULL)
-			return FALSE;
+			return NULL;
 
 		/* local and directory remotes have the firmware already */
 		if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_LOCAL) {
@@ -1768,14 +2209,16 @@ fu_util_update_device_with_release (FuUtilPrivate *priv,
 		}
 		/* install with flags chosen by the user */
 		if (fn != NULL) {
-			return fwupd_client_install (priv->client,
-						     fwupd_device_get_id (dev),
-						     fn, priv->flags, NULL, error);
+			dl = fu_util_download_new (priv, NULL, fn, NULL);
+			dl->device = g_object_ref (dev);
+			dl->release = g_object_ref (rel);
+			dl->done = TRUE;
+			return g_steal_pointer (&dl);
 		}
 
 		uri_str = fwupd_remote_build_firmware_uri (remote, uri_tmp, error);
 		if (uri_str == NULL)
-			return FALSE;
+			return NULL;
 	} else {
 		uri_str = g_strdup (uri_tmp);
 	}
@@ -1786,22 +2229,65 @@ fu_util_update_device_with_release (FuUtilPrivate *priv,
 		 fwupd_device_get_name (dev));
 	fn = fu_util_get_user_cache_path (uri_str);
 	if (!fu_common_mkdir_parent (fn, error))
-		return FALSE;
-	checksums = fwupd_release_get_checksums (rel);
+		return NULL;
 	uri = soup_uri_new (uri_str);
-	if (!fu_util_download_file (priv, uri, fn,
-				    fwupd_checksum_get_best (checksums),
-				    error))
+	if (uri == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "Failed to parse URI %s", uri_str);
+		return NULL;
+	}
+	checksums = fwupd_release_get_checksums (rel);
+	dl = fu_util_download_new (priv, uri, fn, fwupd_checksum_get_best (checksums));
+	dl->device = g_object_ref (dev);
+	dl->release = g_object_ref (rel);
+
+	/* devices sharing firmware use one download, as they use one file */
+	for (guint i = 0; downloads != NULL && i < downloads->len; i++) {
+		FuUtilDownload *dl_tmp = g_ptr_array_index (downloads, i);
+		if (dl_tmp->shared == NULL &&
+		    g_strcmp0 (dl_tmp->filename, fn) == 0) {
+			g_debug ("already downloading %s", uri_str);
+			dl->shared = dl_tmp;
+			return g_steal_pointer (&dl);
+		}
+	}
+	if (!fu_util_download_start (dl, error))
+		return NULL;
+	return g_steal_pointer (&dl);
+}
+
+static gboolean
+fu_util_download_install (FuUtilDownload *dl, GError **error)
+{
+	FuUtilPrivate *priv = dl->priv;
+	if (!fu_util_download_wait (dl, error))
 		return FALSE;
 	return fwupd_client_install (priv->client,
-				     fwupd_device_get_id (dev), fn,
-				     priv->flags, NULL, error);
+				     fwupd_device_get_id (dl->device),
+				     dl->filename, priv->flags, NULL, error);
+}
+
+static gboolean
+fu_util_update_device_with_release (FuUtilPrivate *priv,
+				    FwupdDevice *dev,
+				    FwupdRelease *rel,
+				    GError **error)
+{
+	g_autoptr(FuUtilDownload) dl = NULL;
+
+	dl = fu_util_download_for_release (priv, dev, rel, NULL, error);
+	if (dl == NULL)
+		return FALSE;
+	return fu_util_download_install (dl, error);
 }
 
 static gboolean
 fu_util_update_all (FuUtilPrivate *priv, GError **error)
 {
 	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) downloads = NULL;
 
 	/* get devices from daemon */
 	devices = fwupd_client_get_devices (priv->client, NULL, error);
@@ -1810,9 +2296,13 @@ fu_util_update_all (FuUtilPrivate *priv, GError **error)
 	priv->current_operation = FU_UTIL_OPERATION_UPDATE;
 	g_signal_connect (priv->client, "device-changed",
 			  G_CALLBACK (fu_util_update_device_changed_cb), priv);
+
+	/* start fetching all the firmware in parallel */
+	downloads = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_util_download_free);
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devices, i);
 		FwupdRelease *rel;
+		FuUtilDownload *dl;
 		g_autoptr(GPtrArray) rels = NULL;
 		g_autoptr(GError) error_local = NULL;
 
@@ -1829,9 +2319,22 @@ fu_util_update_all (FuUtilPrivate *priv, GError **error)
 			continue;
 		}
 		rel = g_ptr_array_index (rels, 0);
-		if (!fu_util_update_device_with_release (priv, dev, rel, error))
+		dl = fu_util_download_for_release (priv, dev, rel, downloads, error);
+		if (dl == NULL) {
+			fu_util_download_cancel_all (downloads);
 			return FALSE;
+		}
+		g_ptr_array_add (downloads, dl);
+	}
 
+	/* install in device order, waiting for each download in turn; the
+	 * other downloads carry on while the daemon is busy */
+	for (guint i = 0; i < downloads->len; i++) {
+		FuUtilDownload *dl = g_ptr_array_index (downloads, i);
+		if (!fu_util_download_install (dl, error)) {
+			fu_util_download_cancel_all (downloads);
+			return FALSE;
+		}
 		fu_util_display_current_message (priv);
 	}
 
@@ -2091,6 +2594,96 @@ fu_util_get_approved_firmware (FuUtilPrivate *priv, gchar **values, GError **err
 	return TRUE;
 }
 
+static gboolean
+fu_util_get_stats (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	GVariantIter iter;
+	GVariant *child;
+	g_autoptr(GPtrArray) items = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+	g_autoptr(GVariant) dict_bytes = NULL;
+	g_autoptr(GVariant) dict_usecs = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	/* check args */
+	if (g_strv_length (values) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments: none expected");
+		return FALSE;
+	}
+
+	/* call into daemon */
+	val = fwupd_client_get_stats (priv->client, priv->cancellable, error);
+	if (val == NULL)
+		return FALSE;
+	if (g_variant_n_children (val) == 0) {
+		/* TRANSLATORS: no performance counters recorded yet */
+		g_print ("%s\n", _("No statistics available."));
+		return TRUE;
+	}
+
+	/* one line per ID so it can be scraped easily */
+	g_variant_iter_init (&iter, val);
+	while ((child = g_variant_iter_next_value (&iter)) != NULL)
+		g_ptr_array_add (items, child);
+	g_ptr_array_sort (items, fu_util_sort_stats_cb);
+	for (guint i = 0; i < items->len; i++) {
+		const gchar *id = NULL;
+		guint64 count = 0;
+		guint64 total = 0;
+		guint64 min = 0;
+		guint64 max = 0;
+		g_autoptr(GString) str = g_string_new (NULL);
+		g_autoptr(GVariant) dict = NULL;
+		g_autoptr(GVariant) histogram = NULL;
+
+		g_variant_get (g_ptr_array_index (items, i), "{&s@a{sv}}", &id, &dict);
+		g_variant_lookup (dict, "Count", "t", &count);
+		g_variant_lookup (dict, "Total", "t", &total);
+		g_variant_lookup (dict, "Min", "t", &min);
+		g_variant_lookup (dict, "Max", "t", &max);
+		g_string_append_printf (str, "%s count=%" G_GUINT64_FORMAT
+					" total=%" G_GUINT64_FORMAT
+					" min=%" G_GUINT64_FORMAT
+					" max=%" G_GUINT64_FORMAT
+					" mean=%" G_GUINT64_FORMAT,
+					id, count, total, min, max,
+					count > 0 ? total / count : 0);
+		histogram = g_variant_lookup_value (dict, "Histogram",
+						    G_VARIANT_TYPE ("at"));
+		if (histogram != NULL) {
+			gsize n_elements = 0;
+			const guint64 *buckets;
+			buckets = g_variant_get_fixed_array (histogram, &n_elements,
+							     sizeof (guint64));
+			g_string_append (str, " histogram=");
+			for (gsize j = 0; j < n_elements; j++) {
+				if (j > 0)
+					g_string_append_c (str, ',');
+				g_string_append_printf (str, "%" G_GUINT64_FORMAT,
+							buckets[j]);
+			}
+		}
+		g_print ("%s\n", str->str);
+	}
+
+	/* throughput is more useful than the raw write duration */
+	dict_usecs = g_variant_lookup_value (val, "install.write", G_VARIANT_TYPE_VARDICT);
+	dict_bytes = g_variant_lookup_value (val, "install.write-bytes", G_VARIANT_TYPE_VARDICT);
+	if (dict_usecs != NULL && dict_bytes != NULL) {
+		guint64 usecs = 0;
+		guint64 bytes = 0;
+		g_variant_lookup (dict_usecs, "Total", "t", &usecs);
+		g_variant_lookup (dict_bytes, "Total", "t", &bytes);
+		if (usecs > 0) {
+			g_print ("install.write-throughput kib_per_s=%" G_GUINT64_FORMAT "\n",
+				 (bytes * G_USEC_PER_SEC) / (usecs * 1024));
+		}
+	}
+	return TRUE;
+}
+
 static void
 fu_util_ignore_cb (const gchar *log_domain, GLogLevelFlags log_level,
 		   const gchar *message, gpointer user_data)
@@ -2350,6 +2943,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: firmware approved by the admin */
 		     _("Sets the list of approved firmware."),
 		     fu_util_set_approved_firmware);
+	fu_util_cmd_array_add (cmd_array,
+		     "get-stats",
+		     NULL,
+		     /* TRANSLATORS: performance counters kept by the daemon */
+		     _("Gets the daemon performance counters."),
+		     fu_util_get_stats);
 
 	/* do stuff on ctrl+c */
 	priv->cancellable = g_cancellable_new ();
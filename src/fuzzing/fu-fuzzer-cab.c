@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-common-cab.h"
+#include "fu-fuzzer.h"
+
+/* much smaller than the default ArchiveSizeMax to avoid OOM reports */
+#define FU_FUZZER_CAB_SIZE_MAX		(64 * 0x100000)
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autoptr(GBytes) blob = g_bytes_new_static (data, size);
+	g_autoptr(XbSilo) silo = NULL;
+	silo = fu_common_cab_build_silo (blob, FU_FUZZER_CAB_SIZE_MAX, NULL);
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "fu-fuzzer.h"
+
+/* used instead of libFuzzer to replay a corpus, for instance to reproduce a
+ * crash or to find out how many MB/s the parser can process */
+
+static gboolean
+fu_fuzzer_add_path (GPtrArray *blobs, const gchar *path, GError **error)
+{
+	const gchar *fn;
+	gchar *data = NULL;
+	gsize len = 0;
+	g_autoptr(GDir) dir = NULL;
+
+	/* single file */
+	if (!g_file_test (path, G_FILE_TEST_IS_DIR)) {
+		if (!g_file_get_contents (path, &data, &len, error))
+			return FALSE;
+		g_ptr_array_add (blobs, g_bytes_new_take (data, len));
+		return TRUE;
+	}
+
+	/* every file in the corpus directory */
+	dir = g_dir_open (path, 0, error);
+	if (dir == NULL)
+		return FALSE;
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *filename = g_build_filename (path, fn, NULL);
+		if (!fu_fuzzer_add_path (blobs, filename, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+	gboolean benchmark = FALSE;
+	gint iterations = 100;
+	gdouble elapsed;
+	guint64 total = 0;
+	g_autofree gchar *name = g_path_get_basename (argv[0]);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(GPtrArray) blobs = NULL;
+	g_autoptr(GTimer) timer = NULL;
+	const GOptionEntry options[] = {
+		{ "benchmark", '\0', 0, G_OPTION_ARG_NONE, &benchmark,
+			"Report the throughput of the parser", NULL },
+		{ "iterations", '\0', 0, G_OPTION_ARG_INT, &iterations,
+			"Number of times to parse the corpus when benchmarking", NULL },
+		{ NULL}
+	};
+
+	context = g_option_context_new ("FILE|DIRECTORY...");
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if (argc < 2 || iterations < 1) {
+		g_autofree gchar *tmp = g_option_context_get_help (context, TRUE, NULL);
+		g_printerr ("%s", tmp);
+		return EXIT_FAILURE;
+	}
+
+	/* load everything first so that only the parser is measured */
+	blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	for (gint i = 1; i < argc; i++) {
+		if (!fu_fuzzer_add_path (blobs, argv[i], &error)) {
+			g_printerr ("Failed to load %s: %s\n", argv[i], error->message);
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* parse each input, more than once if benchmarking */
+	if (!benchmark)
+		iterations = 1;
+	timer = g_timer_new ();
+	for (gint j = 0; j < iterations; j++) {
+		for (guint i = 0; i < blobs->len; i++) {
+			GBytes *blob = g_ptr_array_index (blobs, i);
+			gsize sz = 0;
+			const guint8 *buf = g_bytes_get_data (blob, &sz);
+			LLVMFuzzerTestOneInput (buf, sz);
+			total += sz;
+		}
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	/* one line per harness so the output can be collected from a script */
+	if (benchmark) {
+		g_print ("%s: %u inputs, %" G_GUINT64_FORMAT " bytes in %.3fs, %.2f MB/s\n",
+			 name, blobs->len, total, elapsed,
+			 elapsed > 0.f ? (gdouble) total / elapsed / 1000000.f : 0.f);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-fuzzer.h"
+#include "fu-quirks.h"
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	fu_quirks_add_quirks_from_data (quirks, (const gchar *) data, size, NULL);
+	return 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2019 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include "fu-fuzzer.h"
+#include "fu-smbios.h"
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuSmbios) smbios = fu_smbios_new ();
+
+	/* also check whatever was parsed can be used */
+	fu_smbios_setup_from_data (smbios, data, size, NULL);
+	str = fu_smbios_to_string (smbios);
+	return 0;
+}